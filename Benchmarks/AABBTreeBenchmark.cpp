@@ -0,0 +1,16 @@
+#include "tspch.h"
+#include "SceneManager/DynamicAABBTree.h"
+
+// Logs DynamicAABBTree build, refit and query timings.
+// Usage: TS_ENGINE_AABBTreeBenchmark [numProxies] [numFrames] [numQueries]
+int main(int argc, char** argv)
+{
+	TS_ENGINE::Log::Init();
+
+	uint32_t numProxies = argc > 1 ? (uint32_t)std::stoul(argv[1]) : 5000;
+	uint32_t numFrames = argc > 2 ? (uint32_t)std::stoul(argv[2]) : 100;
+	uint32_t numQueries = argc > 3 ? (uint32_t)std::stoul(argv[3]) : 10000;
+
+	TS_ENGINE::DynamicAABBTree::Benchmark(numProxies, numFrames, numQueries);
+	return 0;
+}
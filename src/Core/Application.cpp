@@ -4,6 +4,13 @@
 #include "Core/Base.h"
 //#include "Renderer/Renderer.h"
 #include "Renderer/RenderCommand.h"
+#include "Core/JobSystem.h"
+#include "Renderer/MeshArena.h"
+#include "Renderer/StreamBuffer.h"
+#include "Renderer/TextureStreamer.h"
+#include "Renderer/GPUMemory.h"
+#include "Renderer/BindlessTextureTable.h"
+#include "Renderer/Framebuffer.h"
 
 namespace TS_ENGINE
 {
@@ -14,6 +21,7 @@ namespace TS_ENGINE
 	std::filesystem::path Application::s_ResourcesDir;
 	std::filesystem::path Application::s_SaveSceneDir;
 	std::filesystem::path Application::s_ThumbnailsDir;
+	std::filesystem::path Application::s_TextureCacheDir;
 
 	std::chrono::time_point<std::chrono::steady_clock> finish;
 
@@ -37,6 +45,8 @@ namespace TS_ENGINE
 	Application::~Application()
 	{
 		//Renderer::Shutdown();
+		JobSystem::GetInstance()->Shutdown();	// Finish pending jobs such as framebuffer captures
+		MeshArena::Shutdown();					// Layers and their meshes are deleted before the window and its context
 		TS_CORE_INFO("Deleting application");
 	}
 
@@ -84,6 +94,7 @@ namespace TS_ENGINE
 		s_ResourcesDir = std::string(exeDir.string() + "\\Resources");
 		s_SaveSceneDir = std::string(exeDir.string() + "\\Assets\\SavedScenes");
 		s_ThumbnailsDir = std::string(exeDir.string() + "\\Resources\\SavedSceneThumbnails");
+		s_TextureCacheDir = std::string(exeDir.string() + "\\Resources\\TextureCache");
 	}
 
 	void Application::Run()
@@ -96,8 +107,13 @@ namespace TS_ENGINE
 
 			//TS_CORE_INFO("FPS: {0}, {1} ms/frame", 1000.0f / mDeltaTime, mDeltaTime);
 
+			Framebuffer::ProcessAllReadbacks();		// Asynchronous readbacks of every framebuffer, also while minimized
+
 			if (!mMinimized)
 			{
+				MeshArena::GetInstance()->Defragment(MeshArena::sDefragmentBytesPerFrame);
+				TextureStreamer::GetInstance()->Update();
+
 				// Render scene
 				for (Layer* layer : mLayerStack)
 				{
@@ -115,6 +131,12 @@ namespace TS_ENGINE
 				mImGuiLayer->End();
 
 				mWindow->OnUpdate();
+				StreamBuffer::GetInstance()->NextFrame();
+
+				if (mBindlessTextures && BindlessTextureTable::IsSupported())
+					BindlessTextureTable::GetInstance()->NextFrame();
+
+				GPUMemoryManager::GetInstance()->Update();
 			}
 		}
 	}
@@ -154,11 +176,53 @@ namespace TS_ENGINE
 		mTotalIndices += indices;
 	}
 
+	void Application::AddVisibleMeshes(uint32_t meshes)
+	{
+		mVisibleMeshes += meshes;
+	}
+
+	void Application::AddCulledMeshes(uint32_t meshes)
+	{
+		mCulledMeshes += meshes;
+	}
+
+	void Application::AddOccludedMeshes(uint32_t meshes)
+	{
+		mOccludedMeshes += meshes;
+	}
+
+	void Application::AddCulledClusterTriangles(uint32_t triangles)
+	{
+		mCulledClusterTriangles += triangles;
+	}
+
+	void Application::AddLODSavedTriangles(uint32_t triangles)
+	{
+		mLODSavedTriangles += triangles;
+	}
+
+	void Application::AddImpostorInstances(uint32_t instances)
+	{
+		mImpostorInstances += instances;
+	}
+
+	void Application::AddHLODProxyNodes(uint32_t nodes)
+	{
+		mHLODProxyNodes += nodes;
+	}
+
 	void Application::ResetStats()
 	{
 		mDrawCalls = 0;
 		mTotalVertices = 0;
 		mTotalIndices = 0;
+		mVisibleMeshes = 0;
+		mCulledMeshes = 0;
+		mOccludedMeshes = 0;
+		mCulledClusterTriangles = 0;
+		mLODSavedTriangles = 0;
+		mImpostorInstances = 0;
+		mHLODProxyNodes = 0;
 	}
 
 	bool Application::OnWindowClose(WindowCloseEvent& e)
@@ -187,6 +251,41 @@ namespace TS_ENGINE
 		return mTotalIndices;
 	}
 
+	const uint32_t Application::GetVisibleMeshes() const
+	{
+		return mVisibleMeshes;
+	}
+
+	const uint32_t Application::GetCulledMeshes() const
+	{
+		return mCulledMeshes;
+	}
+
+	const uint32_t Application::GetOccludedMeshes() const
+	{
+		return mOccludedMeshes;
+	}
+
+	const uint32_t Application::GetCulledClusterTriangles() const
+	{
+		return mCulledClusterTriangles;
+	}
+
+	const uint32_t Application::GetLODSavedTriangles() const
+	{
+		return mLODSavedTriangles;
+	}
+
+	const uint32_t Application::GetImpostorInstances() const
+	{
+		return mImpostorInstances;
+	}
+
+	const uint32_t Application::GetHLODProxyNodes() const
+	{
+		return mHLODProxyNodes;
+	}
+
 	void Application::ToggleWireframeMode()
 	{
 		mWireframeMode = !mWireframeMode;
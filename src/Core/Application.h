@@ -29,11 +29,25 @@ namespace TS_ENGINE
 		void AddDrawCalls(uint32_t drawcalls);
 		void AddVertices(uint32_t vertices);
 		void AddIndices(uint32_t indices);
+		void AddVisibleMeshes(uint32_t meshes);
+		void AddCulledMeshes(uint32_t meshes);
+		void AddOccludedMeshes(uint32_t meshes);
+		void AddCulledClusterTriangles(uint32_t triangles);
+		void AddLODSavedTriangles(uint32_t triangles);
+		void AddImpostorInstances(uint32_t instances);
+		void AddHLODProxyNodes(uint32_t nodes);
 
 		const float GetDeltaTime() const;
 		const uint32_t GetDrawCalls() const;
 		const uint32_t GetTotalVertices() const;
 		const uint32_t GetTotalIndices() const;
+		const uint32_t GetVisibleMeshes() const;
+		const uint32_t GetCulledMeshes() const;
+		const uint32_t GetOccludedMeshes() const;
+		const uint32_t GetCulledClusterTriangles() const;
+		const uint32_t GetLODSavedTriangles() const;
+		const uint32_t GetImpostorInstances() const;
+		const uint32_t GetHLODProxyNodes() const;
 		
 		void ResetStats();
 
@@ -53,11 +67,34 @@ namespace TS_ENGINE
 		static std::filesystem::path s_ResourcesDir;
 		static std::filesystem::path s_SaveSceneDir;
 		static std::filesystem::path s_ThumbnailsDir;
+		static std::filesystem::path s_TextureCacheDir;
 		
 		bool mWireframeMode = false;
 		bool mTextureModeEnabled = true;
 		bool mBoneView = false;
 		bool mBoneInfluence = false;
+		bool mFrustumCulling = true;
+		bool mOcclusionCulling = true;
+		bool mClusterCulling = true;		// Meshlet frustum and normal cone culling
+		bool mLODSelection = true;			// Coarser LODs for meshes small on screen
+		bool mGPUCulling = false;			// Compute shader culling with indirect draws, when the driver supports it
+		bool mImpostors = true;				// Loaded models beyond mImpostorDistance are drawn as baked billboards
+		float mImpostorDistance = 40.0f;
+		bool mHLOD = true;					// Clusters of static nodes beyond mHLODDistance are drawn as one merged proxy
+		float mHLODDistance = 80.0f;
+		float mHLODCellSize = 32.0f;		// Grid cell grouping nodes into clusters
+		bool mStaticBatching = true;		// Meshes of subtrees flagged static are drawn from merged world space batches
+		bool mDynamicBatching = true;		// Small meshes sharing a material are transformed on the CPU and drawn together
+		bool mMeshArena = true;				// Triangle meshes created from now on share large per format buffers
+		bool mTextureArrays = true;			// Textures loaded from now on become layers of arrays shared by equal sized textures
+		bool mBindlessTextures = true;		// Shaders indexing the handle table sample textures without binds, if the driver supports it
+		bool mSRGBTextures = false;			// Color textures loaded from now on are stored as sRGB, for gamma corrected output
+		bool mTextureCompression = false;	// Textures loaded from now on are block compressed on import and cached in s_TextureCacheDir
+		bool mBC7Textures = false;			// BC7 instead of BC1/BC3 for compressed color textures, slower to encode but sharper
+		bool mMipmaps = true;				// Textures loaded from now on get full mip chains and trilinear filtering
+		float mTextureAnisotropy = 8.0f;	// Anisotropic samples of textures loaded from now on, 1 turns it off
+		bool mTextureStreaming = true;		// Textures loaded from now on are imported on workers and uploaded over frames, smallest mip first
+		uint32_t mGPUMemoryBudget = 0;		// MB, textures drop their largest mips while over it. 0 uses 3/4 of the video memory the driver reports.
 	private:
 		static Application* mInstance;		
 
@@ -73,6 +110,13 @@ namespace TS_ENGINE
 		uint32_t mDrawCalls;
 		uint32_t mTotalVertices;
 		uint32_t mTotalIndices;
+		uint32_t mVisibleMeshes = 0;
+		uint32_t mCulledMeshes = 0;
+		uint32_t mOccludedMeshes = 0;
+		uint32_t mCulledClusterTriangles = 0;
+		uint32_t mLODSavedTriangles = 0;
+		uint32_t mImpostorInstances = 0;
+		uint32_t mHLODProxyNodes = 0;
 
 		bool mRunning = true;
 		bool mMinimized = false;			
@@ -0,0 +1,109 @@
+#include "tspch.h"
+#include "JobSystem.h"
+
+namespace TS_ENGINE {
+
+	JobSystem* JobSystem::mInstance = nullptr;
+	thread_local bool JobSystem::sIsWorkerThread = false;
+
+	JobSystem* JobSystem::GetInstance()
+	{
+		if (mInstance == nullptr)
+		{
+			mInstance = new JobSystem();
+		}
+
+		return mInstance;
+	}
+
+	JobSystem::JobSystem()
+	{
+		// Leave one core for the main thread
+		uint32_t numCores = std::thread::hardware_concurrency();
+		uint32_t numWorkers = numCores > 1 ? numCores - 1 : 1;
+
+		for (uint32_t i = 0; i < numWorkers; i++)
+			mWorkers.emplace_back(&JobSystem::WorkerLoop, this);
+
+		TS_CORE_INFO("Started job system with {0} workers", numWorkers);
+	}
+
+	JobSystem::~JobSystem()
+	{
+		Shutdown();
+	}
+
+	void JobSystem::Submit(std::function<void()> job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+
+			if (!mStopping)
+			{
+				mJobs.push(std::move(job));
+				mJobAvailable.notify_one();
+				return;
+			}
+		}
+
+		job();
+	}
+
+	void JobSystem::Wait()
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mJobsDone.wait(lock, [this]() { return mJobs.empty() && mActiveJobs == 0; });
+	}
+
+	void JobSystem::Shutdown()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+
+			if (mStopping)
+				return;
+
+			mStopping = true;
+		}
+
+		mJobAvailable.notify_all();
+
+		for (auto& worker : mWorkers)
+			worker.join();
+
+		mWorkers.clear();
+	}
+
+	void JobSystem::WorkerLoop()
+	{
+		sIsWorkerThread = true;
+
+		while (true)
+		{
+			std::function<void()> job;
+
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mJobAvailable.wait(lock, [this]() { return mStopping || !mJobs.empty(); });
+
+				// Drain the queue before stopping
+				if (mJobs.empty())
+					return;
+
+				job = std::move(mJobs.front());
+				mJobs.pop();
+				mActiveJobs++;
+			}
+
+			job();
+
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mActiveJobs--;
+
+				if (mJobs.empty() && mActiveJobs == 0)
+					mJobsDone.notify_all();
+			}
+		}
+	}
+}
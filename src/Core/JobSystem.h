@@ -0,0 +1,61 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+
+namespace TS_ENGINE {
+
+	/// <summary>
+	/// Fixed pool of worker threads running jobs in submission order.
+	/// Jobs must not touch the GL context, which stays on the main thread.
+	/// </summary>
+	class JobSystem
+	{
+	public:
+		static JobSystem* GetInstance();
+		~JobSystem();
+
+		void Submit(std::function<void()> job);
+
+		// Runs the function on a worker and returns its result through a future
+		template<typename Function>
+		auto Async(Function&& function) -> std::future<decltype(function())>;
+
+		// Blocks until every submitted job has finished
+		void Wait();
+		// Finishes pending jobs and joins the workers. Submitting afterwards runs jobs inline.
+		void Shutdown();
+
+		uint32_t GetWorkerCount() const { return (uint32_t)mWorkers.size(); }
+		// Jobs that split their work must run it inline here, waiting on jobs queued behind them can stall every worker
+		static bool IsWorkerThread() { return sIsWorkerThread; }
+	private:
+		JobSystem();
+		void WorkerLoop();
+
+		static JobSystem* mInstance;
+		static thread_local bool sIsWorkerThread;
+
+		std::vector<std::thread> mWorkers;
+		std::queue<std::function<void()>> mJobs;
+		std::mutex mMutex;
+		std::condition_variable mJobAvailable;
+		std::condition_variable mJobsDone;
+		uint32_t mActiveJobs = 0;
+		bool mStopping = false;
+	};
+
+	template<typename Function>
+	auto JobSystem::Async(Function&& function) -> std::future<decltype(function())>
+	{
+		using Result = decltype(function());
+
+		// std::function needs a copyable callable, so the task is shared
+		auto task = CreateRef<std::packaged_task<Result()>>(std::forward<Function>(function));
+		std::future<Result> future = task->get_future();
+		Submit([task]() { (*task)(); });
+		return future;
+	}
+}
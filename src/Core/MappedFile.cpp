@@ -0,0 +1,110 @@
+#include "tspch.h"
+#include "MappedFile.h"
+
+#ifndef TS_PLATFORM_WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace TS_ENGINE {
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+#ifdef TS_PLATFORM_WINDOWS
+	bool MappedFile::Open(const std::filesystem::path& path)
+	{
+		Close();
+
+		HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size;
+
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+		if (!data)
+		{
+			if (mapping)
+				CloseHandle(mapping);
+
+			CloseHandle(file);
+			return false;
+		}
+
+		mFile = file;
+		mMapping = mapping;
+		mData = (const uint8_t*)data;
+		mSize = (size_t)size.QuadPart;
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (mData)
+			UnmapViewOfFile(mData);
+
+		if (mMapping)
+			CloseHandle(mMapping);
+
+		if (mFile)
+			CloseHandle(mFile);
+
+		mData = nullptr;
+		mSize = 0;
+		mFile = nullptr;
+		mMapping = nullptr;
+	}
+#else
+	bool MappedFile::Open(const std::filesystem::path& path)
+	{
+		Close();
+
+		int file = open(path.c_str(), O_RDONLY);
+
+		if (file < 0)
+			return false;
+
+		struct stat fileStat;
+
+		if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+		{
+			close(file);
+			return false;
+		}
+
+		// The mapping stays valid after the descriptor is closed
+		void* data = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		close(file);
+
+		if (data == MAP_FAILED)
+			return false;
+
+		mData = (const uint8_t*)data;
+		mSize = (size_t)fileStat.st_size;
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (mData)
+			munmap((void*)mData, mSize);
+
+		mData = nullptr;
+		mSize = 0;
+	}
+#endif
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <filesystem>
+
+namespace TS_ENGINE {
+
+	/// <summary>
+	/// Read only memory mapping of a whole file. Pages are read in by the OS when they're first touched,
+	/// so only the parts of the file that are used get loaded.
+	/// </summary>
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		// Closes the current mapping first. False if the file can't be opened or is empty.
+		bool Open(const std::filesystem::path& path);
+		void Close();
+
+		bool IsOpen() const { return mData != nullptr; }
+		const uint8_t* GetData() const { return mData; }
+		size_t GetSize() const { return mSize; }
+	private:
+		const uint8_t* mData = nullptr;
+		size_t mSize = 0;
+#ifdef TS_PLATFORM_WINDOWS
+		void* mFile = nullptr;
+		void* mMapping = nullptr;
+#endif
+	};
+}
@@ -5,6 +5,8 @@
 
 namespace TS_ENGINE
 {
+	uint32_t Transform::sTrackedVersion = 0;
+
 	Transform::Transform() :
 		mLocalPosition(0),
 		mLocalRotation(1.0, 0.0f, 0.0f, 0.0f),
@@ -36,7 +38,9 @@ namespace TS_ENGINE
 
 	void Transform::Follow(Ref<Node> targetNode)
 	{
+		Matrix4 previousWorldMatrix = mWorldTransformationMatrix;
 		mWorldTransformationMatrix = targetNode->GetTransform()->GetWorldTransformationMatrix();
+		NotifyWorldMatrixChanged(previousWorldMatrix);
 	}
 
 	void Transform::LookAt(Ref<Node> parentNode, const Ref<Transform> target)
@@ -44,6 +48,7 @@ namespace TS_ENGINE
 		mLookAtTarget = target;
 		mLookAtEnabled = true;
 
+		Matrix4 previousWorldMatrix = mWorldTransformationMatrix;
 		Matrix4 modelMatrix = Matrix4(1);
 
 		if (parentNode)
@@ -76,10 +81,14 @@ namespace TS_ENGINE
 		mRight = GetRight();
 		mUp = GetUp();
 		mForward = GetForward();
+
+		NotifyWorldMatrixChanged(previousWorldMatrix);
 	}
 
 	void Transform::ComputeTransformationMatrix(Ref<Node> parentNode)
 	{
+		Matrix4 previousWorldMatrix = mWorldTransformationMatrix;
+
 		// Update local transformation matrix
 		const Matrix4 translationMatrix = glm::translate(Matrix4(1.0f), mLocalPosition);
 		const Matrix4 rotationMatrix = glm::toMat4(mLocalRotation);// Quaternion to Matrix4x4						
@@ -113,6 +122,8 @@ namespace TS_ENGINE
 		mRight = glm::normalize(GetRight());
 		mUp = glm::normalize(GetUp());
 		mForward = glm::normalize(GetForward());
+
+		NotifyWorldMatrixChanged(previousWorldMatrix);
 	}
 
 	void Transform::SetLocalTransformationMatrix(const Matrix4& transformationMatrix)
@@ -130,7 +141,9 @@ namespace TS_ENGINE
 
 	void Transform::SetWorldTransformationMatrix(const Matrix4& transformationMatrix)
 	{
+		Matrix4 previousWorldMatrix = mWorldTransformationMatrix;
 		mWorldTransformationMatrix = transformationMatrix;
+		NotifyWorldMatrixChanged(previousWorldMatrix);
 		
 		Vector3 skew;
 		Vector4 perspective;
@@ -338,4 +351,10 @@ namespace TS_ENGINE
 		mLocalRotation = rollRotation * mLocalRotation; // Pre-multiply for local space
 		mLocalRotation = glm::normalize(mLocalRotation);
 	}
-}
\ No newline at end of file
+
+	void Transform::NotifyWorldMatrixChanged(const Matrix4& previousWorldMatrix)
+	{
+		if (mTracked && mWorldTransformationMatrix != previousWorldMatrix)
+			sTrackedVersion++;
+	}
+}
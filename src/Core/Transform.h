@@ -94,5 +94,14 @@ namespace TS_ENGINE
 
 		Ref<Transform> mLookAtTarget;
 		bool mLookAtEnabled = false;
+
+		// World matrix changes of tracked transforms bump GetTrackedVersion, so caches of tracked transforms are checked in O(1)
+		void SetTracked(bool tracked) { mTracked = tracked; }
+		static uint32_t GetTrackedVersion() { return sTrackedVersion; }
+	private:
+		void NotifyWorldMatrixChanged(const Matrix4& previousWorldMatrix);
+
+		bool mTracked = false;
+		static uint32_t sTrackedVersion;
 	};
 }
\ No newline at end of file
@@ -40,5 +40,8 @@
 #include "Base.h"
 
 #ifdef TS_PLATFORM_WINDOWS
+#ifndef NOMINMAX
+#define NOMINMAX	// Keeps std::min/max and glm::min/max usable
+#endif
 #include <Windows.h>
 #endif
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "tspch.h"
+#include "Platform/OpenGL/OpenGLBindlessTextureTable.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+namespace TS_ENGINE {
+
+	// ARB_bindless_texture, not part of the 4.5 loader
+	typedef GLuint64 (APIENTRYP PFNGETTEXTUREHANDLEARBPROC)(GLuint texture);
+	typedef void (APIENTRYP PFNMAKETEXTUREHANDLERESIDENTARBPROC)(GLuint64 handle);
+	typedef void (APIENTRYP PFNMAKETEXTUREHANDLENONRESIDENTARBPROC)(GLuint64 handle);
+	static PFNGETTEXTUREHANDLEARBPROC sGetTextureHandle = nullptr;
+	static PFNMAKETEXTUREHANDLERESIDENTARBPROC sMakeTextureHandleResident = nullptr;
+	static PFNMAKETEXTUREHANDLENONRESIDENTARBPROC sMakeTextureHandleNonResident = nullptr;
+	static bool sBindlessFunctionsLoaded = false;
+
+	OpenGLBindlessTextureTable::OpenGLBindlessTextureTable()
+	{
+		TS_CORE_ASSERT(IsSupported());
+
+		glCreateBuffers(1, &mTableBuffer);
+		glNamedBufferStorage(mTableBuffer, sMaxHandles * sizeof(GLuint64), nullptr, GL_DYNAMIC_STORAGE_BIT);
+	}
+
+	OpenGLBindlessTextureTable::~OpenGLBindlessTextureTable()
+	{
+		for (const auto& entry : mEntries)
+		{
+			Ref<Texture2D> texture = entry.texture.lock();
+
+			if (entry.resident && texture && texture->GetRendererID() == entry.rendererID)
+				sMakeTextureHandleNonResident(entry.handle);
+		}
+
+		glDeleteBuffers(1, &mTableBuffer);
+	}
+
+	bool OpenGLBindlessTextureTable::IsSupported()
+	{
+		if (!sBindlessFunctionsLoaded)
+		{
+			sBindlessFunctionsLoaded = true;
+
+			if (glfwExtensionSupported("GL_ARB_bindless_texture"))
+			{
+				sGetTextureHandle = (PFNGETTEXTUREHANDLEARBPROC)glfwGetProcAddress("glGetTextureHandleARB");
+				sMakeTextureHandleResident = (PFNMAKETEXTUREHANDLERESIDENTARBPROC)glfwGetProcAddress("glMakeTextureHandleResidentARB");
+				sMakeTextureHandleNonResident = (PFNMAKETEXTUREHANDLENONRESIDENTARBPROC)glfwGetProcAddress("glMakeTextureHandleNonResidentARB");
+			}
+
+			TS_CORE_INFO("Bindless textures: {0}", sGetTextureHandle ? "GL_ARB_bindless_texture" : "unsupported, binding texture slots");
+		}
+
+		return sGetTextureHandle && sMakeTextureHandleResident && sMakeTextureHandleNonResident;
+	}
+
+	void OpenGLBindlessTextureTable::Bind()
+	{
+		if (mDirtyBegin < mDirtyEnd)
+		{
+			std::vector<GLuint64> handles(mDirtyEnd - mDirtyBegin);
+
+			for (uint32_t i = mDirtyBegin; i < mDirtyEnd; i++)
+				handles[i - mDirtyBegin] = mEntries[i].handle;
+
+			// Ordered after the draws already submitted, which still read the old handles
+			glNamedBufferSubData(mTableBuffer, (GLintptr)mDirtyBegin * sizeof(GLuint64), (GLsizeiptr)(handles.size() * sizeof(GLuint64)), handles.data());
+
+			mDirtyBegin = UINT32_MAX;
+			mDirtyEnd = 0;
+		}
+
+		// Nothing else uses sTableBinding
+		if (!mBound)
+		{
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, sTableBinding, mTableBuffer);
+			mBound = true;
+		}
+	}
+
+	uint64_t OpenGLBindlessTextureTable::CreateHandle(uint32_t rendererID)
+	{
+		if (rendererID == 0)
+			return 0;
+
+		// Also freezes the texture's sampling parameters
+		return sGetTextureHandle(rendererID);
+	}
+
+	void OpenGLBindlessTextureTable::SetResident(uint64_t handle, bool resident)
+	{
+		if (resident)
+			sMakeTextureHandleResident(handle);
+		else
+			sMakeTextureHandleNonResident(handle);
+	}
+}
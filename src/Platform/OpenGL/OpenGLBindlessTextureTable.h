@@ -0,0 +1,22 @@
+#pragma once
+#include "Renderer/BindlessTextureTable.h"
+
+namespace TS_ENGINE {
+
+	class OpenGLBindlessTextureTable : public BindlessTextureTable
+	{
+	public:
+		OpenGLBindlessTextureTable();
+		virtual ~OpenGLBindlessTextureTable();
+
+		virtual void Bind() override;
+
+		static bool IsSupported();
+	protected:
+		virtual uint64_t CreateHandle(uint32_t rendererID) override;
+		virtual void SetResident(uint64_t handle, bool resident) override;
+	private:
+		uint32_t mTableBuffer = 0;		// sMaxHandles 64-bit handles, read as uvec2 in std430
+		bool mBound = false;
+	};
+}
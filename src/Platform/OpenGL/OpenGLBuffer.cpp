@@ -1,27 +1,35 @@
 #include "tspch.h"
 #include "OpenGLBuffer.h"
+#include "Renderer/GPUMemory.h"
 
 namespace TS_ENGINE {
 
 	///***/////////////////////////////VertexBuffer///////////////////////////***///
 
-	OpenGLVertexBuffer::OpenGLVertexBuffer(uint32_t size) 
+	OpenGLVertexBuffer::OpenGLVertexBuffer(uint32_t size) :
+		mSize(size)
 	{
 		glCreateBuffers(1, &mRendererID);
 		glBindBuffer(GL_ARRAY_BUFFER, mRendererID);
 		glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+
+		GPUMemoryManager::GetInstance()->Allocate(GPUMemoryCategory::VertexBuffer, mSize);
 	}
 
-	OpenGLVertexBuffer::OpenGLVertexBuffer(void* vertices, uint32_t size)
+	OpenGLVertexBuffer::OpenGLVertexBuffer(void* vertices, uint32_t size) :
+		mSize(size)
 	{
 		glCreateBuffers(1, &mRendererID);
 		glBindBuffer(GL_ARRAY_BUFFER, mRendererID);
 		glBufferData(GL_ARRAY_BUFFER, size, vertices, GL_STATIC_DRAW);
+
+		GPUMemoryManager::GetInstance()->Allocate(GPUMemoryCategory::VertexBuffer, mSize);
 	}
 
 	OpenGLVertexBuffer::~OpenGLVertexBuffer()
 	{
 		glDeleteBuffers(1, &mRendererID);
+		GPUMemoryManager::GetInstance()->Release(GPUMemoryCategory::VertexBuffer, mSize);
 	}
 
 	void OpenGLVertexBuffer::Bind() const
@@ -43,17 +51,33 @@ namespace TS_ENGINE {
 	///***/////////////////////////////IndexBuffer///////////////////////////***///
 	
 	OpenGLIndexBuffer::OpenGLIndexBuffer(uint32_t* indices, uint32_t count) :
-		mCount(count)
+		mCount(count),
+		mIndexType(IndexType::UINT32)
 	{
 		glCreateBuffers(1, &mRendererID);
 
 		glBindBuffer(GL_ARRAY_BUFFER, mRendererID);
 		glBufferData(GL_ARRAY_BUFFER, count * sizeof(uint32_t), indices, GL_STATIC_DRAW);
+
+		GPUMemoryManager::GetInstance()->Allocate(GPUMemoryCategory::IndexBuffer, (uint64_t)count * sizeof(uint32_t));
+	}
+
+	OpenGLIndexBuffer::OpenGLIndexBuffer(uint16_t* indices, uint32_t count) :
+		mCount(count),
+		mIndexType(IndexType::UINT16)
+	{
+		glCreateBuffers(1, &mRendererID);
+
+		glBindBuffer(GL_ARRAY_BUFFER, mRendererID);
+		glBufferData(GL_ARRAY_BUFFER, count * sizeof(uint16_t), indices, GL_STATIC_DRAW);
+
+		GPUMemoryManager::GetInstance()->Allocate(GPUMemoryCategory::IndexBuffer, (uint64_t)count * sizeof(uint16_t));
 	}
 
 	OpenGLIndexBuffer::~OpenGLIndexBuffer()
 	{
 		glDeleteBuffers(1, &mRendererID);
+		GPUMemoryManager::GetInstance()->Release(GPUMemoryCategory::IndexBuffer, (uint64_t)mCount * (mIndexType == IndexType::UINT16 ? sizeof(uint16_t) : sizeof(uint32_t)));
 	}
 
 	void OpenGLIndexBuffer::Bind() const
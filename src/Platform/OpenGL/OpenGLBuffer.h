@@ -7,6 +7,7 @@ namespace TS_ENGINE {
 	{
 	private:
 		uint32_t mRendererID;
+		uint32_t mSize;
 		BufferLayout mLayout;
 	public:
 		OpenGLVertexBuffer(uint32_t size);
@@ -37,8 +38,10 @@ namespace TS_ENGINE {
 	private:
 		uint32_t mRendererID;
 		uint32_t mCount;
+		IndexType mIndexType;
 	public:
 		OpenGLIndexBuffer(uint32_t* indices, uint32_t count);
+		OpenGLIndexBuffer(uint16_t* indices, uint32_t count);
 		virtual ~OpenGLIndexBuffer();
 
 		virtual void Bind() const; 
@@ -48,6 +51,11 @@ namespace TS_ENGINE {
 		{
 			return mCount;
 		}
+
+		virtual IndexType GetIndexType() const override
+		{
+			return mIndexType;
+		}
 	};
 }
 
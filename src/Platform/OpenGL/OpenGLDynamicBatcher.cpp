@@ -0,0 +1,45 @@
+#include "tspch.h"
+#include "Platform/OpenGL/OpenGLDynamicBatcher.h"
+#include "Renderer/StreamBuffer.h"
+#include <glad/glad.h>
+
+namespace TS_ENGINE {
+
+	OpenGLDynamicBatcher::OpenGLDynamicBatcher()
+	{
+		// Same attribute locations as the mesh vertex formats, all read from binding 0
+		glCreateVertexArrays(1, &mVertexArray);
+
+		glEnableVertexArrayAttrib(mVertexArray, 0);
+		glVertexArrayAttribFormat(mVertexArray, 0, 4, GL_FLOAT, GL_FALSE, (GLuint)offsetof(DynamicVertex, position));
+		glVertexArrayAttribBinding(mVertexArray, 0, 0);
+
+		glEnableVertexArrayAttrib(mVertexArray, 1);
+		glVertexArrayAttribFormat(mVertexArray, 1, 2, GL_FLOAT, GL_FALSE, (GLuint)offsetof(DynamicVertex, texCoord));
+		glVertexArrayAttribBinding(mVertexArray, 1, 0);
+
+		glEnableVertexArrayAttrib(mVertexArray, 2);
+		glVertexArrayAttribFormat(mVertexArray, 2, 4, GL_FLOAT, GL_FALSE, (GLuint)offsetof(DynamicVertex, normal));
+		glVertexArrayAttribBinding(mVertexArray, 2, 0);
+	}
+
+	OpenGLDynamicBatcher::~OpenGLDynamicBatcher()
+	{
+		glDeleteVertexArrays(1, &mVertexArray);
+	}
+
+	void OpenGLDynamicBatcher::Draw(uint32_t vertexOffset, uint32_t indexOffset, uint32_t indexCount)
+	{
+		uint32_t buffer = StreamBuffer::GetInstance()->GetRendererID();
+
+		if (buffer != mBoundBuffer)
+		{
+			glVertexArrayElementBuffer(mVertexArray, buffer);
+			mBoundBuffer = buffer;
+		}
+
+		glVertexArrayVertexBuffer(mVertexArray, 0, buffer, vertexOffset, sizeof(DynamicVertex));
+		glBindVertexArray(mVertexArray);
+		glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (const void*)(uintptr_t)indexOffset);
+	}
+}
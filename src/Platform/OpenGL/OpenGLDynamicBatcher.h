@@ -0,0 +1,17 @@
+#pragma once
+#include "Renderer/DynamicBatcher.h"
+
+namespace TS_ENGINE {
+
+	class OpenGLDynamicBatcher : public DynamicBatcher
+	{
+	public:
+		OpenGLDynamicBatcher();
+		virtual ~OpenGLDynamicBatcher();
+	protected:
+		virtual void Draw(uint32_t vertexOffset, uint32_t indexOffset, uint32_t indexCount) override;
+	private:
+		uint32_t mVertexArray = 0;
+		uint32_t mBoundBuffer = 0;		// Stream buffer attached to the vertex array
+	};
+}
@@ -2,10 +2,13 @@
 #include "Platform/OpenGL/OpenGLFramebuffer.h"
 #include <glad/glad.h>
 #include <stb_image_write.h>
+#include "Core/JobSystem.h"
+#include "Renderer/GPUMemory.h"
 
 namespace TS_ENGINE {
 	
 	static const uint32_t sMaxFramebufferSize = 8192;
+	static const uint32_t sReadbackRingSize = 3;	// Enough for results that arrive two frames late
 
 	namespace Utils {
 
@@ -110,9 +113,13 @@ namespace TS_ENGINE {
 
 	OpenGLFramebuffer::~OpenGLFramebuffer()
 	{
+		ReleaseReadbacks();
+
 		glDeleteFramebuffers(1, &mRendererID);
 		glDeleteTextures((GLsizei)mColorAttachments.size(), mColorAttachments.data());
 		glDeleteTextures(1, &mDepthAttachment);
+
+		GPUMemoryManager::GetInstance()->Release(GPUMemoryCategory::Framebuffer, mGPUBytes);
 	}
 
 	void OpenGLFramebuffer::Invalidate()
@@ -181,6 +188,16 @@ namespace TS_ENGINE {
 
 		TS_CORE_ASSERT(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "Framebuffer is incomplete!");
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		// RGBA8, R32I and DEPTH24STENCIL8 all take 4 bytes a sample
+		uint32_t attachmentCount = (uint32_t)mColorAttachments.size() + (mDepthAttachment != 0 ? 1 : 0);
+		uint64_t bytes = (uint64_t)mSpecification.Width * mSpecification.Height * std::max(1u, mSpecification.Samples) * 4 * attachmentCount;
+		GPUMemoryManager::GetInstance()->Release(GPUMemoryCategory::Framebuffer, mGPUBytes);
+		GPUMemoryManager::GetInstance()->Allocate(GPUMemoryCategory::Framebuffer, bytes);
+		mGPUBytes = bytes;
+
+		if (mReadbackSlots.empty())
+			mReadbackSlots.resize(sReadbackRingSize);
 	}
 
 	void OpenGLFramebuffer::Bind()
@@ -273,6 +290,27 @@ namespace TS_ENGINE {
 		glClearTexImage(mColorAttachments[attachmentIndex], 0, Utils::TsFramebufferTextureFormatToGL(spec.TextureFormat), GL_INT, &value);
 	}
 
+	void OpenGLFramebuffer::ClearAttachmentRegion(uint32_t attachmentIndex, int value, int x, int y, int width, int height)
+	{
+		TS_CORE_ASSERT(attachmentIndex < mColorAttachments.size());
+
+		auto& spec = mColorAttachmentSpecifications[attachmentIndex];
+		glClearTexSubImage(mColorAttachments[attachmentIndex], 0, x, y, 0, width, height, 1, Utils::TsFramebufferTextureFormatToGL(spec.TextureFormat), GL_INT, &value);
+	}
+
+	void OpenGLFramebuffer::SetDrawAttachments(const std::vector<uint32_t>& attachmentIndices)
+	{
+		GLenum buffers[4] = { GL_NONE, GL_NONE, GL_NONE, GL_NONE };
+
+		for (uint32_t attachmentIndex : attachmentIndices)
+		{
+			TS_CORE_ASSERT(attachmentIndex < mColorAttachments.size() && attachmentIndex < 4);
+			buffers[attachmentIndex] = GL_COLOR_ATTACHMENT0 + attachmentIndex;
+		}
+
+		glNamedFramebufferDrawBuffers(mRendererID, (GLsizei)mColorAttachments.size(), buffers);
+	}
+
 	uint32_t OpenGLFramebuffer::GetColorAttachmentRendererID(uint32_t index) const
 	{
 		TS_CORE_ASSERT(index < mColorAttachments.size());
@@ -299,4 +337,238 @@ namespace TS_ENGINE {
 
 		return framebufferImage;
 	}
-}
\ No newline at end of file
+
+	void OpenGLFramebuffer::IssueReadback(uint32_t attachmentIndex, int x, int y, int width, int height, GLenum format, GLenum type, uint32_t size, ReadbackHandler handler)
+	{
+		TS_CORE_ASSERT(attachmentIndex < mColorAttachments.size());
+
+		ReadbackSlot& slot = mReadbackSlots[mNextReadbackSlot];
+		mNextReadbackSlot = (mNextReadbackSlot + 1) % sReadbackRingSize;
+
+		// Ring is full, the oldest readback has to finish before its buffer is reused
+		if (slot.fence)
+			CompleteReadback(slot, true);
+
+		if (slot.capacity < size)
+		{
+			if (slot.pixelBuffer)
+				glDeleteBuffers(1, &slot.pixelBuffer);
+
+			glCreateBuffers(1, &slot.pixelBuffer);
+			glNamedBufferData(slot.pixelBuffer, size, nullptr, GL_STREAM_READ);
+			slot.capacity = size;
+		}
+
+		GLint previousReadFramebuffer = 0;
+		glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousReadFramebuffer);
+
+		// With a pack buffer bound, glReadPixels only queues the copy
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, mRendererID);
+		glReadBuffer(GL_COLOR_ATTACHMENT0 + attachmentIndex);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pixelBuffer);
+		glReadPixels(x, y, width, height, format, type, nullptr);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, previousReadFramebuffer);
+
+		slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		slot.size = size;
+		slot.handler = std::move(handler);
+
+		sReadbackFramebuffers.insert(this);
+	}
+
+	bool OpenGLFramebuffer::CompleteReadback(ReadbackSlot& slot, bool wait)
+	{
+		GLenum result = glClientWaitSync(slot.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? GL_TIMEOUT_IGNORED : 0);
+
+		if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+			return false;
+
+		glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+
+		const uint8_t* data = static_cast<const uint8_t*>(glMapNamedBufferRange(slot.pixelBuffer, 0, slot.size, GL_MAP_READ_BIT));
+
+		if (data)
+		{
+			slot.handler(data, slot.size);
+			glUnmapNamedBuffer(slot.pixelBuffer);
+		}
+		else
+		{
+			TS_CORE_ERROR("Failed to map readback buffer");
+			slot.handler(nullptr, 0);
+		}
+
+		slot.handler = nullptr;
+		return true;
+	}
+
+	void OpenGLFramebuffer::ProcessReadbacks()
+	{
+		// Oldest first, stop at the first one the GPU hasn't finished so results stay in order
+		for (uint32_t i = 0; i < mReadbackSlots.size(); i++)
+		{
+			ReadbackSlot& slot = mReadbackSlots[(mNextReadbackSlot + i) % sReadbackRingSize];
+
+			if (!slot.fence)
+				continue;
+
+			if (!CompleteReadback(slot, false))
+				return;
+		}
+
+		sReadbackFramebuffers.erase(this);
+	}
+
+	void OpenGLFramebuffer::ReleaseReadbacks()
+	{
+		sReadbackFramebuffers.erase(this);
+
+		// Oldest first, so results arrive in the order they were requested
+		for (uint32_t i = 0; i < mReadbackSlots.size(); i++)
+		{
+			ReadbackSlot& slot = mReadbackSlots[(mNextReadbackSlot + i) % sReadbackRingSize];
+
+			if (slot.fence)
+				CompleteReadback(slot, true);
+		}
+
+		for (auto& slot : mReadbackSlots)
+		{
+			if (slot.pixelBuffer)
+				glDeleteBuffers(1, &slot.pixelBuffer);
+		}
+
+		mReadbackSlots.clear();
+	}
+
+	void OpenGLFramebuffer::ReadPixelAsync(uint32_t attachmentIndex, int x, int y, const std::function<void(int)>& callback)
+	{
+		IssueReadback(attachmentIndex, x, y, 1, 1, GL_RED_INTEGER, GL_INT, sizeof(int), [callback](const uint8_t* data, uint32_t size)
+			{
+				if (!data)
+					return;
+
+				int pixelData;
+				memcpy(&pixelData, data, sizeof(int));
+				callback(pixelData);
+			});
+	}
+
+	std::future<int> OpenGLFramebuffer::ReadPixelAsync(uint32_t attachmentIndex, int x, int y)
+	{
+		auto promise = CreateRef<std::promise<int>>();
+		std::future<int> future = promise->get_future();
+		IssueReadback(attachmentIndex, x, y, 1, 1, GL_RED_INTEGER, GL_INT, sizeof(int), [promise](const uint8_t* data, uint32_t size)
+			{
+				if (!data)
+				{
+					promise->set_exception(std::make_exception_ptr(std::runtime_error("Framebuffer readback failed")));
+					return;
+				}
+
+				int pixelData;
+				memcpy(&pixelData, data, sizeof(int));
+				promise->set_value(pixelData);
+			});
+
+		return future;
+	}
+
+	void OpenGLFramebuffer::ReadPixelColorAsync(uint32_t attachmentIndex, int x, int y, const std::function<void(Vector4)>& callback)
+	{
+		IssueReadback(attachmentIndex, x, y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, 4, [callback](const uint8_t* data, uint32_t size)
+			{
+				if (data)
+					callback(Vector4(data[0], data[1], data[2], data[3]));
+			});
+	}
+
+	void OpenGLFramebuffer::IssueImageReadback(int startX, int startY, const std::function<void(Ref<Image>)>& callback)
+	{
+		int width = (int)mSpecification.Width;
+		int height = (int)mSpecification.Height;
+
+		IssueReadback(0, startX, startY, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 4 * width * height, [callback, width, height](const uint8_t* data, uint32_t size)
+			{
+				// The mapped buffer is reused by the ring, so the pixels are copied before leaving the main thread
+				Ref<Image> framebufferImage = nullptr;
+
+				if (data)
+				{
+					framebufferImage = CreateRef<Image>();
+					framebufferImage->pixels.assign(data, data + size);
+					framebufferImage->width = width;
+					framebufferImage->height = height;
+				}
+
+				JobSystem::GetInstance()->Submit([callback, framebufferImage]() { callback(framebufferImage); });
+			});
+	}
+
+	void OpenGLFramebuffer::GetFrameBufferImageAsync(int startX, int startY, const std::function<void(Ref<Image>)>& callback)
+	{
+		IssueImageReadback(startX, startY, [callback](Ref<Image> image)
+			{
+				if (image)
+					callback(image);
+			});
+	}
+
+	std::future<Ref<Image>> OpenGLFramebuffer::GetFrameBufferImageAsync(int startX, int startY)
+	{
+		auto promise = CreateRef<std::promise<Ref<Image>>>();
+		std::future<Ref<Image>> future = promise->get_future();
+
+		IssueImageReadback(startX, startY, [promise](Ref<Image> image)
+			{
+				if (image)
+					promise->set_value(image);
+				else
+					promise->set_exception(std::make_exception_ptr(std::runtime_error("Framebuffer readback failed")));
+			});
+
+		return future;
+	}
+
+	std::future<bool> OpenGLFramebuffer::SaveFramebufferToFileAsync(const std::string& _filepath)
+	{
+		auto promise = CreateRef<std::promise<bool>>();
+		std::future<bool> future = promise->get_future();
+
+		IssueImageReadback(0, 0, [promise, _filepath](Ref<Image> image)
+			{
+				if (!image)
+				{
+					TS_CORE_ERROR("Failed to read framebuffer for file: {0}", _filepath);
+					promise->set_value(false);
+					return;
+				}
+
+				// Flip the image vertically since OpenGL's origin is bottom-left and most image formats expect top-left
+				uint32_t rowSize = 4 * image->width;
+				std::vector<uint8_t> flippedPixels(image->pixels.size());
+
+				for (int y = 0; y < image->height; y++)
+				{
+					memcpy(&flippedPixels[rowSize * y], &image->pixels[rowSize * (image->height - 1 - y)], rowSize);
+				}
+
+				bool saved = stbi_write_png(_filepath.c_str(), image->width, image->height, 4, flippedPixels.data(), rowSize) != 0;
+
+				if (!saved)
+				{
+					TS_CORE_ERROR("Failed to save framebuffer to file: {0}", _filepath);
+				}
+				else
+				{
+					TS_CORE_INFO("Framebuffer saved to: {0}", _filepath);
+				}
+
+				promise->set_value(saved);
+			});
+
+		return future;
+	}
+}
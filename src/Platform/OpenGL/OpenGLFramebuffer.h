@@ -25,13 +25,47 @@ namespace TS_ENGINE {
 
 		virtual void ClearAttachment(uint32_t attachmentIndex, int value) override;
 
+		virtual void ClearAttachmentRegion(uint32_t attachmentIndex, int value, int x, int y, int width, int height) override;
+
+		virtual void SetDrawAttachments(const std::vector<uint32_t>& attachmentIndices) override;
+
 		virtual uint32_t GetColorAttachmentRendererID(uint32_t index) const override;
+		virtual uint32_t GetDepthAttachmentRendererID() const override { return mDepthAttachment; }
 
 		virtual const FramebufferSpecification& GetSpecification() const override;
 
 		virtual Ref<Image> GetFrameBufferImage(int startX, int startY) override;
 
+		virtual void ReadPixelAsync(uint32_t attachmentIndex, int x, int y, const std::function<void(int)>& callback) override;
+		virtual std::future<int> ReadPixelAsync(uint32_t attachmentIndex, int x, int y) override;
+		virtual void ReadPixelColorAsync(uint32_t attachmentIndex, int x, int y, const std::function<void(Vector4)>& callback) override;
+		virtual void GetFrameBufferImageAsync(int startX, int startY, const std::function<void(Ref<Image>)>& callback) override;
+		virtual std::future<Ref<Image>> GetFrameBufferImageAsync(int startX, int startY) override;
+		virtual std::future<bool> SaveFramebufferToFileAsync(const std::string& _filepath) override;
+		virtual void ProcessReadbacks() override;
+
 	private:
+		// Called on the main thread with the mapped pixel data, or with nullptr if the readback failed
+		typedef std::function<void(const uint8_t* data, uint32_t size)> ReadbackHandler;
+
+		struct ReadbackSlot
+		{
+			uint32_t pixelBuffer = 0;
+			uint32_t capacity = 0;
+			GLsync fence = nullptr;
+			uint32_t size = 0;
+			ReadbackHandler handler;
+		};
+
+		// Queues glReadPixels into the next pixel buffer of the ring
+		void IssueReadback(uint32_t attachmentIndex, int x, int y, int width, int height, GLenum format, GLenum type, uint32_t size, ReadbackHandler handler);
+		// Maps the slot's buffer, runs its handler and frees the slot. Waits for the fence if wait is true.
+		bool CompleteReadback(ReadbackSlot& slot, bool wait);
+		// Waits for the readbacks in flight and delivers them before deleting the ring
+		void ReleaseReadbacks();
+		// Full color attachment readback. The callback runs on a worker thread and gets nullptr if the readback failed.
+		void IssueImageReadback(int startX, int startY, const std::function<void(Ref<Image>)>& callback);
+
 		uint32_t mRendererID = 0;
 		FramebufferSpecification mSpecification;
 
@@ -40,5 +74,9 @@ namespace TS_ENGINE {
 
 		std::vector<uint32_t> mColorAttachments;
 		uint32_t mDepthAttachment = 0;
+		uint64_t mGPUBytes = 0;					// Of the attachments, accounted with the GPUMemoryManager
+
+		std::vector<ReadbackSlot> mReadbackSlots;
+		uint32_t mNextReadbackSlot = 0;			// Oldest slot, the next one to be reused
 	};
 }
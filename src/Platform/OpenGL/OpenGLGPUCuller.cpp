@@ -0,0 +1,487 @@
+#include "tspch.h"
+#include "Platform/OpenGL/OpenGLGPUCuller.h"
+#include "Renderer/Frustum.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+// GL 4.6 / ARB_indirect_parameters, not part of the 4.5 loader
+#ifndef GL_PARAMETER_BUFFER
+#define GL_PARAMETER_BUFFER 0x80EE
+#endif
+
+namespace TS_ENGINE {
+
+	typedef void (APIENTRYP PFNMULTIDRAWELEMENTSINDIRECTCOUNTPROC)(GLenum mode, GLenum type, const void* indirect, GLintptr drawcount, GLsizei maxdrawcount, GLsizei stride);
+	static PFNMULTIDRAWELEMENTSINDIRECTCOUNTPROC sMultiDrawElementsIndirectCount = nullptr;
+	static bool sMultiDrawElementsIndirectCountLoaded = false;
+
+	static const uint32_t sCullGroupSize = 64;
+	static const uint32_t sDepthReduceGroupSize = 8;
+
+	static const char* sCullShaderSource = R"(
+#version 450 core
+layout(local_size_x = 64) in;
+
+struct Instance
+{
+	vec4 boundsMin;
+	vec4 boundsMax;
+	uint indexCount;
+	uint firstIndex;
+	int baseVertex;
+	uint drawGroup;
+	uint groupSlot;
+	uint padding0;
+	uint padding1;
+	uint padding2;
+};
+
+struct DrawCommand
+{
+	uint count;
+	uint instanceCount;
+	uint firstIndex;
+	int baseVertex;
+	uint baseInstance;
+};
+
+layout(std430, binding = 0) readonly buffer Instances { Instance instances[]; };
+layout(std430, binding = 1) readonly buffer GroupOffsets { uint groupOffsets[]; };
+layout(std430, binding = 2) buffer GroupCounts { uint groupCounts[]; };
+layout(std430, binding = 3) writeonly buffer Commands { DrawCommand commands[]; };
+
+layout(binding = 0) uniform sampler2D u_DepthPyramid;
+
+uniform uint u_InstanceCount;
+uniform vec4 u_FrustumPlanes[6];
+uniform bool u_UseDepthPyramid;
+uniform mat4 u_DepthProjectionView;
+uniform int u_DepthPyramidLevels;
+uniform bool u_Compact;
+
+bool IsInFrustum(vec3 boundsMin, vec3 boundsMax)
+{
+	vec3 center = (boundsMin + boundsMax) * 0.5;
+	vec3 extents = (boundsMax - boundsMin) * 0.5;
+
+	for (int i = 0; i < 6; i++)
+	{
+		vec4 plane = u_FrustumPlanes[i];
+
+		if (dot(plane.xyz, center) + plane.w + dot(abs(plane.xyz), extents) < 0.0)
+			return false;
+	}
+
+	return true;
+}
+
+bool IsOccluded(vec3 boundsMin, vec3 boundsMax)
+{
+	ivec2 size = textureSize(u_DepthPyramid, 0);
+	vec2 screenMin = vec2(1e30);
+	vec2 screenMax = vec2(-1e30);
+	float minDepth = 1.0;
+
+	for (int i = 0; i < 8; i++)
+	{
+		vec3 corner = vec3((i & 1) != 0 ? boundsMax.x : boundsMin.x, (i & 2) != 0 ? boundsMax.y : boundsMin.y, (i & 4) != 0 ? boundsMax.z : boundsMin.z);
+		vec4 clip = u_DepthProjectionView * vec4(corner, 1.0);
+
+		// Crosses the near plane of the previous frame
+		if (clip.w < 1e-4 || clip.z < -clip.w)
+			return false;
+
+		vec3 ndc = clip.xyz / clip.w;
+		vec2 screen = (ndc.xy * 0.5 + 0.5) * vec2(size);
+		screenMin = min(screenMin, screen);
+		screenMax = max(screenMax, screen);
+		minDepth = min(minDepth, ndc.z * 0.5 + 0.5);
+	}
+
+	if (screenMax.x < 0.0 || screenMax.y < 0.0 || screenMin.x >= float(size.x) || screenMin.y >= float(size.y))
+		return false;
+
+	ivec2 texelMin = clamp(ivec2(floor(screenMin)), ivec2(0), size - 1);
+	ivec2 texelMax = clamp(ivec2(floor(screenMax)), ivec2(0), size - 1);
+	ivec2 extent = texelMax - texelMin + 1;
+
+	// Level where the rectangle spans at most 2x2 texels
+	int level = min(int(ceil(log2(float(max(extent.x, extent.y))))), u_DepthPyramidLevels - 1);
+	ivec2 levelSize = textureSize(u_DepthPyramid, level);
+	ivec2 a = min(texelMin >> level, levelSize - 1);
+	ivec2 b = min(texelMax >> level, levelSize - 1);
+
+	float maxDepth = max(
+		max(texelFetch(u_DepthPyramid, a, level).r, texelFetch(u_DepthPyramid, ivec2(b.x, a.y), level).r),
+		max(texelFetch(u_DepthPyramid, ivec2(a.x, b.y), level).r, texelFetch(u_DepthPyramid, b, level).r));
+
+	return minDepth > maxDepth;
+}
+
+void main()
+{
+	uint id = gl_GlobalInvocationID.x;
+
+	if (id >= u_InstanceCount)
+		return;
+
+	Instance instance = instances[id];
+	bool visible = IsInFrustum(instance.boundsMin.xyz, instance.boundsMax.xyz);
+
+	if (visible && u_UseDepthPyramid)
+		visible = !IsOccluded(instance.boundsMin.xyz, instance.boundsMax.xyz);
+
+	DrawCommand command;
+	command.count = instance.indexCount;
+	command.instanceCount = 1u;
+	command.firstIndex = instance.firstIndex;
+	command.baseVertex = instance.baseVertex;
+	command.baseInstance = id;
+
+	if (u_Compact)
+	{
+		if (visible)
+		{
+			uint slot = atomicAdd(groupCounts[instance.drawGroup], 1u);
+			commands[groupOffsets[instance.drawGroup] + slot] = command;
+		}
+	}
+	else
+	{
+		// Without a GPU draw count every slot is drawn, culled ones with zero instances
+		command.instanceCount = visible ? 1u : 0u;
+		commands[groupOffsets[instance.drawGroup] + instance.groupSlot] = command;
+	}
+}
+)";
+
+	static const char* sDepthReduceShaderSource = R"(
+#version 450 core
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding = 0) uniform sampler2D u_Source;
+layout(r32f, binding = 0) writeonly uniform image2D u_Destination;
+
+uniform int u_SourceLevel;
+uniform bool u_Copy;
+
+void main()
+{
+	ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+	ivec2 size = imageSize(u_Destination);
+
+	if (texel.x >= size.x || texel.y >= size.y)
+		return;
+
+	if (u_Copy)
+	{
+		imageStore(u_Destination, texel, vec4(texelFetch(u_Source, texel, 0).r));
+		return;
+	}
+
+	// The last row and column also cover the texels left over by odd source sizes
+	ivec2 sourceSize = textureSize(u_Source, u_SourceLevel);
+	ivec2 first = texel * 2;
+	ivec2 last = min(first + 1, sourceSize - 1);
+
+	if (texel.x == size.x - 1)
+		last.x = sourceSize.x - 1;
+
+	if (texel.y == size.y - 1)
+		last.y = sourceSize.y - 1;
+
+	float depth = 0.0;
+
+	for (int y = first.y; y <= last.y; y++)
+	{
+		for (int x = first.x; x <= last.x; x++)
+			depth = max(depth, texelFetch(u_Source, ivec2(x, y), u_SourceLevel).r);
+	}
+
+	imageStore(u_Destination, texel, vec4(depth));
+}
+)";
+
+	OpenGLGPUCuller::OpenGLGPUCuller() :
+		mDepthProjectionViewMatrix(Matrix4(1))
+	{
+		mCullProgram = CreateComputeProgram("GPUCull", sCullShaderSource);
+		mDepthReduceProgram = CreateComputeProgram("DepthReduce", sDepthReduceShaderSource);
+
+		if (!sMultiDrawElementsIndirectCountLoaded)
+		{
+			sMultiDrawElementsIndirectCountLoaded = true;
+
+			if (GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 6))
+				sMultiDrawElementsIndirectCount = (PFNMULTIDRAWELEMENTSINDIRECTCOUNTPROC)glfwGetProcAddress("glMultiDrawElementsIndirectCount");
+			else if (glfwExtensionSupported("GL_ARB_indirect_parameters"))
+				sMultiDrawElementsIndirectCount = (PFNMULTIDRAWELEMENTSINDIRECTCOUNTPROC)glfwGetProcAddress("glMultiDrawElementsIndirectCountARB");
+
+			TS_CORE_INFO("GPU culling draw count: {0}", sMultiDrawElementsIndirectCount ? "glMultiDrawElementsIndirectCount" : "unsupported, drawing every slot");
+		}
+	}
+
+	OpenGLGPUCuller::~OpenGLGPUCuller()
+	{
+		glDeleteProgram(mCullProgram);
+		glDeleteProgram(mDepthReduceProgram);
+
+		uint32_t buffers[] = { mInstanceBuffer, mGroupOffsetBuffer, mGroupCountBuffer, mCommandBuffer, mDrawInstanceBuffer, mDrawInstanceIndexBuffer, mDrawMaterialBuffer };
+		glDeleteBuffers(7, buffers);
+
+		if (mDepthPyramid)
+			glDeleteTextures(1, &mDepthPyramid);
+	}
+
+	bool OpenGLGPUCuller::IsSupported()
+	{
+		// Compute shaders and multi draw indirect are core since 4.3
+		return GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 3);
+	}
+
+	bool OpenGLGPUCuller::HasDrawCountSupport() const
+	{
+		return sMultiDrawElementsIndirectCount != nullptr;
+	}
+
+	uint32_t OpenGLGPUCuller::CreateComputeProgram(const char* name, const char* source)
+	{
+		GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+		glShaderSource(shader, 1, &source, NULL);
+		glCompileShader(shader);
+
+		int success;
+		GLchar infoLog[1024];
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+		if (!success)
+		{
+			glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+			TS_CORE_ERROR("ERROR::SHADER_COMPILATION_ERROR of type: COMPUTE ({0})\n{1}", name, infoLog);
+		}
+
+		GLuint program = glCreateProgram();
+		glAttachShader(program, shader);
+		glLinkProgram(program);
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+		if (!success)
+		{
+			glGetProgramInfoLog(program, 1024, NULL, infoLog);
+			TS_CORE_ERROR("ERROR::PROGRAM_LINKING_ERROR of type: COMPUTE ({0})\n{1}", name, infoLog);
+		}
+
+		glDeleteShader(shader);
+		return program;
+	}
+
+	void OpenGLGPUCuller::ReserveBuffer(uint32_t& buffer, uint32_t& capacity, uint32_t size)
+	{
+		if (buffer && capacity >= size)
+			return;
+
+		if (buffer)
+			glDeleteBuffers(1, &buffer);
+
+		capacity = std::max(size, 64u);
+		glCreateBuffers(1, &buffer);
+		glNamedBufferStorage(buffer, capacity, nullptr, GL_DYNAMIC_STORAGE_BIT);
+	}
+
+	void OpenGLGPUCuller::SetInstances(std::vector<GPUCullInstance>& instances, const std::vector<GPUDrawInstance>& drawInstances,
+		const std::vector<GPUDrawMaterial>& drawMaterials, uint32_t numDrawGroups)
+	{
+		TS_CORE_ASSERT(drawInstances.size() == instances.size());
+		mInstanceCount = (uint32_t)instances.size();
+
+		// Lay groups out one after another in the command buffer
+		mGroupSizes.assign(numDrawGroups, 0);
+
+		for (auto& instance : instances)
+		{
+			TS_CORE_ASSERT(instance.drawGroup < numDrawGroups);
+			instance.groupSlot = mGroupSizes[instance.drawGroup]++;
+		}
+
+		mGroupOffsets.resize(numDrawGroups);
+		uint32_t offset = 0;
+
+		for (uint32_t group = 0; group < numDrawGroups; group++)
+		{
+			mGroupOffsets[group] = offset;
+			offset += mGroupSizes[group];
+		}
+
+		ReserveBuffer(mInstanceBuffer, mInstanceBufferCapacity, (uint32_t)(instances.size() * sizeof(GPUCullInstance)));
+		ReserveBuffer(mGroupOffsetBuffer, mGroupOffsetBufferCapacity, numDrawGroups * sizeof(uint32_t));
+		ReserveBuffer(mGroupCountBuffer, mGroupCountBufferCapacity, numDrawGroups * sizeof(uint32_t));
+		ReserveBuffer(mCommandBuffer, mCommandBufferCapacity, (uint32_t)(instances.size() * sizeof(DrawElementsIndirectCommand)));
+		ReserveBuffer(mDrawInstanceBuffer, mDrawInstanceBufferCapacity, (uint32_t)(drawInstances.size() * sizeof(GPUDrawInstance)));
+		ReserveBuffer(mDrawMaterialBuffer, mDrawMaterialBufferCapacity, (uint32_t)(drawMaterials.size() * sizeof(GPUDrawMaterial)));
+
+		// The indices only grow, so they are rewritten when the buffer is replaced
+		uint32_t previousIndexBuffer = mDrawInstanceIndexBuffer;
+		ReserveBuffer(mDrawInstanceIndexBuffer, mDrawInstanceIndexBufferCapacity, mInstanceCount * sizeof(uint32_t));
+
+		if (mDrawInstanceIndexBuffer != previousIndexBuffer)
+		{
+			std::vector<uint32_t> indices(mDrawInstanceIndexBufferCapacity / sizeof(uint32_t));
+
+			for (uint32_t i = 0; i < (uint32_t)indices.size(); i++)
+				indices[i] = i;
+
+			glNamedBufferSubData(mDrawInstanceIndexBuffer, 0, indices.size() * sizeof(uint32_t), indices.data());
+		}
+
+		if (!instances.empty())
+		{
+			glNamedBufferSubData(mInstanceBuffer, 0, instances.size() * sizeof(GPUCullInstance), instances.data());
+			glNamedBufferSubData(mDrawInstanceBuffer, 0, drawInstances.size() * sizeof(GPUDrawInstance), drawInstances.data());
+		}
+
+		if (!drawMaterials.empty())
+			glNamedBufferSubData(mDrawMaterialBuffer, 0, drawMaterials.size() * sizeof(GPUDrawMaterial), drawMaterials.data());
+
+		if (numDrawGroups > 0)
+			glNamedBufferSubData(mGroupOffsetBuffer, 0, numDrawGroups * sizeof(uint32_t), mGroupOffsets.data());
+	}
+
+	void OpenGLGPUCuller::BuildDepthPyramid(uint32_t depthTextureID, uint32_t width, uint32_t height, const Matrix4& depthProjectionViewMatrix)
+	{
+		if (depthTextureID == 0 || width == 0 || height == 0)
+		{
+			mHasDepthPyramid = false;
+			return;
+		}
+
+		if (!mDepthPyramid || mDepthPyramidWidth != width || mDepthPyramidHeight != height)
+		{
+			if (mDepthPyramid)
+				glDeleteTextures(1, &mDepthPyramid);
+
+			mDepthPyramidWidth = width;
+			mDepthPyramidHeight = height;
+			mDepthPyramidLevels = 1 + (uint32_t)floor(log2((double)std::max(width, height)));
+
+			glCreateTextures(GL_TEXTURE_2D, 1, &mDepthPyramid);
+			glTextureStorage2D(mDepthPyramid, mDepthPyramidLevels, GL_R32F, width, height);
+			glTextureParameteri(mDepthPyramid, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+			glTextureParameteri(mDepthPyramid, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTextureParameteri(mDepthPyramid, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTextureParameteri(mDepthPyramid, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		}
+
+		GLint previousProgram = 0;
+		glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+
+		glUseProgram(mDepthReduceProgram);
+		GLint sourceLevelLocation = glGetUniformLocation(mDepthReduceProgram, "u_SourceLevel");
+		GLint copyLocation = glGetUniformLocation(mDepthReduceProgram, "u_Copy");
+
+		// Level 0 is a copy of the depth texture, every other level keeps the max of the texels below it
+		for (uint32_t level = 0; level < mDepthPyramidLevels; level++)
+		{
+			uint32_t levelWidth = std::max(width >> level, 1u);
+			uint32_t levelHeight = std::max(height >> level, 1u);
+
+			glBindTextureUnit(0, level == 0 ? depthTextureID : mDepthPyramid);
+			glBindImageTexture(0, mDepthPyramid, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+			glUniform1i(sourceLevelLocation, level == 0 ? 0 : (int)level - 1);
+			glUniform1i(copyLocation, level == 0 ? 1 : 0);
+
+			glDispatchCompute((levelWidth + sDepthReduceGroupSize - 1) / sDepthReduceGroupSize, (levelHeight + sDepthReduceGroupSize - 1) / sDepthReduceGroupSize, 1);
+			glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+		}
+
+		glBindTextureUnit(0, 0);
+		glUseProgram(previousProgram);
+
+		mDepthProjectionViewMatrix = depthProjectionViewMatrix;
+		mHasDepthPyramid = true;
+	}
+
+	void OpenGLGPUCuller::Cull(const Matrix4& projectionViewMatrix)
+	{
+		if (mInstanceCount == 0)
+			return;
+
+		GLint previousProgram = 0;
+		glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+
+		Frustum frustum(projectionViewMatrix);
+		Vector4 planes[Frustum::COUNT];
+
+		for (int i = 0; i < Frustum::COUNT; i++)
+			planes[i] = frustum.GetPlane((Frustum::Plane)i);
+
+		uint32_t zero = 0;
+		glClearNamedBufferData(mGroupCountBuffer, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+
+		glUseProgram(mCullProgram);
+		glUniform1ui(glGetUniformLocation(mCullProgram, "u_InstanceCount"), mInstanceCount);
+		glUniform4fv(glGetUniformLocation(mCullProgram, "u_FrustumPlanes"), Frustum::COUNT, glm::value_ptr(planes[0]));
+		glUniform1i(glGetUniformLocation(mCullProgram, "u_UseDepthPyramid"), mHasDepthPyramid ? 1 : 0);
+		glUniformMatrix4fv(glGetUniformLocation(mCullProgram, "u_DepthProjectionView"), 1, GL_FALSE, glm::value_ptr(mDepthProjectionViewMatrix));
+		glUniform1i(glGetUniformLocation(mCullProgram, "u_DepthPyramidLevels"), (int)mDepthPyramidLevels);
+		glUniform1i(glGetUniformLocation(mCullProgram, "u_Compact"), HasDrawCountSupport() ? 1 : 0);
+
+		if (mHasDepthPyramid)
+			glBindTextureUnit(0, mDepthPyramid);
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mInstanceBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, mGroupOffsetBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, mGroupCountBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, mCommandBuffer);
+
+		glDispatchCompute((mInstanceCount + sCullGroupSize - 1) / sCullGroupSize, 1, 1);
+
+		// Commands and counts are read by the indirect draws
+		glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+		if (mHasDepthPyramid)
+			glBindTextureUnit(0, 0);
+
+		glUseProgram(previousProgram);
+	}
+
+	void OpenGLGPUCuller::DrawGroup(uint32_t drawGroup, IndexType indexType)
+	{
+		TS_CORE_ASSERT(drawGroup < mGroupSizes.size());
+
+		if (mGroupSizes[drawGroup] == 0)
+			return;
+
+		GLenum type = indexType == IndexType::UINT16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+		const void* commandOffset = (const void*)(uintptr_t)(mGroupOffsets[drawGroup] * sizeof(DrawElementsIndirectCommand));
+
+		// Each command's base instance selects its a_DrawInstance, which is the index of its draw instance
+		GLint vertexArray = 0;
+		glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertexArray);
+
+		glEnableVertexArrayAttrib(vertexArray, sDrawInstanceLocation);
+		glVertexArrayAttribIFormat(vertexArray, sDrawInstanceLocation, 1, GL_UNSIGNED_INT, 0);
+		glVertexArrayAttribBinding(vertexArray, sDrawInstanceLocation, sDrawInstanceLocation);
+		glVertexArrayBindingDivisor(vertexArray, sDrawInstanceLocation, 1);
+		glVertexArrayVertexBuffer(vertexArray, sDrawInstanceLocation, mDrawInstanceIndexBuffer, 0, sizeof(uint32_t));
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, sDrawInstanceBinding, mDrawInstanceBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, sDrawMaterialBinding, mDrawMaterialBuffer);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, mCommandBuffer);
+
+		if (HasDrawCountSupport())
+		{
+			glBindBuffer(GL_PARAMETER_BUFFER, mGroupCountBuffer);
+			sMultiDrawElementsIndirectCount(GL_TRIANGLES, type, commandOffset, drawGroup * sizeof(uint32_t), mGroupSizes[drawGroup], 0);
+			glBindBuffer(GL_PARAMETER_BUFFER, 0);
+		}
+		else
+		{
+			glMultiDrawElementsIndirect(GL_TRIANGLES, type, commandOffset, mGroupSizes[drawGroup], 0);
+		}
+
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+		// Other draws of the vertex array don't read it
+		glDisableVertexArrayAttrib(vertexArray, sDrawInstanceLocation);
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "Renderer/GPUCuller.h"
+
+namespace TS_ENGINE {
+
+	class OpenGLGPUCuller : public GPUCuller
+	{
+	public:
+		OpenGLGPUCuller();
+		virtual ~OpenGLGPUCuller();
+
+		virtual void SetInstances(std::vector<GPUCullInstance>& instances, const std::vector<GPUDrawInstance>& drawInstances,
+			const std::vector<GPUDrawMaterial>& drawMaterials, uint32_t numDrawGroups) override;
+		virtual void BuildDepthPyramid(uint32_t depthTextureID, uint32_t width, uint32_t height, const Matrix4& depthProjectionViewMatrix) override;
+		virtual void InvalidateDepthPyramid() override { mHasDepthPyramid = false; }
+		virtual void Cull(const Matrix4& projectionViewMatrix) override;
+		virtual void DrawGroup(uint32_t drawGroup, IndexType indexType) override;
+
+		virtual uint32_t GetInstanceCount() const override { return mInstanceCount; }
+		virtual bool HasDrawCountSupport() const override;
+
+		static bool IsSupported();
+	private:
+		static uint32_t CreateComputeProgram(const char* name, const char* source);
+		// Grows the buffer to at least size bytes, contents are not kept
+		static void ReserveBuffer(uint32_t& buffer, uint32_t& capacity, uint32_t size);
+
+		uint32_t mCullProgram = 0;
+		uint32_t mDepthReduceProgram = 0;
+
+		uint32_t mInstanceBuffer = 0;
+		uint32_t mInstanceBufferCapacity = 0;
+		uint32_t mGroupOffsetBuffer = 0;
+		uint32_t mGroupOffsetBufferCapacity = 0;
+		uint32_t mGroupCountBuffer = 0;
+		uint32_t mGroupCountBufferCapacity = 0;
+		uint32_t mCommandBuffer = 0;
+		uint32_t mCommandBufferCapacity = 0;
+		uint32_t mDrawInstanceBuffer = 0;
+		uint32_t mDrawInstanceBufferCapacity = 0;
+		uint32_t mDrawInstanceIndexBuffer = 0;		// 0, 1, 2.., read as a_DrawInstance at each command's base instance
+		uint32_t mDrawInstanceIndexBufferCapacity = 0;
+		uint32_t mDrawMaterialBuffer = 0;
+		uint32_t mDrawMaterialBufferCapacity = 0;
+
+		uint32_t mInstanceCount = 0;
+		std::vector<uint32_t> mGroupOffsets;		// First command of each group
+		std::vector<uint32_t> mGroupSizes;
+
+		uint32_t mDepthPyramid = 0;					// R32F, each texel is the farthest depth below it
+		uint32_t mDepthPyramidWidth = 0;
+		uint32_t mDepthPyramidHeight = 0;
+		uint32_t mDepthPyramidLevels = 0;
+		Matrix4 mDepthProjectionViewMatrix;
+		bool mHasDepthPyramid = false;
+	};
+}
@@ -0,0 +1,31 @@
+#include "tspch.h"
+#include "Platform/OpenGL/OpenGLGPUMemory.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+// NVX_gpu_memory_info and ATI_meminfo, not part of the 4.5 loader
+#define GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX 0x9047
+#define GL_TEXTURE_FREE_MEMORY_ATI 0x87FC
+
+namespace TS_ENGINE {
+
+	uint64_t OpenGLGPUMemoryManager::QueryDeviceMemory()
+	{
+		// In kilobytes, ATI reports four values of which the first is the total free memory
+		GLint kilobytes[4] = {};
+
+		if (glfwExtensionSupported("GL_NVX_gpu_memory_info"))
+		{
+			glGetIntegerv(GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, kilobytes);
+			return (uint64_t)kilobytes[0] << 10;
+		}
+
+		if (glfwExtensionSupported("GL_ATI_meminfo"))
+		{
+			glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, kilobytes);
+			return ((uint64_t)kilobytes[0] << 10) + GetTotalUsage();
+		}
+
+		return 0;
+	}
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include "Renderer/GPUMemory.h"
+
+namespace TS_ENGINE {
+
+	class OpenGLGPUMemoryManager : public GPUMemoryManager
+	{
+	public:
+		OpenGLGPUMemoryManager() = default;
+		virtual ~OpenGLGPUMemoryManager() = default;
+	protected:
+		// NVX_gpu_memory_info, or ATI_meminfo's free memory plus what's already allocated
+		virtual uint64_t QueryDeviceMemory() override;
+	};
+}
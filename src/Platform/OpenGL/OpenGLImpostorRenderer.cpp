@@ -0,0 +1,549 @@
+#include "tspch.h"
+#include "Platform/OpenGL/OpenGLImpostorRenderer.h"
+#include "Application.h"
+#include "SceneManager/Node.h"
+#include "Primitive/Model.h"
+#include "Renderer/RenderCommand.h"
+#include <glad/glad.h>
+
+namespace TS_ENGINE {
+
+	static const uint32_t sMaxBakeBones = 200;
+	static const int sAlbedoMaxMipLevel = 4;	// Stops at 8 pixel cells, lower levels would mix neighbouring views
+
+	// Same bone blend as the scene shader and Mesh::ComputePosedPositions: skinned positions come out in world space
+	static const char* sBakeVertexShaderSource = R"(
+		#version 450 core
+
+		layout(location = 0) in vec3 a_Position;
+		layout(location = 1) in vec2 a_TexCoord;
+		layout(location = 2) in vec3 a_Normal;
+		layout(location = 3) in ivec4 a_BoneIds;
+		layout(location = 4) in vec4 a_Weights;
+
+		const int MAX_BONES = 200;
+
+		uniform mat4 u_Model;
+		uniform mat4 u_View;
+		uniform mat4 u_Projection;
+		uniform mat4 u_RootFromWorld;
+		uniform mat4 u_Bones[MAX_BONES];
+		uniform int u_BoneCount;
+		uniform int u_Skinned;
+
+		out vec2 v_TexCoord;
+		out vec3 v_Normal;
+		out float v_ViewDepth;
+
+		void main()
+		{
+			vec4 worldPosition = u_Model * vec4(a_Position, 1.0);
+			vec3 worldNormal = mat3(transpose(inverse(u_Model))) * a_Normal;
+
+			if (u_Skinned != 0)
+			{
+				vec4 posedPosition = vec4(0.0);
+				vec3 posedNormal = vec3(0.0);
+				float totalWeight = 0.0;
+
+				for (int i = 0; i < 4; i++)
+				{
+					int boneId = a_BoneIds[i];
+
+					if (boneId < 0 || boneId >= u_BoneCount)
+						continue;
+
+					posedPosition += a_Weights[i] * (u_Bones[boneId] * vec4(a_Position, 1.0));
+					posedNormal += a_Weights[i] * (mat3(u_Bones[boneId]) * a_Normal);
+					totalWeight += a_Weights[i];
+				}
+
+				if (totalWeight > 0.0)
+				{
+					worldPosition = posedPosition;
+					worldNormal = posedNormal;
+				}
+			}
+
+			vec4 viewPosition = u_View * worldPosition;
+			v_ViewDepth = -viewPosition.z;
+			v_TexCoord = a_TexCoord;
+			v_Normal = mat3(u_RootFromWorld) * worldNormal;
+			gl_Position = u_Projection * viewPosition;
+		}
+	)";
+
+	// Albedo is the material's diffuse color and map without lighting, the draw lights it with the baked normals
+	static const char* sBakeFragmentShaderSource = R"(
+		#version 450 core
+
+		layout(binding = 0) uniform sampler2D u_DiffuseMap;
+
+		uniform vec4 u_DiffuseColor;
+		uniform vec4 u_DiffuseMapTransform;	// Offset, tiling
+		uniform int u_HasDiffuseMap;
+		uniform vec2 u_DepthRange;			// Near plane, far minus near
+
+		in vec2 v_TexCoord;
+		in vec3 v_Normal;
+		in float v_ViewDepth;
+
+		layout(location = 0) out vec4 o_Albedo;
+		layout(location = 1) out vec4 o_NormalDepth;
+
+		void main()
+		{
+			vec4 albedo = u_DiffuseColor;
+
+			if (u_HasDiffuseMap != 0)
+				albedo *= texture(u_DiffuseMap, v_TexCoord * u_DiffuseMapTransform.zw + u_DiffuseMapTransform.xy);
+
+			float normalLength = length(v_Normal);
+			vec3 normal = normalLength > 0.0 ? v_Normal / normalLength : vec3(0.0, 1.0, 0.0);
+			float depth = clamp((v_ViewDepth - u_DepthRange.x) / u_DepthRange.y, 0.0, 1.0);
+
+			o_Albedo = vec4(albedo.rgb, 1.0);
+			// Alpha 0 is kept for empty texels
+			o_NormalDepth = vec4(normal * 0.5 + 0.5, mix(1.0 / 255.0, 1.0, depth));
+		}
+	)";
+
+	// The quad lies in the plane of the nearest baked view through the bounds center. The fragment moves along the view
+	// direction by the baked depth, clip space is linear in that offset so it is carried as a position plus a direction.
+	static const char* sDrawVertexShaderSource = R"(
+		#version 450 core
+
+		layout(location = 0) in vec2 a_Corner;
+		layout(location = 1) in mat4 a_InstanceMatrix;
+		layout(location = 5) in int a_EntityID;
+
+		uniform mat4 u_View;
+		uniform mat4 u_Projection;
+		uniform vec3 u_CameraPosition;
+		uniform vec4 u_Bounds;			// Root space center and radius
+		uniform ivec2 u_ViewCount;		// Yaw, pitch
+		uniform float u_PitchStep;		// Radians
+
+		out vec2 v_AtlasUV;
+		out vec4 v_ClipPosition;
+		flat out vec4 v_ClipDirection;
+		flat out mat3 v_NormalMatrix;
+		flat out int v_EntityID;
+
+		const float PI = 3.14159265359;
+
+		void main()
+		{
+			vec3 localCamera = (inverse(a_InstanceMatrix) * vec4(u_CameraPosition, 1.0)).xyz;
+			vec3 toCamera = localCamera - u_Bounds.xyz;
+			float toCameraLength = length(toCamera);
+			toCamera = toCameraLength > 0.0 ? toCamera / toCameraLength : vec3(0.0, 0.0, 1.0);
+
+			float yawStep = 2.0 * PI / float(u_ViewCount.x);
+			int yawView = int(mod(round(atan(toCamera.x, toCamera.z) / yawStep), float(u_ViewCount.x)));
+			int pitchView = clamp(int(round(asin(clamp(toCamera.y, -1.0, 1.0)) / u_PitchStep)), 0, u_ViewCount.y - 1);
+
+			float yaw = float(yawView) * yawStep;
+			float pitch = float(pitchView) * u_PitchStep;
+			vec3 viewDirection = vec3(cos(pitch) * sin(yaw), sin(pitch), cos(pitch) * cos(yaw));
+
+			// Same basis as the baking camera's look at
+			vec3 right = normalize(cross(-viewDirection, vec3(0.0, 1.0, 0.0)));
+			vec3 up = cross(right, -viewDirection);
+
+			vec3 rootPosition = u_Bounds.xyz + (right * a_Corner.x + up * a_Corner.y) * u_Bounds.w;
+			mat4 clipFromRoot = u_Projection * u_View * a_InstanceMatrix;
+
+			gl_Position = clipFromRoot * vec4(rootPosition, 1.0);
+			v_ClipPosition = gl_Position;
+			v_ClipDirection = clipFromRoot * vec4(viewDirection * u_Bounds.w, 0.0);
+			v_AtlasUV = (vec2(yawView, pitchView) + a_Corner * 0.5 + 0.5) / vec2(u_ViewCount);
+			v_NormalMatrix = transpose(inverse(mat3(a_InstanceMatrix)));
+			v_EntityID = a_EntityID;
+		}
+	)";
+
+	static const char* sDrawFragmentShaderSource = R"(
+		#version 450 core
+
+		layout(binding = 0) uniform sampler2D u_AlbedoAtlas;
+		layout(binding = 1) uniform sampler2D u_NormalDepthAtlas;
+
+		uniform vec3 u_LightDirection;	// Towards the light, world space
+		uniform vec3 u_LightAmbient;
+		uniform vec3 u_LightDiffuse;
+
+		in vec2 v_AtlasUV;
+		in vec4 v_ClipPosition;
+		flat in vec4 v_ClipDirection;
+		flat in mat3 v_NormalMatrix;
+		flat in int v_EntityID;
+
+		layout(location = 0) out vec4 o_Color;
+		layout(location = 1) out int o_EntityID;
+
+		void main()
+		{
+			vec4 normalDepth = texture(u_NormalDepthAtlas, v_AtlasUV);
+
+			if (normalDepth.a == 0.0)
+				discard;
+
+			// Baked depth runs from the front of the bounds (0) to the back (1), the quad is at the center
+			float depth = (normalDepth.a - 1.0 / 255.0) / (1.0 - 1.0 / 255.0);
+			vec4 clipPosition = v_ClipPosition + v_ClipDirection * (1.0 - 2.0 * depth);
+			gl_FragDepth = clamp(clipPosition.z / clipPosition.w * 0.5 + 0.5, 0.0, 1.0);
+
+			vec3 normal = normalize(v_NormalMatrix * (normalDepth.rgb * 2.0 - 1.0));
+			vec3 light = u_LightAmbient + u_LightDiffuse * max(dot(normal, u_LightDirection), 0.0);
+
+			o_Color = vec4(texture(u_AlbedoAtlas, v_AtlasUV).rgb * light, 1.0);
+			o_EntityID = v_EntityID;
+		}
+	)";
+
+	OpenGLImpostorRenderer::OpenGLImpostorRenderer()
+	{
+		mBakeProgram = CreateProgram("ImpostorBake", sBakeVertexShaderSource, sBakeFragmentShaderSource);
+		mDrawProgram = CreateProgram("ImpostorDraw", sDrawVertexShaderSource, sDrawFragmentShaderSource);
+
+		const float corners[] = { -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f };
+
+		glCreateBuffers(1, &mQuadVertexBuffer);
+		glNamedBufferStorage(mQuadVertexBuffer, sizeof(corners), corners, 0);
+
+		glCreateVertexArrays(1, &mQuadVertexArray);
+		glVertexArrayVertexBuffer(mQuadVertexArray, 0, mQuadVertexBuffer, 0, 2 * sizeof(float));
+		glEnableVertexArrayAttrib(mQuadVertexArray, 0);
+		glVertexArrayAttribFormat(mQuadVertexArray, 0, 2, GL_FLOAT, GL_FALSE, 0);
+		glVertexArrayAttribBinding(mQuadVertexArray, 0, 0);
+
+		// Instance matrix takes four consecutive locations, one column each
+		for (uint32_t column = 0; column < 4; column++)
+		{
+			glEnableVertexArrayAttrib(mQuadVertexArray, 1 + column);
+			glVertexArrayAttribFormat(mQuadVertexArray, 1 + column, 4, GL_FLOAT, GL_FALSE, (uint32_t)offsetof(ImpostorInstance, worldMatrix) + column * sizeof(Vector4));
+			glVertexArrayAttribBinding(mQuadVertexArray, 1 + column, 1);
+		}
+
+		glEnableVertexArrayAttrib(mQuadVertexArray, 5);
+		glVertexArrayAttribIFormat(mQuadVertexArray, 5, 1, GL_INT, (uint32_t)offsetof(ImpostorInstance, entityID));
+		glVertexArrayAttribBinding(mQuadVertexArray, 5, 1);
+
+		glVertexArrayBindingDivisor(mQuadVertexArray, 1, 1);
+	}
+
+	OpenGLImpostorRenderer::~OpenGLImpostorRenderer()
+	{
+		glDeleteProgram(mBakeProgram);
+		glDeleteProgram(mDrawProgram);
+		glDeleteVertexArrays(1, &mQuadVertexArray);
+		glDeleteBuffers(1, &mQuadVertexBuffer);
+
+		if (mInstanceBuffer)
+			glDeleteBuffers(1, &mInstanceBuffer);
+	}
+
+	uint32_t OpenGLImpostorRenderer::CreateProgram(const char* name, const char* vertexSource, const char* fragmentSource)
+	{
+		int success;
+		GLchar infoLog[1024];
+
+		GLuint shaders[2] = { glCreateShader(GL_VERTEX_SHADER), glCreateShader(GL_FRAGMENT_SHADER) };
+		const char* sources[2] = { vertexSource, fragmentSource };
+		const char* types[2] = { "VERTEX", "FRAGMENT" };
+		GLuint program = glCreateProgram();
+
+		for (int i = 0; i < 2; i++)
+		{
+			glShaderSource(shaders[i], 1, &sources[i], NULL);
+			glCompileShader(shaders[i]);
+			glGetShaderiv(shaders[i], GL_COMPILE_STATUS, &success);
+
+			if (!success)
+			{
+				glGetShaderInfoLog(shaders[i], 1024, NULL, infoLog);
+				TS_CORE_ERROR("ERROR::SHADER_COMPILATION_ERROR of type: {0} ({1})\n{2}", types[i], name, infoLog);
+			}
+
+			glAttachShader(program, shaders[i]);
+		}
+
+		glLinkProgram(program);
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+		if (!success)
+		{
+			glGetProgramInfoLog(program, 1024, NULL, infoLog);
+			TS_CORE_ERROR("ERROR::PROGRAM_LINKING_ERROR ({0})\n{1}", name, infoLog);
+		}
+
+		glDeleteShader(shaders[0]);
+		glDeleteShader(shaders[1]);
+		return program;
+	}
+
+	Ref<Impostor> OpenGLImpostorRenderer::Bake(Ref<Node> rootNode, Ref<Model> model, Ref<Shader> shader)
+	{
+		struct BakeDraw
+		{
+			Node* node;
+			Ref<Mesh> mesh;
+			bool skinned;
+		};
+
+		GLint previousProgram = 0;
+		GLint previousViewport[4];
+		glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+		glGetIntegerv(GL_VIEWPORT, previousViewport);
+
+		// Bones first, so skinned meshes are measured in the pose that gets baked
+		shader->Bind();
+		Ref<std::vector<Matrix4>> boneMatrices = model ? model->GetBoneMatrices() : nullptr;
+
+		if (model)
+			model->UpdateBone(shader);
+
+		bool hasBones = boneMatrices && !boneMatrices->empty();
+		Matrix4 rootFromWorld = glm::inverse(rootNode->GetTransform()->GetWorldTransformationMatrix());
+
+		std::vector<BakeDraw> draws;
+		AABB bounds;
+		std::vector<Node*> stack = { rootNode.get() };
+
+		while (!stack.empty())
+		{
+			Node* node = stack.back();
+			stack.pop_back();
+
+#ifdef TS_ENGINE_EDITOR
+			if (!node->m_Enabled)
+				continue;
+#endif
+			for (auto& child : node->GetChildren())
+				stack.push_back(child.get());
+
+			for (auto& mesh : node->GetMeshes())
+			{
+				if (mesh->GetDrawMode() != DrawMode::TRIANGLE || mesh->GetNumIndices() == 0)
+					continue;
+
+				bool skinned = mesh->HasBoneInfluence() && hasBones;
+
+				if (skinned)
+				{
+					for (const auto& vertex : mesh->GetVertices())
+					{
+						Vector4 posedPosition(0.0f);
+						float totalWeight = 0.0f;
+
+						for (int j = 0; j < MAX_BONE_INFLUENCE; j++)
+						{
+							int boneId = vertex.mBoneIds[j];
+
+							if (boneId < 0 || boneId >= (int)boneMatrices->size())
+								continue;
+
+							posedPosition += vertex.mWeights[j] * ((*boneMatrices)[boneId] * Vector4(Vector3(vertex.position), 1.0f));
+							totalWeight += vertex.mWeights[j];
+						}
+
+						Vector4 worldPosition = totalWeight > 0.0f ? posedPosition : node->GetTransform()->GetWorldTransformationMatrix() * Vector4(Vector3(vertex.position), 1.0f);
+						bounds.Expand(Vector3(rootFromWorld * worldPosition));
+					}
+				}
+				else if (mesh->GetBoundingBox().IsValid())
+				{
+					bounds.Expand(mesh->GetBoundingBox().Transform(rootFromWorld * node->GetTransform()->GetWorldTransformationMatrix()));
+				}
+
+				draws.push_back({ node, mesh, skinned });
+			}
+		}
+
+		Vector3 center = bounds.IsValid() ? bounds.GetCenter() : Vector3(0.0f);
+		float radius = bounds.IsValid() ? glm::length(bounds.max - bounds.min) * 0.5f : 0.0f;
+
+		if (draws.empty() || radius <= 0.0f)
+		{
+			TS_CORE_WARN("Impostor of {0} was not baked, it has no visible triangle meshes", rootNode->mName);
+			glUseProgram(previousProgram);
+			return nullptr;
+		}
+
+		Ref<Impostor> impostor = CreateRef<Impostor>();
+		impostor->bounds = BoundingSphere(center, radius);
+
+		for (auto& draw : draws)
+		{
+			Ref<Material> material = draw.mesh->GetMaterial();
+			impostor->sources.push_back({ draw.mesh, material.get(), draw.mesh->GetVertexVersion(), material ? material->GetVersion() : 0 });
+		}
+
+		FramebufferSpecification spec;
+		spec.Width = sYawViews * sViewResolution;
+		spec.Height = sPitchViews * sViewResolution;
+		spec.Attachments = { FramebufferTextureFormat::RGBA8, FramebufferTextureFormat::RGBA8, FramebufferTextureFormat::Depth };
+		impostor->atlas = Framebuffer::Create(spec);
+
+		// Orthographic views from outside the bounding sphere, the sphere fills each cell
+		float nearPlane = radius;
+		float farPlane = 3.0f * radius;
+		Matrix4 projection = glm::ortho(-radius, radius, -radius, radius, nearPlane, farPlane);
+
+		// Albedo and normals with depth in one pass, the materials' shaders are not used so nothing is lit twice
+		impostor->atlas->Bind();
+		RenderCommand::SetClearColor(Vector4(0.0f));
+		RenderCommand::Clear();
+		RenderCommand::EnableDepthTest(true);
+		RenderCommand::EnableAlphaBlending(false);
+
+		glUseProgram(mBakeProgram);
+		GLint modelLocation = glGetUniformLocation(mBakeProgram, "u_Model");
+		GLint viewLocation = glGetUniformLocation(mBakeProgram, "u_View");
+		GLint skinnedLocation = glGetUniformLocation(mBakeProgram, "u_Skinned");
+		GLint diffuseColorLocation = glGetUniformLocation(mBakeProgram, "u_DiffuseColor");
+		GLint diffuseMapTransformLocation = glGetUniformLocation(mBakeProgram, "u_DiffuseMapTransform");
+		GLint hasDiffuseMapLocation = glGetUniformLocation(mBakeProgram, "u_HasDiffuseMap");
+
+		glUniformMatrix4fv(glGetUniformLocation(mBakeProgram, "u_Projection"), 1, GL_FALSE, glm::value_ptr(projection));
+		glUniformMatrix4fv(glGetUniformLocation(mBakeProgram, "u_RootFromWorld"), 1, GL_FALSE, glm::value_ptr(rootFromWorld));
+		glUniform2f(glGetUniformLocation(mBakeProgram, "u_DepthRange"), nearPlane, farPlane - nearPlane);
+
+		uint32_t boneCount = hasBones ? std::min((uint32_t)boneMatrices->size(), sMaxBakeBones) : 0;
+
+		if (hasBones && boneMatrices->size() > sMaxBakeBones)
+			TS_CORE_WARN("Impostor of {0} uses the first {1} of {2} bones", rootNode->mName, sMaxBakeBones, boneMatrices->size());
+
+		glUniform1i(glGetUniformLocation(mBakeProgram, "u_BoneCount"), (int)boneCount);
+
+		if (boneCount > 0)
+			glUniformMatrix4fv(glGetUniformLocation(mBakeProgram, "u_Bones[0]"), boneCount, GL_FALSE, glm::value_ptr((*boneMatrices)[0]));
+
+		bool textures = Application::GetInstance().IsTextureModeEnabled();
+
+		for (uint32_t pitch = 0; pitch < sPitchViews; pitch++)
+		{
+			for (uint32_t yaw = 0; yaw < sYawViews; yaw++)
+			{
+				Vector3 eye = center + GetViewDirection(yaw, pitch) * (2.0f * radius);
+				Matrix4 viewMatrix = glm::lookAt(eye, center, Vector3(0.0f, 1.0f, 0.0f)) * rootFromWorld;
+
+				RenderCommand::SetViewport(yaw * sViewResolution, pitch * sViewResolution, sViewResolution, sViewResolution);
+				glUniformMatrix4fv(viewLocation, 1, GL_FALSE, glm::value_ptr(viewMatrix));
+
+				for (auto& draw : draws)
+				{
+					Ref<Material> material = draw.mesh->GetMaterial();
+					Ref<Texture2D> diffuseMap = material && textures ? material->GetDiffuseMap() : nullptr;
+					Vector4 diffuseColor = material ? material->GetDiffuseColor() : Vector4(1.0f);
+
+					if (diffuseMap)
+					{
+						diffuseMap->Bind(0);
+						glUniform4f(diffuseMapTransformLocation, material->GetDiffuseMapOffset().x, material->GetDiffuseMapOffset().y,
+							material->GetDiffuseMapTiling().x, material->GetDiffuseMapTiling().y);
+					}
+
+					glUniform4fv(diffuseColorLocation, 1, glm::value_ptr(diffuseColor));
+					glUniform1i(hasDiffuseMapLocation, diffuseMap ? 1 : 0);
+					glUniformMatrix4fv(modelLocation, 1, GL_FALSE, glm::value_ptr(draw.node->GetTransform()->GetWorldTransformationMatrix()));
+					glUniform1i(skinnedLocation, draw.skinned ? 1 : 0);
+					draw.mesh->Draw();
+				}
+			}
+		}
+
+		impostor->atlas->Unbind();
+		glBindTextureUnit(0, 0);
+
+		// Distant impostors sample the albedo from mips, normals and depth are read exactly so texels are never blended with empty ones
+		uint32_t albedoTexture = impostor->atlas->GetColorAttachmentRendererID(0);
+		glTextureParameteri(albedoTexture, GL_TEXTURE_MAX_LEVEL, sAlbedoMaxMipLevel);
+		glTextureParameteri(albedoTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glGenerateTextureMipmap(albedoTexture);
+
+		uint32_t normalDepthTexture = impostor->atlas->GetColorAttachmentRendererID(1);
+		glTextureParameteri(normalDepthTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTextureParameteri(normalDepthTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+		glUseProgram(previousProgram);
+		glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+
+		TS_CORE_INFO("Baked impostor of {0}: {1} meshes, {2}x{3} views", rootNode->mName, draws.size(), sYawViews, sPitchViews);
+		return impostor;
+	}
+
+	void OpenGLImpostorRenderer::Flush(const Matrix4& viewMatrix, const Matrix4& projectionMatrix, bool countStats)
+	{
+		if (mQueuedImpostors.empty())
+			return;
+
+		// All instances go into one buffer, each impostor draws its range
+		mInstanceScratch.clear();
+
+		for (Impostor* impostor : mQueuedImpostors)
+			mInstanceScratch.insert(mInstanceScratch.end(), impostor->instances.begin(), impostor->instances.end());
+
+		uint32_t size = (uint32_t)(mInstanceScratch.size() * sizeof(ImpostorInstance));
+
+		if (!mInstanceBuffer || mInstanceBufferCapacity < size)
+		{
+			if (mInstanceBuffer)
+				glDeleteBuffers(1, &mInstanceBuffer);
+
+			mInstanceBufferCapacity = std::max(size, mInstanceBufferCapacity * 2);
+			glCreateBuffers(1, &mInstanceBuffer);
+			glNamedBufferStorage(mInstanceBuffer, mInstanceBufferCapacity, nullptr, GL_DYNAMIC_STORAGE_BIT);
+			glVertexArrayVertexBuffer(mQuadVertexArray, 1, mInstanceBuffer, 0, sizeof(ImpostorInstance));
+		}
+
+		glNamedBufferSubData(mInstanceBuffer, 0, size, mInstanceScratch.data());
+
+		GLint previousProgram = 0;
+		glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+
+		RenderCommand::EnableDepthTest(true);
+		RenderCommand::EnableAlphaBlending(false);
+
+		glUseProgram(mDrawProgram);
+		glUniformMatrix4fv(glGetUniformLocation(mDrawProgram, "u_View"), 1, GL_FALSE, glm::value_ptr(viewMatrix));
+		glUniformMatrix4fv(glGetUniformLocation(mDrawProgram, "u_Projection"), 1, GL_FALSE, glm::value_ptr(projectionMatrix));
+		glUniform3fv(glGetUniformLocation(mDrawProgram, "u_CameraPosition"), 1, glm::value_ptr(Vector3(glm::inverse(viewMatrix)[3])));
+		glUniform2i(glGetUniformLocation(mDrawProgram, "u_ViewCount"), (int)sYawViews, (int)sPitchViews);
+		glUniform1f(glGetUniformLocation(mDrawProgram, "u_PitchStep"), glm::radians(sPitchStep));
+		glUniform3fv(glGetUniformLocation(mDrawProgram, "u_LightDirection"), 1, glm::value_ptr(mLightDirection));
+		glUniform3fv(glGetUniformLocation(mDrawProgram, "u_LightAmbient"), 1, glm::value_ptr(mLightAmbient));
+		glUniform3fv(glGetUniformLocation(mDrawProgram, "u_LightDiffuse"), 1, glm::value_ptr(mLightDiffuse));
+		GLint boundsLocation = glGetUniformLocation(mDrawProgram, "u_Bounds");
+
+		glBindVertexArray(mQuadVertexArray);
+		uint32_t baseInstance = 0;
+
+		for (Impostor* impostor : mQueuedImpostors)
+		{
+			uint32_t instanceCount = (uint32_t)impostor->instances.size();
+
+			glUniform4f(boundsLocation, impostor->bounds.center.x, impostor->bounds.center.y, impostor->bounds.center.z, impostor->bounds.radius);
+			glBindTextureUnit(0, impostor->atlas->GetColorAttachmentRendererID(0));
+			glBindTextureUnit(1, impostor->atlas->GetColorAttachmentRendererID(1));
+			glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 4, instanceCount, baseInstance);
+
+			if (countStats)
+			{
+				Application::GetInstance().AddDrawCalls(1);
+				Application::GetInstance().AddImpostorInstances(instanceCount);
+			}
+
+			baseInstance += instanceCount;
+			impostor->instances.clear();
+		}
+
+		mQueuedImpostors.clear();
+
+		glBindVertexArray(0);
+		glBindTextureUnit(0, 0);
+		glBindTextureUnit(1, 0);
+		glUseProgram(previousProgram);
+	}
+}
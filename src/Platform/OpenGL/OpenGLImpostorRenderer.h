@@ -0,0 +1,26 @@
+#pragma once
+#include "Renderer/ImpostorRenderer.h"
+
+namespace TS_ENGINE {
+
+	class OpenGLImpostorRenderer : public ImpostorRenderer
+	{
+	public:
+		OpenGLImpostorRenderer();
+		virtual ~OpenGLImpostorRenderer();
+
+		virtual Ref<Impostor> Bake(Ref<Node> rootNode, Ref<Model> model, Ref<Shader> shader) override;
+		virtual void Flush(const Matrix4& viewMatrix, const Matrix4& projectionMatrix, bool countStats = true) override;
+	private:
+		static uint32_t CreateProgram(const char* name, const char* vertexSource, const char* fragmentSource);
+
+		uint32_t mBakeProgram = 0;			// Writes albedo, normals and depth of the meshes
+		uint32_t mDrawProgram = 0;			// Draws the instanced quads
+
+		uint32_t mQuadVertexArray = 0;
+		uint32_t mQuadVertexBuffer = 0;
+		uint32_t mInstanceBuffer = 0;
+		uint32_t mInstanceBufferCapacity = 0;
+		std::vector<ImpostorInstance> mInstanceScratch;
+	};
+}
@@ -0,0 +1,194 @@
+#include "tspch.h"
+#include "Platform/OpenGL/OpenGLMeshArena.h"
+#include "Renderer/GPUMemory.h"
+#include "Platform/OpenGL/OpenGLVertexArray.h"
+#include <glad/glad.h>
+
+namespace TS_ENGINE {
+
+	static bool IsIntegerAttribute(ShaderDataType type)
+	{
+		return type == ShaderDataType::INT || type == ShaderDataType::INT2 || type == ShaderDataType::INT3
+			|| type == ShaderDataType::INT4 || type == ShaderDataType::UBYTE4;
+	}
+
+	OpenGLMeshArena::~OpenGLMeshArena()
+	{
+		GPUMemoryManager* memoryManager = GPUMemoryManager::GetInstance();
+
+		for (uint32_t i = 0; i < sNumVertexFormats; i++)
+			memoryManager->Release(GPUMemoryCategory::VertexBuffer, (uint64_t)mVertexCapacities[i] * VertexFormatUtils::GetStride((VertexFormat)i));
+
+		for (uint32_t i = 0; i < sNumIndexTypes; i++)
+			memoryManager->Release(GPUMemoryCategory::IndexBuffer, (uint64_t)mIndexCapacities[i] * GetIndexSize((IndexType)i));
+
+		glDeleteBuffers(sNumVertexFormats, mVertexBuffers);
+		glDeleteBuffers(sNumIndexTypes, mIndexBuffers);
+
+		for (uint32_t i = 0; i < sNumVertexFormats; i++)
+			glDeleteVertexArrays(sNumIndexTypes, mVertexArrays[i]);
+	}
+
+	void OpenGLMeshArena::Bind(VertexFormat vertexFormat, IndexType indexType)
+	{
+		glBindVertexArray(GetVertexArray(vertexFormat, indexType));
+	}
+
+	void OpenGLMeshArena::DrawRanges(Handle handle, const IndexRange* ranges, uint32_t rangeCount)
+	{
+		if (rangeCount == 0)
+			return;
+
+		const MeshArenaAllocation& allocation = GetAllocation(handle);
+		Bind(allocation.vertexFormat, allocation.indexType);
+
+		GLenum indexType = allocation.indexType == IndexType::UINT16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+		size_t indexSize = GetIndexSize(allocation.indexType);
+
+		if (rangeCount == 1)
+		{
+			glDrawElementsBaseVertex(GL_TRIANGLES, ranges[0].indexCount, indexType,
+				(const void*)((allocation.firstIndex + ranges[0].firstIndex) * indexSize), (GLint)allocation.baseVertex);
+			return;
+		}
+
+		mCounts.resize(rangeCount);
+		mOffsets.resize(rangeCount);
+		mBaseVertices.assign(rangeCount, (int32_t)allocation.baseVertex);
+
+		for (uint32_t i = 0; i < rangeCount; i++)
+		{
+			mCounts[i] = (int32_t)ranges[i].indexCount;
+			mOffsets[i] = (const void*)((allocation.firstIndex + ranges[i].firstIndex) * indexSize);
+		}
+
+		glMultiDrawElementsBaseVertex(GL_TRIANGLES, mCounts.data(), indexType, mOffsets.data(), (GLsizei)rangeCount, mBaseVertices.data());
+	}
+
+	bool OpenGLMeshArena::ResizeBuffer(uint32_t& buffer, uint32_t oldSize, uint32_t newSize)
+	{
+		while (glGetError() != GL_NO_ERROR);
+
+		uint32_t newBuffer;
+		glCreateBuffers(1, &newBuffer);
+		glNamedBufferStorage(newBuffer, newSize, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+		if (glGetError() == GL_OUT_OF_MEMORY)
+		{
+			glDeleteBuffers(1, &newBuffer);
+			return false;
+		}
+
+		if (buffer != 0)
+		{
+			glCopyNamedBufferSubData(buffer, newBuffer, 0, 0, oldSize);
+			glDeleteBuffers(1, &buffer);
+		}
+
+		buffer = newBuffer;
+		return true;
+	}
+
+	bool OpenGLMeshArena::ResizeVertexBuffer(VertexFormat vertexFormat, uint32_t capacity)
+	{
+		uint32_t format = (uint32_t)vertexFormat;
+		uint32_t stride = VertexFormatUtils::GetStride(vertexFormat);
+
+		if (!ResizeBuffer(mVertexBuffers[format], mVertexCapacities[format] * stride, capacity * stride))
+			return false;
+
+		GPUMemoryManager::GetInstance()->Release(GPUMemoryCategory::VertexBuffer, (uint64_t)mVertexCapacities[format] * stride);
+		GPUMemoryManager::GetInstance()->Allocate(GPUMemoryCategory::VertexBuffer, (uint64_t)capacity * stride);
+		mVertexCapacities[format] = capacity;
+
+		for (uint32_t i = 0; i < sNumIndexTypes; i++)
+		{
+			if (mVertexArrays[format][i] != 0)
+				glVertexArrayVertexBuffer(mVertexArrays[format][i], 0, mVertexBuffers[format], 0, stride);
+		}
+
+		return true;
+	}
+
+	bool OpenGLMeshArena::ResizeIndexBuffer(IndexType indexType, uint32_t capacity)
+	{
+		uint32_t type = (uint32_t)indexType;
+		uint32_t indexSize = GetIndexSize(indexType);
+
+		if (!ResizeBuffer(mIndexBuffers[type], mIndexCapacities[type] * indexSize, capacity * indexSize))
+			return false;
+
+		GPUMemoryManager::GetInstance()->Release(GPUMemoryCategory::IndexBuffer, (uint64_t)mIndexCapacities[type] * indexSize);
+		GPUMemoryManager::GetInstance()->Allocate(GPUMemoryCategory::IndexBuffer, (uint64_t)capacity * indexSize);
+		mIndexCapacities[type] = capacity;
+
+		for (uint32_t i = 0; i < sNumVertexFormats; i++)
+		{
+			if (mVertexArrays[i][type] != 0)
+				glVertexArrayElementBuffer(mVertexArrays[i][type], mIndexBuffers[type]);
+		}
+
+		return true;
+	}
+
+	void OpenGLMeshArena::UploadVertices(VertexFormat vertexFormat, uint32_t offset, const void* data, uint32_t count)
+	{
+		uint32_t stride = VertexFormatUtils::GetStride(vertexFormat);
+		glNamedBufferSubData(mVertexBuffers[(uint32_t)vertexFormat], (GLintptr)offset * stride, (GLsizeiptr)count * stride, data);
+	}
+
+	void OpenGLMeshArena::UploadIndices(IndexType indexType, uint32_t offset, const void* data, uint32_t count)
+	{
+		uint32_t indexSize = GetIndexSize(indexType);
+		glNamedBufferSubData(mIndexBuffers[(uint32_t)indexType], (GLintptr)offset * indexSize, (GLsizeiptr)count * indexSize, data);
+	}
+
+	void OpenGLMeshArena::CopyVertices(VertexFormat vertexFormat, uint32_t source, uint32_t destination, uint32_t count)
+	{
+		uint32_t buffer = mVertexBuffers[(uint32_t)vertexFormat];
+		uint32_t stride = VertexFormatUtils::GetStride(vertexFormat);
+		glCopyNamedBufferSubData(buffer, buffer, (GLintptr)source * stride, (GLintptr)destination * stride, (GLsizeiptr)count * stride);
+	}
+
+	void OpenGLMeshArena::CopyIndices(IndexType indexType, uint32_t source, uint32_t destination, uint32_t count)
+	{
+		uint32_t buffer = mIndexBuffers[(uint32_t)indexType];
+		uint32_t indexSize = GetIndexSize(indexType);
+		glCopyNamedBufferSubData(buffer, buffer, (GLintptr)source * indexSize, (GLintptr)destination * indexSize, (GLsizeiptr)count * indexSize);
+	}
+
+	uint32_t OpenGLMeshArena::GetVertexArray(VertexFormat vertexFormat, IndexType indexType)
+	{
+		uint32_t& vertexArray = mVertexArrays[(uint32_t)vertexFormat][(uint32_t)indexType];
+
+		if (vertexArray != 0)
+			return vertexArray;
+
+		// Same attribute locations as OpenGLVertexArray, all read from binding 0
+		glCreateVertexArrays(1, &vertexArray);
+		BufferLayout layout = VertexFormatUtils::GetBufferLayout(vertexFormat);
+		uint32_t location = 0;
+
+		for (const auto& element : layout)
+		{
+			glEnableVertexArrayAttrib(vertexArray, location);
+
+			if (IsIntegerAttribute(element.type))
+				glVertexArrayAttribIFormat(vertexArray, location, element.GetComponentCount(), ShaderDataTypeToOpenGLBaseType(element.type), (GLuint)element.offset);
+			else
+				glVertexArrayAttribFormat(vertexArray, location, element.GetComponentCount(), ShaderDataTypeToOpenGLBaseType(element.type),
+					element.normalized ? GL_TRUE : GL_FALSE, (GLuint)element.offset);
+
+			glVertexArrayAttribBinding(vertexArray, location, 0);
+			location++;
+		}
+
+		if (mVertexBuffers[(uint32_t)vertexFormat] != 0)
+			glVertexArrayVertexBuffer(vertexArray, 0, mVertexBuffers[(uint32_t)vertexFormat], 0, layout.GetStride());
+
+		if (mIndexBuffers[(uint32_t)indexType] != 0)
+			glVertexArrayElementBuffer(vertexArray, mIndexBuffers[(uint32_t)indexType]);
+
+		return vertexArray;
+	}
+}
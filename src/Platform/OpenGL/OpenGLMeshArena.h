@@ -0,0 +1,39 @@
+#pragma once
+#include "Renderer/MeshArena.h"
+
+namespace TS_ENGINE {
+
+	class OpenGLMeshArena : public MeshArena
+	{
+	public:
+		OpenGLMeshArena() = default;
+		virtual ~OpenGLMeshArena();
+
+		virtual void Bind(VertexFormat vertexFormat, IndexType indexType) override;
+		virtual void DrawRanges(Handle handle, const IndexRange* ranges, uint32_t rangeCount) override;
+	protected:
+		virtual bool ResizeVertexBuffer(VertexFormat vertexFormat, uint32_t capacity) override;
+		virtual bool ResizeIndexBuffer(IndexType indexType, uint32_t capacity) override;
+
+		virtual void UploadVertices(VertexFormat vertexFormat, uint32_t offset, const void* data, uint32_t count) override;
+		virtual void UploadIndices(IndexType indexType, uint32_t offset, const void* data, uint32_t count) override;
+
+		virtual void CopyVertices(VertexFormat vertexFormat, uint32_t source, uint32_t destination, uint32_t count) override;
+		virtual void CopyIndices(IndexType indexType, uint32_t source, uint32_t destination, uint32_t count) override;
+	private:
+		// Creates a buffer of newSize bytes holding the first oldSize bytes of buffer, which is replaced
+		static bool ResizeBuffer(uint32_t& buffer, uint32_t oldSize, uint32_t newSize);
+		// Vertex array reading the format's vertex buffer and the index type's index buffer, created on first use
+		uint32_t GetVertexArray(VertexFormat vertexFormat, IndexType indexType);
+
+		uint32_t mVertexBuffers[sNumVertexFormats] = {};
+		uint32_t mVertexCapacities[sNumVertexFormats] = {};
+		uint32_t mIndexBuffers[sNumIndexTypes] = {};
+		uint32_t mIndexCapacities[sNumIndexTypes] = {};
+		uint32_t mVertexArrays[sNumVertexFormats][sNumIndexTypes] = {};
+
+		std::vector<int32_t> mCounts;				// Scratch for DrawRanges
+		std::vector<const void*> mOffsets;
+		std::vector<int32_t> mBaseVertices;
+	};
+}
@@ -43,6 +43,10 @@ namespace TS_ENGINE
 
 		glEnable(GL_DEPTH_TEST);
 		glEnable(GL_LINE_SMOOTH);
+
+		// Generic values for attributes that compact vertex formats don't carry (see VertexFormat.h)
+		glVertexAttribI4i(3, -1, -1, -1, -1);	// a_BoneIds
+		glVertexAttrib4f(4, 0.0f, 0.0f, 0.0f, 0.0f);	// a_Weights
 	}
 
 	void OpenGLRendererAPI::SetViewport(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
@@ -64,13 +68,48 @@ namespace TS_ENGINE
 	{
 		vertexArray->Bind();
 		uint32_t count = 0;
+		GLenum indexType = GL_UNSIGNED_INT;
 		
 		auto indexBuffer = vertexArray->GetIndexBuffer();
 
-		if(vertexArray->GetIndexBuffer())
-			count = indexCount ? indexCount : vertexArray->GetIndexBuffer()->GetCount();
+		if (indexBuffer)
+		{
+			count = indexCount ? indexCount : indexBuffer->GetCount();
+			indexType = indexBuffer->GetIndexType() == IndexType::UINT16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+		}
 		
-		glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, nullptr);
+		glDrawElements(GL_TRIANGLES, count, indexType, nullptr);
+	}
+
+	void OpenGLRendererAPI::DrawIndexedRanges(const Ref<VertexArray>& vertexArray, const std::vector<IndexRange>& ranges)
+	{
+		auto indexBuffer = vertexArray->GetIndexBuffer();
+
+		if (!indexBuffer || ranges.empty())
+			return;
+
+		vertexArray->Bind();
+		GLenum indexType = indexBuffer->GetIndexType() == IndexType::UINT16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+		size_t indexSize = indexBuffer->GetIndexType() == IndexType::UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+
+		if (ranges.size() == 1)
+		{
+			glDrawElements(GL_TRIANGLES, ranges[0].indexCount, indexType, (const void*)(ranges[0].firstIndex * indexSize));
+			return;
+		}
+
+		static thread_local std::vector<GLsizei> counts;
+		static thread_local std::vector<const void*> offsets;
+		counts.resize(ranges.size());
+		offsets.resize(ranges.size());
+
+		for (size_t i = 0; i < ranges.size(); i++)
+		{
+			counts[i] = (GLsizei)ranges[i].indexCount;
+			offsets[i] = (const void*)(ranges[i].firstIndex * indexSize);
+		}
+
+		glMultiDrawElements(GL_TRIANGLES, counts.data(), indexType, offsets.data(), (GLsizei)ranges.size());
 	}
 
 	void OpenGLRendererAPI::DrawLines(const Ref<VertexArray>& vertexArray, uint32_t vertexCount)
@@ -112,4 +151,50 @@ namespace TS_ENGINE
 	{
 		glPolygonMode(GL_FRONT_AND_BACK, _enable ? GL_LINE : GL_FILL);
 	}
+
+	void OpenGLRendererAPI::EnableDepthWrite(bool enable)
+	{
+		glDepthMask(enable ? GL_TRUE : GL_FALSE);
+	}
+
+	void OpenGLRendererAPI::ClearDepth()
+	{
+		glClear(GL_DEPTH_BUFFER_BIT);
+	}
+
+	void OpenGLRendererAPI::EnableScissorTest(bool enable)
+	{
+		if (enable)
+		{
+			glEnable(GL_SCISSOR_TEST);
+		}
+		else
+		{
+			glDisable(GL_SCISSOR_TEST);
+		}
+	}
+
+	void OpenGLRendererAPI::SetScissor(int x, int y, int width, int height)
+	{
+		glScissor(x, y, width, height);
+	}
+
+	void OpenGLRendererAPI::EnableBackFaceCulling(bool enable)
+	{
+		// Set per mesh, so unchanged state isn't sent again
+		if (enable == mBackFaceCulling)
+			return;
+
+		if (enable)
+		{
+			glEnable(GL_CULL_FACE);
+			glCullFace(GL_BACK);
+		}
+		else
+		{
+			glDisable(GL_CULL_FACE);
+		}
+
+		mBackFaceCulling = enable;
+	}
 }
\ No newline at end of file
@@ -10,10 +10,19 @@ namespace TS_ENGINE {
 		virtual void SetClearColor(const glm::vec4& color) override;
 		virtual void Clear() override;
 		virtual void DrawIndexed(const Ref<VertexArray>& vertexArray, uint32_t indexCount) override;
+		virtual void DrawIndexedRanges(const Ref<VertexArray>& vertexArray, const std::vector<IndexRange>& ranges) override;
 		virtual void DrawLines(const Ref<VertexArray>& vertexArray, uint32_t vertexCount) override;
 		virtual void SetLineWidth(float width) override;
 		virtual void EnableDepthTest(bool enable) override;
 		virtual void EnableAlphaBlending(bool enable) override;
 		virtual void EnableWireframe(bool _enable) override;
+		virtual void EnableDepthWrite(bool enable) override;
+		virtual void ClearDepth() override;
+		virtual void EnableScissorTest(bool enable) override;
+		virtual void SetScissor(int x, int y, int width, int height) override;
+		virtual void EnableBackFaceCulling(bool enable) override;
+		virtual bool IsBackFaceCullingEnabled() const override { return mBackFaceCulling; }
+	private:
+		bool mBackFaceCulling = false;
 	};
 }
\ No newline at end of file
@@ -107,6 +107,11 @@ namespace TS_ENGINE {
 		return mName;
 	}
 
+	bool OpenGLShader::HasUniform(const char* name) const
+	{
+		return glGetUniformLocation(mRendererID, name) != -1;
+	}
+
 	void OpenGLShader::SetBool(const char* name, bool value)
 	{
 		glUniform1i(glGetUniformLocation(mRendererID, name), (int)value);
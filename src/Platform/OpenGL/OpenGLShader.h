@@ -18,6 +18,7 @@ namespace TS_ENGINE {
 		virtual void Unbind() const override;
 
 		virtual const std::string& GetName() const override;
+		virtual bool HasUniform(const char* name) const override;
 
 		virtual void SetBool(const char* name, bool value) override;
 		virtual void SetInt(const char* name, int value) override;
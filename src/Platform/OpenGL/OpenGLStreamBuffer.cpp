@@ -0,0 +1,79 @@
+#include "tspch.h"
+#include "Platform/OpenGL/OpenGLStreamBuffer.h"
+#include <glad/glad.h>
+
+namespace TS_ENGINE {
+
+	OpenGLStreamBuffer::OpenGLStreamBuffer(uint32_t frameCapacity) :
+		mFrameCapacity(frameCapacity)
+	{
+		// Coherent, so writes are visible to the GPU without explicit flushes
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		glCreateBuffers(1, &mRendererID);
+		glNamedBufferStorage(mRendererID, (GLsizeiptr)frameCapacity * sFrameCount, nullptr, flags);
+		mMappedMemory = (uint8_t*)glMapNamedBufferRange(mRendererID, 0, (GLsizeiptr)frameCapacity * sFrameCount, flags);
+
+		if (!mMappedMemory)
+			TS_CORE_ERROR("Stream buffer of {0} bytes could not be mapped, streamed geometry falls back to regular buffers", frameCapacity * sFrameCount);
+	}
+
+	OpenGLStreamBuffer::~OpenGLStreamBuffer()
+	{
+		for (void* fence : mFences)
+		{
+			if (fence)
+				glDeleteSync((GLsync)fence);
+		}
+
+		if (mMappedMemory)
+			glUnmapNamedBuffer(mRendererID);
+
+		glDeleteBuffers(1, &mRendererID);
+	}
+
+	void* OpenGLStreamBuffer::Allocate(uint32_t size, uint32_t alignment, uint32_t& offset)
+	{
+		if (!mMappedMemory)
+			return nullptr;
+
+		uint32_t alignedOffset = (mFrameOffset + alignment - 1) / alignment * alignment;
+
+		if (alignedOffset + (uint64_t)size > mFrameCapacity)
+			return nullptr;
+
+		mFrameOffset = alignedOffset + size;
+		offset = mFrame * mFrameCapacity + alignedOffset;
+		return mMappedMemory + offset;
+	}
+
+	void OpenGLStreamBuffer::NextFrame()
+	{
+		if (mFrameOffset > 0)
+		{
+			if (mFences[mFrame])
+				glDeleteSync((GLsync)mFences[mFrame]);
+
+			mFences[mFrame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		}
+
+		mFrame = (mFrame + 1) % sFrameCount;
+		mFrameOffset = 0;
+		mFrameIndex++;
+
+		// The region was last written sFrameCount frames ago, this only blocks if the GPU is that far behind
+		if (GLsync fence = (GLsync)mFences[mFrame])
+		{
+			GLenum result = glClientWaitSync(fence, 0, 0);
+
+			while (result == GL_TIMEOUT_EXPIRED)
+				result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+
+			if (result == GL_WAIT_FAILED)
+				TS_CORE_ERROR("Waiting for stream buffer region {0} failed", mFrame);
+
+			glDeleteSync(fence);
+			mFences[mFrame] = nullptr;
+		}
+	}
+}
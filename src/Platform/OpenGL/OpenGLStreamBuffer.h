@@ -0,0 +1,27 @@
+#pragma once
+#include "Renderer/StreamBuffer.h"
+
+namespace TS_ENGINE {
+
+	class OpenGLStreamBuffer : public StreamBuffer
+	{
+	public:
+		OpenGLStreamBuffer(uint32_t frameCapacity);
+		virtual ~OpenGLStreamBuffer();
+
+		virtual void* Allocate(uint32_t size, uint32_t alignment, uint32_t& offset) override;
+		virtual void NextFrame() override;
+
+		virtual uint32_t GetRendererID() const override { return mRendererID; }
+		virtual uint64_t GetFrameIndex() const override { return mFrameIndex; }
+	private:
+		uint32_t mRendererID = 0;
+		uint8_t* mMappedMemory = nullptr;		// Whole buffer, mapped for its lifetime
+		uint32_t mFrameCapacity;
+
+		uint32_t mFrame = 0;					// Region written this frame
+		uint32_t mFrameOffset = 0;				// Bytes used in it
+		uint64_t mFrameIndex = 0;
+		void* mFences[sFrameCount] = {};		// GLsync of the last frame that wrote each region
+	};
+}
@@ -1,9 +1,16 @@
 #include "tspch.h"
 #include "OpenGLTexture.h"
+#include "Renderer/GPUMemory.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+// EXT_texture_compression_s3tc and EXT_texture_sRGB, not part of the 4.5 loader
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+
 namespace TS_ENGINE {
 
 	OpenGLTexture2D::OpenGLTexture2D(uint32_t width, uint32_t height) :
@@ -24,9 +31,11 @@ namespace TS_ENGINE {
 		// Texture wrapping
 		glTextureParameteri(mRendererID, GL_TEXTURE_WRAP_S, GL_REPEAT);
 		glTextureParameteri(mRendererID, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+		TrackGPUMemory(GetLevelBytes(0));
 	}
 
-	OpenGLTexture2D::OpenGLTexture2D(const std::string& path) :
+	OpenGLTexture2D::OpenGLTexture2D(const std::string& path, const TextureImportSettings& settings) :
 		mChannels(4),
 		mDataFormat(GL_RGB),
 		mWidth(0),
@@ -35,183 +44,366 @@ namespace TS_ENGINE {
 		mRendererID(0)
 	{
 		mPath = path;
-		int width, height, channels;
-		stbi_set_flip_vertically_on_load(1);
-		
-		data = nullptr;
+		TextureImportSettings importSettings = GetSupportedSettings(settings);
+
+		if (Ref<TextureImage> image = TextureImporter::ImportFile(path, importSettings))
 		{
-			data = stbi_load(path.c_str(), &width, &height, &channels, 0);
-			TS_CORE_INFO("Texture loaded from path: {0}", path);
+			mRendererID = CreateStorage(*image, importSettings);
+			Upload(*image);
+			TrackGPUMemory(GetLevelBytes(0));
+
+			TS_CORE_INFO("TextureID: {0}", mRendererID);
 		}
+	}
 
-		if (data)
+	OpenGLTexture2D::OpenGLTexture2D(const char* name, const unsigned char* pixelData, uint32_t len, const TextureImportSettings& settings, bool keepPixels) :
+		mChannels(4),
+		mDataFormat(GL_RGB),
+		mWidth(0),
+		mHeight(0),
+		mInternalFormat(GL_RGBA8),
+		mRendererID(0)
+	{
+		TextureImportSettings importSettings = GetSupportedSettings(settings);
+
+		if (Ref<TextureImage> image = TextureImporter::ImportMemory(pixelData, len, importSettings, keepPixels))
 		{
-			mIsLoaded = false;
+			mRendererID = CreateStorage(*image, importSettings);
+			Upload(*image);
+			TrackGPUMemory(GetLevelBytes(0));
 
-			mWidth = width;
-			mHeight = height;
-			mChannels = channels;
+			mPixels = std::move(image->pixels);
 
-			GLenum internalFormat = 0, dataFormat = 0;
+			TS_CORE_INFO("TextureID: {0}", mRendererID);
+		}
+	}
 
-			if (channels == 4)
-			{
-				internalFormat = GL_RGBA32F;
-				dataFormat = GL_RGBA;				
-				//internalFormat = GL_RGBA32F;	// For Gamma Correction
-				//dataFormat = GL_RGBA;			// For Gamma Correction
-			}
-			else if (channels == 3)
-			{
-				internalFormat = GL_RGB8;
-				dataFormat = GL_RGB;
-				//internalFormat = GL_RGB32F;	// For Gamma Correction
-				//dataFormat = GL_RGB;			// For Gamma Correction
-			}
-			else if (channels == 1)
-			{
-				internalFormat = GL_R;
-				dataFormat = GL_RED;
-			}
+	OpenGLTexture2D::~OpenGLTexture2D()
+	{
+		glDeleteTextures(1, &mRendererID);
 
-			// Copy pixels data to mPixels vector
-			//mPixels.resize(width * height * channels);
-			//std::memcpy(mPixels.data(), data, width * height * channels);
+		if (mStreamingID != 0 && mStreamingID != mRendererID)
+			glDeleteTextures(1, &mStreamingID);
 
-			mInternalFormat = internalFormat;
-			mDataFormat = dataFormat;
+		TrackGPUMemory(0);
+	}
 
-			TS_CORE_ASSERT(internalFormat & dataFormat, "Format not supported!");
+	void OpenGLTexture2D::SetData(unsigned char* data, uint32_t size)
+	{
+		this->data = data;
 
-			glCreateTextures(GL_TEXTURE_2D, 1, &mRendererID);
-			
-			// Allocates texture's storage in GPU memory and specifies it's dimensions, format, and number of mipmap levels.
-			glTextureStorage2D(mRendererID, 1, internalFormat, mWidth, mHeight);
+		uint32_t bpp = mDataFormat == GL_RGBA ? 4 : 3;
+		TS_CORE_ASSERT(size == mWidth * mHeight * bpp, "Data must be entire texture!");
+		glTextureSubImage2D(mRendererID, 0, 0, 0, mWidth, mHeight, mDataFormat, GL_UNSIGNED_BYTE, data);		
+	}
 
-			// glTextureSubImage2D is used to upload a portion of texture data to a texture that has already been allocated with storage
-			glTextureSubImage2D(mRendererID, 0, 0, 0, mWidth, mHeight, dataFormat, GL_UNSIGNED_BYTE, data);
+	void OpenGLTexture2D::Bind(uint32_t slot) const
+	{
+		glBindTextureUnit(slot, mRendererID);
+		MarkUsed();
+	}
 
-			// Allocates storage and uploads data in one call
-			//glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, mWidth, mHeight, 0, dataFormat, GL_UNSIGNED_BYTE, data);
+	void OpenGLTexture2D::SetVerticalFlip(bool flip) const
+	{
+		stbi_set_flip_vertically_on_load(flip);
+	}
+
+	void OpenGLTexture2D::OverrideTextureID(GLuint texID)
+	{
+		// The overriding texture is owned by whoever made it, see TextureArrayManager
+		mRendererID = texID;
+		TrackGPUMemory(0);
+	}
+
+	void OpenGLTexture2D::BeginStreaming(const std::string& path)
+	{
+		mPath = path;
+		mStreaming = true;
+
+		// White until the smallest level arrives, so materials show their colors
+		uint32_t white = 0xFFFFFFFF;
+		glTextureSubImage2D(mRendererID, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, &white);
+	}
+
+	GLuint OpenGLTexture2D::AllocateStreamingStorage(TextureImage& image, const TextureImportSettings& settings)
+	{
+		TS_CORE_ASSERT(mStreaming && mStreamingID == 0);
 
-			// Texture filters
-			glTextureParameteri(mRendererID, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			glTextureParameteri(mRendererID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-			// Texture wrapping
-			glTextureParameteri(mRendererID, GL_TEXTURE_WRAP_S, GL_REPEAT);
-			glTextureParameteri(mRendererID, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		mStreamingID = CreateStorage(image, settings);
+		mPixels = std::move(image.pixels);
+		TrackGPUMemory(mGPUBytes + GetLevelBytes(0));
 
-			TS_CORE_INFO("Width: {0}, height : {1}, channel : {2} TextureID: {3}", mWidth, mHeight, channels, mRendererID);			
+		// Nothing is uploaded yet, the levels arrive smallest first
+		glTextureParameteri(mStreamingID, GL_TEXTURE_BASE_LEVEL, (GLint)image.levels.size() - 1);
+		return mStreamingID;
+	}
+
+	void OpenGLTexture2D::SetStreamedLevel(uint32_t level)
+	{
+		TS_CORE_ASSERT(mStreaming && mStreamingID != 0);
+
+		glTextureParameteri(mStreamingID, GL_TEXTURE_BASE_LEVEL, (GLint)level);
 
-			stbi_image_free(data);
+		// The first level swaps the placeholder for the streamed storage
+		if (mRendererID != mStreamingID)
+		{
+			GLuint placeholder = mRendererID;
+			mRendererID = mStreamingID;
+			Texture2D::ReplaceRendererID(placeholder, mRendererID);
+			glDeleteTextures(1, &placeholder);
+			TrackGPUMemory(GetLevelBytes(0));
+		}
+
+		if (level == 0)
+		{
+			mStreaming = false;
+			mStreamingID = 0;
 		}
 	}
 
-	OpenGLTexture2D::OpenGLTexture2D(const char* name, const unsigned char* pixelData, uint32_t len) :
-		mChannels(4),
-		mDataFormat(GL_RGB),
-		mWidth(0),
-		mHeight(0),
-		mInternalFormat(GL_RGBA8),
-		mRendererID(0)
+	GLuint OpenGLTexture2D::CreateStorage(const TextureImage& image, const TextureImportSettings& settings)
 	{
-		int width, height, channels;
-		stbi_set_flip_vertically_on_load(0);
+		mIsLoaded = false;
+
+		mWidth = image.width;
+		mHeight = image.height;
+		mChannels = image.sourceChannels;
+
+		bool srgb = settings.usage == TextureUsage::Color && settings.srgb;
 
-		data = nullptr;
+		if (image.format != TextureBlockFormat::None)
 		{
-			data = stbi_load_from_memory(pixelData, len, &width, &height, &channels, 0);
-			//TS_CORE_INFO("Embedded texture loaded with name: {0}, length: {1}, width: {2}, height: {3}, channel: {4}", name, len, width, height, channels);
+			mInternalFormat = GetCompressedFormat(image.format, srgb);
+			mDataFormat = mInternalFormat;
 		}
+		else if (image.channels == 4)
+		{
+			mInternalFormat = srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+			mDataFormat = GL_RGBA;
+		}
+		else if (image.channels == 3)
+		{
+			mInternalFormat = srgb ? GL_SRGB8 : GL_RGB8;
+			mDataFormat = GL_RGB;
+		}
+		else if (image.channels == 2)
+		{
+			mInternalFormat = GL_RG8;
+			mDataFormat = GL_RG;
+		}
+		else
+		{
+			mInternalFormat = GL_R8;
+			mDataFormat = GL_RED;
+		}
+
+		GLuint texture;
+		glCreateTextures(GL_TEXTURE_2D, 1, &texture);
 
-		if (data)
+		// Allocates texture's storage in GPU memory and specifies it's dimensions, format, and number of mipmap levels.
+		glTextureStorage2D(texture, (GLsizei)image.levels.size(), mInternalFormat, mWidth, mHeight);
+
+		mLevelCount = (uint32_t)image.levels.size();
+		mResidentLevel = 0;
+		mCacheKey = image.cacheKey;
+		mAnisotropy = settings.anisotropy;
+
+		SetSamplingParameters(texture, mLevelCount, mAnisotropy);
+		return texture;
+	}
+
+	void OpenGLTexture2D::Upload(const TextureImage& image)
+	{
+		// Rows of one, two and three channel images aren't 4 byte aligned
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		for (uint32_t level = 0; level < image.levels.size(); level++)
 		{
-			mIsLoaded = false;
+			GLsizei levelWidth = std::max(1u, mWidth >> level);
+			GLsizei levelHeight = std::max(1u, mHeight >> level);
 
-			mWidth = width;
-			mHeight = height;
-			mChannels = channels;
+			if (image.format != TextureBlockFormat::None)
+				glCompressedTextureSubImage2D(mRendererID, level, 0, 0, levelWidth, levelHeight, mInternalFormat, (GLsizei)image.levels[level].size, image.levels[level].data);
+			else
+				glTextureSubImage2D(mRendererID, level, 0, 0, levelWidth, levelHeight, mDataFormat, GL_UNSIGNED_BYTE, image.levels[level].data);
+		}
 
-			GLenum internalFormat = 0, dataFormat = 0;
-			
-			if (channels == 4)
-			{
-				//internalFormat = GL_RGBA8;
-				internalFormat = GL_RGBA32F;
-				dataFormat = GL_RGBA;
-			}
-			else if (channels == 3)
-			{
-				internalFormat = GL_RGB8;
-				dataFormat = GL_RGB;
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	}
 
-			}
-			else if (channels == 2)
-			{
-				internalFormat = GL_RG;
-				dataFormat = GL_RG8;
+	void OpenGLTexture2D::SetSamplingParameters(GLuint texture, uint32_t levelCount, float anisotropy)
+	{
+		// Texture filters, trilinear when there are mips
+		glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		// Texture wrapping
+		glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-			}
-			else if (channels == 1)
-			{
-				internalFormat = GL_R;
-				dataFormat = GL_RED;
+		float maxAnisotropy = GetMaxAnisotropy();
 
-			}
+		if (maxAnisotropy > 1.0f && anisotropy > 1.0f)
+			glTextureParameterf(texture, GL_TEXTURE_MAX_ANISOTROPY, std::min(anisotropy, maxAnisotropy));
+	}
 
-			//Copy pixels data to mPixels vector
-			mPixels.resize(width * height * channels);
-			std::memcpy(mPixels.data(), data, width * height * channels);
+	uint64_t OpenGLTexture2D::GetLevelBytes(uint32_t level) const
+	{
+		return GetStorageBytes(mInternalFormat, mWidth, mHeight, level, mLevelCount);
+	}
 
-			mInternalFormat = internalFormat;
-			mDataFormat = dataFormat;
+	bool OpenGLTexture2D::CanChangeResidency() const
+	{
+		return mCacheKey != 0 && mLevelCount > 1 && !mStreaming && !mArrayLayer.IsValid();
+	}
 
-			TS_CORE_ASSERT(internalFormat & dataFormat, "Format not supported!");
+	bool OpenGLTexture2D::SetResidentLevel(uint32_t level)
+	{
+		if (!CanChangeResidency() || level >= mLevelCount)
+			return false;
 
-			glCreateTextures(GL_TEXTURE_2D, 1, &mRendererID);
-			glTextureStorage2D(mRendererID, 1, internalFormat, mWidth, mHeight);
+		if (level == mResidentLevel)
+			return true;
 
-			glTextureParameteri(mRendererID, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			glTextureParameteri(mRendererID, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		// Dropped levels can only come back from the baked container, a texture without one keeps its levels
+		TextureContainer container;
 
-			glTextureParameteri(mRendererID, GL_TEXTURE_WRAP_S, GL_REPEAT);
-			glTextureParameteri(mRendererID, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		if (!container.Open(TextureCompressor::GetCachePath(mCacheKey)) || container.GetLevelCount() != mLevelCount)
+		{
+			TS_CORE_WARN("Baked container of texture {0} is gone, its levels stay resident", mPath);
+			mCacheKey = 0;
+			return false;
+		}
 
-			glTextureSubImage2D(mRendererID, 0, 0, 0, mWidth, mHeight, dataFormat, GL_UNSIGNED_BYTE, data);
+		uint32_t levelCount = mLevelCount - level;
+		GLuint texture;
+		glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+		glTextureStorage2D(texture, levelCount, mInternalFormat, std::max(1u, mWidth >> level), std::max(1u, mHeight >> level));
+		SetSamplingParameters(texture, levelCount, mAnisotropy);
 
-			TS_CORE_INFO("TextureID: {0}", mRendererID);
-			
-			stbi_image_free(data);
+		// Levels both storages have are copied on the GPU
+		for (uint32_t i = std::max(level, mResidentLevel); i < mLevelCount; i++)
+		{
+			glCopyImageSubData(mRendererID, GL_TEXTURE_2D, i - mResidentLevel, 0, 0, 0, texture, GL_TEXTURE_2D, i - level, 0, 0, 0,
+				std::max(1u, mWidth >> i), std::max(1u, mHeight >> i), 1);
 		}
+
+		// Rows of one, two and three channel images aren't 4 byte aligned
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		for (uint32_t i = level; i < mResidentLevel; i++)
+		{
+			TextureContainerLevel containerLevel = container.GetLevel(i);
+			GLsizei levelWidth = std::max(1u, mWidth >> i);
+			GLsizei levelHeight = std::max(1u, mHeight >> i);
+
+			if (container.GetFormat() != TextureBlockFormat::None)
+				glCompressedTextureSubImage2D(texture, i - level, 0, 0, levelWidth, levelHeight, mInternalFormat, (GLsizei)containerLevel.size, containerLevel.data);
+			else
+				glTextureSubImage2D(texture, i - level, 0, 0, levelWidth, levelHeight, mDataFormat, GL_UNSIGNED_BYTE, containerLevel.data);
+		}
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+		GLuint previous = mRendererID;
+		mRendererID = texture;
+		mResidentLevel = level;
+		Texture2D::ReplaceRendererID(previous, mRendererID);
+		glDeleteTextures(1, &previous);
+
+		TrackGPUMemory(GetLevelBytes(level));
+		return true;
 	}
 
-	OpenGLTexture2D::~OpenGLTexture2D()
+	void OpenGLTexture2D::TrackGPUMemory(uint64_t bytes)
 	{
-		glDeleteTextures(1, &mRendererID);
+		GPUMemoryManager* manager = GPUMemoryManager::GetInstance();
+		manager->Release(GPUMemoryCategory::Texture, mGPUBytes);
+		manager->Allocate(GPUMemoryCategory::Texture, bytes);
+		mGPUBytes = bytes;
 	}
 
-	void OpenGLTexture2D::SetData(unsigned char* data, uint32_t size)
+	uint64_t OpenGLTexture2D::GetStorageBytes(GLenum internalFormat, uint32_t width, uint32_t height, uint32_t firstLevel, uint32_t endLevel)
 	{
-		this->data = data;
+		uint32_t blockBytes = 0;
+		uint32_t texelBytes = 4;		// RGB8 is padded to 4 bytes by most drivers
 
-		uint32_t bpp = mDataFormat == GL_RGBA ? 4 : 3;
-		TS_CORE_ASSERT(size == mWidth * mHeight * bpp, "Data must be entire texture!");
-		glTextureSubImage2D(mRendererID, 0, 0, 0, mWidth, mHeight, mDataFormat, GL_UNSIGNED_BYTE, data);		
+		switch (internalFormat)
+		{
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RED_RGTC1:
+			blockBytes = 8;
+			break;
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+		case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+		case GL_COMPRESSED_RG_RGTC2:
+		case GL_COMPRESSED_RGBA_BPTC_UNORM:
+		case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+			blockBytes = 16;
+			break;
+		case GL_RG8:
+			texelBytes = 2;
+			break;
+		case GL_R8:
+			texelBytes = 1;
+			break;
+		}
+
+		uint64_t bytes = 0;
+
+		for (uint32_t level = firstLevel; level < endLevel; level++)
+		{
+			uint64_t levelWidth = std::max(1u, width >> level);
+			uint64_t levelHeight = std::max(1u, height >> level);
+			bytes += blockBytes != 0 ? ((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * blockBytes : levelWidth * levelHeight * texelBytes;
+		}
+
+		return bytes;
 	}
 
-	void OpenGLTexture2D::Bind(uint32_t slot) const
+	float OpenGLTexture2D::GetMaxAnisotropy()
 	{
-		glBindTextureUnit(slot, mRendererID);
+		static float maxAnisotropy = -1.0f;
+
+		if (maxAnisotropy < 0.0f)
+		{
+			maxAnisotropy = 1.0f;
+
+			if (glfwExtensionSupported("GL_ARB_texture_filter_anisotropic") || glfwExtensionSupported("GL_EXT_texture_filter_anisotropic"))
+				glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &maxAnisotropy);
+		}
+
+		return maxAnisotropy;
 	}
 
-	void OpenGLTexture2D::SetVerticalFlip(bool flip) const
+	TextureImportSettings OpenGLTexture2D::GetSupportedSettings(const TextureImportSettings& settings)
 	{
-		stbi_set_flip_vertically_on_load(flip);
+		static bool s3tcSupported = glfwExtensionSupported("GL_EXT_texture_compression_s3tc") == GLFW_TRUE;
+
+		// BC7 is core since 4.2, BC1 and BC3 still come from an extension
+		TextureImportSettings supportedSettings = settings;
+		supportedSettings.preferBC7 |= settings.compress && !s3tcSupported;
+		return supportedSettings;
 	}
 
-	void OpenGLTexture2D::OverrideTextureID(GLuint texID)
+	GLenum OpenGLTexture2D::GetCompressedFormat(TextureBlockFormat format, bool srgb)
 	{
-		mRendererID = texID;
+		switch (format)
+		{
+		case TextureBlockFormat::BC1:
+			return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		case TextureBlockFormat::BC3:
+			return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		case TextureBlockFormat::BC4:
+			return GL_COMPRESSED_RED_RGTC1;
+		case TextureBlockFormat::BC5:
+			return GL_COMPRESSED_RG_RGTC2;
+		case TextureBlockFormat::BC7:
+			return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+		default:
+			TS_CORE_ASSERT(false, "Format not supported!");
+			return 0;
+		}
 	}
 }
 
@@ -1,16 +1,23 @@
 #pragma once
 #include "Renderer/Texture.h"
+#include "Renderer/TextureImporter.h"
 #include <glad/glad.h>
 #include <Renderer/TextureAtlasHelper.h>
 
+// ARB_texture_filter_anisotropic, core since 4.6
+#ifndef GL_TEXTURE_MAX_ANISOTROPY
+#define GL_TEXTURE_MAX_ANISOTROPY 0x84FE
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY 0x84FF
+#endif
+
 namespace TS_ENGINE {
 
 	class OpenGLTexture2D : public Texture2D
 	{
 	public:
 		OpenGLTexture2D(uint32_t width, uint32_t height);
-		OpenGLTexture2D(const std::string& path);
-		OpenGLTexture2D(const char* name, const unsigned char* pixelData, uint32_t len);
+		OpenGLTexture2D(const std::string& path, const TextureImportSettings& settings);
+		OpenGLTexture2D(const char* name, const unsigned char* pixelData, uint32_t len, const TextureImportSettings& settings, bool keepPixels);
 
 		virtual ~OpenGLTexture2D();
 
@@ -48,12 +55,72 @@ namespace TS_ENGINE {
 		{
 			return data;
 		}
-		virtual std::vector<unsigned char> GetPixels() const override
+		virtual const std::vector<unsigned char>& GetPixels() const override
 		{
 			return mPixels;
 		}
 		
 		virtual void OverrideTextureID(GLuint texID) override;
+
+		virtual bool IsStreaming() const override
+		{
+			return mStreaming;
+		}
+
+		// Streaming, see OpenGLTextureStreamer. A streamed texture is created as a 1x1 placeholder, which stays its renderer ID
+		// until the smallest level of its storage was uploaded.
+		void BeginStreaming(const std::string& path);
+		// Allocates all levels of the decoded image, none of them sampled yet, and takes its pixels
+		GLuint AllocateStreamingStorage(TextureImage& image, const TextureImportSettings& settings);
+		// Levels from level down to the smallest are uploaded. Level 0 finishes streaming.
+		void SetStreamedLevel(uint32_t level);
+		GLuint GetStreamingID() const
+		{
+			return mStreamingID;
+		}
+
+		GLenum GetInternalFormat() const
+		{
+			return mInternalFormat;
+		}
+		GLenum GetDataFormat() const
+		{
+			return mDataFormat;
+		}
+
+		virtual uint32_t GetLevelCount() const override
+		{
+			return mLevelCount;
+		}
+		virtual uint32_t GetResidentLevel() const override
+		{
+			return mResidentLevel;
+		}
+		virtual uint64_t GetLevelBytes(uint32_t level) const override;
+		virtual bool CanChangeResidency() const override;
+		virtual bool SetResidentLevel(uint32_t level) override;
+		// Baked container dropped levels are reloaded from, 0 if there is none
+		uint64_t GetCacheKey() const
+		{
+			return mCacheKey;
+		}
+
+		// Estimated GPU memory of levels [firstLevel, endLevel) of a 2D texture, or of one layer of an array
+		static uint64_t GetStorageBytes(GLenum internalFormat, uint32_t width, uint32_t height, uint32_t firstLevel, uint32_t endLevel);
+		// 1 if anisotropic filtering isn't supported
+		static float GetMaxAnisotropy();
+		// Falls back to BC7 when the driver lacks S3TC. Asks the driver, so it's called on the main thread.
+		static TextureImportSettings GetSupportedSettings(const TextureImportSettings& settings);
+	private:
+		// Allocates storage for all levels of the image, sets the formats and returns the texture
+		GLuint CreateStorage(const TextureImage& image, const TextureImportSettings& settings);
+		// Uploads every level to mRendererID at once
+		void Upload(const TextureImage& image);
+		void SetSamplingParameters(GLuint texture, uint32_t levelCount, float anisotropy);
+		// Accounts bytes as the GPU memory the texture owns, in place of what it owned before
+		void TrackGPUMemory(uint64_t bytes);
+
+		static GLenum GetCompressedFormat(TextureBlockFormat format, bool srgb);
 	private:
 		unsigned char* data = nullptr;
 		std::vector<unsigned char> mPixels;
@@ -61,5 +128,12 @@ namespace TS_ENGINE {
 		uint32_t mWidth, mHeight, mChannels;
 		uint32_t mRendererID;
 		GLenum mInternalFormat, mDataFormat;
+		bool mStreaming = false;
+		GLuint mStreamingID = 0;		// Storage being streamed into, until level 0 arrived
+		uint32_t mLevelCount = 1;
+		uint32_t mResidentLevel = 0;	// Level 0 of the storage, the levels above are dropped
+		uint64_t mCacheKey = 0;			// Baked container dropped levels are reloaded from, 0 if there is none
+		float mAnisotropy = 1.0f;
+		uint64_t mGPUBytes = 0;			// Accounted for the storage the texture owns
 	};
 }
\ No newline at end of file
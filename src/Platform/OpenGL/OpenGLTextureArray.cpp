@@ -0,0 +1,197 @@
+#include "tspch.h"
+#include "Platform/OpenGL/OpenGLTextureArray.h"
+#include "Platform/OpenGL/OpenGLTexture.h"
+#include "Core/Application.h"
+#include "Renderer/GPUMemory.h"
+#include "Renderer/TextureContainer.h"
+#include <glad/glad.h>
+
+namespace TS_ENGINE {
+
+	OpenGLTextureArrayManager::~OpenGLTextureArrayManager()
+	{
+		// Views of the layers keep their storage alive
+		for (const auto& array : mArrays)
+			glDeleteTextures(1, &array.rendererID);
+
+		for (const auto& [rendererID, bytes] : mArrayBytes)
+			GPUMemoryManager::GetInstance()->Release(GPUMemoryCategory::Texture, bytes);
+	}
+
+	void OpenGLTextureArrayManager::Bind(uint32_t array)
+	{
+		uint32_t rendererID = mArrays[array].rendererID;
+
+		if (rendererID != mBoundArray)
+		{
+			glBindTextureUnit(sArraySlot, rendererID);
+			mBoundArray = rendererID;
+		}
+	}
+
+	uint64_t OpenGLTextureArrayManager::GetLevelBytes(uint32_t array, uint32_t level) const
+	{
+		const Array& textureArray = mArrays[array];
+		const ArrayFormat& format = textureArray.format;
+		return OpenGLTexture2D::GetStorageBytes(format.internalFormat, format.width, format.height, level, format.levels) * textureArray.capacity;
+	}
+
+	bool OpenGLTextureArrayManager::GetFormat(const Texture2D& texture, ArrayFormat& format)
+	{
+		uint32_t rendererID = texture.GetRendererID();
+
+		if (rendererID == 0 || texture.GetWidth() == 0 || texture.GetHeight() == 0)
+			return false;
+
+		// Views need immutable storage, which also fixes the mip levels
+		GLint immutable = GL_FALSE;
+		glGetTextureParameteriv(rendererID, GL_TEXTURE_IMMUTABLE_FORMAT, &immutable);
+
+		if (immutable != GL_TRUE)
+			return false;
+
+		GLint levels = 0;
+		GLint internalFormat = 0;
+		glGetTextureParameteriv(rendererID, GL_TEXTURE_IMMUTABLE_LEVELS, &levels);
+		glGetTextureLevelParameteriv(rendererID, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+
+		format.width = texture.GetWidth();
+		format.height = texture.GetHeight();
+		format.internalFormat = (uint32_t)internalFormat;
+		format.levels = (uint32_t)levels;
+		return levels > 0;
+	}
+
+	uint32_t OpenGLTextureArrayManager::CreateArray(const ArrayFormat& format, uint32_t capacity)
+	{
+		while (glGetError() != GL_NO_ERROR);
+
+		uint32_t rendererID;
+		glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &rendererID);
+		glTextureStorage3D(rendererID, format.levels, format.internalFormat, format.width, format.height, capacity);
+
+		if (glGetError() != GL_NO_ERROR)
+		{
+			glDeleteTextures(1, &rendererID);
+			return 0;
+		}
+
+		uint64_t bytes = OpenGLTexture2D::GetStorageBytes(format.internalFormat, format.width, format.height, 0, format.levels) * capacity;
+		GPUMemoryManager::GetInstance()->Allocate(GPUMemoryCategory::Texture, bytes);
+		mArrayBytes[rendererID] = bytes;
+
+		glTextureParameteri(rendererID, GL_TEXTURE_MIN_FILTER, format.levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTextureParameteri(rendererID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTextureParameteri(rendererID, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTextureParameteri(rendererID, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+		float anisotropy = std::min(Application::GetInstance().mTextureAnisotropy, OpenGLTexture2D::GetMaxAnisotropy());
+
+		if (anisotropy > 1.0f)
+			glTextureParameterf(rendererID, GL_TEXTURE_MAX_ANISOTROPY, anisotropy);
+
+		return rendererID;
+	}
+
+	void OpenGLTextureArrayManager::CopyTextureToLayer(uint32_t texture, uint32_t array, const ArrayFormat& format, uint32_t residentLevel, uint32_t layer)
+	{
+		for (uint32_t level = residentLevel; level < format.levels; level++)
+		{
+			GLsizei width = std::max(1u, format.width >> level);
+			GLsizei height = std::max(1u, format.height >> level);
+			glCopyImageSubData(texture, GL_TEXTURE_2D, level, 0, 0, 0, array, GL_TEXTURE_2D_ARRAY, level - residentLevel, 0, 0, layer, width, height, 1);
+		}
+	}
+
+	void OpenGLTextureArrayManager::CopyLayers(uint32_t sourceArray, uint32_t sourceResidentLevel, uint32_t destinationArray, uint32_t destinationResidentLevel,
+		const ArrayFormat& format, uint32_t layerCount)
+	{
+		if (layerCount == 0)
+			return;
+
+		for (uint32_t level = std::max(sourceResidentLevel, destinationResidentLevel); level < format.levels; level++)
+		{
+			GLsizei width = std::max(1u, format.width >> level);
+			GLsizei height = std::max(1u, format.height >> level);
+			glCopyImageSubData(sourceArray, GL_TEXTURE_2D_ARRAY, level - sourceResidentLevel, 0, 0, 0,
+				destinationArray, GL_TEXTURE_2D_ARRAY, level - destinationResidentLevel, 0, 0, 0, width, height, layerCount);
+		}
+	}
+
+	bool OpenGLTextureArrayManager::HasBakedLevels(const Texture2D& texture) const
+	{
+		return static_cast<const OpenGLTexture2D&>(texture).GetCacheKey() != 0;
+	}
+
+	bool OpenGLTextureArrayManager::UploadBakedLevels(const Texture2D& texture, uint32_t array, const ArrayFormat& format, uint32_t residentLevel, uint32_t layer,
+		uint32_t firstLevel, uint32_t endLevel)
+	{
+		const OpenGLTexture2D& glTexture = static_cast<const OpenGLTexture2D&>(texture);
+		TextureContainer container;
+
+		if (!container.Open(TextureCompressor::GetCachePath(glTexture.GetCacheKey())) || container.GetLevelCount() != format.levels)
+			return false;
+
+		// Rows of one, two and three channel images aren't 4 byte aligned
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		for (uint32_t level = firstLevel; level < endLevel; level++)
+		{
+			TextureContainerLevel containerLevel = container.GetLevel(level);
+			GLsizei width = std::max(1u, format.width >> level);
+			GLsizei height = std::max(1u, format.height >> level);
+
+			if (container.GetFormat() != TextureBlockFormat::None)
+				glCompressedTextureSubImage3D(array, level - residentLevel, 0, 0, layer, width, height, 1, format.internalFormat, (GLsizei)containerLevel.size, containerLevel.data);
+			else
+				glTextureSubImage3D(array, level - residentLevel, 0, 0, layer, width, height, 1, glTexture.GetDataFormat(), GL_UNSIGNED_BYTE, containerLevel.data);
+		}
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		return true;
+	}
+
+	uint32_t OpenGLTextureArrayManager::CreateLayerView(uint32_t array, const ArrayFormat& format, uint32_t layer, uint32_t parametersSource)
+	{
+		// glTextureView needs a name that was never bound, which glCreateTextures doesn't give
+		uint32_t view;
+		glGenTextures(1, &view);
+		glTextureView(view, GL_TEXTURE_2D, array, format.internalFormat, 0, format.levels, layer, 1);
+
+		const GLenum parameters[] = { GL_TEXTURE_MIN_FILTER, GL_TEXTURE_MAG_FILTER, GL_TEXTURE_WRAP_S, GL_TEXTURE_WRAP_T };
+
+		for (GLenum parameter : parameters)
+		{
+			GLint value = 0;
+			glGetTextureParameteriv(parametersSource, parameter, &value);
+			glTextureParameteri(view, parameter, value);
+		}
+
+		if (OpenGLTexture2D::GetMaxAnisotropy() > 1.0f)
+		{
+			GLfloat anisotropy = 1.0f;
+			glGetTextureParameterfv(parametersSource, GL_TEXTURE_MAX_ANISOTROPY, &anisotropy);
+			glTextureParameterf(view, GL_TEXTURE_MAX_ANISOTROPY, anisotropy);
+		}
+
+		return view;
+	}
+
+	void OpenGLTextureArrayManager::DeleteTexture(uint32_t texture)
+	{
+		// Names are reused, so a deleted array must not look bound
+		if (texture == mBoundArray)
+			mBoundArray = 0;
+
+		glDeleteTextures(1, &texture);
+
+		// Views own no storage
+		auto it = mArrayBytes.find(texture);
+
+		if (it != mArrayBytes.end())
+		{
+			GPUMemoryManager::GetInstance()->Release(GPUMemoryCategory::Texture, it->second);
+			mArrayBytes.erase(it);
+		}
+	}
+}
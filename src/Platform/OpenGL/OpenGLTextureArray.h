@@ -0,0 +1,29 @@
+#pragma once
+#include "Renderer/TextureArray.h"
+
+namespace TS_ENGINE {
+
+	class OpenGLTextureArrayManager : public TextureArrayManager
+	{
+	public:
+		OpenGLTextureArrayManager() = default;
+		virtual ~OpenGLTextureArrayManager();
+
+		virtual void Bind(uint32_t array) override;
+		virtual uint64_t GetLevelBytes(uint32_t array, uint32_t level) const override;
+	protected:
+		virtual bool GetFormat(const Texture2D& texture, ArrayFormat& format) override;
+		virtual uint32_t CreateArray(const ArrayFormat& format, uint32_t capacity) override;
+		virtual void CopyTextureToLayer(uint32_t texture, uint32_t array, const ArrayFormat& format, uint32_t residentLevel, uint32_t layer) override;
+		virtual void CopyLayers(uint32_t sourceArray, uint32_t sourceResidentLevel, uint32_t destinationArray, uint32_t destinationResidentLevel,
+			const ArrayFormat& format, uint32_t layerCount) override;
+		virtual bool HasBakedLevels(const Texture2D& texture) const override;
+		virtual bool UploadBakedLevels(const Texture2D& texture, uint32_t array, const ArrayFormat& format, uint32_t residentLevel, uint32_t layer,
+			uint32_t firstLevel, uint32_t endLevel) override;
+		virtual uint32_t CreateLayerView(uint32_t array, const ArrayFormat& format, uint32_t layer, uint32_t parametersSource) override;
+		virtual void DeleteTexture(uint32_t texture) override;
+	private:
+		uint32_t mBoundArray = 0;		// Renderer ID bound to sArraySlot
+		std::unordered_map<uint32_t, uint64_t> mArrayBytes;		// GPU memory of each array's storage, by renderer ID
+	};
+}
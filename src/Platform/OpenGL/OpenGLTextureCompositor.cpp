@@ -0,0 +1,157 @@
+#include "tspch.h"
+#include "Platform/OpenGL/OpenGLTextureCompositor.h"
+#include "Renderer/Framebuffer.h"
+#include <glad/glad.h>
+
+namespace TS_ENGINE {
+
+	static const char* sCompositeVertexShaderSource = R"(
+		#version 450 core
+
+		void main()
+		{
+			vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+			gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+		}
+	)";
+
+	// The viewport covers the rect and its padding, UVs are clamped so the padding repeats the edge texels
+	static const char* sCompositeFragmentShaderSource = R"(
+		#version 450 core
+
+		layout(binding = 0) uniform sampler2D u_Texture;
+
+		uniform vec4 u_Rect;			// Pixels, without the padding
+		uniform vec4 u_Tint;
+		uniform int u_HasTexture;
+
+		layout(location = 0) out vec4 o_Color;
+
+		void main()
+		{
+			if (u_HasTexture == 0)
+			{
+				o_Color = u_Tint;
+				return;
+			}
+
+			// Half a texel in from the edges, sources may wrap
+			vec2 halfTexel = 0.5 / vec2(textureSize(u_Texture, 0));
+			vec2 uv = clamp((gl_FragCoord.xy - u_Rect.xy) / u_Rect.zw, halfTexel, 1.0 - halfTexel);
+			o_Color = texture(u_Texture, uv) * u_Tint;
+		}
+	)";
+
+	OpenGLTextureCompositor::OpenGLTextureCompositor()
+	{
+		int success;
+		GLchar infoLog[1024];
+
+		GLuint shaders[2] = { glCreateShader(GL_VERTEX_SHADER), glCreateShader(GL_FRAGMENT_SHADER) };
+		const char* sources[2] = { sCompositeVertexShaderSource, sCompositeFragmentShaderSource };
+		const char* types[2] = { "VERTEX", "FRAGMENT" };
+		mProgram = glCreateProgram();
+
+		for (int i = 0; i < 2; i++)
+		{
+			glShaderSource(shaders[i], 1, &sources[i], NULL);
+			glCompileShader(shaders[i]);
+			glGetShaderiv(shaders[i], GL_COMPILE_STATUS, &success);
+
+			if (!success)
+			{
+				glGetShaderInfoLog(shaders[i], 1024, NULL, infoLog);
+				TS_CORE_ERROR("ERROR::SHADER_COMPILATION_ERROR of type: {0} (TextureComposite)\n{1}", types[i], infoLog);
+			}
+
+			glAttachShader(mProgram, shaders[i]);
+		}
+
+		glLinkProgram(mProgram);
+		glGetProgramiv(mProgram, GL_LINK_STATUS, &success);
+
+		if (!success)
+		{
+			glGetProgramInfoLog(mProgram, 1024, NULL, infoLog);
+			TS_CORE_ERROR("ERROR::PROGRAM_LINKING_ERROR (TextureComposite)\n{0}", infoLog);
+		}
+
+		glDeleteShader(shaders[0]);
+		glDeleteShader(shaders[1]);
+
+		glCreateVertexArrays(1, &mEmptyVertexArray);
+	}
+
+	OpenGLTextureCompositor::~OpenGLTextureCompositor()
+	{
+		glDeleteProgram(mProgram);
+		glDeleteVertexArrays(1, &mEmptyVertexArray);
+	}
+
+	Ref<Texture2D> OpenGLTextureCompositor::Composite(uint32_t width, uint32_t height, const std::vector<TextureCompositeRect>& rects)
+	{
+		GLint previousFramebuffer = 0;
+		GLint previousProgram = 0;
+		GLint previousViewport[4];
+		glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+		glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+		glGetIntegerv(GL_VIEWPORT, previousViewport);
+
+		FramebufferSpecification spec;
+		spec.Width = width;
+		spec.Height = height;
+		spec.Attachments = { FramebufferTextureFormat::RGBA8 };
+		Ref<Framebuffer> framebuffer = Framebuffer::Create(spec);
+		framebuffer->Bind();
+
+		GLfloat clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		glClearBufferfv(GL_COLOR, 0, clearColor);
+
+		GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+		GLboolean blend = glIsEnabled(GL_BLEND);
+		glDisable(GL_DEPTH_TEST);
+		glDisable(GL_BLEND);
+
+		glUseProgram(mProgram);
+		glBindVertexArray(mEmptyVertexArray);
+		GLint rectLocation = glGetUniformLocation(mProgram, "u_Rect");
+		GLint tintLocation = glGetUniformLocation(mProgram, "u_Tint");
+		GLint hasTextureLocation = glGetUniformLocation(mProgram, "u_HasTexture");
+
+		for (const auto& rect : rects)
+		{
+			TS_CORE_ASSERT(rect.x >= rect.padding && rect.y >= rect.padding
+				&& rect.x + rect.width + rect.padding <= width && rect.y + rect.height + rect.padding <= height);
+
+			glViewport(rect.x - rect.padding, rect.y - rect.padding, rect.width + 2 * rect.padding, rect.height + 2 * rect.padding);
+			glUniform4f(rectLocation, (float)rect.x, (float)rect.y, (float)rect.width, (float)rect.height);
+			glUniform4fv(tintLocation, 1, glm::value_ptr(rect.tint));
+			glUniform1i(hasTextureLocation, rect.texture ? 1 : 0);
+
+			if (rect.texture)
+				glBindTextureUnit(0, rect.texture->GetRendererID());
+
+			glDrawArrays(GL_TRIANGLES, 0, 3);
+		}
+
+		// The framebuffer is temporary, its pixels move into a regular texture
+		Ref<Texture2D> texture = Texture2D::Create(width, height);
+		glCopyImageSubData(framebuffer->GetColorAttachmentRendererID(0), GL_TEXTURE_2D, 0, 0, 0, 0,
+			texture->GetRendererID(), GL_TEXTURE_2D, 0, 0, 0, 0, width, height, 1);
+
+		glBindTextureUnit(0, 0);
+		glBindVertexArray(0);
+		glUseProgram(previousProgram);
+
+		if (depthTest)
+			glEnable(GL_DEPTH_TEST);
+
+		if (blend)
+			glEnable(GL_BLEND);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+		glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+
+		return texture;
+	}
+}
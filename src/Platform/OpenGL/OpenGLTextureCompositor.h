@@ -0,0 +1,17 @@
+#pragma once
+#include "Renderer/TextureCompositor.h"
+
+namespace TS_ENGINE {
+
+	class OpenGLTextureCompositor : public TextureCompositor
+	{
+	public:
+		OpenGLTextureCompositor();
+		virtual ~OpenGLTextureCompositor();
+
+		virtual Ref<Texture2D> Composite(uint32_t width, uint32_t height, const std::vector<TextureCompositeRect>& rects) override;
+	private:
+		uint32_t mProgram = 0;
+		uint32_t mEmptyVertexArray = 0;		// The full screen triangle is generated from gl_VertexID
+	};
+}
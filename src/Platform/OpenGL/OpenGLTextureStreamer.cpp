@@ -0,0 +1,93 @@
+#include "tspch.h"
+#include "Platform/OpenGL/OpenGLTextureStreamer.h"
+#include "Platform/OpenGL/OpenGLTexture.h"
+#include <glad/glad.h>
+
+namespace TS_ENGINE {
+
+	OpenGLTextureStreamer::OpenGLTextureStreamer()
+	{
+		mStagingBuffer = StreamBuffer::Create(sUploadBudget);
+	}
+
+	Ref<Texture2D> OpenGLTextureStreamer::CreatePlaceholder(const std::string& path)
+	{
+		Ref<OpenGLTexture2D> texture = CreateRef<OpenGLTexture2D>(1, 1);
+		texture->BeginStreaming(path);
+		return texture;
+	}
+
+	TextureImportSettings OpenGLTextureStreamer::GetSupportedSettings(const TextureImportSettings& settings)
+	{
+		return OpenGLTexture2D::GetSupportedSettings(settings);
+	}
+
+	void OpenGLTextureStreamer::AllocateStorage(Texture2D& texture, TextureImage& image, const TextureImportSettings& settings)
+	{
+		static_cast<OpenGLTexture2D&>(texture).AllocateStreamingStorage(image, settings);
+	}
+
+	bool OpenGLTextureStreamer::UploadRows(Texture2D& texture, const TextureImage& image, uint32_t level, uint32_t firstRow, uint32_t rowCount)
+	{
+		OpenGLTexture2D& glTexture = static_cast<OpenGLTexture2D&>(texture);
+		size_t rowBytes = image.GetRowBytes(level);
+		uint32_t size = (uint32_t)(rowCount * rowBytes);
+		const uint8_t* rows = image.levels[level].data + firstRow * rowBytes;
+
+		uint32_t offset = 0;
+		void* staging = mStagingBuffer->Allocate(size, 16, offset);
+
+		if (!staging)
+		{
+			if (mStagedBytes > 0)
+				return false;
+
+			// Rows larger than a region, or a ring that couldn't be mapped
+			CopyRows(glTexture, image, level, firstRow, rowCount, rows);
+			return true;
+		}
+
+		std::memcpy(staging, rows, size);
+		mStagedBytes += size;
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mStagingBuffer->GetRendererID());
+		CopyRows(glTexture, image, level, firstRow, rowCount, (const void*)(uintptr_t)offset);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		return true;
+	}
+
+	void OpenGLTextureStreamer::CopyRows(OpenGLTexture2D& texture, const TextureImage& image, uint32_t level, uint32_t firstRow, uint32_t rowCount, const void* data)
+	{
+		GLsizei levelWidth = std::max(1u, image.width >> level);
+		GLsizei levelHeight = std::max(1u, image.height >> level);
+
+		// Rows of one, two and three channel images aren't 4 byte aligned
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		if (image.format != TextureBlockFormat::None)
+		{
+			// Rows of blocks, the last one may cover less than 4 texel rows
+			GLint y = (GLint)firstRow * 4;
+			GLsizei height = std::min((GLsizei)rowCount * 4, levelHeight - y);
+			glCompressedTextureSubImage2D(texture.GetStreamingID(), level, 0, y, levelWidth, height, texture.GetInternalFormat(),
+				(GLsizei)(rowCount * image.GetRowBytes(level)), data);
+		}
+		else
+		{
+			glTextureSubImage2D(texture.GetStreamingID(), level, 0, firstRow, levelWidth, rowCount, texture.GetDataFormat(), GL_UNSIGNED_BYTE, data);
+		}
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	}
+
+	void OpenGLTextureStreamer::SetStreamedLevel(Texture2D& texture, uint32_t level)
+	{
+		static_cast<OpenGLTexture2D&>(texture).SetStreamedLevel(level);
+	}
+
+	void OpenGLTextureStreamer::NextFrame()
+	{
+		mStagingBuffer->NextFrame();
+		mStagedBytes = 0;
+	}
+}
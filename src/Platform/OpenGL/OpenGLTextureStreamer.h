@@ -0,0 +1,29 @@
+#pragma once
+#include "Renderer/TextureStreamer.h"
+#include "Renderer/StreamBuffer.h"
+
+namespace TS_ENGINE {
+
+	class OpenGLTexture2D;
+
+	// Stages rows in a StreamBuffer of its own, bound as the pixel unpack buffer for the copies into the textures
+	class OpenGLTextureStreamer : public TextureStreamer
+	{
+	public:
+		OpenGLTextureStreamer();
+		virtual ~OpenGLTextureStreamer() = default;
+	protected:
+		virtual Ref<Texture2D> CreatePlaceholder(const std::string& path) override;
+		virtual TextureImportSettings GetSupportedSettings(const TextureImportSettings& settings) override;
+		virtual void AllocateStorage(Texture2D& texture, TextureImage& image, const TextureImportSettings& settings) override;
+		virtual bool UploadRows(Texture2D& texture, const TextureImage& image, uint32_t level, uint32_t firstRow, uint32_t rowCount) override;
+		virtual void SetStreamedLevel(Texture2D& texture, uint32_t level) override;
+		virtual void NextFrame() override;
+	private:
+		// data is an offset in the bound unpack buffer, or client memory when none is bound
+		void CopyRows(OpenGLTexture2D& texture, const TextureImage& image, uint32_t level, uint32_t firstRow, uint32_t rowCount, const void* data);
+
+		Ref<StreamBuffer> mStagingBuffer;
+		size_t mStagedBytes = 0;		// In the staging buffer's current region
+	};
+}
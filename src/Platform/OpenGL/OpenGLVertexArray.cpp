@@ -5,7 +5,7 @@
 
 namespace TS_ENGINE {
 
-	static GLenum ShaderDataTypeToOpenGLBaseType(ShaderDataType type)
+	uint32_t ShaderDataTypeToOpenGLBaseType(ShaderDataType type)
 	{
 		switch (type)
 		{
@@ -31,6 +31,16 @@ namespace TS_ENGINE {
 			return GL_FLOAT;
 		case ShaderDataType::MAT4:
 			return GL_FLOAT;
+		case ShaderDataType::HALF2:
+			return GL_HALF_FLOAT;
+		case ShaderDataType::PACKED_NORMAL:
+			return GL_INT_2_10_10_10_REV;
+		case ShaderDataType::UBYTE4:
+			return GL_UNSIGNED_BYTE;
+		case ShaderDataType::USHORT4:
+			return GL_UNSIGNED_SHORT;
+		default:
+			break;
 		}
 
 		TS_CORE_ASSERT(false, "Unknown ShaderDataType");
@@ -90,6 +100,8 @@ namespace TS_ENGINE {
 			case ShaderDataType::INT3:
 
 			case ShaderDataType::INT4:
+
+			case ShaderDataType::UBYTE4:
 			{
 				glEnableVertexAttribArray(mVertexBufferIndex);
 
@@ -113,6 +125,12 @@ namespace TS_ENGINE {
 			case ShaderDataType::FLOAT3:
 
 			case ShaderDataType::FLOAT4:
+
+			case ShaderDataType::HALF2:
+
+			case ShaderDataType::PACKED_NORMAL:
+
+			case ShaderDataType::USHORT4:
 			{
 				glEnableVertexAttribArray(mVertexBufferIndex);
 
@@ -153,6 +171,25 @@ namespace TS_ENGINE {
 			}
 		}
 
+		// Each attribute was given a binding of its own by glVertexAttribPointer, at its offset in the vertex
+		if (mVertexBuffers.empty())
+		{
+			for (const auto& element : layout)
+			{
+				if (element.type == ShaderDataType::MAT3 || element.type == ShaderDataType::MAT4)
+				{
+					uint8_t count = element.GetComponentCount();
+
+					for (uint8_t i = 0; i < count; i++)
+						mSourceOffsets.push_back((uint32_t)(element.offset + sizeof(float) * count * i));
+				}
+				else
+				{
+					mSourceOffsets.push_back((uint32_t)element.offset);
+				}
+			}
+		}
+
 		mVertexBuffers.push_back(vertexBuffer);
 	}
 
@@ -163,4 +200,12 @@ namespace TS_ENGINE {
 
 		mIndexBuffer = indexBuffer;
 	}
+
+	void OpenGLVertexArray::SetVertexSource(uint32_t buffer, uint32_t offset)
+	{
+		GLsizei stride = (GLsizei)mVertexBuffers[0]->GetLayout().GetStride();
+
+		for (uint32_t i = 0; i < (uint32_t)mSourceOffsets.size(); i++)
+			glVertexArrayVertexBuffer(mRendererID, i, buffer, (GLintptr)offset + mSourceOffsets[i], stride);
+	}
 }
\ No newline at end of file
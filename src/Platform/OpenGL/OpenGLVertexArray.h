@@ -3,12 +3,16 @@
 
 namespace TS_ENGINE {
 
+	// GL component type of a vertex attribute, shared by every OpenGL vertex layout
+	uint32_t ShaderDataTypeToOpenGLBaseType(ShaderDataType type);
+
 	class OpenGLVertexArray : public VertexArray
 	{
 	private:
 		uint32_t mRendererID;
 		uint32_t mVertexBufferIndex = 0;
 		std::vector<Ref<VertexBuffer>> mVertexBuffers;
+		std::vector<uint32_t> mSourceOffsets;		// Offset in its vertex of each attribute of the first vertex buffer
 		Ref<IndexBuffer> mIndexBuffer;
 	public:
 		OpenGLVertexArray();
@@ -19,6 +23,7 @@ namespace TS_ENGINE {
 
 		virtual void AddVertexBuffer(const Ref<VertexBuffer>& vertexBuffer) override;
 		virtual void SetIndexBuffer(const Ref<IndexBuffer>& indexBuffer) override;
+		virtual void SetVertexSource(uint32_t buffer, uint32_t offset) override;
 
 		virtual const std::vector<Ref<VertexBuffer>>& GetVertexBuffers() const
 		{
@@ -3,6 +3,7 @@
 #include "Renderer/MaterialManager.h"
 #include "Core/Factory.h"
 #include "Renderer/RenderCommand.h"
+#include "Renderer/DynamicBatcher.h"
 
 namespace TS_ENGINE {
 	
@@ -10,6 +11,7 @@ namespace TS_ENGINE {
 		mId(0),
 		mOffsetMatrix(Matrix4(1)),
 		mNode(nullptr),
+		mBoneTransformMatrix(Matrix4(1)),
 		mJointGuiNode(nullptr),
 		mBoneGuiNodes({})
 	{
@@ -89,29 +91,17 @@ namespace TS_ENGINE {
 		}
 	}
 
-	void Bone::Render(Ref<Shader> _shader)
+	void Bone::Render(Ref<Shader> _shader, DynamicBatcher* _dynamicBatcher)
 	{
 		// Make sure bone is never rendered in wireframe
 		RenderCommand::EnableWireframe(false);
 
 		// Render mJointGuiNode 
-		_shader->SetMat4("u_Model", mJointGuiNode->mTransform->GetWorldTransformationMatrix());
-#ifdef TS_ENGINE_EDITOR
-		mJointGuiNode->GetMesh()->Render(mJointGuiNode->GetEntity()->GetEntityID(), false);
-#else
-		mJointGuiNode->GetMesh()->Render(false);
-#endif
+		RenderGuiNode(_shader, mJointGuiNode, _dynamicBatcher);
 
 		// Render all boneGuiNodes 
 		for(auto& boneGuiNode : mBoneGuiNodes)
-		{
-			_shader->SetMat4("u_Model", boneGuiNode->mTransform->GetWorldTransformationMatrix());
-#ifdef TS_ENGINE_EDITOR		
-			boneGuiNode->GetMesh()->Render(boneGuiNode->GetEntity()->GetEntityID(), false);
-#else		
-			boneGuiNode->GetMesh()->Render(false);
-#endif
-		}
+			RenderGuiNode(_shader, boneGuiNode, _dynamicBatcher);
 
 		// If wireframe mode is enabled, re-enable it for other meshes
 		if (Application::GetInstance().IsWireframeModeEnabled())
@@ -120,6 +110,25 @@ namespace TS_ENGINE {
 		}
 	}
 
+	void Bone::RenderGuiNode(Ref<Shader> _shader, Ref<Node> _guiNode, DynamicBatcher* _dynamicBatcher)
+	{
+		const Matrix4& worldMatrix = _guiNode->mTransform->GetWorldTransformationMatrix();
+
+#ifdef TS_ENGINE_EDITOR
+		if (_dynamicBatcher && _dynamicBatcher->Submit(_guiNode->GetEntity()->GetEntityID(), _guiNode->GetMesh(), worldMatrix))
+			return;
+
+		_shader->SetMat4("u_Model", worldMatrix);
+		_guiNode->GetMesh()->Render(_guiNode->GetEntity()->GetEntityID(), false);
+#else
+		if (_dynamicBatcher && _dynamicBatcher->Submit(_guiNode->GetMesh(), worldMatrix))
+			return;
+
+		_shader->SetMat4("u_Model", worldMatrix);
+		_guiNode->GetMesh()->Render(false);
+#endif
+	}
+
 	bool Bone::PickNode(int _entityId)
 	{
 		// If JointGuiNode's entity Id matches
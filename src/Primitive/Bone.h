@@ -5,6 +5,8 @@
 
 namespace TS_ENGINE {
 
+	class DynamicBatcher;
+
 	struct VertexWeight 
 	{
 		unsigned int vertexId = 0;
@@ -32,15 +34,19 @@ namespace TS_ENGINE {
 		void SetNode(Ref<Node> _node);
 		Ref<Node> GetNode();
 		int GetId();
+		const Matrix4& GetBoneTransformMatrix() const { return mBoneTransformMatrix; }
 
 		void Initialize(const std::string& _name);
 		void Update(Ref<Shader> _shader);
-		void Render(Ref<Shader> _shader);
+		// Draws the joint and bone GUI. With a dynamic batcher they are queued to it instead, for the caller to flush.
+		void Render(Ref<Shader> _shader, DynamicBatcher* _dynamicBatcher = nullptr);
 
 		void UpdateBoneGui(Ref<Node> _rootNode);
 
 		bool PickNode(int _entityId);
 	private:
+		void RenderGuiNode(Ref<Shader> _shader, Ref<Node> _guiNode, DynamicBatcher* _dynamicBatcher);
+
 		int mId;									// ID is index in finalBoneMatrices
 		Matrix4 mOffsetMatrix;						// OffsetMatrix transforms vertex from model space to bone space
 		Ref<Node> mNode;							// Node that will be effected by the bone			
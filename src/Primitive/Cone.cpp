@@ -63,12 +63,32 @@ namespace TS_ENGINE {
         }
 
 		// Generate indices for base
-		for (int i = 1; i <= numSegments; ++i) 
+		mesh->SetIndices(CreateIndices(numSegments, 1));
+
+		// LODs skip segments of the same vertex ring
+		const int lodSteps[] = { 2, 3, 5 };
+
+		for (int i = 0; i < 3; i++)
+		{
+			int step = lodSteps[i];
+
+			if (numSegments % step == 0 && numSegments / step >= 3)
+				mesh->AddLOD(CreateIndices(numSegments, step), Mesh::sDefaultLODScreenSizes[i]);
+		}
+	}
+
+	std::vector<uint32_t> Cone::CreateIndices(int numSegments, int step)
+	{
+		std::vector<uint32_t> indices;
+
+		for (int i = 0; i < numSegments; i += step)
 		{
-			mesh->AddIndex(0);
-			mesh->AddIndex(i);
-			mesh->AddIndex((i % numSegments) + 1);
+			indices.push_back(0);
+			indices.push_back(i + 1);
+			indices.push_back(((i + step) % numSegments) + 1);
 		}
+
+		return indices;
 	}
 
 	Ref<Mesh> Cone::GetMesh()
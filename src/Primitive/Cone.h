@@ -14,6 +14,8 @@ namespace TS_ENGINE {
 
 	private:
 		void CreateMesh(Ref<Mesh> mesh, float radius, float height, int numSegments);		
+		// Triangles from the apex over every step-th segment
+		std::vector<uint32_t> CreateIndices(int numSegments, int step);
 	
 	private:
 		float mPI = 3.141f;
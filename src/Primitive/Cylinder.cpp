@@ -51,18 +51,40 @@ namespace TS_ENGINE {
 		}
 
 		// Generate indices for side
-		for (int i = 0; i < numSegments; ++i)
+		mesh->SetIndices(CreateIndices(numSegments, 1));
+
+		// LODs skip segments of the same vertex ring
+		const int lodSteps[] = { 2, 3, 5 };
+
+		for (int i = 0; i < 3; i++)
 		{
-			mesh->AddIndex(i * 2);
-			mesh->AddIndex(i * 2 + 1);
-			mesh->AddIndex((i + 1) * 2 + 1);
+			int step = lodSteps[i];
 
-			mesh->AddIndex(i * 2);
-			mesh->AddIndex((i + 1) * 2 + 1);
-			mesh->AddIndex((i + 1) * 2);
+			if (numSegments % step == 0 && numSegments / step >= 3)
+				mesh->AddLOD(CreateIndices(numSegments, step), Mesh::sDefaultLODScreenSizes[i]);
 		}
 	}
 
+	std::vector<uint32_t> Cylinder::CreateIndices(int numSegments, int step)
+	{
+		std::vector<uint32_t> indices;
+
+		for (int i = 0; i < numSegments; i += step)
+		{
+			int next = i + step;
+
+			indices.push_back(i * 2);
+			indices.push_back(i * 2 + 1);
+			indices.push_back(next * 2 + 1);
+
+			indices.push_back(i * 2);
+			indices.push_back(next * 2 + 1);
+			indices.push_back(next * 2);
+		}
+
+		return indices;
+	}
+
 
 	Ref<Mesh> Cylinder::GetMesh()
 	{
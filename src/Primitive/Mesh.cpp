@@ -2,13 +2,21 @@
 #include "Mesh.h"
 #include "Application.h"
 #include "Renderer/RenderCommand.h"
+#include "Renderer/StreamBuffer.h"
+#include "Primitive/MeshSimplifier.h"
+#include "Primitive/MeshOptimizer.h"
 
 namespace TS_ENGINE {
 
+	const float Mesh::sDefaultLODScreenSizes[Mesh::sMaxLODs] = { 0.5f, 0.25f, 0.125f, 0.0625f };
+	uint32_t Mesh::sTrackedVersion = 0;
+
 	Mesh::Mesh() :
 		mStatsRegistered(false),
 		mDrawMode(DrawMode::TRIANGLE),
-		mHasBoneInfluence(false)
+		mHasBoneInfluence(false),
+		mVertexFormat(VertexFormat::STANDARD),
+		mVertexFormatOverridden(false)
 	{
 		mPrimitiveType = PrimitiveType::MODEL;
 		std::string shaderDir = Application::s_ResourcesDir.string() + "\\Shaders\\";
@@ -18,9 +26,9 @@ namespace TS_ENGINE {
 
 	Mesh::~Mesh()
 	{
+		ReleaseGeometry();
 		mVertices.clear();
 		mIndices.clear();
-		mVertexArray = nullptr;
 		mStatsRegistered = false;
 		mDrawMode = DrawMode::TRIANGLE;
 		mPrimitiveType = PrimitiveType::MODEL;
@@ -40,6 +48,9 @@ namespace TS_ENGINE {
 	void Mesh::SetMaterial(Ref<Material> material)
 	{
 		mMaterial = material;
+
+		if (mTracked)
+			sTrackedVersion++;
 	}
 
 	void Mesh::SetVertices(std::vector<Vertex> vertices) 
@@ -50,6 +61,34 @@ namespace TS_ENGINE {
 	void Mesh::SetIndices(std::vector<uint32_t> indices) 
 	{ 
 		mIndices = indices;
+		mMeshlets.clear();
+		mLODs.clear();
+		mLODIndices.clear();
+	}
+
+	void Mesh::UpdateVertices(const std::vector<Vertex>& vertices)
+	{
+		bool created = mArenaHandle != MeshArena::sInvalidHandle || mVertexArray;
+		VertexFormat vertexFormat = mVertexFormatOverridden ? mVertexFormat : VertexFormatUtils::SelectFormat(vertices, mHasBoneInfluence, mDrawMode == DrawMode::LINE);
+
+		bool sameLayout = created && !vertices.empty() && vertices.size() == mVertices.size() && vertexFormat == mVertexFormat;
+		mVertices = vertices;
+
+		// Vertices that change after creation are drawn from the stream buffer, so arena meshes move to buffers of their own
+		mStreamed = true;
+
+		if (!sameLayout || mArenaHandle != MeshArena::sInvalidHandle)
+		{
+			Create(mDrawMode);
+			return;
+		}
+
+		ComputeBounds();
+		mBVH = nullptr;
+		mVertexVersion++;
+
+		mStreamedVertexData = VertexFormatUtils::Pack(mVertices, mVertexFormat);
+		mStreamedFrame = UINT64_MAX;
 	}
 
 	void Mesh::AddVertex(Vertex vertex)
@@ -66,33 +105,91 @@ namespace TS_ENGINE {
 	{
 		mDrawMode = drawMode;
 
-		mVertexArray = VertexArray::Create();
+		ComputeBounds();
+		mBVH = nullptr;
+		mVertexVersion++;
 
-		Ref<VertexBuffer> vertexBuffer = VertexBuffer::Create(&mVertices[0], (uint32_t)mVertices.size() * sizeof(Vertex));
+		if (mTracked)
+			sTrackedVersion++;
 
-		vertexBuffer->SetLayout({
-			{ ShaderDataType::FLOAT4, "a_Position"},	// Position
-			{ ShaderDataType::FLOAT2, "a_TexCoord"},	// UV
-			{ ShaderDataType::FLOAT3, "a_Normal"},		// Normal
-			{ ShaderDataType::INT4,   "a_BoneIds" },	// Bone IDs
-			{ ShaderDataType::FLOAT4, "a_Weights" }		// Bone Weights
-			});
+		ReleaseGeometry();
 
-		mVertexArray->AddVertexBuffer(vertexBuffer);
+		if (!mVertexFormatOverridden)
+			mVertexFormat = VertexFormatUtils::SelectFormat(mVertices, mHasBoneInfluence, mDrawMode == DrawMode::LINE);
+
+		std::vector<uint8_t> vertexData = VertexFormatUtils::Pack(mVertices, mVertexFormat);
 
 		if (mDrawMode == DrawMode::TRIANGLE)
 		{
-			Ref<IndexBuffer> indexBuffer = IndexBuffer::Create(&mIndices[0], (uint32_t)mIndices.size());
+			// LOD indices follow the base indices
+			std::vector<uint32_t> lodIndices;
+
+			if (!mLODIndices.empty())
+			{
+				lodIndices.reserve(mIndices.size() + mLODIndices.size());
+				lodIndices.insert(lodIndices.end(), mIndices.begin(), mIndices.end());
+				lodIndices.insert(lodIndices.end(), mLODIndices.begin(), mLODIndices.end());
+			}
+
+			std::vector<uint32_t>& indices = mLODIndices.empty() ? mIndices : lodIndices;
+
+			// 16-bit indices whenever every vertex can be addressed with them
+			std::vector<uint16_t> indices16;
+
+			if (mVertices.size() <= 65536)
+				indices16.assign(indices.begin(), indices.end());
+
+			// Shared storage, own buffers only when the arena is disabled or can't grow
+			if (Application::GetInstance().mMeshArena && !mStreamed && !mVertices.empty() && !indices.empty())
+			{
+				mArena = MeshArena::GetInstance();
+
+				if (!indices16.empty())
+					mArenaHandle = mArena->Allocate(mVertexFormat, vertexData.data(), (uint32_t)mVertices.size(), IndexType::UINT16, indices16.data(), (uint32_t)indices16.size());
+				else
+					mArenaHandle = mArena->Allocate(mVertexFormat, vertexData.data(), (uint32_t)mVertices.size(), IndexType::UINT32, indices.data(), (uint32_t)indices.size());
+
+				if (mArenaHandle != MeshArena::sInvalidHandle)
+					return;
+
+				mArena = nullptr;
+			}
+
+			mVertexArray = VertexArray::Create();
+			Ref<VertexBuffer> vertexBuffer = VertexBuffer::Create(vertexData.data(), (uint32_t)vertexData.size());
+			vertexBuffer->SetLayout(VertexFormatUtils::GetBufferLayout(mVertexFormat));
+			mVertexArray->AddVertexBuffer(vertexBuffer);
+
+			Ref<IndexBuffer> indexBuffer;
+
+			if (!indices16.empty())
+				indexBuffer = IndexBuffer::Create(indices16.data(), (uint32_t)indices16.size());
+			else
+				indexBuffer = IndexBuffer::Create(indices.data(), (uint32_t)indices.size());
+
 			mVertexArray->SetIndexBuffer(indexBuffer);
 		}
+		else
+		{
+			mVertexArray = VertexArray::Create();
+			Ref<VertexBuffer> vertexBuffer = VertexBuffer::Create(vertexData.data(), (uint32_t)vertexData.size());
+			vertexBuffer->SetLayout(VertexFormatUtils::GetBufferLayout(mVertexFormat));
+			mVertexArray->AddVertexBuffer(vertexBuffer);
+		}
 
 		mVertexArray->Unbind();
+
+		if (mStreamed)
+		{
+			mStreamedVertexData = std::move(vertexData);
+			mStreamedFrame = UINT64_MAX;
+		}
 	}
 
 #ifdef TS_ENGINE_EDITOR
-	void Mesh::Render(int entityID, bool _enableTextures)
+	void Mesh::Render(int entityID, bool _enableTextures, uint32_t lod)
 #else
-	void Mesh::Render(bool _enableTextures)
+	void Mesh::Render(bool _enableTextures, uint32_t lod)
 #endif
 	{
 		// Render Material
@@ -102,20 +199,225 @@ namespace TS_ENGINE {
 		mMaterial->Render(_enableTextures);
 #endif
 
+		uint32_t indexCount = (uint32_t)mIndices.size();
+
 		// Render Command To Draw Geometry
+		if (mDrawMode == DrawMode::TRIANGLE && lod > 0 && lod <= mLODs.size())
+		{
+			const MeshLOD& meshLOD = mLODs[lod - 1];
+			indexCount = meshLOD.indexCount;
+			DrawRange(meshLOD.firstIndex, meshLOD.indexCount);
+			TS_ENGINE::Application::GetInstance().AddLODSavedTriangles((uint32_t)(mIndices.size() - meshLOD.indexCount) / 3);
+		}
+		else
+			Draw();
+
+		// Add DrawCalls, Vertices and Indices for Stats
+		TS_ENGINE::Application::GetInstance().AddDrawCalls(1);
+		TS_ENGINE::Application::GetInstance().AddVertices((uint32_t)mVertices.size());
+		TS_ENGINE::Application::GetInstance().AddIndices(indexCount);
+	}
+
+	void Mesh::Draw()
+	{
+		StreamVertices();
+
 		if (mDrawMode == DrawMode::TRIANGLE)
-			RenderCommand::DrawIndexed(mVertexArray, (uint32_t)mIndices.size());
+			DrawRange(0, (uint32_t)mIndices.size());
 		else if (mDrawMode == DrawMode::LINE)
 			RenderCommand::DrawLines(mVertexArray, (uint32_t)mVertices.size());
+	}
+
+	void Mesh::DrawRanges(const std::vector<IndexRange>& ranges)
+	{
+		if (ranges.empty())
+			return;
+
+		StreamVertices();
+
+		if (mArenaHandle != MeshArena::sInvalidHandle)
+			mArena->DrawRanges(mArenaHandle, ranges.data(), (uint32_t)ranges.size());
+		else
+			RenderCommand::DrawIndexedRanges(mVertexArray, ranges);
+	}
+
+	void Mesh::DrawRange(uint32_t firstIndex, uint32_t indexCount)
+	{
+		StreamVertices();
+
+		if (mArenaHandle != MeshArena::sInvalidHandle)
+		{
+			IndexRange range = { firstIndex, indexCount };
+			mArena->DrawRanges(mArenaHandle, &range, 1);
+		}
+		else if (firstIndex == 0)
+		{
+			RenderCommand::DrawIndexed(mVertexArray, indexCount);
+		}
+		else
+		{
+			RenderCommand::DrawIndexedRanges(mVertexArray, { { firstIndex, indexCount } });
+		}
+	}
+
+#ifdef TS_ENGINE_EDITOR
+	bool Mesh::RenderClusters(int entityID, bool _enableTextures, const Frustum* frustum, const Matrix4& worldMatrix, const RenderView& view)
+#else
+	bool Mesh::RenderClusters(bool _enableTextures, const Frustum* frustum, const Matrix4& worldMatrix, const RenderView& view)
+#endif
+	{
+		// Without back face culling the back of a meshlet is drawn, so it can't be culled for facing away
+		bool backFaceCulled = !mDoubleSided && RenderCommand::IsBackFaceCullingEnabled();
+		uint32_t visibleTriangles = MeshletUtils::Cull(mMeshlets, frustum, worldMatrix, view.cameraPosition, view.viewDirection, view.orthographic, backFaceCulled, mVisibleRanges);
+		TS_ENGINE::Application::GetInstance().AddCulledClusterTriangles((uint32_t)(mIndices.size() / 3) - visibleTriangles);
+
+		if (visibleTriangles == 0)
+			return false;
+
+#ifdef TS_ENGINE_EDITOR
+		mMaterial->Render(entityID, _enableTextures);
+#else
+		mMaterial->Render(_enableTextures);
+#endif
+
+		DrawRanges(mVisibleRanges);
 
-		// Add DrawCalls, Vertices and Indices for Stats
 		TS_ENGINE::Application::GetInstance().AddDrawCalls(1);
 		TS_ENGINE::Application::GetInstance().AddVertices((uint32_t)mVertices.size());
-		TS_ENGINE::Application::GetInstance().AddIndices((uint32_t)mIndices.size());
+		TS_ENGINE::Application::GetInstance().AddIndices(visibleTriangles * 3);
+		return true;
+	}
+
+	void Mesh::BuildMeshlets()
+	{
+		mMeshlets.clear();
+
+		if (mIndices.size() / 3 <= MeshletUtils::sMaxTriangles)
+			return;
+
+		std::vector<Vector3> positions(mVertices.size());
+
+		for (size_t i = 0; i < mVertices.size(); i++)
+			positions[i] = Vector3(mVertices[i].position);
+
+		mMeshlets = MeshletUtils::Build(positions, mIndices);
+
+		// Vertices in the order the meshlets reference them, meshlet bounds are positions so they stay valid
+		MeshOptimizer::OptimizeVertexFetch(mVertices, mIndices);
+	}
+
+	void Mesh::GenerateLODs()
+	{
+		static const uint32_t sMinLODTriangles = 256;		// Smaller meshes are cheap enough as they are
+		static const float sMaxLODError = 0.05f;			// Fraction of the extent
+		static const float sMinReduction = 0.1f;			// Stop once a level removes fewer triangles than this
+
+		mLODs.clear();
+		mLODIndices.clear();
+
+		if (mDrawMode != DrawMode::TRIANGLE || mIndices.size() / 3 < sMinLODTriangles)
+			return;
+
+		std::vector<Vector3> positions(mVertices.size());
+
+		for (size_t i = 0; i < mVertices.size(); i++)
+			positions[i] = Vector3(mVertices[i].position);
+
+		std::vector<uint32_t> source = mIndices;
+
+		for (uint32_t level = 0; level < sMaxLODs; level++)
+		{
+			float error = 0.0f;
+			size_t targetIndexCount = source.size() / 6 * 3;
+			std::vector<uint32_t> lodIndices = MeshSimplifier::Simplify(positions, source, targetIndexCount, sMaxLODError, &error);
+
+			if ((float)lodIndices.size() > (float)source.size() * (1.0f - sMinReduction) || lodIndices.empty())
+				break;
+
+			MeshOptimizer::OptimizeVertexCache(lodIndices, mVertices.size());
+			AddLOD(lodIndices, sDefaultLODScreenSizes[level], error);
+			source = std::move(lodIndices);
+		}
+	}
+
+	void Mesh::AddLOD(const std::vector<uint32_t>& indices, float screenSize, float error)
+	{
+		MeshLOD meshLOD;
+		meshLOD.firstIndex = (uint32_t)(mIndices.size() + mLODIndices.size());
+		meshLOD.indexCount = (uint32_t)indices.size();
+		meshLOD.screenSize = screenSize;
+		meshLOD.error = error;
+
+		mLODs.push_back(meshLOD);
+		mLODIndices.insert(mLODIndices.end(), indices.begin(), indices.end());
+	}
+
+	uint32_t Mesh::GetLODTriangleCount(uint32_t lod) const
+	{
+		if (lod == 0 || lod > mLODs.size())
+			return (uint32_t)(mIndices.size() / 3);
+
+		return mLODs[lod - 1].indexCount / 3;
+	}
+
+	uint32_t Mesh::SelectLOD(float screenSize, uint32_t currentLOD) const
+	{
+		uint32_t lod = std::min(currentLOD, (uint32_t)mLODs.size());
+
+		// mLODs[i].screenSize is the threshold between LOD i and LOD i + 1
+		while (lod < mLODs.size() && screenSize < mLODs[lod].screenSize * (1.0f - sLODHysteresis))
+			lod++;
+
+		if (lod != currentLOD)
+			return lod;
+
+		while (lod > 0 && screenSize > mLODs[lod - 1].screenSize * (1.0f + sLODHysteresis))
+			lod--;
+
+		return lod;
+	}
+
+	uint32_t Mesh::SelectLOD(const Camera* camera, float screenSize, bool keep)
+	{
+		if (!keep)
+		{
+			auto it = mSelectedLODs.find(camera);
+			return it != mSelectedLODs.end() ? std::min(it->second, (uint32_t)mLODs.size()) : SelectLOD(screenSize, 0);
+		}
+
+		uint32_t& selectedLOD = mSelectedLODs[camera];
+		selectedLOD = SelectLOD(screenSize, selectedLOD);
+		return selectedLOD;
+	}
+
+	float Mesh::GetScreenSize(const BoundingSphere& worldSphere, const Vector3& cameraPosition, const Matrix4& projectionMatrix)
+	{
+		// Orthographic
+		if (projectionMatrix[3][3] == 1.0f)
+			return worldSphere.radius * projectionMatrix[1][1];
+
+		Vector3 offset = worldSphere.center - cameraPosition;
+		float distanceSquared = glm::dot(offset, offset);
+		float radiusSquared = worldSphere.radius * worldSphere.radius;
+
+		// Camera inside the sphere
+		if (distanceSquared <= radiusSquared)
+			return FLT_MAX;
+
+		return worldSphere.radius * projectionMatrix[1][1] / sqrtf(distanceSquared - radiusSquared);
 	}
 
 	void Mesh::Destroy()
 	{
+		if (mArenaHandle != MeshArena::sInvalidHandle)
+		{
+			ReleaseGeometry();
+			mVertices.clear();
+			mIndices.clear();
+			mStatsRegistered = false;
+			return;
+		}
+
 		for (auto& vertexBuffer : mVertexArray->GetVertexBuffers())
 		{
 			vertexBuffer->Unbind();
@@ -141,6 +443,15 @@ namespace TS_ENGINE {
 		this->mIndices = mesh->GetIndices();
 		this->mPrimitiveType = mesh->mPrimitiveType;
 		this->mDrawMode = mesh->mDrawMode;
+		this->mHasBoneInfluence = mesh->mHasBoneInfluence;
+		this->mVertexFormat = mesh->mVertexFormat;
+		this->mVertexFormatOverridden = mesh->mVertexFormatOverridden;
+		this->mBoneMatrices = mesh->mBoneMatrices ? CreateRef<std::vector<Matrix4>>(*mesh->mBoneMatrices) : nullptr;	// Own pose, posing the source doesn't move the clone
+		this->mOccluderMesh = mesh->mOccluderMesh;
+		this->mMeshlets = mesh->mMeshlets;
+		this->mDoubleSided = mesh->mDoubleSided;
+		this->mLODs = mesh->mLODs;
+		this->mLODIndices = mesh->mLODIndices;
 
 		Create(this->mDrawMode);
 
@@ -154,6 +465,15 @@ namespace TS_ENGINE {
 		this->mIndices = mesh->GetIndices();
 		this->mPrimitiveType = mesh->mPrimitiveType;
 		this->mDrawMode = mesh->mDrawMode;
+		this->mHasBoneInfluence = mesh->mHasBoneInfluence;
+		this->mVertexFormat = mesh->mVertexFormat;
+		this->mVertexFormatOverridden = mesh->mVertexFormatOverridden;
+		this->mBoneMatrices = mesh->mBoneMatrices ? CreateRef<std::vector<Matrix4>>(*mesh->mBoneMatrices) : nullptr;	// Own pose, posing the source doesn't move the clone
+		this->mOccluderMesh = mesh->mOccluderMesh;
+		this->mMeshlets = mesh->mMeshlets;
+		this->mDoubleSided = mesh->mDoubleSided;
+		this->mLODs = mesh->mLODs;
+		this->mLODIndices = mesh->mLODIndices;
 
 		Create(this->mDrawMode);
 
@@ -189,6 +509,53 @@ namespace TS_ENGINE {
 		return mVertexArray;
 	}
 
+	void Mesh::StreamVertices()
+	{
+		if (!mStreamed || mStreamedVertexData.empty())
+			return;
+
+		Ref<StreamBuffer> streamBuffer = StreamBuffer::GetInstance();
+		uint64_t frame = streamBuffer->GetFrameIndex();
+
+		// Allocations only last for the frame they were made in
+		if (mStreamedFrame == frame)
+			return;
+
+		mStreamedFrame = frame;
+		uint32_t size = (uint32_t)mStreamedVertexData.size();
+		uint32_t offset = 0;
+
+		if (void* memory = streamBuffer->Allocate(size, 16, offset))
+		{
+			memcpy(memory, mStreamedVertexData.data(), size);
+			mVertexArray->SetVertexSource(streamBuffer->GetRendererID(), offset);
+		}
+		else
+		{
+			// The region is full, drawn from the mesh's own buffer this frame
+			const Ref<VertexBuffer>& vertexBuffer = mVertexArray->GetVertexBuffers()[0];
+			vertexBuffer->SetData(mStreamedVertexData.data(), size);
+			mVertexArray->SetVertexSource(vertexBuffer->GetRendererID(), 0);
+		}
+	}
+
+	const MeshArenaAllocation* Mesh::GetArenaAllocation() const
+	{
+		return mArenaHandle != MeshArena::sInvalidHandle ? &mArena->GetAllocation(mArenaHandle) : nullptr;
+	}
+
+	void Mesh::ReleaseGeometry()
+	{
+		if (mArenaHandle != MeshArena::sInvalidHandle)
+		{
+			mArena->Free(mArenaHandle);
+			mArenaHandle = MeshArena::sInvalidHandle;
+		}
+
+		mArena = nullptr;
+		mVertexArray = nullptr;
+	}
+
 	uint32_t Mesh::GetNumIndices()
 	{
 		return (uint32_t)mIndices.size();
@@ -198,4 +565,169 @@ namespace TS_ENGINE {
 	{
 		mHasBoneInfluence = _hasBoneInfluence;
 	}
-}
\ No newline at end of file
+
+	void Mesh::ComputeBounds()
+	{
+		mBoundingBox = AABB();
+
+		for (const Vertex& vertex : mVertices)
+			mBoundingBox.Expand(Vector3(vertex.position));
+
+		if (!mBoundingBox.IsValid())
+		{
+			mBoundingSphere = BoundingSphere();
+			return;
+		}
+
+		// Centered on the box, radius reaching the farthest vertex
+		Vector3 center = mBoundingBox.GetCenter();
+		float radiusSquared = 0.0f;
+
+		for (const Vertex& vertex : mVertices)
+		{
+			Vector3 offset = Vector3(vertex.position) - center;
+			radiusSquared = glm::max(radiusSquared, glm::dot(offset, offset));
+		}
+
+		mBoundingSphere = BoundingSphere(center, sqrtf(radiusSquared));
+	}
+
+	void Mesh::SetVertexFormat(VertexFormat vertexFormat)
+	{
+		mVertexFormat = vertexFormat;
+		mVertexFormatOverridden = true;
+	}
+
+	void Mesh::SetBoneMatrices(Ref<std::vector<Matrix4>> boneMatrices)
+	{
+		mBoneMatrices = boneMatrices;
+	}
+
+	void Mesh::SetOccluderMesh(Ref<Mesh> occluderMesh)
+	{
+		mOccluderMesh = occluderMesh;
+	}
+
+	std::vector<uint32_t> Mesh::BuildOccluderIndices() const
+	{
+		static const float sMaxOccluderError = 0.05f;		// Fraction of the extent, as for the LODs
+
+		if (mDrawMode != DrawMode::TRIANGLE || mHasBoneInfluence || mIndices.size() / 3 <= sMaxOccluderTriangles)
+			return {};
+
+		// LOD indices follow the base indices
+		auto getLODIndices = [&](const MeshLOD& meshLOD)
+			{
+				auto first = mLODIndices.begin() + (meshLOD.firstIndex - mIndices.size());
+				return std::vector<uint32_t>(first, first + meshLOD.indexCount);
+			};
+
+		for (const MeshLOD& meshLOD : mLODs)
+		{
+			if (meshLOD.indexCount / 3 <= sMaxOccluderTriangles)
+				return getLODIndices(meshLOD);
+		}
+
+		std::vector<Vector3> positions(mVertices.size());
+
+		for (size_t i = 0; i < mVertices.size(); i++)
+			positions[i] = Vector3(mVertices[i].position);
+
+		std::vector<uint32_t> indices = MeshSimplifier::Simplify(positions, mLODs.empty() ? mIndices : getLODIndices(mLODs.back()),
+			sMaxOccluderTriangles * 3, sMaxOccluderError);
+
+		if (indices.size() / 3 > sMaxOccluderTriangles)
+			return {};
+
+		return indices;
+	}
+
+	void Mesh::CreateOccluderMesh(const std::vector<uint32_t>& indices)
+	{
+		// Only the referenced vertices are kept
+		std::vector<uint32_t> remap(mVertices.size(), UINT32_MAX);
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> occluderIndices(indices.size());
+
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			uint32_t& index = remap[indices[i]];
+
+			if (index == UINT32_MAX)
+			{
+				index = (uint32_t)vertices.size();
+				vertices.push_back(mVertices[indices[i]]);
+			}
+
+			occluderIndices[i] = index;
+		}
+
+		Ref<Mesh> occluderMesh = CreateRef<Mesh>();
+		occluderMesh->SetName(mName + "_Occluder");
+		occluderMesh->SetVertices(std::move(vertices));
+		occluderMesh->SetIndices(std::move(occluderIndices));
+		SetOccluderMesh(occluderMesh);
+	}
+
+	void Mesh::ComputePosedPositions()
+	{
+		mPosedPositions.resize(mVertices.size());
+
+		for (size_t i = 0; i < mVertices.size(); i++)
+		{
+			const Vertex& vertex = mVertices[i];
+			Vector4 posedPosition(0.0f);
+			float totalWeight = 0.0f;
+
+			// Same blend as the vertex shader
+			for (int j = 0; j < MAX_BONE_INFLUENCE; j++)
+			{
+				int boneId = vertex.mBoneIds[j];
+
+				if (boneId < 0 || boneId >= (int)mBoneMatrices->size())
+					continue;
+
+				posedPosition += vertex.mWeights[j] * ((*mBoneMatrices)[boneId] * Vector4(Vector3(vertex.position), 1.0f));
+				totalWeight += vertex.mWeights[j];
+			}
+
+			mPosedPositions[i] = totalWeight > 0.0f ? Vector3(posedPosition) : Vector3(vertex.position);
+		}
+	}
+
+	bool Mesh::Raycast(const Vector3& origin, const Vector3& direction, float maxDistance, MeshBVH::Hit& hit)
+	{
+		if (mDrawMode != DrawMode::TRIANGLE || mIndices.size() < 3)
+			return false;
+
+		bool posed = mHasBoneInfluence && mBoneMatrices && !mBoneMatrices->empty();
+
+		if (posed)
+		{
+			ComputePosedPositions();
+		}
+		else if (!mBVH)
+		{
+			mPosedPositions.resize(mVertices.size());
+
+			for (size_t i = 0; i < mVertices.size(); i++)
+				mPosedPositions[i] = Vector3(mVertices[i].position);
+		}
+
+		if (!mBVH)
+		{
+			mBVH = CreateScope<MeshBVH>();
+			mBVH->Build(mPosedPositions, mIndices);
+		}
+		else if (posed)
+		{
+			// Topology doesn't change with the pose, refitting is enough
+			mBVH->Refit(mPosedPositions);
+		}
+
+		if (!posed)
+			mPosedPositions = std::vector<Vector3>();
+
+		return mBVH->Raycast(origin, direction, maxDistance, hit);
+	}
+}
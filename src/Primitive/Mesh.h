@@ -2,9 +2,16 @@
 #include "Renderer/VertexArray.h"
 #include "Renderer/Buffer.h"
 #include "Renderer/Material.h"
+#include "Renderer/VertexFormat.h"
+#include "Renderer/Bounds.h"
+#include "Primitive/MeshBVH.h"
+#include "Primitive/Meshlet.h"
+#include "Renderer/MeshArena.h"
 
 namespace TS_ENGINE {
 
+	class Camera;
+
 	enum class PrimitiveType
 	{
 		LINE,
@@ -65,6 +72,41 @@ namespace TS_ENGINE {
 		}
 	};
 
+	/// <summary>
+	/// Coarser version of a mesh. Its indices follow the base indices in the mesh's index buffer and reuse the mesh's vertices.
+	/// </summary>
+	struct MeshLOD
+	{
+		uint32_t firstIndex = 0;
+		uint32_t indexCount = 0;
+		float screenSize = 0.0f;		// Used below this projected height (fraction of the viewport height)
+		float error = 0.0f;				// Simplification error, fraction of the mesh extent
+	};
+
+	class Mesh;
+	class ImpostorRenderer;
+	class DynamicBatcher;
+
+	/// <summary>
+	/// Camera data for per mesh culling and LOD selection while rendering the hierarchy.
+	/// </summary>
+	struct RenderView
+	{
+		Vector3 cameraPosition = Vector3(0.0f);
+		Vector3 viewDirection = Vector3(0.0f, 0.0f, -1.0f);				// World space, shared by every view ray of an orthographic camera
+		bool orthographic = false;
+		Matrix4 projectionMatrix = Matrix4(1);
+		bool clusterCulling = false;
+		const Camera* lodCamera = nullptr;									// Meshes keep their LOD per camera for hysteresis, nullptr disables LODs
+		bool keepLODs = true;												// Off for extra passes, which reuse the LODs of the color pass
+		ImpostorRenderer* impostorRenderer = nullptr;						// Queues distant nodes that have an impostor, nullptr disables impostors
+		float impostorDistance = FLT_MAX;
+		const std::vector<uint8_t>* activeHLODClusters = nullptr;			// Nonzero for HLOD clusters drawn by their proxy, whose nodes are skipped
+		bool staticBatches = false;											// Meshes of statically batched nodes are skipped, their batches draw them
+		DynamicBatcher* dynamicBatcher = nullptr;							// Queues small meshes to be merged per material, nullptr draws them directly
+		bool countStats = true;												// Off for extra passes such as entity ID picks, so meshes are counted once per frame
+	};
+
 	enum DrawMode
 	{
 		TRIANGLE,
@@ -83,6 +125,13 @@ namespace TS_ENGINE {
 		void SetVertices(std::vector<Vertex> vertices);
 		void SetIndices(std::vector<uint32_t> indices);		
 
+		/// <summary>
+		/// Replaces the vertices of a created mesh in place. The mesh is drawn from the stream buffer from then on, its packed vertices
+		/// are written into the current frame's region instead of a buffer the GPU may still read, no buffers are created.
+		/// Falls back to Create if the vertex count or format changes, or the mesh has to move out of the mesh arena.
+		/// </summary>
+		void UpdateVertices(const std::vector<Vertex>& vertices);
+
 		void AddVertex(Vertex vertex);
 		void AddIndex(uint32_t index);
 
@@ -91,45 +140,182 @@ namespace TS_ENGINE {
 
 		/// <summary>
 		/// 1. Sets draw mode(Triangle/Line)
-		/// 2. Creates vertex array
-		/// 3. Creates vertex buffer and sets layout for it 
-		/// 4. Sets vertex buffer in created vertex array
-		/// 5. Creates index buffer and sets that in vertex array
+		/// 2. Packs vertices into the mesh's vertex format (picked automatically unless set)
+		/// 3. Packs indices (16-bit when the vertex count allows it)
+		/// 4. Triangle meshes are copied into the shared mesh arena while it is enabled
+		/// 5. Otherwise creates a vertex array with its own vertex and index buffers
 		/// </summary>
 		/// <param name="drawMode"></param>
 		void Create(DrawMode drawMode = DrawMode::TRIANGLE);
 
 #ifdef TS_ENGINE_EDITOR
-		void Render(int entityID, bool _enableTextures);
+		void Render(int entityID, bool _enableTextures, uint32_t lod = 0);
 #else
-		void Render(bool _enableTextures);
+		void Render(bool _enableTextures, uint32_t lod = 0);
+#endif
+
+		// Draws the base geometry with the bound shader, without applying the material
+		void Draw();
+		// Draws index ranges of the base geometry with the bound shader in one call, without applying the material
+		void DrawRanges(const std::vector<IndexRange>& ranges);
+
+		/// <summary>
+		/// Culls the meshlets against the frustum (nullptr to skip) and the view's camera, then draws the visible ones with one call.
+		/// Meshlets facing away are only culled while back face culling is enabled. Returns false if nothing was visible. Needs BuildMeshlets first.
+		/// </summary>
+#ifdef TS_ENGINE_EDITOR
+		bool RenderClusters(int entityID, bool _enableTextures, const Frustum* frustum, const Matrix4& worldMatrix, const RenderView& view);
+#else
+		bool RenderClusters(bool _enableTextures, const Frustum* frustum, const Matrix4& worldMatrix, const RenderView& view);
 #endif
 
 		void Destroy();
 
 		const std::string& GetName() const { return mName; }
 		std::vector<Vertex>& GetVertices() { return mVertices; }
+		// Changes whenever Create or UpdateVertices uploads the vertices, so CPU copies of them can tell they are stale
+		uint32_t GetVertexVersion() const { return mVertexVersion; }
 		std::vector<Vertex> GetWorldSpaceVertices(Vector3 position, Vector3 eulerAngles, Vector3 scale);
 		std::vector<uint32_t>& GetIndices() { return mIndices; }
 		Ref<Material> GetMaterial() const { return mMaterial; }
 		PrimitiveType GetPrimitiveType() { return mPrimitiveType; }
+		// Material changes of tracked meshes bump GetTrackedVersion. Geometry changes free the mesh's arena allocation, see MeshArena::GetLayoutVersion.
+		void SetTracked(bool tracked) { mTracked = tracked; }
+		static uint32_t GetTrackedVersion() { return sTrackedVersion; }
 
+		// Own vertex array, nullptr for meshes stored in the mesh arena
 		Ref<VertexArray> GetVertexArray();
+		// Location in the mesh arena, nullptr for meshes with their own vertex array
+		const MeshArenaAllocation* GetArenaAllocation() const;
 		uint32_t GetNumIndices();		
 		
 		void SetHasBoneInfluence(bool _hasBoneInfluence);
 		bool HasBoneInfluence() { return mHasBoneInfluence; }
+		DrawMode GetDrawMode() const { return mDrawMode; }
+
+		/// <summary>
+		/// Forces a vertex format for the next Create call. By default the format is picked from the draw mode and bone influence.
+		/// </summary>
+		void SetVertexFormat(VertexFormat vertexFormat);
+		VertexFormat GetVertexFormat() const { return mVertexFormat; }
+
+		// Recomputes local space bounds from the CPU vertices. Called by Create.
+		void ComputeBounds();
+		const AABB& GetBoundingBox() const { return mBoundingBox; }
+		const BoundingSphere& GetBoundingSphere() const { return mBoundingSphere; }
+
+		/// <summary>
+		/// Closest triangle hit along a ray given in mesh space. The triangle BVH is built on the first call.
+		/// Skinned meshes are tested in the current pose of their bones, so the ray is in the space the skinned vertices end up in.
+		/// </summary>
+		bool Raycast(const Vector3& origin, const Vector3& direction, float maxDistance, MeshBVH::Hit& hit);
+		// Skinning matrices indexed by bone id, shared by all meshes of a model
+		void SetBoneMatrices(Ref<std::vector<Matrix4>> boneMatrices);
+
+		// Simplified geometry rasterized instead of this mesh by occlusion culling. It must not cover more than the mesh does,
+		// beyond the small simplification error of occluders built from LODs.
+		void SetOccluderMesh(Ref<Mesh> occluderMesh);
+		Ref<Mesh> GetOccluderMesh() const { return mOccluderMesh; }
+
+		/// <summary>
+		/// Index list over the vertices of this mesh with at most sMaxOccluderTriangles triangles, for meshes too large to be rasterized
+		/// as occluders. The finest LOD that fits is used, otherwise the coarsest LOD is simplified further. Empty for small or skinned
+		/// meshes and for meshes that can't be simplified that far. CPU only, safe to run on worker threads for different meshes.
+		/// </summary>
+		std::vector<uint32_t> BuildOccluderIndices() const;
+		// Occluder mesh made of the vertices the indices reference. Creates a mesh, so it runs on the thread owning the GL context.
+		void CreateOccluderMesh(const std::vector<uint32_t>& indices);
+
+		/// <summary>
+		/// Splits the triangles into meshlets and reorders the indices so each meshlet is contiguous.
+		/// CPU only, so it can run on a worker before Create. Meshes with fewer triangles than two meshlets are left as is.
+		/// </summary>
+		void BuildMeshlets();
+		bool HasMeshlets() const { return !mMeshlets.empty(); }
+		const std::vector<Meshlet>& GetMeshlets() const { return mMeshlets; }
+
+		/// <summary>
+		/// Builds up to sMaxLODs coarser index lists with quadric simplification, each about half of the previous one.
+		/// CPU only, so it can run on a worker before Create. Stops when simplification stops making progress.
+		/// </summary>
+		void GenerateLODs();
+		// Adds a coarser index list over the same vertices, e.g. from parametric generation. Call before Create.
+		void AddLOD(const std::vector<uint32_t>& indices, float screenSize, float error = 0.0f);
+		// LODs below the base mesh, LOD 0 is the mesh itself
+		uint32_t GetLODCount() const { return (uint32_t)mLODs.size(); }
+		const std::vector<MeshLOD>& GetLODs() const { return mLODs; }
+		uint32_t GetLODTriangleCount(uint32_t lod) const;
+
+		/// <summary>
+		/// LOD for a projected size. Switching needs the size to pass a threshold by sLODHysteresis,
+		/// so a mesh close to a threshold does not change LOD every frame.
+		/// </summary>
+		uint32_t SelectLOD(float screenSize, uint32_t currentLOD) const;
+		/// <summary>
+		/// LOD for a projected size seen from camera, starting from the LOD last kept for it.
+		/// With keep false the kept LOD is only read, so extra passes draw what the color pass drew.
+		/// </summary>
+		uint32_t SelectLOD(const Camera* camera, float screenSize, bool keep);
+		// Drops the LOD kept for a camera that is removed
+		void ReleaseCamera(const Camera* camera) { mSelectedLODs.erase(camera); }
+		// Projected height of the world space sphere as a fraction of the viewport height
+		static float GetScreenSize(const BoundingSphere& worldSphere, const Vector3& cameraPosition, const Matrix4& projectionMatrix);
+
+		static constexpr uint32_t sMaxLODs = 4;
+		static constexpr float sLODHysteresis = 0.1f;
+		static const float sDefaultLODScreenSizes[sMaxLODs];
+		static constexpr uint32_t sMaxOccluderTriangles = 4096;		// Larger meshes are rasterized through their occluder mesh
+
+		// Double sided meshes are visible from behind, so their meshlets are not cone culled
+		void SetDoubleSided(bool doubleSided) { mDoubleSided = doubleSided; }
+		bool IsDoubleSided() const { return mDoubleSided; }
 	private:
+		// Vertex positions after skinning with the current bone matrices
+		void ComputePosedPositions();
+		// Frees the arena allocation or the own vertex array
+		void ReleaseGeometry();
+		void DrawRange(uint32_t firstIndex, uint32_t indexCount);
+		// Writes the vertices of a streamed mesh into this frame's stream buffer region once and points its vertex array there
+		void StreamVertices();
+
 		std::string mName;
 		PrimitiveType mPrimitiveType;
 		std::vector<Vertex> mVertices;
 		std::vector<uint32_t> mIndices;		
 		Ref<VertexArray> mVertexArray;
+		Ref<MeshArena> mArena;
+		MeshArena::Handle mArenaHandle = MeshArena::sInvalidHandle;
 		bool mStatsRegistered;
 		DrawMode mDrawMode;
 		Ref<Material> mMaterial;
 
 		bool mHasBoneInfluence;
+		VertexFormat mVertexFormat;
+		bool mVertexFormatOverridden;
+
+		AABB mBoundingBox;					// Local space
+		BoundingSphere mBoundingSphere;		// Local space
+
+		Scope<MeshBVH> mBVH;						// Built lazily by Raycast
+		uint32_t mVertexVersion = 0;
+		bool mTracked = false;
+		static uint32_t sTrackedVersion;
+
+		bool mStreamed = false;						// Vertices updated after creation, drawn from the stream buffer
+		std::vector<uint8_t> mStreamedVertexData;	// Packed, written again in every frame the mesh is drawn
+		uint64_t mStreamedFrame = UINT64_MAX;		// Stream buffer frame of the last write
+		Ref<std::vector<Matrix4>> mBoneMatrices;
+		std::vector<Vector3> mPosedPositions;
+
+		Ref<Mesh> mOccluderMesh;
+
+		std::vector<Meshlet> mMeshlets;
+		std::vector<IndexRange> mVisibleRanges;		// Scratch for RenderClusters
+		bool mDoubleSided = false;
+
+		std::vector<MeshLOD> mLODs;
+		std::vector<uint32_t> mLODIndices;			// Uploaded after mIndices
+		std::unordered_map<const Camera*, uint32_t> mSelectedLODs;	// Last LOD per camera, for hysteresis
 	};
 }
 
@@ -0,0 +1,409 @@
+#include "tspch.h"
+#include "MeshBVH.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define TS_MESHBVH_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace TS_ENGINE {
+
+	static constexpr uint32_t sMaxLeafTriangles = 4;	// One packet per leaf
+	static constexpr uint32_t sNumBins = 12;
+	static constexpr float sEpsilon = 1e-8f;
+	static constexpr uint32_t sTraversalStackSize = 64;	// Deeper trees traverse with a heap stack
+
+	MeshBVH::MeshBVH()
+	{
+
+	}
+
+	const AABB& MeshBVH::GetBounds() const
+	{
+		static const AABB emptyBounds;
+		return mNodes.empty() ? emptyBounds : mNodes[0].bounds;
+	}
+
+	void MeshBVH::Build(const std::vector<Vector3>& positions, const std::vector<uint32_t>& indices)
+	{
+		mNodes.clear();
+		mPackets.clear();
+		mIndices = indices;
+		mMaxDepth = 0;
+
+		uint32_t numTriangles = (uint32_t)(indices.size() / 3);
+
+		if (numTriangles == 0)
+			return;
+
+		std::vector<AABB> triangleBounds(numTriangles);
+		std::vector<Vector3> centroids(numTriangles);
+		mTriangleOrder.resize(numTriangles);
+
+		for (uint32_t t = 0; t < numTriangles; t++)
+		{
+			AABB bounds;
+			bounds.Expand(positions[indices[t * 3]]);
+			bounds.Expand(positions[indices[t * 3 + 1]]);
+			bounds.Expand(positions[indices[t * 3 + 2]]);
+
+			triangleBounds[t] = bounds;
+			centroids[t] = bounds.GetCenter();
+			mTriangleOrder[t] = t;
+		}
+
+		mNodes.reserve(2 * (numTriangles / sMaxLeafTriangles + 1));
+		mNodes.emplace_back();
+		Subdivide(0, 0, 0, numTriangles, triangleBounds, centroids);
+
+		// Leaves were created with triangle indices only, fill their vertex data
+		for (TrianglePacket& packet : mPackets)
+			FillPacket(packet, positions);
+	}
+
+	void MeshBVH::Subdivide(uint32_t nodeIndex, uint32_t depth, uint32_t first, uint32_t count, const std::vector<AABB>& triangleBounds, const std::vector<Vector3>& centroids)
+	{
+		AABB bounds;
+		AABB centroidBounds;
+
+		for (uint32_t i = first; i < first + count; i++)
+		{
+			bounds.Expand(triangleBounds[mTriangleOrder[i]]);
+			centroidBounds.Expand(centroids[mTriangleOrder[i]]);
+		}
+
+		mNodes[nodeIndex].bounds = bounds;
+		mMaxDepth = std::max(mMaxDepth, depth);
+
+		if (count <= sMaxLeafTriangles)
+		{
+			TrianglePacket packet;
+			packet.count = count;
+
+			for (uint32_t i = 0; i < count; i++)
+				packet.triangleIndex[i] = mTriangleOrder[first + i];
+
+			mNodes[nodeIndex].isLeaf = true;
+			mNodes[nodeIndex].leftChildOrPacket = (uint32_t)mPackets.size();
+			mPackets.push_back(packet);
+			return;
+		}
+
+		// Binned surface area heuristic along the longest centroid axis
+		Vector3 extent = centroidBounds.max - centroidBounds.min;
+		int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+		float axisMin = centroidBounds.min[axis];
+		float axisExtent = extent[axis];
+
+		uint32_t splitCount = 0;
+
+		if (axisExtent > 0.0f)
+		{
+			AABB binBounds[sNumBins];
+			uint32_t binCounts[sNumBins] = {};
+			float binScale = (float)sNumBins / axisExtent;
+
+			auto binOf = [&](uint32_t triangle)
+				{
+					return glm::min((uint32_t)((centroids[triangle][axis] - axisMin) * binScale), sNumBins - 1);
+				};
+
+			for (uint32_t i = first; i < first + count; i++)
+			{
+				uint32_t bin = binOf(mTriangleOrder[i]);
+				binCounts[bin]++;
+				binBounds[bin].Expand(triangleBounds[mTriangleOrder[i]]);
+			}
+
+			// Sweep from the right to get suffix areas
+			float rightAreas[sNumBins];
+			uint32_t rightCounts[sNumBins];
+			AABB rightBounds;
+			uint32_t rightCount = 0;
+
+			for (int b = sNumBins - 1; b > 0; b--)
+			{
+				rightBounds.Expand(binBounds[b]);
+				rightCount += binCounts[b];
+				rightAreas[b] = rightBounds.IsValid() ? rightBounds.GetSurfaceArea() : 0.0f;
+				rightCounts[b] = rightCount;
+			}
+
+			float bestCost = FLT_MAX;
+			uint32_t bestSplit = 0;
+			AABB leftBounds;
+			uint32_t leftCount = 0;
+
+			for (uint32_t b = 0; b < sNumBins - 1; b++)
+			{
+				leftBounds.Expand(binBounds[b]);
+				leftCount += binCounts[b];
+
+				if (leftCount == 0 || rightCounts[b + 1] == 0)
+					continue;
+
+				float cost = leftCount * leftBounds.GetSurfaceArea() + rightCounts[b + 1] * rightAreas[b + 1];
+
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestSplit = b;
+				}
+			}
+
+			if (bestCost < FLT_MAX)
+			{
+				auto middle = std::partition(mTriangleOrder.begin() + first, mTriangleOrder.begin() + first + count,
+					[&](uint32_t triangle) { return binOf(triangle) <= bestSplit; });
+
+				splitCount = (uint32_t)(middle - (mTriangleOrder.begin() + first));
+			}
+		}
+
+		// All centroids in one bin, split in the middle
+		if (splitCount == 0 || splitCount == count)
+		{
+			splitCount = count / 2;
+			std::nth_element(mTriangleOrder.begin() + first, mTriangleOrder.begin() + first + splitCount, mTriangleOrder.begin() + first + count,
+				[&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+		}
+
+		uint32_t leftChild = (uint32_t)mNodes.size();
+		mNodes.emplace_back();
+		mNodes.emplace_back();
+
+		mNodes[nodeIndex].isLeaf = false;
+		mNodes[nodeIndex].leftChildOrPacket = leftChild;
+
+		Subdivide(leftChild, depth + 1, first, splitCount, triangleBounds, centroids);
+		Subdivide(leftChild + 1, depth + 1, first + splitCount, count - splitCount, triangleBounds, centroids);
+	}
+
+	void MeshBVH::FillPacket(TrianglePacket& packet, const std::vector<Vector3>& positions) const
+	{
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			Vector3 v0(0.0f), e1(0.0f), e2(0.0f);	// Unused lanes are degenerate and never hit
+
+			if (i < packet.count)
+			{
+				uint32_t t = packet.triangleIndex[i];
+				v0 = positions[mIndices[t * 3]];
+				e1 = positions[mIndices[t * 3 + 1]] - v0;
+				e2 = positions[mIndices[t * 3 + 2]] - v0;
+			}
+			else
+			{
+				packet.triangleIndex[i] = 0;
+			}
+
+			packet.v0x[i] = v0.x; packet.v0y[i] = v0.y; packet.v0z[i] = v0.z;
+			packet.e1x[i] = e1.x; packet.e1y[i] = e1.y; packet.e1z[i] = e1.z;
+			packet.e2x[i] = e2.x; packet.e2y[i] = e2.y; packet.e2z[i] = e2.z;
+		}
+	}
+
+	void MeshBVH::Refit(const std::vector<Vector3>& positions)
+	{
+		if (mNodes.empty())
+			return;
+
+		for (TrianglePacket& packet : mPackets)
+			FillPacket(packet, positions);
+
+		// Children always come after their parent, so a reverse sweep updates bottom up
+		for (size_t n = mNodes.size(); n-- > 0;)
+		{
+			BVHNode& node = mNodes[n];
+
+			if (node.isLeaf)
+			{
+				const TrianglePacket& packet = mPackets[node.leftChildOrPacket];
+				node.bounds = AABB();
+
+				for (uint32_t i = 0; i < packet.count; i++)
+				{
+					uint32_t t = packet.triangleIndex[i];
+					node.bounds.Expand(positions[mIndices[t * 3]]);
+					node.bounds.Expand(positions[mIndices[t * 3 + 1]]);
+					node.bounds.Expand(positions[mIndices[t * 3 + 2]]);
+				}
+			}
+			else
+			{
+				node.bounds = AABB::Union(mNodes[node.leftChildOrPacket].bounds, mNodes[node.leftChildOrPacket + 1].bounds);
+			}
+		}
+	}
+
+	// Moller-Trumbore against 4 triangles at once, double sided
+	void MeshBVH::IntersectPacket(const TrianglePacket& packet, const Vector3& origin, const Vector3& direction, Hit& hit) const
+	{
+#ifdef TS_MESHBVH_SSE
+		__m128 dirX = _mm_set1_ps(direction.x), dirY = _mm_set1_ps(direction.y), dirZ = _mm_set1_ps(direction.z);
+
+		__m128 e1x = _mm_load_ps(packet.e1x), e1y = _mm_load_ps(packet.e1y), e1z = _mm_load_ps(packet.e1z);
+		__m128 e2x = _mm_load_ps(packet.e2x), e2y = _mm_load_ps(packet.e2y), e2z = _mm_load_ps(packet.e2z);
+
+		// p = direction x e2
+		__m128 px = _mm_sub_ps(_mm_mul_ps(dirY, e2z), _mm_mul_ps(dirZ, e2y));
+		__m128 py = _mm_sub_ps(_mm_mul_ps(dirZ, e2x), _mm_mul_ps(dirX, e2z));
+		__m128 pz = _mm_sub_ps(_mm_mul_ps(dirX, e2y), _mm_mul_ps(dirY, e2x));
+
+		__m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+		__m128 absDet = _mm_andnot_ps(_mm_set1_ps(-0.0f), det);
+		__m128 valid = _mm_cmpgt_ps(absDet, _mm_set1_ps(sEpsilon));
+		__m128 inverseDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+		// s = origin - v0
+		__m128 sx = _mm_sub_ps(_mm_set1_ps(origin.x), _mm_load_ps(packet.v0x));
+		__m128 sy = _mm_sub_ps(_mm_set1_ps(origin.y), _mm_load_ps(packet.v0y));
+		__m128 sz = _mm_sub_ps(_mm_set1_ps(origin.z), _mm_load_ps(packet.v0z));
+
+		__m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inverseDet);
+
+		// q = s x e1
+		__m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+		__m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+		__m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+
+		__m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dirX, qx), _mm_mul_ps(dirY, qy)), _mm_mul_ps(dirZ, qz)), inverseDet);
+		__m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inverseDet);
+
+		__m128 zero = _mm_setzero_ps();
+		valid = _mm_and_ps(valid, _mm_cmpge_ps(u, zero));
+		valid = _mm_and_ps(valid, _mm_cmpge_ps(v, zero));
+		valid = _mm_and_ps(valid, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f)));
+		valid = _mm_and_ps(valid, _mm_cmpgt_ps(t, _mm_set1_ps(sEpsilon)));
+		valid = _mm_and_ps(valid, _mm_cmplt_ps(t, _mm_set1_ps(hit.distance)));
+
+		int mask = _mm_movemask_ps(valid);
+
+		if (mask == 0)
+			return;
+
+		alignas(16) float tValues[4], uValues[4], vValues[4];
+		_mm_store_ps(tValues, t);
+		_mm_store_ps(uValues, u);
+		_mm_store_ps(vValues, v);
+
+		for (int i = 0; i < 4; i++)
+		{
+			if ((mask & (1 << i)) && tValues[i] < hit.distance)
+			{
+				hit.distance = tValues[i];
+				hit.triangleIndex = packet.triangleIndex[i];
+				hit.u = uValues[i];
+				hit.v = vValues[i];
+				hit.normal = glm::cross(Vector3(packet.e1x[i], packet.e1y[i], packet.e1z[i]), Vector3(packet.e2x[i], packet.e2y[i], packet.e2z[i]));
+			}
+		}
+#else
+		for (uint32_t i = 0; i < packet.count; i++)
+		{
+			Vector3 e1(packet.e1x[i], packet.e1y[i], packet.e1z[i]);
+			Vector3 e2(packet.e2x[i], packet.e2y[i], packet.e2z[i]);
+			Vector3 p = glm::cross(direction, e2);
+			float det = glm::dot(e1, p);
+
+			if (fabsf(det) <= sEpsilon)
+				continue;
+
+			float inverseDet = 1.0f / det;
+			Vector3 s = origin - Vector3(packet.v0x[i], packet.v0y[i], packet.v0z[i]);
+			float u = glm::dot(s, p) * inverseDet;
+
+			if (u < 0.0f || u > 1.0f)
+				continue;
+
+			Vector3 q = glm::cross(s, e1);
+			float v = glm::dot(direction, q) * inverseDet;
+
+			if (v < 0.0f || u + v > 1.0f)
+				continue;
+
+			float t = glm::dot(e2, q) * inverseDet;
+
+			if (t > sEpsilon && t < hit.distance)
+			{
+				hit.distance = t;
+				hit.triangleIndex = packet.triangleIndex[i];
+				hit.u = u;
+				hit.v = v;
+				hit.normal = glm::cross(e1, e2);
+			}
+		}
+#endif
+	}
+
+	bool MeshBVH::Raycast(const Vector3& origin, const Vector3& direction, float maxDistance, Hit& hit) const
+	{
+		if (mNodes.empty())
+			return false;
+
+		Vector3 inverseDirection = 1.0f / direction;
+		hit = Hit();
+		hit.distance = maxDistance;
+		bool found = false;
+
+		// Each level pops one node and pushes at most two, so the stack never holds more than the depth plus two
+		uint32_t inlineStack[sTraversalStackSize];
+		std::vector<uint32_t> heapStack;
+		uint32_t* stack = inlineStack;
+
+		if (mMaxDepth + 2 > sTraversalStackSize)
+		{
+			heapStack.resize(mMaxDepth + 2);
+			stack = heapStack.data();
+		}
+
+		int stackSize = 0;
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			const BVHNode& node = mNodes[stack[--stackSize]];
+			float tEnter;
+
+			if (!node.bounds.IntersectsRay(origin, inverseDirection, hit.distance, tEnter))
+				continue;
+
+			if (node.isLeaf)
+			{
+				float previousDistance = hit.distance;
+				IntersectPacket(mPackets[node.leftChildOrPacket], origin, direction, hit);
+
+				if (hit.distance < previousDistance)
+					found = true;
+
+				continue;
+			}
+
+			// Visit the nearer child first
+			uint32_t left = node.leftChildOrPacket;
+			uint32_t right = left + 1;
+			float tLeft, tRight;
+			bool hitLeft = mNodes[left].bounds.IntersectsRay(origin, inverseDirection, hit.distance, tLeft);
+			bool hitRight = mNodes[right].bounds.IntersectsRay(origin, inverseDirection, hit.distance, tRight);
+
+			if (hitLeft && hitRight)
+			{
+				stack[stackSize++] = tLeft < tRight ? right : left;
+				stack[stackSize++] = tLeft < tRight ? left : right;
+			}
+			else if (hitLeft)
+			{
+				stack[stackSize++] = left;
+			}
+			else if (hitRight)
+			{
+				stack[stackSize++] = right;
+			}
+		}
+
+		if (found)
+			hit.normal = glm::normalize(hit.normal);
+
+		return found;
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "Renderer/Bounds.h"
+
+namespace TS_ENGINE {
+
+	/// <summary>
+	/// Triangle bounding volume hierarchy of a single mesh, used for CPU ray casts.
+	/// Leaves hold up to 4 triangles stored as one SIMD packet, so a leaf is a single 4-wide ray/triangle test.
+	/// The topology can be refitted to new vertex positions (skinned poses) without rebuilding.
+	/// </summary>
+	class MeshBVH
+	{
+	public:
+		struct Hit
+		{
+			float distance = FLT_MAX;
+			uint32_t triangleIndex = 0;
+			float u = 0.0f;		// Barycentric weight of vertex 1
+			float v = 0.0f;		// Barycentric weight of vertex 2
+			Vector3 normal = Vector3(0.0f);	// Normalized geometric normal, in the BVH's space
+		};
+
+		MeshBVH();
+
+		void Build(const std::vector<Vector3>& positions, const std::vector<uint32_t>& indices);
+		// Updates bounds and triangle data for new positions, keeping the tree structure
+		void Refit(const std::vector<Vector3>& positions);
+
+		// Closest hit along the ray. Distances are in units of the direction vector.
+		bool Raycast(const Vector3& origin, const Vector3& direction, float maxDistance, Hit& hit) const;
+
+		bool IsBuilt() const { return !mNodes.empty(); }
+		const AABB& GetBounds() const;
+		uint32_t GetNodeCount() const { return (uint32_t)mNodes.size(); }
+	private:
+		struct BVHNode
+		{
+			AABB bounds;
+			uint32_t leftChildOrPacket = 0;		// Left child index (right child follows it) or packet index for leaves
+			bool isLeaf = false;
+		};
+
+		struct alignas(16) TrianglePacket
+		{
+			float v0x[4], v0y[4], v0z[4];
+			float e1x[4], e1y[4], e1z[4];
+			float e2x[4], e2y[4], e2z[4];
+			uint32_t triangleIndex[4];
+			uint32_t count = 0;
+		};
+
+		void Subdivide(uint32_t nodeIndex, uint32_t depth, uint32_t first, uint32_t count, const std::vector<AABB>& triangleBounds, const std::vector<Vector3>& centroids);
+		void FillPacket(TrianglePacket& packet, const std::vector<Vector3>& positions) const;
+		void IntersectPacket(const TrianglePacket& packet, const Vector3& origin, const Vector3& direction, Hit& hit) const;
+
+		std::vector<BVHNode> mNodes;
+		std::vector<TrianglePacket> mPackets;
+		std::vector<uint32_t> mTriangleOrder;	// Triangle indices ordered by leaf
+		std::vector<uint32_t> mIndices;			// Copy of the index list
+		uint32_t mMaxDepth = 0;					// Deepest leaf, sizes the traversal stack
+	};
+}
@@ -0,0 +1,477 @@
+#include "tspch.h"
+#include "MeshOptimizer.h"
+#include <unordered_set>
+#include <array>
+
+namespace TS_ENGINE {
+
+	// Forsyth, "Linear-Speed Vertex Cache Optimisation"
+	namespace ForsythScore
+	{
+		static constexpr uint32_t sMaxCacheSize = 32;
+		static constexpr float sCacheDecayPower = 1.5f;
+		static constexpr float sLastTriangleScore = 0.75f;
+		static constexpr float sValenceBoostScale = 2.0f;
+		static constexpr float sValenceBoostPower = 0.5f;
+
+		static float ScoreVertex(int cachePosition, uint32_t numActiveTriangles)
+		{
+			// No triangle needs this vertex anymore
+			if (numActiveTriangles == 0)
+				return -1.0f;
+
+			float score = 0.0f;
+
+			if (cachePosition >= 0)
+			{
+				// The vertices of the last triangle get a fixed score so it is not reused right away
+				if (cachePosition < 3)
+				{
+					score = sLastTriangleScore;
+				}
+				else
+				{
+					float scaler = 1.0f / (float)(sMaxCacheSize - 3);
+					score = powf(1.0f - (float)(cachePosition - 3) * scaler, sCacheDecayPower);
+				}
+			}
+
+			// Boost vertices with few remaining triangles to finish them off
+			score += sValenceBoostScale * powf((float)numActiveTriangles, -sValenceBoostPower);
+			return score;
+		}
+	}
+
+	struct TriangleKeyHash
+	{
+		size_t operator()(const std::array<uint32_t, 3>& key) const
+		{
+			size_t hash = key[0];
+			hash = hash * 2654435761u ^ key[1];
+			hash = hash * 2654435761u ^ key[2];
+			return hash;
+		}
+	};
+
+	MeshOptimizationReport MeshOptimizer::Optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		MeshOptimizationReport report;
+
+		if (vertices.empty() || indices.empty() || indices.size() % 3 != 0)
+			return report;
+
+		report.before = AnalyzeVertexCache(indices, vertices.size());
+
+		report.removedTriangles = RemoveDegenerateAndDuplicateTriangles(vertices, indices);
+		OptimizeVertexCache(indices, vertices.size());
+		report.clusters = OptimizeOverdraw(vertices, indices);
+		report.removedVertices = OptimizeVertexFetch(vertices, indices);
+
+		report.after = AnalyzeVertexCache(indices, vertices.size());
+
+		return report;
+	}
+
+	uint32_t MeshOptimizer::RemoveDegenerateAndDuplicateTriangles(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		std::unordered_set<std::array<uint32_t, 3>, TriangleKeyHash> triangles;
+		triangles.reserve(indices.size() / 3);
+
+		size_t writeIndex = 0;
+
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			uint32_t a = indices[i];
+			uint32_t b = indices[i + 1];
+			uint32_t c = indices[i + 2];
+
+			// Degenerate by index
+			if (a == b || b == c || a == c)
+				continue;
+
+			// Degenerate by position (zero area, collapsed vertices)
+			const Vector3 pa = Vector3(vertices[a].position);
+			const Vector3 pb = Vector3(vertices[b].position);
+			const Vector3 pc = Vector3(vertices[c].position);
+
+			if (pa == pb || pb == pc || pa == pc)
+				continue;
+
+			// Rotate so the smallest index comes first. Keeps the winding, so back-to-back faces are not treated as duplicates
+			std::array<uint32_t, 3> key;
+
+			if (a < b && a < c)
+				key = { a, b, c };
+			else if (b < c)
+				key = { b, c, a };
+			else
+				key = { c, a, b };
+
+			if (!triangles.insert(key).second)
+				continue;
+
+			indices[writeIndex++] = a;
+			indices[writeIndex++] = b;
+			indices[writeIndex++] = c;
+		}
+
+		uint32_t removedTriangles = (uint32_t)((indices.size() - writeIndex) / 3);
+		indices.resize(writeIndex);
+
+		return removedTriangles;
+	}
+
+	void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount)
+	{
+		using namespace ForsythScore;
+
+		size_t numTriangles = indices.size() / 3;
+
+		if (numTriangles == 0)
+			return;
+
+		// Vertex to triangle adjacency
+		std::vector<uint32_t> numActiveTriangles(vertexCount, 0);
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		std::vector<uint32_t> adjacency(indices.size());
+
+		for (uint32_t index : indices)
+			numActiveTriangles[index]++;
+
+		for (size_t v = 0; v < vertexCount; v++)
+			adjacencyOffsets[v + 1] = adjacencyOffsets[v] + numActiveTriangles[v];
+
+		{
+			std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+			for (size_t i = 0; i < indices.size(); i++)
+				adjacency[fill[indices[i]]++] = (uint32_t)(i / 3);
+		}
+
+		std::vector<int> cachePositions(vertexCount, -1);
+		std::vector<float> vertexScores(vertexCount);
+		std::vector<float> triangleScores(numTriangles);
+		std::vector<bool> triangleEmitted(numTriangles, false);
+
+		for (size_t v = 0; v < vertexCount; v++)
+			vertexScores[v] = ScoreVertex(-1, numActiveTriangles[v]);
+
+		int bestTriangle = -1;
+		float bestScore = -1.0f;
+
+		for (size_t t = 0; t < numTriangles; t++)
+		{
+			triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+
+			if (triangleScores[t] > bestScore)
+			{
+				bestScore = triangleScores[t];
+				bestTriangle = (int)t;
+			}
+		}
+
+		std::vector<uint32_t> cache;
+		std::vector<uint32_t> newCache;
+		cache.reserve(sMaxCacheSize + 3);
+		newCache.reserve(sMaxCacheSize + 3);
+
+		std::vector<uint32_t> output;
+		output.reserve(indices.size());
+
+		size_t scanCursor = 0;
+
+		for (size_t emitted = 0; emitted < numTriangles; emitted++)
+		{
+			// Nothing in the cache touches a remaining triangle, restart from the first one left
+			if (bestTriangle < 0)
+			{
+				while (triangleEmitted[scanCursor])
+					scanCursor++;
+
+				bestTriangle = (int)scanCursor;
+			}
+
+			const uint32_t* triangle = &indices[(size_t)bestTriangle * 3];
+			triangleEmitted[bestTriangle] = true;
+			output.insert(output.end(), triangle, triangle + 3);
+
+			// Remove triangle from the active lists of its vertices
+			for (int i = 0; i < 3; i++)
+			{
+				uint32_t v = triangle[i];
+				uint32_t* begin = &adjacency[adjacencyOffsets[v]];
+				uint32_t* end = begin + numActiveTriangles[v];
+				uint32_t* it = std::find(begin, end, (uint32_t)bestTriangle);
+
+				TS_CORE_ASSERT(it != end);
+				std::swap(*it, *(end - 1));
+				numActiveTriangles[v]--;
+			}
+
+			// Move triangle vertices to the front of the LRU cache
+			newCache.assign(triangle, triangle + 3);
+
+			for (uint32_t v : cache)
+			{
+				if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+					newCache.push_back(v);
+			}
+
+			// Vertices pushed out of the cache lose their cache score
+			for (size_t i = sMaxCacheSize; i < newCache.size(); i++)
+			{
+				cachePositions[newCache[i]] = -1;
+				vertexScores[newCache[i]] = ScoreVertex(-1, numActiveTriangles[newCache[i]]);
+			}
+
+			if (newCache.size() > sMaxCacheSize)
+				newCache.resize(sMaxCacheSize);
+
+			for (size_t i = 0; i < newCache.size(); i++)
+			{
+				uint32_t v = newCache[i];
+				cachePositions[v] = (int)i;
+				vertexScores[v] = ScoreVertex((int)i, numActiveTriangles[v]);
+			}
+
+			// Only triangles touching the cache can change score
+			bestTriangle = -1;
+			bestScore = -1.0f;
+
+			for (uint32_t v : newCache)
+			{
+				const uint32_t* active = &adjacency[adjacencyOffsets[v]];
+
+				for (uint32_t i = 0; i < numActiveTriangles[v]; i++)
+				{
+					uint32_t t = active[i];
+					float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+					triangleScores[t] = score;
+
+					if (score > bestScore)
+					{
+						bestScore = score;
+						bestTriangle = (int)t;
+					}
+				}
+			}
+
+			cache.swap(newCache);
+		}
+
+		indices.swap(output);
+	}
+
+	uint32_t MeshOptimizer::OptimizeOverdraw(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		size_t numTriangles = indices.size() / 3;
+
+		if (numTriangles == 0)
+			return 0;
+
+		// Split the cache optimized order into clusters, first at hard boundaries (triangles that miss the cache with all three vertices),
+		// then into smaller soft clusters wherever restarting the cache keeps the ACMR within sOverdrawThreshold of the hard cluster.
+		// Reordering whole clusters keeps most of the vertex cache efficiency of the previous stage.
+		std::vector<uint32_t> cacheTimestamps(vertices.size(), 0);
+		uint32_t timestamp = sCacheSize + 1;
+
+		auto transformTriangle = [&](size_t t)
+			{
+				uint32_t misses = 0;
+
+				for (int i = 0; i < 3; i++)
+				{
+					uint32_t v = indices[t * 3 + i];
+
+					if (timestamp - cacheTimestamps[v] > sCacheSize)
+					{
+						cacheTimestamps[v] = timestamp++;
+						misses++;
+					}
+				}
+
+				return misses;
+			};
+
+		std::vector<uint32_t> hardClusterStarts;
+
+		for (size_t t = 0; t < numTriangles; t++)
+		{
+			if (transformTriangle(t) == 3 || t == 0)
+				hardClusterStarts.push_back((uint32_t)t);
+		}
+
+		std::vector<uint32_t> clusterStarts;
+
+		for (size_t h = 0; h < hardClusterStarts.size(); h++)
+		{
+			size_t begin = hardClusterStarts[h];
+			size_t end = h + 1 < hardClusterStarts.size() ? hardClusterStarts[h + 1] : numTriangles;
+
+			// Flush the cache
+			timestamp += sCacheSize + 1;
+			uint32_t clusterMisses = 0;
+
+			for (size_t t = begin; t < end; t++)
+				clusterMisses += transformTriangle(t);
+
+			float clusterThreshold = sOverdrawThreshold * (float)clusterMisses / (float)(end - begin);
+
+			clusterStarts.push_back((uint32_t)begin);
+			timestamp += sCacheSize + 1;
+
+			uint32_t runningMisses = 0;
+			uint32_t runningTriangles = 0;
+
+			for (size_t t = begin; t < end; t++)
+			{
+				runningMisses += transformTriangle(t);
+				runningTriangles++;
+
+				if ((float)runningMisses / (float)runningTriangles <= clusterThreshold && t + 1 < end)
+				{
+					clusterStarts.push_back((uint32_t)(t + 1));
+					timestamp += sCacheSize + 1;
+					runningMisses = 0;
+					runningTriangles = 0;
+				}
+			}
+		}
+
+		size_t numClusters = clusterStarts.size();
+
+		if (numClusters < 2)
+			return (uint32_t)numClusters;
+
+		// Area weighted centroid and average normal per cluster
+		std::vector<Vector3> clusterCentroids(numClusters, Vector3(0.0f));
+		std::vector<Vector3> clusterNormals(numClusters, Vector3(0.0f));
+		Vector3 meshCentroid(0.0f);
+		float meshArea = 0.0f;
+
+		for (size_t c = 0; c < numClusters; c++)
+		{
+			size_t begin = clusterStarts[c];
+			size_t end = c + 1 < numClusters ? clusterStarts[c + 1] : numTriangles;
+			float clusterArea = 0.0f;
+
+			for (size_t t = begin; t < end; t++)
+			{
+				const Vector3 p0 = Vector3(vertices[indices[t * 3]].position);
+				const Vector3 p1 = Vector3(vertices[indices[t * 3 + 1]].position);
+				const Vector3 p2 = Vector3(vertices[indices[t * 3 + 2]].position);
+
+				Vector3 normal = glm::cross(p1 - p0, p2 - p0);
+				float area = glm::length(normal);
+
+				clusterCentroids[c] += (p0 + p1 + p2) * (area / 3.0f);
+				clusterNormals[c] += normal;
+				clusterArea += area;
+			}
+
+			meshCentroid += clusterCentroids[c];
+			meshArea += clusterArea;
+
+			if (clusterArea > 0.0f)
+				clusterCentroids[c] /= clusterArea;
+
+			float normalLength = glm::length(clusterNormals[c]);
+
+			if (normalLength > 0.0f)
+				clusterNormals[c] /= normalLength;
+		}
+
+		if (meshArea > 0.0f)
+			meshCentroid /= meshArea;
+
+		// Clusters on the outside facing away from the center are likely to occlude the rest, so they are drawn first
+		std::vector<float> sortKeys(numClusters);
+
+		for (size_t c = 0; c < numClusters; c++)
+			sortKeys[c] = glm::dot(clusterCentroids[c] - meshCentroid, clusterNormals[c]);
+
+		std::vector<uint32_t> clusterOrder(numClusters);
+
+		for (size_t c = 0; c < numClusters; c++)
+			clusterOrder[c] = (uint32_t)c;
+
+		std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&sortKeys](uint32_t a, uint32_t b)
+			{
+				return sortKeys[a] > sortKeys[b];
+			});
+
+		std::vector<uint32_t> output;
+		output.reserve(indices.size());
+
+		for (uint32_t c : clusterOrder)
+		{
+			size_t begin = clusterStarts[c];
+			size_t end = c + 1 < numClusters ? clusterStarts[c + 1] : numTriangles;
+			output.insert(output.end(), indices.begin() + begin * 3, indices.begin() + end * 3);
+		}
+
+		indices.swap(output);
+
+		return (uint32_t)numClusters;
+	}
+
+	uint32_t MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		// Store vertices in the order they are first referenced, dropping unreferenced ones
+		const uint32_t unused = ~0u;
+		std::vector<uint32_t> remap(vertices.size(), unused);
+		std::vector<Vertex> remappedVertices;
+		remappedVertices.reserve(vertices.size());
+
+		for (uint32_t& index : indices)
+		{
+			if (remap[index] == unused)
+			{
+				remap[index] = (uint32_t)remappedVertices.size();
+				remappedVertices.push_back(vertices[index]);
+			}
+
+			index = remap[index];
+		}
+
+		uint32_t removedVertices = (uint32_t)(vertices.size() - remappedVertices.size());
+		vertices.swap(remappedVertices);
+
+		return removedVertices;
+	}
+
+	VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+	{
+		VertexCacheStats stats;
+
+		if (indices.empty() || vertexCount == 0)
+			return stats;
+
+		std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+		std::vector<bool> referenced(vertexCount, false);
+		uint32_t timestamp = cacheSize + 1;
+		uint32_t transformedVertices = 0;
+		uint32_t uniqueVertices = 0;
+
+		for (uint32_t index : indices)
+		{
+			// FIFO cache: a vertex stays cached until cacheSize newer vertices have been transformed
+			if (timestamp - cacheTimestamps[index] > cacheSize)
+			{
+				cacheTimestamps[index] = timestamp++;
+				transformedVertices++;
+			}
+
+			if (!referenced[index])
+			{
+				referenced[index] = true;
+				uniqueVertices++;
+			}
+		}
+
+		stats.acmr = (float)transformedVertices / (float)(indices.size() / 3);
+		stats.atvr = (float)transformedVertices / (float)uniqueVertices;
+
+		return stats;
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "Mesh.h"
+
+namespace TS_ENGINE {
+
+	/// <summary>
+	/// Cache statistics for an indexed triangle list, measured with a simulated FIFO post-transform cache.
+	/// ACMR = transformed vertices per triangle (0.5 is ideal on a closed mesh, 3 is worst).
+	/// ATVR = transformed vertices per referenced vertex (1 is ideal).
+	/// </summary>
+	struct VertexCacheStats
+	{
+		float acmr = 0.0f;
+		float atvr = 0.0f;
+	};
+
+	struct MeshOptimizationReport
+	{
+		VertexCacheStats before;
+		VertexCacheStats after;
+		uint32_t removedTriangles = 0;		// Degenerate and duplicate triangles
+		uint32_t removedVertices = 0;		// Vertices no longer referenced by any triangle
+		uint32_t clusters = 0;				// Clusters used for overdraw ordering
+	};
+
+	/// <summary>
+	/// Import-time optimizations for indexed triangle meshes.
+	/// All functions work on the CPU copy only and are safe to run on worker threads for different meshes.
+	/// </summary>
+	class MeshOptimizer
+	{
+	public:
+		static constexpr uint32_t sCacheSize = 16;			// FIFO size used for ACMR/ATVR and overdraw clustering
+		static constexpr float sOverdrawThreshold = 1.05f;	// Max ACMR increase allowed by overdraw ordering
+
+		/// <summary>
+		/// Runs every stage in order:
+		/// 1. Degenerate/duplicate triangle removal
+		/// 2. Post-transform vertex cache reordering (Forsyth)
+		/// 3. Overdraw-aware cluster ordering
+		/// 4. Vertex fetch remapping
+		/// </summary>
+		static MeshOptimizationReport Optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+		static uint32_t RemoveDegenerateAndDuplicateTriangles(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+		static void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+		static uint32_t OptimizeOverdraw(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+		static uint32_t OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+		static VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = sCacheSize);
+	};
+}
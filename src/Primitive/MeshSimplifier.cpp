@@ -0,0 +1,358 @@
+#include "tspch.h"
+#include "Primitive/MeshSimplifier.h"
+
+namespace TS_ENGINE {
+
+	namespace
+	{
+		// Symmetric 4x4 plane quadric, plus the total weight so errors are weighted mean squared distances
+		struct Quadric
+		{
+			double a2 = 0.0, b2 = 0.0, c2 = 0.0;
+			double ab = 0.0, ac = 0.0, bc = 0.0;
+			double ad = 0.0, bd = 0.0, cd = 0.0;
+			double d2 = 0.0;
+			double weight = 0.0;
+
+			void AddPlane(const Vector3& normal, float distance, double planeWeight)
+			{
+				double a = normal.x, b = normal.y, c = normal.z, d = distance;
+
+				a2 += a * a * planeWeight; b2 += b * b * planeWeight; c2 += c * c * planeWeight;
+				ab += a * b * planeWeight; ac += a * c * planeWeight; bc += b * c * planeWeight;
+				ad += a * d * planeWeight; bd += b * d * planeWeight; cd += c * d * planeWeight;
+				d2 += d * d * planeWeight;
+				weight += planeWeight;
+			}
+
+			void Add(const Quadric& quadric)
+			{
+				a2 += quadric.a2; b2 += quadric.b2; c2 += quadric.c2;
+				ab += quadric.ab; ac += quadric.ac; bc += quadric.bc;
+				ad += quadric.ad; bd += quadric.bd; cd += quadric.cd;
+				d2 += quadric.d2;
+				weight += quadric.weight;
+			}
+
+			double Evaluate(const Vector3& point) const
+			{
+				double x = point.x, y = point.y, z = point.z;
+				double error = a2 * x * x + b2 * y * y + c2 * z * z
+					+ 2.0 * (ab * x * y + ac * x * z + bc * y * z)
+					+ 2.0 * (ad * x + bd * y + cd * z) + d2;
+
+				return weight > 0.0 ? std::max(error, 0.0) / weight : 0.0;
+			}
+		};
+
+		enum class VertexKind : uint8_t
+		{
+			MANIFOLD,	// Interior vertex, can collapse anywhere
+			BORDER,		// On an open border, can only collapse along it
+			LOCKED		// Attribute seam or non-manifold, never moves
+		};
+
+		struct Collapse
+		{
+			uint32_t from;
+			uint32_t to;
+			double cost;
+		};
+
+		struct PositionHash
+		{
+			size_t operator()(const Vector3& position) const
+			{
+				uint32_t bits[3];
+				memcpy(bits, &position, sizeof(bits));
+				return (size_t)bits[0] * 73856093u ^ (size_t)bits[1] * 19349663u ^ (size_t)bits[2] * 83492791u;
+			}
+		};
+
+		uint64_t EdgeKey(uint32_t a, uint32_t b)
+		{
+			return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+		}
+	}
+
+	std::vector<uint32_t> MeshSimplifier::Simplify(const std::vector<Vector3>& positions, const std::vector<uint32_t>& indices,
+		size_t targetIndexCount, float targetError, float* resultError)
+	{
+		std::vector<uint32_t> result = indices;
+
+		if (resultError)
+			*resultError = 0.0f;
+
+		size_t numVertices = positions.size();
+
+		if (result.size() <= targetIndexCount || numVertices == 0)
+			return result;
+
+		AABB bounds;
+
+		for (const auto& position : positions)
+			bounds.Expand(position);
+
+		Vector3 size = bounds.max - bounds.min;
+		float extent = std::max(size.x, std::max(size.y, size.z));
+
+		if (extent <= 0.0f)
+			return result;
+
+		double errorLimit = (double)targetError * extent * (double)targetError * extent;
+
+		// Vertices split for normals or UVs share a position. Topology is evaluated on the first vertex of each position.
+		std::vector<uint32_t> weld(numVertices);
+		std::vector<uint32_t> wedgeCount(numVertices, 0);
+		std::unordered_map<Vector3, uint32_t, PositionHash> firstVertexAtPosition;
+		firstVertexAtPosition.reserve(numVertices);
+
+		for (uint32_t i = 0; i < numVertices; i++)
+		{
+			weld[i] = firstVertexAtPosition.insert({ positions[i], i }).first->second;
+			wedgeCount[weld[i]]++;
+		}
+
+		std::unordered_map<uint64_t, uint32_t> edgeTriangles;
+		std::vector<VertexKind> kinds(numVertices);
+
+		// Counts the triangles on each welded edge and classifies the vertices
+		auto classify = [&]()
+			{
+				edgeTriangles.clear();
+
+				for (size_t i = 0; i < result.size(); i += 3)
+				{
+					for (int k = 0; k < 3; k++)
+						edgeTriangles[EdgeKey(weld[result[i + k]], weld[result[i + (k + 1) % 3]])]++;
+				}
+
+				std::vector<uint8_t> border(numVertices, 0), complex(numVertices, 0);
+
+				for (const auto& [key, count] : edgeTriangles)
+				{
+					uint32_t a = (uint32_t)(key >> 32), b = (uint32_t)(key & 0xffffffffu);
+
+					if (count == 1)
+						border[a] = border[b] = 1;
+					else if (count > 2)
+						complex[a] = complex[b] = 1;
+				}
+
+				for (uint32_t i = 0; i < numVertices; i++)
+				{
+					uint32_t w = weld[i];
+
+					if (wedgeCount[w] > 1 || complex[w])
+						kinds[i] = VertexKind::LOCKED;
+					else if (border[w])
+						kinds[i] = VertexKind::BORDER;
+					else
+						kinds[i] = VertexKind::MANIFOLD;
+				}
+			};
+
+		auto isBorderEdge = [&](uint32_t a, uint32_t b)
+			{
+				auto it = edgeTriangles.find(EdgeKey(weld[a], weld[b]));
+				return it != edgeTriangles.end() && it->second == 1;
+			};
+
+		classify();
+
+		// Face planes weighted by area, plus planes through border edges perpendicular to their face
+		std::vector<Quadric> quadrics(numVertices);
+
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			uint32_t triangle[3] = { result[i], result[i + 1], result[i + 2] };
+			const Vector3& p0 = positions[triangle[0]];
+			Vector3 normal = glm::cross(positions[triangle[1]] - p0, positions[triangle[2]] - p0);
+			float doubleArea = glm::length(normal);
+
+			if (doubleArea <= 0.0f)
+				continue;
+
+			normal /= doubleArea;
+
+			for (int k = 0; k < 3; k++)
+				quadrics[triangle[k]].AddPlane(normal, -glm::dot(normal, p0), doubleArea * 0.5);
+
+			for (int k = 0; k < 3; k++)
+			{
+				uint32_t a = triangle[k], b = triangle[(k + 1) % 3];
+
+				if (!isBorderEdge(a, b))
+					continue;
+
+				Vector3 edge = positions[b] - positions[a];
+				Vector3 borderNormal = glm::cross(edge, normal);
+				float length = glm::length(borderNormal);
+
+				if (length <= 0.0f)
+					continue;
+
+				borderNormal /= length;
+				double borderWeight = glm::dot(edge, edge) * sBorderWeight;
+				quadrics[a].AddPlane(borderNormal, -glm::dot(borderNormal, positions[a]), borderWeight);
+				quadrics[b].AddPlane(borderNormal, -glm::dot(borderNormal, positions[a]), borderWeight);
+			}
+		}
+
+		std::vector<uint32_t> vertexTriangleOffsets, vertexTriangles;
+		std::vector<Collapse> collapses;
+		std::vector<uint8_t> touched(numVertices);
+		std::vector<uint32_t> remap(numVertices);
+		double maxError = 0.0;
+
+		auto canCollapse = [&](uint32_t from, uint32_t to)
+			{
+				if (kinds[from] == VertexKind::MANIFOLD)
+					return true;
+
+				return kinds[from] == VertexKind::BORDER && kinds[to] != VertexKind::MANIFOLD && isBorderEdge(from, to);
+			};
+
+		// Moving from onto to must not turn any remaining triangle around from upside down
+		auto flipsTriangles = [&](uint32_t from, uint32_t to)
+			{
+				for (uint32_t i = vertexTriangleOffsets[from]; i < vertexTriangleOffsets[from + 1]; i++)
+				{
+					const uint32_t* triangle = &result[vertexTriangles[i] * 3];
+
+					if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+						continue;
+
+					Vector3 before[3], after[3];
+
+					for (int k = 0; k < 3; k++)
+					{
+						before[k] = positions[triangle[k]];
+						after[k] = positions[triangle[k] == from ? to : triangle[k]];
+					}
+
+					Vector3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+					Vector3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+
+					if (glm::dot(normalBefore, normalAfter) <= 0.25f * glm::length(normalBefore) * glm::length(normalAfter))
+						return true;
+				}
+
+				return false;
+			};
+
+		// Each pass applies a batch of independent collapses, cheapest first
+		while (result.size() > targetIndexCount)
+		{
+			size_t numTriangles = result.size() / 3;
+
+			vertexTriangleOffsets.assign(numVertices + 1, 0);
+
+			for (uint32_t index : result)
+				vertexTriangleOffsets[index + 1]++;
+
+			for (size_t i = 0; i < numVertices; i++)
+				vertexTriangleOffsets[i + 1] += vertexTriangleOffsets[i];
+
+			vertexTriangles.resize(result.size());
+			std::vector<uint32_t> cursor(vertexTriangleOffsets.begin(), vertexTriangleOffsets.end() - 1);
+
+			for (size_t i = 0; i < result.size(); i++)
+				vertexTriangles[cursor[result[i]]++] = (uint32_t)(i / 3);
+
+			collapses.clear();
+
+			for (size_t i = 0; i < result.size(); i += 3)
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					uint32_t a = result[i + k], b = result[i + (k + 1) % 3];
+
+					// Shared edges are visited from both triangles, keep one
+					if (a > b && !isBorderEdge(a, b))
+						continue;
+
+					Collapse best = { 0, 0, DBL_MAX };
+
+					if (canCollapse(a, b))
+						best = { a, b, quadrics[a].Evaluate(positions[b]) };
+
+					if (canCollapse(b, a))
+					{
+						double cost = quadrics[b].Evaluate(positions[a]);
+
+						if (cost < best.cost)
+							best = { b, a, cost };
+					}
+
+					if (best.cost != DBL_MAX)
+						collapses.push_back(best);
+				}
+			}
+
+			if (collapses.empty())
+				break;
+
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+			size_t trianglesToRemove = numTriangles - targetIndexCount / 3;
+			size_t removedTriangles = 0;
+			size_t appliedCollapses = 0;
+
+			std::fill(touched.begin(), touched.end(), 0);
+
+			for (uint32_t i = 0; i < numVertices; i++)
+				remap[i] = i;
+
+			for (const auto& collapse : collapses)
+			{
+				if (collapse.cost > errorLimit || removedTriangles >= trianglesToRemove)
+					break;
+
+				if (touched[collapse.from] || touched[collapse.to] || flipsTriangles(collapse.from, collapse.to))
+					continue;
+
+				// The triangles around from change, keep their vertices out of this pass
+				for (uint32_t i = vertexTriangleOffsets[collapse.from]; i < vertexTriangleOffsets[collapse.from + 1]; i++)
+				{
+					const uint32_t* triangle = &result[vertexTriangles[i] * 3];
+
+					if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+						removedTriangles++;
+
+					touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = 1;
+				}
+
+				remap[collapse.from] = collapse.to;
+				quadrics[collapse.to].Add(quadrics[collapse.from]);
+				maxError = std::max(maxError, collapse.cost);
+				appliedCollapses++;
+			}
+
+			if (appliedCollapses == 0)
+				break;
+
+			size_t writeIndex = 0;
+
+			for (size_t i = 0; i < result.size(); i += 3)
+			{
+				uint32_t a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+
+				if (a == b || b == c || a == c)
+					continue;
+
+				result[writeIndex++] = a;
+				result[writeIndex++] = b;
+				result[writeIndex++] = c;
+			}
+
+			result.resize(writeIndex);
+			classify();
+		}
+
+		if (resultError)
+			*resultError = (float)(sqrt(maxError) / extent);
+
+		return result;
+	}
+}
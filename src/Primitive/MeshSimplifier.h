@@ -0,0 +1,25 @@
+#pragma once
+#include "Renderer/Bounds.h"
+
+namespace TS_ENGINE {
+
+	/// <summary>
+	/// Quadric error mesh simplification (Garland and Heckbert). Edges are collapsed onto one of their existing vertices,
+	/// so the result is a new index list over the same vertex buffer and can be used as a LOD without new vertices.
+	/// CPU only, safe to run on worker threads for different meshes.
+	/// </summary>
+	class MeshSimplifier
+	{
+	public:
+		static constexpr float sBorderWeight = 10.0f;		// Scale of the quadrics keeping open borders in place
+
+		/// <summary>
+		/// Collapses the cheapest edges until the index count reaches targetIndexCount or the next collapse would move the surface
+		/// by more than targetError (fraction of the mesh extent). Vertices on attribute seams and non-manifold edges are kept,
+		/// border vertices only slide along the border and collapses that would flip a triangle are skipped.
+		/// resultError receives the largest error of the applied collapses, as a fraction of the extent.
+		/// </summary>
+		static std::vector<uint32_t> Simplify(const std::vector<Vector3>& positions, const std::vector<uint32_t>& indices,
+			size_t targetIndexCount, float targetError, float* resultError = nullptr);
+	};
+}
@@ -0,0 +1,359 @@
+#include "tspch.h"
+#include "Primitive/Meshlet.h"
+#include "Primitive/MeshOptimizer.h"
+#include "Renderer/Frustum.h"
+
+namespace TS_ENGINE {
+
+	std::vector<Meshlet> MeshletUtils::Build(const std::vector<Vector3>& positions, std::vector<uint32_t>& indices)
+	{
+		std::vector<Meshlet> meshlets;
+		size_t numTriangles = indices.size() / 3;
+		size_t numVertices = positions.size();
+
+		if (numTriangles == 0 || numVertices == 0)
+			return meshlets;
+
+		// Triangles using each vertex
+		std::vector<uint32_t> vertexTriangleOffsets(numVertices + 1, 0);
+
+		for (uint32_t index : indices)
+			vertexTriangleOffsets[index + 1]++;
+
+		for (size_t i = 0; i < numVertices; i++)
+			vertexTriangleOffsets[i + 1] += vertexTriangleOffsets[i];
+
+		std::vector<uint32_t> vertexTriangles(indices.size());
+		std::vector<uint32_t> liveTriangles(numVertices);
+		std::vector<uint32_t> cursor(vertexTriangleOffsets.begin(), vertexTriangleOffsets.end() - 1);
+
+		for (size_t i = 0; i < indices.size(); i++)
+			vertexTriangles[cursor[indices[i]]++] = (uint32_t)(i / 3);
+
+		for (size_t i = 0; i < numVertices; i++)
+			liveTriangles[i] = vertexTriangleOffsets[i + 1] - vertexTriangleOffsets[i];
+
+		std::vector<Vector3> triangleCentroids(numTriangles);
+
+		for (size_t i = 0; i < numTriangles; i++)
+			triangleCentroids[i] = (positions[indices[i * 3]] + positions[indices[i * 3 + 1]] + positions[indices[i * 3 + 2]]) / 3.0f;
+
+		std::vector<uint8_t> emitted(numTriangles, 0);
+		std::vector<uint32_t> vertexMeshlet(numVertices, UINT32_MAX);	// Last meshlet that referenced the vertex
+		std::vector<uint32_t> meshletVertices;
+		std::vector<uint32_t> reordered;
+		reordered.reserve(indices.size());
+		meshletVertices.reserve(sMaxVertices);
+
+		uint32_t meshletIndex = 0;
+		size_t nextSeed = 0;
+		Meshlet meshlet;
+		Vector3 centroidSum(0.0f);
+
+		auto countNewVertices = [&](uint32_t triangle)
+			{
+				uint32_t a = indices[triangle * 3], b = indices[triangle * 3 + 1], c = indices[triangle * 3 + 2];
+				uint32_t count = vertexMeshlet[a] != meshletIndex ? 1 : 0;
+				count += (vertexMeshlet[b] != meshletIndex && b != a) ? 1 : 0;
+				count += (vertexMeshlet[c] != meshletIndex && c != a && c != b) ? 1 : 0;
+				return count;
+			};
+
+		auto finishMeshlet = [&]()
+			{
+				if (meshlet.triangleCount > 0)
+				{
+					meshlet.vertexCount = (uint32_t)meshletVertices.size();
+					meshlets.push_back(meshlet);
+				}
+
+				meshletIndex++;
+				meshlet = Meshlet();
+				meshlet.firstIndex = (uint32_t)reordered.size();
+				meshletVertices.clear();
+				centroidSum = Vector3(0.0f);
+			};
+
+		while (reordered.size() < indices.size())
+		{
+			// Unemitted triangle touching the meshlet that adds the fewest vertices, nearest to the meshlet on ties
+			int64_t best = -1;
+			uint32_t bestNewVertices = UINT32_MAX;
+			float bestDistance = FLT_MAX;
+			Vector3 center = meshlet.triangleCount > 0 ? centroidSum / (float)meshlet.triangleCount : Vector3(0.0f);
+
+			for (uint32_t vertex : meshletVertices)
+			{
+				if (liveTriangles[vertex] == 0)
+					continue;
+
+				for (uint32_t i = vertexTriangleOffsets[vertex]; i < vertexTriangleOffsets[vertex + 1]; i++)
+				{
+					uint32_t triangle = vertexTriangles[i];
+
+					if (emitted[triangle])
+						continue;
+
+					uint32_t newVertices = countNewVertices(triangle);
+
+					if (newVertices > bestNewVertices)
+						continue;
+
+					Vector3 offset = triangleCentroids[triangle] - center;
+					float distance = glm::dot(offset, offset);
+
+					if (newVertices < bestNewVertices || distance < bestDistance)
+					{
+						best = triangle;
+						bestNewVertices = newVertices;
+						bestDistance = distance;
+					}
+				}
+			}
+
+			// Nothing connected left, continue with the next triangle in index order
+			if (best < 0)
+			{
+				while (emitted[nextSeed])
+					nextSeed++;
+
+				best = (int64_t)nextSeed;
+				bestNewVertices = countNewVertices((uint32_t)best);
+			}
+
+			if (meshlet.triangleCount + 1 > sMaxTriangles || meshletVertices.size() + bestNewVertices > sMaxVertices)
+			{
+				finishMeshlet();
+				continue;
+			}
+
+			uint32_t triangle = (uint32_t)best;
+
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				uint32_t vertex = indices[triangle * 3 + k];
+
+				if (vertexMeshlet[vertex] != meshletIndex)
+				{
+					vertexMeshlet[vertex] = meshletIndex;
+					meshletVertices.push_back(vertex);
+				}
+
+				liveTriangles[vertex]--;
+				reordered.push_back(vertex);
+			}
+
+			emitted[triangle] = 1;
+			meshlet.triangleCount++;
+			centroidSum += triangleCentroids[triangle];
+		}
+
+		finishMeshlet();
+		indices.swap(reordered);
+
+		// Growing by shared vertices undoes the import's vertex cache order, so each meshlet's triangles are ordered again.
+		// Meshlets follow the seeds in index order, which keeps the overdraw order between them.
+		std::vector<uint32_t> localIndices;
+		std::vector<uint32_t> localVertices;
+		std::vector<uint32_t> localIds(numVertices, UINT32_MAX);
+
+		for (const auto& builtMeshlet : meshlets)
+		{
+			uint32_t indexCount = builtMeshlet.triangleCount * 3;
+			localIndices.resize(indexCount);
+			localVertices.clear();
+
+			for (uint32_t i = 0; i < indexCount; i++)
+			{
+				uint32_t vertex = indices[builtMeshlet.firstIndex + i];
+
+				if (localIds[vertex] == UINT32_MAX)
+				{
+					localIds[vertex] = (uint32_t)localVertices.size();
+					localVertices.push_back(vertex);
+				}
+
+				localIndices[i] = localIds[vertex];
+			}
+
+			MeshOptimizer::OptimizeVertexCache(localIndices, localVertices.size());
+
+			for (uint32_t i = 0; i < indexCount; i++)
+				indices[builtMeshlet.firstIndex + i] = localVertices[localIndices[i]];
+
+			for (uint32_t vertex : localVertices)
+				localIds[vertex] = UINT32_MAX;
+		}
+
+		for (auto& builtMeshlet : meshlets)
+			ComputeBounds(builtMeshlet, positions, indices);
+
+		return meshlets;
+	}
+
+	// Cone computation follows meshoptimizer's meshopt_computeClusterBounds
+	void MeshletUtils::ComputeBounds(Meshlet& meshlet, const std::vector<Vector3>& positions, const std::vector<uint32_t>& indices)
+	{
+		AABB box;
+		uint32_t lastIndex = meshlet.firstIndex + meshlet.triangleCount * 3;
+
+		for (uint32_t i = meshlet.firstIndex; i < lastIndex; i++)
+			box.Expand(positions[indices[i]]);
+
+		Vector3 center = box.GetCenter();
+		float radiusSquared = 0.0f;
+
+		for (uint32_t i = meshlet.firstIndex; i < lastIndex; i++)
+		{
+			Vector3 offset = positions[indices[i]] - center;
+			radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+		}
+
+		meshlet.bounds = BoundingSphere(center, sqrtf(radiusSquared));
+
+		// Normal cone
+		Vector3 normals[sMaxTriangles];
+		uint32_t numNormals = 0;
+		Vector3 normalSum(0.0f);
+
+		for (uint32_t i = meshlet.firstIndex; i < lastIndex; i += 3)
+		{
+			const Vector3& p0 = positions[indices[i]];
+			Vector3 normal = glm::cross(positions[indices[i + 1]] - p0, positions[indices[i + 2]] - p0);
+			float length = glm::length(normal);
+
+			if (length <= 1e-12f)
+				continue;
+
+			normals[numNormals] = normal / length;
+			normalSum += normals[numNormals];
+			numNormals++;
+		}
+
+		meshlet.coneCutoff = 1.0f;
+		float axisLength = glm::length(normalSum);
+
+		if (numNormals == 0 || axisLength <= 1e-6f)
+			return;
+
+		Vector3 axis = normalSum / axisLength;
+		float minDot = 1.0f;
+
+		for (uint32_t i = 0; i < numNormals; i++)
+			minDot = std::min(minDot, glm::dot(axis, normals[i]));
+
+		// Wider than about 84 degrees, the cone would almost never cull
+		if (minDot <= 0.1f)
+			return;
+
+		// Move the apex back so every triangle's plane is in front of it
+		float maxT = 0.0f;
+		uint32_t normalIndex = 0;
+
+		for (uint32_t i = meshlet.firstIndex; i < lastIndex; i += 3)
+		{
+			const Vector3& p0 = positions[indices[i]];
+			Vector3 normal = glm::cross(positions[indices[i + 1]] - p0, positions[indices[i + 2]] - p0);
+
+			if (glm::length(normal) <= 1e-12f)
+				continue;
+
+			const Vector3& unitNormal = normals[normalIndex++];
+			float t = glm::dot(center - p0, unitNormal) / glm::dot(axis, unitNormal);
+			maxT = std::max(maxT, t);
+		}
+
+		meshlet.coneApex = center - axis * maxT;
+		meshlet.coneAxis = axis;
+		meshlet.coneCutoff = sqrtf(1.0f - minDot * minDot);
+	}
+
+	uint32_t MeshletUtils::Cull(const std::vector<Meshlet>& meshlets, const Frustum* frustum, const Matrix4& worldMatrix, const Vector3& cameraPosition,
+		const Vector3& viewDirection, bool orthographic, bool backFaceCulled, std::vector<IndexRange>& visibleRanges)
+	{
+		visibleRanges.clear();
+
+		// Work in mesh space: planes go through the transpose of the world matrix, the camera through its inverse
+		Vector4 planes[Frustum::COUNT];
+
+		if (frustum)
+		{
+			Matrix4 transposedWorldMatrix = glm::transpose(worldMatrix);
+
+			for (int i = 0; i < Frustum::COUNT; i++)
+			{
+				Vector4 plane = transposedWorldMatrix * frustum->GetPlane((Frustum::Plane)i);
+				float length = glm::length(Vector3(plane));
+				planes[i] = length > 0.0f ? plane / length : plane;
+			}
+		}
+
+		// Angles are only kept by uniform scale. A mirroring matrix flips the winding, so the cones would point at the drawn side.
+		Matrix3 linearMatrix = Matrix3(worldMatrix);
+		float scaleX = glm::length(linearMatrix[0]);
+		float scaleY = glm::length(linearMatrix[1]);
+		float scaleZ = glm::length(linearMatrix[2]);
+		float maxScale = std::max(scaleX, std::max(scaleY, scaleZ));
+		float minScale = std::min(scaleX, std::min(scaleY, scaleZ));
+		bool coneCulling = backFaceCulled && minScale > 0.0f && maxScale - minScale <= maxScale * 0.01f && glm::determinant(linearMatrix) > 0.0f;
+
+		Vector3 localCameraPosition(0.0f);
+		Vector3 localViewDirection(0.0f);
+
+		if (coneCulling)
+		{
+			// Every view ray of an orthographic camera shares its direction, its position says nothing about which side is seen
+			if (orthographic)
+				localViewDirection = glm::normalize(glm::inverse(linearMatrix) * viewDirection);
+			else
+				localCameraPosition = Vector3(glm::inverse(worldMatrix) * Vector4(cameraPosition, 1.0f));
+		}
+
+		uint32_t visibleTriangles = 0;
+
+		for (const auto& meshlet : meshlets)
+		{
+			bool visible = true;
+
+			if (frustum)
+			{
+				for (int i = 0; i < Frustum::COUNT && visible; i++)
+				{
+					if (glm::dot(Vector3(planes[i]), meshlet.bounds.center) + planes[i].w < -meshlet.bounds.radius)
+						visible = false;
+				}
+			}
+
+			if (visible && coneCulling && meshlet.coneCutoff < 1.0f)
+			{
+				if (orthographic)
+				{
+					if (glm::dot(localViewDirection, meshlet.coneAxis) >= meshlet.coneCutoff)
+						visible = false;
+				}
+				else
+				{
+					Vector3 apexDirection = meshlet.coneApex - localCameraPosition;
+					float distance = glm::length(apexDirection);
+
+					if (distance > 0.0f && glm::dot(apexDirection, meshlet.coneAxis) >= meshlet.coneCutoff * distance)
+						visible = false;
+				}
+			}
+
+			if (!visible)
+				continue;
+
+			uint32_t indexCount = meshlet.triangleCount * 3;
+
+			if (!visibleRanges.empty() && visibleRanges.back().firstIndex + visibleRanges.back().indexCount == meshlet.firstIndex)
+				visibleRanges.back().indexCount += indexCount;
+			else
+				visibleRanges.push_back({ meshlet.firstIndex, indexCount });
+
+			visibleTriangles += meshlet.triangleCount;
+		}
+
+		return visibleTriangles;
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "Renderer/Bounds.h"
+#include "Renderer/Buffer.h"
+
+namespace TS_ENGINE {
+
+	class Frustum;
+
+	/// <summary>
+	/// A small cluster of a mesh's triangles. Its triangles are contiguous in the mesh's index list,
+	/// so a visible meshlet is drawn as one index range.
+	/// </summary>
+	struct Meshlet
+	{
+		uint32_t firstIndex = 0;
+		uint32_t triangleCount = 0;
+		uint32_t vertexCount = 0;			// Unique vertices referenced
+		BoundingSphere bounds;				// Mesh space
+
+		// Normal cone. The meshlet faces away from every camera inside the cone behind the apex.
+		Vector3 coneApex = Vector3(0.0f);
+		Vector3 coneAxis = Vector3(0.0f);
+		float coneCutoff = 1.0f;			// Sine of the cone's half angle, 1 when the normals are too spread out to cull
+	};
+
+	class MeshletUtils
+	{
+	public:
+		static constexpr uint32_t sMaxVertices = 64;
+		static constexpr uint32_t sMaxTriangles = 124;
+
+		/// <summary>
+		/// Greedily grows meshlets over shared vertices, preferring triangles that add the fewest new vertices
+		/// and then the ones closest to the meshlet. Reorders the triangles of indices so each meshlet is contiguous,
+		/// then orders each meshlet's triangles for the vertex cache.
+		/// </summary>
+		static std::vector<Meshlet> Build(const std::vector<Vector3>& positions, std::vector<uint32_t>& indices);
+
+		/// <summary>
+		/// Fills visibleRanges with the index ranges of the meshlets that are inside the frustum and not facing away from the camera.
+		/// Neighbouring visible meshlets are merged into one range. frustum can be nullptr to skip frustum culling.
+		/// Orthographic cameras are tested by their world space viewDirection, perspective ones by cameraPosition.
+		/// Cone culling only runs when the draw culls back faces (backFaceCulled), and is skipped when the world matrix
+		/// has non uniform scale or mirrors. Returns the number of visible triangles.
+		/// </summary>
+		static uint32_t Cull(const std::vector<Meshlet>& meshlets, const Frustum* frustum, const Matrix4& worldMatrix, const Vector3& cameraPosition,
+			const Vector3& viewDirection, bool orthographic, bool backFaceCulled, std::vector<IndexRange>& visibleRanges);
+	private:
+		static void ComputeBounds(Meshlet& meshlet, const std::vector<Vector3>& positions, const std::vector<uint32_t>& indices);
+	};
+}
@@ -4,6 +4,9 @@
 #include "Core/Application.h"
 #include "Renderer/MaterialManager.h"
 #include "Core/Factory.h"
+#include "MeshOptimizer.h"
+#include "Core/JobSystem.h"
+#include <atomic>
 
 namespace TS_ENGINE {
 
@@ -66,11 +69,29 @@ namespace TS_ENGINE {
 		}
 
 		// Process meshes
+		std::vector<Ref<Mesh>> meshes;
+		meshes.reserve(mAssimpScene->mNumMeshes);
+
 		for (unsigned int i = 0; i < mAssimpScene->mNumMeshes; i++)
 		{
 			aiMesh* assimpMesh = mAssimpScene->mMeshes[i];
 			Ref<Mesh> mesh = ProcessMesh(assimpMesh, mAssimpScene);
 			mProcessedMeshes.insert({ mesh->GetName(), mesh });
+			meshes.push_back(mesh);
+		}
+
+		// Optimize meshes on worker threads, then upload on this thread since it owns the GL context
+		OptimizeMeshes(meshes);
+
+		// Skinned meshes share the model's bone matrices so they can be ray cast in their current pose
+		mBoneMatrices = CreateRef<std::vector<Matrix4>>(mBoneCounter, Matrix4(1));
+
+		for (auto& mesh : meshes)
+		{
+			if (mesh->HasBoneInfluence())
+				mesh->SetBoneMatrices(mBoneMatrices);
+
+			mesh->Create();
 		}
 
 		// Process Nodes
@@ -235,10 +256,12 @@ namespace TS_ENGINE {
 		
 		// Fetch Material Info From mProcessedMaterials
 		Ref<Material> material = nullptr;
+		int twoSided = 0;
 
 		if (aiMesh->mMaterialIndex >= 0)
 		{
 			aiMaterial* aiMat = scene->mMaterials[aiMesh->mMaterialIndex];
+			aiMat->Get(AI_MATKEY_TWOSIDED, twoSided);
 
 			// Material name should not be null
 			TS_CORE_ASSERT(mProcessedMaterials[aiMat->GetName().C_Str()]);
@@ -250,6 +273,7 @@ namespace TS_ENGINE {
 		mesh->SetVertices(vertices);	// Vertices
 		mesh->SetIndices(indices);		// Indices		
 		mesh->SetMaterial(material);	// Materials
+		mesh->SetDoubleSided(twoSided != 0);
 
 		for(auto& vertex : mesh->GetVertices())
 		{
@@ -268,14 +292,71 @@ namespace TS_ENGINE {
 			}
 		}
 
-		// Create mesh
-		mesh->Create();
-
+		// Mesh is created after the optimization stage in LoadModel
 		return mesh;
 	}
 
+	void Model::OptimizeMeshes(std::vector<Ref<Mesh>>& _meshes)
+	{
+		std::vector<MeshOptimizationReport> reports(_meshes.size());
+		std::vector<std::vector<uint32_t>> occluderIndices(_meshes.size());
+		std::atomic<size_t> nextMesh(0);
+
+		auto worker = [&]()
+			{
+				for (size_t i = nextMesh++; i < _meshes.size(); i = nextMesh++)
+				{
+					reports[i] = MeshOptimizer::Optimize(_meshes[i]->GetVertices(), _meshes[i]->GetIndices());
+
+					// Skinned vertices move away from the meshlet bounds, so only static meshes are clustered
+					if (!_meshes[i]->HasBoneInfluence())
+						_meshes[i]->BuildMeshlets();
+
+					_meshes[i]->GenerateLODs();
+
+					// Simplified from the LODs, so large meshes can still occlude
+					occluderIndices[i] = _meshes[i]->BuildOccluderIndices();
+				}
+			};
+
+		// One worker job per pool thread plus this thread, all inline when already on a worker
+		size_t numWorkers = JobSystem::IsWorkerThread() ? 1 : std::min<size_t>(JobSystem::GetInstance()->GetWorkerCount() + 1, _meshes.size());
+		std::vector<std::future<void>> workers;
+
+		for (size_t i = 1; i < numWorkers; i++)
+		{
+			workers.push_back(JobSystem::GetInstance()->Async(worker));
+		}
+
+		worker();
+
+		for (auto& future : workers)
+		{
+			future.get();
+		}
+
+		for (size_t i = 0; i < _meshes.size(); i++)
+		{
+			if (!occluderIndices[i].empty())
+				_meshes[i]->CreateOccluderMesh(occluderIndices[i]);
+
+			const MeshOptimizationReport& report = reports[i];
+
+			TS_CORE_TRACE("Optimized mesh {0}: ACMR {1:.3f} -> {2:.3f}, ATVR {3:.3f} -> {4:.3f}, removed {5} triangles and {6} vertices, {7} clusters, {8} meshlets, {9} LODs",
+				_meshes[i]->GetName(), report.before.acmr, report.after.acmr, report.before.atvr, report.after.atvr,
+				report.removedTriangles, report.removedVertices, report.clusters, _meshes[i]->GetMeshlets().size(), _meshes[i]->GetLODCount());
+		}
+	}
+
 	Ref<Texture2D> Model::ProcessTexture(aiMaterial* _assimpMaterial, aiTextureType _textureType, uint32_t _numMaps)
 	{
+		TextureUsage usage = TextureUsage::Data;
+
+		if (_textureType == aiTextureType_DIFFUSE || _textureType == aiTextureType_BASE_COLOR || _textureType == aiTextureType_EMISSIVE)
+			usage = TextureUsage::Color;
+		else if (_textureType == aiTextureType_NORMALS)
+			usage = TextureUsage::NormalMap;
+
 		for (uint32_t i = 0; i < _numMaps; i++)
 		{
 			aiString texturePath;
@@ -296,14 +377,14 @@ namespace TS_ENGINE {
 					if (embeddedTexture)
 					{
 						//TS_CORE_INFO("Processing embedded aiTex named : {0}", embeddedTexture->mFilename.C_Str());
-						Ref<Texture2D> embeddedTex = Texture2D::Create(embeddedTexture->mFilename.C_Str(), reinterpret_cast<unsigned char*>(embeddedTexture->pcData), embeddedTexture->mWidth);
+						Ref<Texture2D> embeddedTex = Texture2D::Create(embeddedTexture->mFilename.C_Str(), reinterpret_cast<unsigned char*>(embeddedTexture->pcData), embeddedTexture->mWidth, usage);
 						//mProcessedEmbeddedTextures.insert(std::pair<std::string, Ref<Texture2D>>(aiTex->mFilename.C_Str(), embeddedTex));
 						texture = embeddedTex;
 					}
 					else
 					{
 						//TS_CORE_INFO("No embedded diffuse map named {0} found", texturePath.C_Str());
-						texture = Texture2D::Create(mModelDirectory + "\\" + texturePath.C_Str());
+						texture = Texture2D::Create(mModelDirectory + "\\" + texturePath.C_Str(), usage);
 					}
 				}
 
@@ -482,17 +563,20 @@ namespace TS_ENGINE {
 			if (bone)
 			{
 				bone->Update(_shader);
+
+				if (mBoneMatrices && bone->GetId() < (int)mBoneMatrices->size())
+					(*mBoneMatrices)[bone->GetId()] = bone->GetBoneTransformMatrix();
 				bone->UpdateBoneGui(mRootNode);
 			}
 		}
 	}
 
-	void Model::RenderBones(Ref<Shader> _shader)
+	void Model::RenderBones(Ref<Shader> _shader, DynamicBatcher* _dynamicBatcher)
 	{
 		for (auto& [name, bone] : mBoneInfoMap)
 		{
 			if (bone)			
-				bone->Render(_shader);			
+				bone->Render(_shader, _dynamicBatcher);
 		}
 	}
 }
\ No newline at end of file
@@ -19,11 +19,13 @@ namespace TS_ENGINE {
 
 		Ref<Node> GetRootNode() { return mRootNode; }	
 		std::unordered_map<std::string, Ref<Bone>>& GetBoneInfoMap() { return mBoneInfoMap;  };
+		Ref<std::vector<Matrix4>> GetBoneMatrices() const { return mBoneMatrices; }
 	private:
 		Ref<Texture2D> ProcessTexture(aiMaterial* _assimpMaterial, aiTextureType _textureType, uint32_t _numMaps);	// Process Texture		
 		Ref<Material> ProcessMaterial(aiMaterial* _assimpMaterial);													// Process Material		
 		Ref<Mesh> ProcessMesh(aiMesh* aiMesh, const aiScene* scene);												// Process Mesh
 		Ref<Node> ProcessNode(aiNode* aiNode, Ref<Node> _parentNode, const aiScene* scene);							// Process Node
+		void OptimizeMeshes(std::vector<Ref<Mesh>>& _meshes);														// Optimize Meshes In Parallel
 		
 #pragma region Bone related functions
 	public:
@@ -39,7 +41,8 @@ namespace TS_ENGINE {
 		void InitializeBones();
 	public:
 		void UpdateBone(Ref<Shader> _shader);
-		void RenderBones(Ref<Shader> _shader);
+		// With a dynamic batcher the bone GUI meshes are queued to it, for the caller to flush
+		void RenderBones(Ref<Shader> _shader, DynamicBatcher* _dynamicBatcher = nullptr);
 #pragma endregion
 
 	private:
@@ -56,6 +59,7 @@ namespace TS_ENGINE {
 		std::unordered_map<std::string, Ref<Bone>> mBoneInfoMap;					// Name & Bone Map
 
 		int mBoneCounter = 0;
+		Ref<std::vector<Matrix4>> mBoneMatrices;									// Skinning Matrices By Bone Id, Used For CPU Ray Casts
 	};
 }
 
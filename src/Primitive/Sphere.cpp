@@ -60,51 +60,45 @@ namespace TS_ENGINE {
 		}
 	}
 
-	void Sphere::CreateIndices(Ref<Mesh> mesh)
+	std::vector<uint32_t> Sphere::CreateIndices(int step)
 	{
 		// generate CCW index list of sphere triangles
 		// k1--k1+1
 		// |  / |
 		// | /  |
 		// k2--k2+1
-		std::vector<int> lineIndices;
+		std::vector<uint32_t> indices;
+		int stackCount = mStackCount / step;
+		int sectorCount = mSectorCount / step;
 		int k1, k2;
-		for (int i = 0; i < mStackCount; ++i)
-		{
-			k1 = i * (mSectorCount + 1);     // beginning of current stack
-			k2 = k1 + mSectorCount + 1;      // beginning of next stack
 
-			for (int j = 0; j < mSectorCount; ++j, ++k1, ++k2)
+		for (int i = 0; i < stackCount; ++i)
+		{
+			for (int j = 0; j < sectorCount; ++j)
 			{
+				k1 = i * step * (mSectorCount + 1) + j * step;		// current stack
+				k2 = k1 + step * (mSectorCount + 1);				// next stack
+
 				// 2 triangles per sector excluding first and last stacks
 				// k1 => k2 => k1+1
 				if (i != 0)
 				{
-					mesh->AddIndex(k1);
-					mesh->AddIndex(k2);
-					mesh->AddIndex(k1 + 1);
+					indices.push_back(k1);
+					indices.push_back(k2);
+					indices.push_back(k1 + step);
 				}
 
 				// k1+1 => k2 => k2+1
-				if (i != (mStackCount - 1))
-				{
-					mesh->AddIndex(k1 + 1);
-					mesh->AddIndex(k2);
-					mesh->AddIndex(k2 + 1);
-				}
-
-				// store indices for lines
-				// vertical lines for all stacks, k1 => k2
-				lineIndices.push_back(k1);
-				lineIndices.push_back(k2);
-
-				if (i != 0)  // horizontal lines except 1st stack, k1 => k+1
+				if (i != (stackCount - 1))
 				{
-					lineIndices.push_back(k1);
-					lineIndices.push_back(k1 + 1);
+					indices.push_back(k1 + step);
+					indices.push_back(k2);
+					indices.push_back(k2 + step);
 				}
 			}
 		}
+
+		return indices;
 	}
 
 	void Sphere::CreateMesh()
@@ -113,7 +107,18 @@ namespace TS_ENGINE {
 		mMesh->SetPrimitiveType(PrimitiveType::SPHERE);
 
 		CreateVertices(mMesh);
-		CreateIndices(mMesh);
+		mMesh->SetIndices(CreateIndices(1));
+
+		// LODs skip stacks and sectors of the same vertex grid
+		const int lodSteps[] = { 2, 4 };
+
+		for (int i = 0; i < 2; i++)
+		{
+			int step = lodSteps[i];
+
+			if (mStackCount % step == 0 && mSectorCount % step == 0 && mStackCount / step >= 2 && mSectorCount / step >= 3)
+				mMesh->AddLOD(CreateIndices(step), Mesh::sDefaultLODScreenSizes[i]);
+		}
 
 		mMesh->Create();
 	}
@@ -15,7 +15,8 @@ namespace TS_ENGINE {
 
 	private:
 		void CreateVertices(Ref<Mesh> mesh);
-		void CreateIndices(Ref<Mesh> mesh);
+		// Triangles over every step-th stack and sector of the vertex grid
+		std::vector<uint32_t> CreateIndices(int step);
 
 		void CreateMesh();
 	
@@ -0,0 +1,214 @@
+#include "tspch.h"
+#include "Renderer/AtlasPacker.h"
+#include <numeric>
+
+namespace TS_ENGINE {
+
+	AtlasPacker::AtlasPacker(uint32_t pageWidth, uint32_t pageHeight, uint32_t padding, uint32_t alignment, bool allowRotation, uint32_t maxPages) :
+		mPageWidth(pageWidth),
+		mPageHeight(pageHeight),
+		mPadding(padding),
+		mAlignment(std::max(1u, alignment)),
+		mAllowRotation(allowRotation),
+		mMaxPages(maxPages)
+	{
+		TS_CORE_ASSERT(pageWidth > 0 && pageHeight > 0);
+	}
+
+	bool AtlasPacker::Pack(const std::vector<std::pair<uint32_t, uint32_t>>& sizes, std::vector<AtlasPackerRect>& rects)
+	{
+		auto startTime = std::chrono::high_resolution_clock::now();
+
+		mPages.clear();
+		mStats = AtlasPackerStats();
+		rects.assign(sizes.size(), AtlasPackerRect());
+
+		// Longest side first, then largest area. Big rects placed late have nowhere left to go.
+		std::vector<uint32_t> order(sizes.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+			{
+				uint32_t sideA = std::max(sizes[a].first, sizes[a].second);
+				uint32_t sideB = std::max(sizes[b].first, sizes[b].second);
+
+				if (sideA != sideB)
+					return sideA > sideB;
+
+				return (uint64_t)sizes[a].first * sizes[a].second > (uint64_t)sizes[b].first * sizes[b].second;
+			});
+
+		auto alignUp = [this](uint32_t value) { return (value + mAlignment - 1) / mAlignment * mAlignment; };
+		uint64_t packedArea = 0;
+
+		for (uint32_t i : order)
+		{
+			uint32_t width = sizes[i].first;
+			uint32_t height = sizes[i].second;
+			uint32_t paddedWidth = alignUp(width + 2 * mPadding);
+			uint32_t paddedHeight = alignUp(height + 2 * mPadding);
+
+			FreeRect position = {};
+			bool rotated = false;
+			uint64_t bestScore = UINT64_MAX;
+			uint32_t bestPage = 0;
+
+			for (uint32_t page = 0; page < mPages.size(); page++)
+			{
+				FreeRect pagePosition;
+				bool pageRotated;
+				uint64_t score = FindPosition(mPages[page], paddedWidth, paddedHeight, pagePosition, pageRotated);
+
+				if (score < bestScore)
+				{
+					bestScore = score;
+					bestPage = page;
+					position = pagePosition;
+					rotated = pageRotated;
+				}
+			}
+
+			if (bestScore == UINT64_MAX && mPages.size() < mMaxPages)
+			{
+				Page page;
+				page.freeRects.push_back({ 0, 0, mPageWidth, mPageHeight });
+				bestScore = FindPosition(page, paddedWidth, paddedHeight, position, rotated);
+
+				if (bestScore != UINT64_MAX)
+				{
+					bestPage = (uint32_t)mPages.size();
+					mPages.push_back(page);
+				}
+			}
+
+			if (bestScore == UINT64_MAX)
+			{
+				mStats.failedRects++;
+				continue;
+			}
+
+			Place(mPages[bestPage], position);
+
+			AtlasPackerRect& rect = rects[i];
+			rect.x = position.x + mPadding;
+			rect.y = position.y + mPadding;
+			rect.width = rotated ? height : width;
+			rect.height = rotated ? width : height;
+			rect.page = bestPage;
+			rect.rotated = rotated;
+			rect.packed = true;
+
+			mStats.packedRects++;
+			packedArea += (uint64_t)width * height;
+		}
+
+		mStats.pages = (uint32_t)mPages.size();
+
+		if (!mPages.empty())
+			mStats.occupancy = (float)((double)packedArea / ((double)mPageWidth * mPageHeight * mPages.size()));
+
+		mStats.packingTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+		return mStats.failedRects == 0;
+	}
+
+	uint64_t AtlasPacker::FindPosition(const Page& page, uint32_t width, uint32_t height, FreeRect& position, bool& rotated) const
+	{
+		uint64_t bestScore = UINT64_MAX;
+
+		auto tryFit = [&](const FreeRect& freeRect, uint32_t fitWidth, uint32_t fitHeight, bool fitRotated)
+			{
+				if (fitWidth > freeRect.width || fitHeight > freeRect.height)
+					return;
+
+				// Best short side fit, the long side breaks ties
+				uint32_t leftoverX = freeRect.width - fitWidth;
+				uint32_t leftoverY = freeRect.height - fitHeight;
+				uint64_t score = ((uint64_t)std::min(leftoverX, leftoverY) << 32) | std::max(leftoverX, leftoverY);
+
+				if (score < bestScore)
+				{
+					bestScore = score;
+					position = { freeRect.x, freeRect.y, fitWidth, fitHeight };
+					rotated = fitRotated;
+				}
+			};
+
+		for (const auto& freeRect : page.freeRects)
+		{
+			tryFit(freeRect, width, height, false);
+
+			if (mAllowRotation && width != height)
+				tryFit(freeRect, height, width, true);
+		}
+
+		return bestScore;
+	}
+
+	void AtlasPacker::Place(Page& page, const FreeRect& placed)
+	{
+		std::vector<FreeRect>& freeRects = page.freeRects;
+		size_t count = freeRects.size();
+
+		for (size_t i = 0; i < count;)
+		{
+			FreeRect freeRect = freeRects[i];
+
+			if (placed.x >= freeRect.x + freeRect.width || placed.x + placed.width <= freeRect.x ||
+				placed.y >= freeRect.y + freeRect.height || placed.y + placed.height <= freeRect.y)
+			{
+				i++;
+				continue;
+			}
+
+			// Up to four maximal rects around the placed one
+			if (placed.x > freeRect.x)
+				freeRects.push_back({ freeRect.x, freeRect.y, placed.x - freeRect.x, freeRect.height });
+
+			if (placed.x + placed.width < freeRect.x + freeRect.width)
+				freeRects.push_back({ placed.x + placed.width, freeRect.y, freeRect.x + freeRect.width - placed.x - placed.width, freeRect.height });
+
+			if (placed.y > freeRect.y)
+				freeRects.push_back({ freeRect.x, freeRect.y, freeRect.width, placed.y - freeRect.y });
+
+			if (placed.y + placed.height < freeRect.y + freeRect.height)
+				freeRects.push_back({ freeRect.x, placed.y + placed.height, freeRect.width, freeRect.y + freeRect.height - placed.y - placed.height });
+
+			freeRects[i] = freeRects[count - 1];
+			freeRects[count - 1] = freeRects.back();
+			freeRects.pop_back();
+			count--;
+		}
+
+		auto contains = [](const FreeRect& outer, const FreeRect& inner)
+			{
+				return inner.x >= outer.x && inner.y >= outer.y &&
+					inner.x + inner.width <= outer.x + outer.width && inner.y + inner.height <= outer.y + outer.height;
+			};
+
+		for (size_t i = 0; i < freeRects.size();)
+		{
+			bool containedI = false;
+
+			for (size_t j = i + 1; j < freeRects.size();)
+			{
+				if (contains(freeRects[j], freeRects[i]))
+				{
+					containedI = true;
+					break;
+				}
+
+				if (contains(freeRects[i], freeRects[j]))
+					freeRects.erase(freeRects.begin() + j);
+				else
+					j++;
+			}
+
+			if (containedI)
+				freeRects.erase(freeRects.begin() + i);
+			else
+				i++;
+		}
+
+		page.usedWidth = std::max(page.usedWidth, placed.x + placed.width);
+		page.usedHeight = std::max(page.usedHeight, placed.y + placed.height);
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include "Core/tspch.h"
+#include "Core/Base.h"
+
+namespace TS_ENGINE {
+
+	struct AtlasPackerRect
+	{
+		uint32_t x = 0;					// Pixels of the rect inside its gutter, origin at the bottom left
+		uint32_t y = 0;
+		uint32_t width = 0;				// Size on the page, swapped if rotated
+		uint32_t height = 0;
+		uint32_t page = 0;
+		bool rotated = false;			// Turned by 90 degrees
+		bool packed = false;			// False if the rect is larger than a page or the pages ran out
+	};
+
+	struct AtlasPackerStats
+	{
+		uint32_t packedRects = 0;
+		uint32_t failedRects = 0;
+		uint32_t pages = 0;
+		float occupancy = 0.0f;			// Area of the packed rects without gutters over the area of all pages
+		float packingTime = 0.0f;		// Milliseconds
+	};
+
+	/// <summary>
+	/// MaxRects bin packer using the best short side fit, opening pages as needed. Every rect gets a gutter of padding texels
+	/// on each side and its padded size is rounded up to the alignment, so with an alignment of 2^n the first n mip levels
+	/// never mix texels of two rects.
+	/// </summary>
+	class AtlasPacker
+	{
+	public:
+		AtlasPacker(uint32_t pageWidth, uint32_t pageHeight, uint32_t padding = 0, uint32_t alignment = 1, bool allowRotation = false, uint32_t maxPages = UINT32_MAX);
+
+		// Packs the sizes from scratch, largest first. rects follows the order of sizes. Returns false if any rect wasn't packed.
+		bool Pack(const std::vector<std::pair<uint32_t, uint32_t>>& sizes, std::vector<AtlasPackerRect>& rects);
+
+		uint32_t GetPageWidth() const { return mPageWidth; }
+		uint32_t GetPageHeight() const { return mPageHeight; }
+		uint32_t GetPageCount() const { return (uint32_t)mPages.size(); }
+		// Bounds of the padded rects placed on a page
+		uint32_t GetUsedWidth(uint32_t page) const { return mPages[page].usedWidth; }
+		uint32_t GetUsedHeight(uint32_t page) const { return mPages[page].usedHeight; }
+		const AtlasPackerStats& GetStats() const { return mStats; }
+	private:
+		struct FreeRect
+		{
+			uint32_t x, y, width, height;
+		};
+
+		struct Page
+		{
+			std::vector<FreeRect> freeRects;
+			uint32_t usedWidth = 0;
+			uint32_t usedHeight = 0;
+		};
+
+		// Best free position on a page for a padded size. Lower scores fit tighter, UINT64_MAX if it doesn't fit.
+		uint64_t FindPosition(const Page& page, uint32_t width, uint32_t height, FreeRect& position, bool& rotated) const;
+		// Splits the free rects overlapping the placed rect and drops the ones contained in others
+		void Place(Page& page, const FreeRect& placed);
+
+		uint32_t mPageWidth;
+		uint32_t mPageHeight;
+		uint32_t mPadding;
+		uint32_t mAlignment;
+		bool mAllowRotation;
+		uint32_t mMaxPages;
+
+		std::vector<Page> mPages;
+		AtlasPackerStats mStats;
+	};
+}
@@ -1,173 +1,255 @@
 #include "tspch.h"
-#include "Batcher.h"
-#include <GameObject.h>
-#include <Core/Log.h>
-#include "RenderCommand.h"
+#include "Renderer/Batcher.h"
+#include <map>
 
 namespace TS_ENGINE {
 
-	Batcher* Batcher::m_pInstance = NULL;
+	namespace
+	{
+		// Static subtree, then the material properties Material::Render applies besides the diffuse map and color
+		typedef std::tuple<uint32_t, const Shader*, float, float, float, float, float, float, float, float, bool, bool> GroupKey;
+
+		GroupKey GetGroupKey(uint32_t staticRoot, const Ref<Material>& material)
+		{
+			Vector4 ambient = material->GetAmbientColor();
+			Vector4 specular = material->GetSpecularColor();
+
+			return GroupKey(staticRoot, material->GetShader().get(), ambient.x, ambient.y, ambient.z, ambient.w,
+				specular.x, specular.y, specular.z, specular.w, material->IsDepthTestEnabled(), material->IsAlphaBlendingEnabled());
+		}
+	}
 
-	Batcher* Batcher::GetInstance()
+	///***/////////////////////////////StaticBatch///////////////////////////***///
+
+	void StaticBatch::UpdateDrawRanges()
 	{
-		if (m_pInstance == NULL)
-			m_pInstance = new Batcher();
+		drawRanges.clear();
 
-		return m_pInstance;
+		for (const auto& range : ranges)
+		{
+			if (!range.batched)
+				continue;
 
+			if (!drawRanges.empty() && drawRanges.back().firstIndex + drawRanges.back().indexCount == range.firstIndex)
+				drawRanges.back().indexCount += range.indexCount;
+			else
+				drawRanges.push_back({ range.firstIndex, range.indexCount });
+		}
 	}
-	
-	Batcher::~Batcher()
+
+	///***/////////////////////////////Batcher///////////////////////////***///
+
+	std::vector<StaticBatch> Batcher::Build(Ref<Node> root, const std::unordered_set<const Node*>& excludedNodes)
 	{
-		/*for (auto vertexBuffer : mVertexArray->GetVertexBuffers())
+		std::vector<StaticBatch> batches;
+
+		if (!root)
+			return batches;
+
+		// Ordered by key, so the same scene always gives the same batches. Meshes of a node stay consecutive.
+		std::map<GroupKey, std::vector<std::pair<Ref<Node>, Ref<Mesh>>>> groups;
+
+		// Nodes with the index of the static subtree they are in, 0 outside of static subtrees
+		std::vector<std::pair<Ref<Node>, uint32_t>> stack = { { root, 0 } };
+		uint32_t staticRootCount = 0;
+
+		while (!stack.empty())
 		{
-			vertexBuffer->Unbind();
-			vertexBuffer->~VertexBuffer();
+			auto [node, staticRoot] = stack.back();
+			stack.pop_back();
+
+#ifdef TS_ENGINE_EDITOR
+			if (!node->m_Enabled || !node->IsVisibleInEditor())
+				continue;
+#endif
+			if (staticRoot == 0 && node->IsStatic())
+				staticRoot = ++staticRootCount;
+
+			for (auto& child : node->GetChildren())
+				stack.push_back({ child, staticRoot });
+
+			if (staticRoot == 0 || excludedNodes.count(node.get()) || !IsBatchable(node.get()))
+				continue;
+
+			for (auto& mesh : node->GetMeshes())
+				groups[GetGroupKey(staticRoot, mesh->GetMaterial())].push_back({ node, mesh });
 		}
 
-		mVertexArray->GetIndexBuffer()->Unbind();
-		mVertexArray->GetIndexBuffer()->~IndexBuffer();
+		Ref<TextureCompositor> compositor = nullptr;
+		std::unordered_set<const Node*> failedNodes;
+
+		for (auto& [key, meshes] : groups)
+		{
+			if (!compositor)
+				compositor = TextureCompositor::Create();
+
+			if (!BuildGroup(meshes, *compositor, batches))
+			{
+				for (auto& [node, mesh] : meshes)
+					failedNodes.insert(node.get());
+			}
+		}
+
+		// A node is only batched if all of its meshes are, other batches drop the rest of a failed node
+		size_t batchedNodeCount = 0;
+
+		for (auto& batch : batches)
+		{
+			for (auto& range : batch.ranges)
+			{
+				if (failedNodes.count(range.node.get()))
+				{
+					range.batched = false;
+				}
+				else if (!range.node->IsStaticBatched())
+				{
+					range.node->SetStaticBatched(true);
+					batchedNodeCount++;
+				}
+			}
+
+			batch.UpdateDrawRanges();
+		}
 
-		mVertexArray->~VertexArray();*/
+		TS_CORE_INFO("Built {0} static batches of {1} nodes", batches.size(), batchedNodeCount);
+		return batches;
 	}
 
-	void Batcher::CreateAtlases()
+	bool Batcher::IsEdited(const StaticBatchRange& range)
 	{
-		std::vector<Ref<Texture2D>> textures = {};
-		
-		for (auto& idAndTexturePair : Texture2D::GetTextureIdAndTexture2DMap())
-			textures.push_back(idAndTexturePair.second);
+		// The same version means the node still holds the meshes recorded
+		if (range.node->GetMeshesVersion() != range.meshesVersion)
+			return true;
 
-		mTextureAtlasCreator = CreateRef<TextureAtlasCreator>(3840, 2160, textures);
-
-		for (auto& textureAtlas : mTextureAtlasCreator->GetTextureAtlases())
+		for (const auto& batched : range.meshes)
 		{
-			auto atlasTex = textureAtlas.GetTexture();
-			mAtlasTextures.push_back(atlasTex);
+			Ref<Material> material = batched.mesh->GetMaterial();
+
+			if (batched.mesh->GetVertexVersion() != batched.vertexVersion || material.get() != batched.material
+				|| (material && material->GetVersion() != batched.materialVersion))
+				return true;
 		}
+
+		return false;
 	}
-	
-	AtlasSizeAndTextureRectPair Batcher::GetAtlasAndTextureRectPair(uint32_t texID)
+
+	bool Batcher::IsBatchable(Node* node)
 	{
-		for (auto& textureAtlas : mTextureAtlasCreator->GetTextureAtlases())
+		if (!node->HasMeshes() || node->GetBoneInfluence() || node->GetSceneCamera() || node->GetHLODCluster() >= 0
+			|| !node->GetMeshesWorldBounds().IsValid())
+			return false;
+
+		for (auto& mesh : node->GetMeshes())
 		{
-			return textureAtlas.GetAtlasSizeAndTextureRectPair(texID);
+			if (mesh->GetDrawMode() != DrawMode::TRIANGLE || mesh->HasBoneInfluence() || mesh->GetNumIndices() == 0 || !MaterialAtlas::FitsAtlas(mesh))
+				return false;
 		}
+
+		return true;
 	}
 
-	void Batcher::StartBatching(std::vector<Ref<TS_ENGINE::Node>> nodes)
+	bool Batcher::BuildGroup(const std::vector<std::pair<Ref<Node>, Ref<Mesh>>>& meshes, TextureCompositor& compositor, std::vector<StaticBatch>& batches)
 	{
-		mBatchedNode = CreateRef<TS_ENGINE::Node>();
-		mBatchedNode->SetName("BatchedNode");
+		MaterialAtlas atlas;
+		std::vector<uint32_t> entries;
+		entries.reserve(meshes.size());
 
-		Ref<GameObject> batchedGameObject = CreateRef<GameObject>();
-		Ref<Mesh> batchedMesh = CreateRef<Mesh>();		
+		for (auto& [node, mesh] : meshes)
+			entries.push_back(atlas.AddMaterial(mesh->GetMaterial()));
 
-		uint32_t lastTotalVertices = 0;
+		Ref<Texture2D> atlasTexture = atlas.Build(compositor);
 
-		if (nodes.size() == 0)
-			return;
+		if (!atlasTexture)
+			return false;
 
-		for (auto& node : nodes)
+		// The group shares every property but the diffuse map and color, which the atlas holds
+		Ref<Material> material = MaterialAtlas::CreateAtlasMaterial(meshes[0].second->GetMaterial(), atlasTexture);
+
+		StaticBatch batch;
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+
+		auto flush = [&]()
+			{
+				Ref<Mesh> batchMesh = CreateRef<Mesh>();
+				batchMesh->SetName("StaticBatch");
+				batchMesh->SetMaterial(material);
+				batchMesh->SetVertices(std::move(vertices));
+				batchMesh->SetIndices(std::move(indices));
+				batchMesh->Create();
+
+				batch.mesh = batchMesh;
+				batches.push_back(std::move(batch));
+
+				batch = StaticBatch();
+				vertices.clear();
+				indices.clear();
+			};
+
+		for (size_t i = 0; i < meshes.size(); i++)
 		{
-			uint32_t meshIndex = 0;
-			Ref<GameObject> go = node->GetAttachedObject();
-
-			uint32_t texID = go->GetTextureID();
-			//TS_CORE_INFO("Texture ID for {0} is {1}",go->GetName(), texID);
-			AtlasSizeAndTextureRectPair atlasAndTextureRectPair = GetAtlasAndTextureRectPair(texID);
-			
-			Rect rect = atlasAndTextureRectPair.GetRect();//Rect between 0 - texWidth, 0, texHeight
-			float atlasWidth = atlasAndTextureRectPair.GetAtlasSize().x;
-			float atlasHeight = atlasAndTextureRectPair.GetAtlasSize().y;
-
-			float u1 = rect.x;
-			float v1 = rect.y;
-			float u2 = (rect.x + rect.w);
-			float v2 = (rect.y + rect.h);
-
-			for (auto& mesh : go->GetMeshes())
+			const auto& [node, mesh] = meshes[i];
+			const std::vector<Vertex>& meshVertices = mesh->GetVertices();
+			bool sameNode = !batch.ranges.empty() && batch.ranges.back().node == node;
+
+			// A node's meshes stay in one batch, a node past sMaxBatchVertices on its own is batched alone with 32-bit indices
+			if (!sameNode && !vertices.empty())
 			{
-				auto vertices = mesh->GetWorldSpaceVertices(node->GetTransform()->GetLocalPosition(), node->GetTransform()->GetLocalEulerAngles(), node->GetTransform()->GetLocalScale());
-				auto indices = mesh->GetIndices();
-				GLuint currentMeshTexID = go->GetTextureID();
+				size_t nodeVertexCount = 0;
 
-				//BatchedVertex batchedVertex;
-				Vertex batchedVertex;
+				for (size_t j = i; j < meshes.size() && meshes[j].first == node; j++)
+					nodeVertexCount += meshes[j].second->GetVertices().size();
 
-				for (const TS_ENGINE::Vertex& vertex : vertices)
-				{
-					batchedVertex.position = vertex.position;
-					batchedVertex.color = go->GetColor();					
-					
-					float u = (u1 + vertex.texCoord.x * rect.w) / atlasWidth;
-					float v = (v1 + vertex.texCoord.y * rect.h) / atlasHeight;
-
-					//TS_CORE_INFO("Texcoord original : {0}, {1}", vertex.texCoord.x, vertex.texCoord.y);
-					//TS_CORE_INFO("Texcoord : {0}, {1}", u, v);
-
-					Vector2 alteredTexCoord = Vector2(u, v);
-					//batchedVertex.texCoord = vertex.texCoord;
-					batchedVertex.texCoord = alteredTexCoord;
-
-					//TS_CORE_INFO("UV: {0}, {1}", vertex.uv.x, vertex.uv.y);
-					//batchedVertex.texID = currentMeshTexID;
-					//mBatchedVertices.push_back(batchedVertex);
-					batchedMesh->AddVertex(batchedVertex);
-				}
+				if (vertices.size() + nodeVertexCount > sMaxBatchVertices)
+					flush();
+			}
 
-				for (const uint32_t& index : indices)
-				{
-					//mBatchedIndices.push_back(lastTotalVertices + index);
-					batchedMesh->AddIndex(lastTotalVertices + index);
-				}
+			const Matrix4& worldMatrix = node->GetTransform()->GetWorldTransformationMatrix();
+			Matrix3 normalMatrix = glm::transpose(glm::inverse(Matrix3(worldMatrix)));
+			const Material& meshMaterial = *mesh->GetMaterial();
+			uint32_t baseVertex = (uint32_t)vertices.size();
+			uint32_t firstIndex = (uint32_t)indices.size();
 
-				lastTotalVertices += vertices.size();
+			for (const auto& vertex : meshVertices)
+			{
+				Vertex merged = vertex;
+				merged.position = worldMatrix * Vector4(Vector3(vertex.position), 1.0f);
+				merged.texCoord = atlas.GetAtlasUV(entries[i], meshMaterial, vertex.texCoord);
 
-				//TS_CORE_INFO("Texture ID for {0}'s mesh at {1} is {2}",go->GetName(), meshIndex ,go->GetTextureID());
-				//auto tex2D = Texture2D::GetTextureFromID(go->GetTextureID());
+				Vector3 normal = normalMatrix * vertex.normal;
+				float normalLength = glm::length(normal);
+				merged.normal = normalLength > 0.0f ? normal / normalLength : normal;
 
-				meshIndex++;
+				vertices.push_back(merged);
 			}
+
+			for (uint32_t index : mesh->GetIndices())
+				indices.push_back(baseVertex + index);
+
+			uint32_t indexCount = (uint32_t)indices.size() - firstIndex;
+			StaticBatchMesh batched = { mesh.get(), &meshMaterial, mesh->GetVertexVersion(), meshMaterial.GetVersion() };
+
+			if (sameNode)
+			{
+				batch.ranges.back().indexCount += indexCount;
+				batch.ranges.back().meshes.push_back(batched);
+				continue;
+			}
+
+			StaticBatchRange range;
+			range.node = node;
+			range.worldMatrix = worldMatrix;
+			range.meshesVersion = node->GetMeshesVersion();
+			range.meshes.push_back(batched);
+			range.firstIndex = firstIndex;
+			range.indexCount = indexCount;
+			batch.ranges.push_back(range);
+			batch.bounds.Expand(node->GetMeshesWorldBounds());
 		}
 
-		//mVertexArray = VertexArray::Create();
-		//auto vao = mVertexArray->GetRendererID();
-
-		//Ref<VertexBuffer> vertexBuffer = VertexBuffer::Create(&mBatchedVertices[0], mBatchedVertices.size() * sizeof(Vertex));
-		//auto vbo = vertexBuffer->GetRendererID();
-		//
-		//vertexBuffer->SetLayout({
-		//	{ShaderDataType::FLOAT3, "a_Position"},
-		//	{ShaderDataType::FLOAT3, "a_Color"},
-		//	{ShaderDataType::FLOAT2, "a_TexCoord"}//,
-		//	//{ShaderDataType::INT, "a_TexID"},
-		//	});
-
-		//mVertexArray->AddVertexBuffer(vertexBuffer);
-
-		//Ref<IndexBuffer> indexBuffer = IndexBuffer::Create(&mBatchedIndices[0], mBatchedIndices.size());
-		//
-		//mVertexArray->SetIndexBuffer(indexBuffer);
-		//
-		//mVertexArray->Unbind();
-
-		batchedMesh->Create();
-		batchedGameObject->AddMesh(batchedMesh);
-		batchedGameObject->SetTexture(mAtlasTextures[0]);
-		mBatchedNode->AttachGameObject(batchedGameObject);
-
-		TS_CORE_INFO("***Batching completed***");
-		mBatched = true;
-	}
+		if (!indices.empty())
+			flush();
 
-	//void Batcher::DrawBatch()
-	//{
-		/*mAtlasTextures[0]->Bind();
-		RenderCommand::DrawIndexed(mVertexArray, mBatchedIndices.size());
-		
-		TS_ENGINE::Application::Get().AddDrawCalls(1);
-		TS_ENGINE::Application::Get().AddVertices(mBatchedVertices.size());
-		TS_ENGINE::Application::Get().AddIndices(mBatchedIndices.size());*/
-	//}
-}
\ No newline at end of file
+		return true;
+	}
+}
@@ -1,53 +1,67 @@
 #pragma once
-#include "TS_ENGINE.h"
 #include "SceneManager/Node.h"
-#include "TextureAtlasCreator.h"
-#include "Core/Base.h"
+#include "Renderer/MaterialAtlas.h"
+#include <unordered_set>
 
 namespace TS_ENGINE {
 
-	//struct BatchedVertex
-	//{
-	//	Vector3 position;//World space position
-	//	Vector3 color;
-	//	Vector2 texCoord;
-	//	GLuint texID;
-	//};
-
-	class Batcher
+	// A batched mesh with the versions its edits bump, at build time
+	struct StaticBatchMesh
 	{
-	public:
-		static Batcher* GetInstance();
-		~Batcher();		
-		
-		const bool IsBatched() const
-		{
-			return mBatched;
-		}
-
-		void CreateAtlases();
-		AtlasSizeAndTextureRectPair GetAtlasAndTextureRectPair(uint32_t texID);
+		const Mesh* mesh = nullptr;
+		const Material* material = nullptr;
+		uint32_t vertexVersion = 0;
+		uint32_t materialVersion = 0;
+	};
 
-		void StartBatching(std::vector<Ref<TS_ENGINE::Node>> nodes);
-		//void DrawBatch();
+	// Indices of one node's meshes in a static batch
+	struct StaticBatchRange
+	{
+		Ref<Node> node;
+		Matrix4 worldMatrix = Matrix4(1);		// At build time, the node is unbatched once it moves
+		uint32_t meshesVersion = 0;				// Node::GetMeshesVersion at build time
+		std::vector<StaticBatchMesh> meshes;	// The node's meshes in order, the node is unbatched once one is edited
+		uint32_t firstIndex = 0;
+		uint32_t indexCount = 0;
+		bool batched = true;					// False once the node was unbatched, its indices are no longer drawn
+	};
 
-		const Ref<Node> GetBatchedNode() const
-		{
-			return mBatchedNode;
-		}
+	/// <summary>
+	/// Meshes of static nodes sharing their material properties merged into one world space mesh, textured by an atlas.
+	/// Each node keeps its index range, so entity IDs can still be drawn per node and an edited node can be left out.
+	/// </summary>
+	struct StaticBatch
+	{
+		Ref<Mesh> mesh;
+		AABB bounds;							// World space
+		std::vector<StaticBatchRange> ranges;	// Ordered by first index
+		std::vector<IndexRange> drawRanges;		// Ranges of the nodes still batched, adjacent ones merged
 
-	private:
-		static Batcher* m_pInstance;
-		bool mBatched = false;
+		// Rebuilds drawRanges from the ranges still batched
+		void UpdateDrawRanges();
+	};
 
-		Ref<Node> mBatchedNode;		
-		//std::vector<BatchedVertex> mBatchedVertices;
-		//std::vector<Vertex> mBatchedVertices;
-		//std::vector<uint32_t> mBatchedIndices;
+	class Batcher
+	{
+	public:
+		// Batches of several nodes stay within 16-bit indices and give culling something to reject. A node larger than this
+		// gets a batch of its own, which Mesh::Create gives 32-bit indices.
+		static constexpr uint32_t sMaxBatchVertices = 1 << 16;
 
-		//Ref<VertexArray> mVertexArray;
+		/// <summary>
+		/// Merges the meshes of nodes in static subtrees below root in world space. Meshes are grouped by static subtree and by
+		/// the material properties the atlas can't hold; each group gets one atlas of its diffuse maps and tints. Nodes that are
+		/// skinned, in an HLOD cluster, excluded, or whose meshes repeat their texture are left out. Batched nodes are flagged
+		/// with Node::SetStaticBatched. Needs world bounds (Node::ComputeWorldBounds).
+		/// </summary>
+		static std::vector<StaticBatch> Build(Ref<Node> root, const std::unordered_set<const Node*>& excludedNodes);
 
-		Ref<TS_ENGINE::TextureAtlasCreator> mTextureAtlasCreator;
-		std::vector<Ref<TS_ENGINE::Texture2D>> mAtlasTextures;
+		// True once the node's meshes were replaced, or their vertices, materials or material properties edited since the range was built
+		static bool IsEdited(const StaticBatchRange& range);
+	private:
+		static bool IsBatchable(Node* node);
+		// Merges meshes sharing their material properties into batches of up to sMaxBatchVertices with one atlas.
+		// Meshes of a node must be consecutive. Returns false if their textures don't fit into the atlas.
+		static bool BuildGroup(const std::vector<std::pair<Ref<Node>, Ref<Mesh>>>& meshes, TextureCompositor& compositor, std::vector<StaticBatch>& batches);
 	};
 }
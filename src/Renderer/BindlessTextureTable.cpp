@@ -0,0 +1,133 @@
+#include "tspch.h"
+#include "Renderer/BindlessTextureTable.h"
+#include "Platform/OpenGL/OpenGLBindlessTextureTable.h"
+
+namespace TS_ENGINE {
+
+	Ref<BindlessTextureTable> BindlessTextureTable::mInstance = nullptr;
+
+	bool BindlessTextureTable::IsSupported()
+	{
+		//ToDo: Add support for multiple APIs
+		return OpenGLBindlessTextureTable::IsSupported();
+	}
+
+	Ref<BindlessTextureTable> BindlessTextureTable::GetInstance()
+	{
+		//ToDo: Add support for multiple APIs
+		if (mInstance == nullptr)
+			mInstance = CreateRef<OpenGLBindlessTextureTable>();
+
+		return mInstance;
+	}
+
+	uint32_t BindlessTextureTable::Acquire(const Ref<Texture2D>& texture)
+	{
+		// Handles freeze the texture's sampling state, which streaming still changes level by level
+		if (texture->IsStreaming())
+			return UINT32_MAX;
+
+		const Texture2D* key = texture.get();
+		auto it = mLookup.find(key);
+		uint32_t index;
+
+		// A destroyed texture's address can be reused before NextFrame freed its slot
+		if (it != mLookup.end() && mEntries[it->second].texture.lock() == texture)
+		{
+			index = it->second;
+		}
+		else
+		{
+			if (it != mLookup.end())
+			{
+				Entry& stale = mEntries[it->second];
+				mResidentCount -= stale.resident ? 1 : 0;
+				stale = Entry();
+				mLookup.erase(it);
+			}
+
+			index = AllocateEntry();
+
+			if (index == UINT32_MAX)
+				return UINT32_MAX;
+
+			mEntries[index].texture = texture;
+			mEntries[index].key = key;
+			mLookup[key] = index;
+		}
+
+		Entry& entry = mEntries[index];
+
+		if (entry.rendererID != texture->GetRendererID())
+		{
+			// The old handle was deleted with the old texture, it needs no release
+			mResidentCount -= entry.resident ? 1 : 0;
+			entry.resident = false;
+			entry.rendererID = texture->GetRendererID();
+			entry.handle = CreateHandle(entry.rendererID);
+
+			mDirtyBegin = std::min(mDirtyBegin, index);
+			mDirtyEnd = std::max(mDirtyEnd, index + 1);
+		}
+
+		// Kept with a null handle so a refused texture isn't retried every draw
+		if (entry.handle == 0)
+			return UINT32_MAX;
+
+		if (!entry.resident)
+		{
+			SetResident(entry.handle, true);
+			entry.resident = true;
+			mResidentCount++;
+		}
+
+		entry.lastUsedFrame = mFrame;
+		texture->MarkUsed();
+		return index;
+	}
+
+	void BindlessTextureTable::NextFrame()
+	{
+		mFrame++;
+
+		for (auto& entry : mEntries)
+		{
+			if (!entry.key)
+				continue;
+
+			Ref<Texture2D> texture = entry.texture.lock();
+
+			if (!texture)
+			{
+				// Deleting the texture deleted its handle
+				mResidentCount -= entry.resident ? 1 : 0;
+				mLookup.erase(entry.key);
+				entry = Entry();
+			}
+			else if (entry.resident && mFrame - entry.lastUsedFrame > sEvictionFrames)
+			{
+				// A texture moved to new storage deleted the handle with its old storage, see Acquire
+				if (texture->GetRendererID() == entry.rendererID)
+					SetResident(entry.handle, false);
+
+				entry.resident = false;
+				mResidentCount--;
+			}
+		}
+	}
+
+	uint32_t BindlessTextureTable::AllocateEntry()
+	{
+		for (uint32_t i = 0; i < mEntries.size(); i++)
+		{
+			if (!mEntries[i].key)
+				return i;
+		}
+
+		if (mEntries.size() >= sMaxHandles)
+			return UINT32_MAX;
+
+		mEntries.emplace_back();
+		return (uint32_t)mEntries.size() - 1;
+	}
+}
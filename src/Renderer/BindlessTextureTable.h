@@ -0,0 +1,65 @@
+#pragma once
+#include "Renderer/Texture.h"
+
+namespace TS_ENGINE {
+
+	/// <summary>
+	/// Bindless texture handles in a GPU table, so shaders pick a material's texture by index and draws need no texture binds.
+	/// A texture gets a handle the first time it's acquired and is made resident whenever it's used. Handles unused for
+	/// sEvictionFrames frames are made non-resident, which lets the driver page their textures out, and slots of destroyed
+	/// textures are reused. Drivers without ARB_bindless_texture keep binding textures to slots.
+	/// </summary>
+	class BindlessTextureTable
+	{
+	public:
+		static constexpr uint32_t sMaxHandles = 4096;
+		static constexpr uint32_t sTableBinding = 8;		// Shader storage binding of the handle table
+		static constexpr uint32_t sEvictionFrames = 120;	// Beyond the frames in flight, so the GPU is done with the handle
+
+		virtual ~BindlessTextureTable() = default;
+
+		// Table index of the texture's handle, made resident for this frame. UINT32_MAX if the table is full, no handle could be
+		// made or the texture is still streaming.
+		uint32_t Acquire(const Ref<Texture2D>& texture);
+
+		// Uploads handles added since the last call and binds the table to sTableBinding
+		virtual void Bind() = 0;
+
+		// Makes handles unused for sEvictionFrames non-resident and frees the slots of destroyed textures. Called once a frame.
+		void NextFrame();
+
+		uint32_t GetHandleCount() const { return (uint32_t)mLookup.size(); }
+		uint32_t GetResidentCount() const { return mResidentCount; }
+
+		// ARB_bindless_texture is available
+		static bool IsSupported();
+		static Ref<BindlessTextureTable> GetInstance();
+	protected:
+		struct Entry
+		{
+			std::weak_ptr<Texture2D> texture;
+			const Texture2D* key = nullptr;		// nullptr for free slots
+			uint32_t rendererID = 0;			// Handles die with their texture, a new renderer ID needs a new handle
+			uint64_t handle = 0;
+			uint64_t lastUsedFrame = 0;
+			bool resident = false;
+		};
+
+		// 0 if the driver refused
+		virtual uint64_t CreateHandle(uint32_t rendererID) = 0;
+		virtual void SetResident(uint64_t handle, bool resident) = 0;
+
+		std::vector<Entry> mEntries;
+		uint32_t mDirtyBegin = UINT32_MAX;		// Range of entries whose handles changed since the last upload
+		uint32_t mDirtyEnd = 0;
+	private:
+		static Ref<BindlessTextureTable> mInstance;
+
+		// Free slot, growing the table up to sMaxHandles. UINT32_MAX if full.
+		uint32_t AllocateEntry();
+
+		std::unordered_map<const Texture2D*, uint32_t> mLookup;
+		uint64_t mFrame = 0;
+		uint32_t mResidentCount = 0;
+	};
+}
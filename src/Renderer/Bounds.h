@@ -0,0 +1,141 @@
+#pragma once
+#include "tspch.h"
+#include <cfloat>
+
+namespace TS_ENGINE {
+
+	/// <summary>
+	/// Axis aligned bounding box. An empty box has min > max.
+	/// </summary>
+	struct AABB
+	{
+		Vector3 min = Vector3(FLT_MAX);
+		Vector3 max = Vector3(-FLT_MAX);
+
+		AABB()
+		{
+
+		}
+
+		AABB(const Vector3& _min, const Vector3& _max) :
+			min(_min),
+			max(_max)
+		{
+
+		}
+
+		bool IsValid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+		Vector3 GetCenter() const { return (min + max) * 0.5f; }
+		Vector3 GetExtents() const { return (max - min) * 0.5f; }
+
+		float GetSurfaceArea() const
+		{
+			Vector3 size = max - min;
+			return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+		}
+
+		bool Contains(const AABB& box) const
+		{
+			return min.x <= box.min.x && min.y <= box.min.y && min.z <= box.min.z &&
+				box.max.x <= max.x && box.max.y <= max.y && box.max.z <= max.z;
+		}
+
+		bool Intersects(const AABB& box) const
+		{
+			return min.x <= box.max.x && box.min.x <= max.x &&
+				min.y <= box.max.y && box.min.y <= max.y &&
+				min.z <= box.max.z && box.min.z <= max.z;
+		}
+
+		// Squared distance from a point to the box, 0 if the point is inside
+		float DistanceSquared(const Vector3& point) const
+		{
+			Vector3 delta = glm::max(glm::max(min - point, point - max), Vector3(0.0f));
+			return glm::dot(delta, delta);
+		}
+
+		// Slab test. inverseDirection is 1 / ray direction. Returns the entry distance in tHit (0 if the origin is inside)
+		bool IntersectsRay(const Vector3& origin, const Vector3& inverseDirection, float maxDistance, float& tHit) const
+		{
+			Vector3 t0 = (min - origin) * inverseDirection;
+			Vector3 t1 = (max - origin) * inverseDirection;
+			Vector3 tSmall = glm::min(t0, t1);
+			Vector3 tLarge = glm::max(t0, t1);
+
+			float tEnter = glm::max(glm::max(tSmall.x, tSmall.y), glm::max(tSmall.z, 0.0f));
+			float tExit = glm::min(glm::min(tLarge.x, tLarge.y), glm::min(tLarge.z, maxDistance));
+
+			tHit = tEnter;
+			return tEnter <= tExit;
+		}
+
+		static AABB Union(const AABB& a, const AABB& b)
+		{
+			AABB box = a;
+			box.Expand(b);
+			return box;
+		}
+
+		void Expand(const Vector3& point)
+		{
+			min = glm::min(min, point);
+			max = glm::max(max, point);
+		}
+
+		void Expand(const AABB& box)
+		{
+			if (!box.IsValid())
+				return;
+
+			min = glm::min(min, box.min);
+			max = glm::max(max, box.max);
+		}
+
+		// Transforms the box and returns the box enclosing the result (Arvo)
+		AABB Transform(const Matrix4& matrix) const
+		{
+			if (!IsValid())
+				return AABB();
+
+			Vector3 center = Vector3(matrix * Vector4(GetCenter(), 1.0f));
+			Vector3 extents = GetExtents();
+
+			Vector3 worldExtents(
+				fabsf(matrix[0][0]) * extents.x + fabsf(matrix[1][0]) * extents.y + fabsf(matrix[2][0]) * extents.z,
+				fabsf(matrix[0][1]) * extents.x + fabsf(matrix[1][1]) * extents.y + fabsf(matrix[2][1]) * extents.z,
+				fabsf(matrix[0][2]) * extents.x + fabsf(matrix[1][2]) * extents.y + fabsf(matrix[2][2]) * extents.z);
+
+			return AABB(center - worldExtents, center + worldExtents);
+		}
+	};
+
+	struct BoundingSphere
+	{
+		Vector3 center = Vector3(0.0f);
+		float radius = -1.0f;
+
+		BoundingSphere()
+		{
+
+		}
+
+		BoundingSphere(const Vector3& _center, float _radius) :
+			center(_center),
+			radius(_radius)
+		{
+
+		}
+
+		bool IsValid() const { return radius >= 0.0f; }
+
+		// Radius is scaled by the largest axis scale so the result always encloses the transformed sphere
+		BoundingSphere Transform(const Matrix4& matrix) const
+		{
+			float scaleX = glm::length(Vector3(matrix[0]));
+			float scaleY = glm::length(Vector3(matrix[1]));
+			float scaleZ = glm::length(Vector3(matrix[2]));
+
+			return BoundingSphere(Vector3(matrix * Vector4(center, 1.0f)), radius * glm::max(scaleX, glm::max(scaleY, scaleZ)));
+		}
+	};
+}
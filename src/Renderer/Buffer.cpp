@@ -55,4 +55,20 @@ namespace TS_ENGINE {
 		TS_CORE_ASSERT(false, "Unknown RendererAPI!");
 		return nullptr;
 	}
+
+	Ref<IndexBuffer> IndexBuffer::Create(uint16_t* indices, uint32_t size)
+	{
+		switch (Renderer::GetAPI())
+		{
+		case RendererAPI::API::NONE:
+			TS_CORE_ASSERT(false, "RendererAPI::None is currently not supported!");
+			return nullptr;
+		case RendererAPI::API::OPENGL:
+			return CreateRef<OpenGLIndexBuffer>(indices, size);
+			//TODO: Add support for more APIs
+		}
+
+		TS_CORE_ASSERT(false, "Unknown RendererAPI!");
+		return nullptr;
+	}
 }
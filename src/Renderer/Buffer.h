@@ -16,10 +16,14 @@ namespace TS_ENGINE {
 		FLOAT3,
 		FLOAT4,
 		MAT3,
-		MAT4
+		MAT4,
+		HALF2,			// Two 16-bit floats packed in 4 bytes
+		PACKED_NORMAL,	// Signed 10-10-10-2 normalized (GL_INT_2_10_10_10_REV)
+		UBYTE4,			// Four 8-bit unsigned integers, read as ivec4
+		USHORT4			// Four 16-bit unsigned integers, usually normalized
 	};
 
-	static uint32_t ShaderDataTypeSize(ShaderDataType type)
+	static constexpr uint32_t ShaderDataTypeSize(ShaderDataType type)
 	{
 		switch (type)
 		{
@@ -45,6 +49,14 @@ namespace TS_ENGINE {
 			return 36;
 		case ShaderDataType::MAT4:
 			return 64;
+		case ShaderDataType::HALF2:
+			return 4;
+		case ShaderDataType::PACKED_NORMAL:
+			return 4;
+		case ShaderDataType::UBYTE4:
+			return 4;
+		case ShaderDataType::USHORT4:
+			return 8;
 		}
 
 		TS_CORE_ASSERT(false, "Unknown ShaderDataType!");
@@ -97,6 +109,14 @@ namespace TS_ENGINE {
 				return 3;
 			case ShaderDataType::MAT4 : 
 				return 4;
+			case ShaderDataType::HALF2 :
+				return 2;
+			case ShaderDataType::PACKED_NORMAL :
+				return 4;
+			case ShaderDataType::UBYTE4 :
+				return 4;
+			case ShaderDataType::USHORT4 :
+				return 4;
 			}
 
 			TS_CORE_ASSERT(false, "Unknown ShaderDataType!");
@@ -134,6 +154,12 @@ namespace TS_ENGINE {
 			CalculateOffsetsAndStride();
 		}
 
+		BufferLayout(const std::vector<BufferElement>& elements) :
+			mElements(elements)
+		{
+			CalculateOffsetsAndStride();
+		}
+
 		uint32_t GetStride() const
 		{
 			return mStride;
@@ -184,6 +210,19 @@ namespace TS_ENGINE {
 		virtual unsigned int GetRendererID() const = 0;
 	};
 
+	enum class IndexType
+	{
+		UINT16,
+		UINT32
+	};
+
+	// Part of an index buffer drawn by DrawIndexedRanges
+	struct IndexRange
+	{
+		uint32_t firstIndex = 0;
+		uint32_t indexCount = 0;
+	};
+
 	class IndexBuffer
 	{
 	public:
@@ -193,7 +232,9 @@ namespace TS_ENGINE {
 		virtual void Unbind() const = 0;
 
 		virtual uint32_t GetCount() const = 0;
+		virtual IndexType GetIndexType() const = 0;
 
 		static Ref<IndexBuffer> Create(uint32_t* indices, uint32_t count);
+		static Ref<IndexBuffer> Create(uint16_t* indices, uint32_t count);
 	};
 }
@@ -140,4 +140,18 @@ namespace TS_ENGINE {
 	{ 
 		return mProjectionMatrix * mViewMatrix; 
 	}	
+
+	void Camera::ScreenPointToRay(const Vector2& viewportPosition, const Vector2& viewportSize, Vector3& origin, Vector3& direction) const
+	{
+		// Viewport to normalized device coordinates, y points up in NDC
+		float ndcX = 2.0f * viewportPosition.x / viewportSize.x - 1.0f;
+		float ndcY = 1.0f - 2.0f * viewportPosition.y / viewportSize.y;
+
+		Matrix4 inverseProjectionView = glm::inverse(GetProjectionViewMatrix());
+		Vector4 nearPoint = inverseProjectionView * Vector4(ndcX, ndcY, -1.0f, 1.0f);
+		Vector4 farPoint = inverseProjectionView * Vector4(ndcX, ndcY, 1.0f, 1.0f);
+
+		origin = Vector3(nearPoint) / nearPoint.w;
+		direction = glm::normalize(Vector3(farPoint) / farPoint.w - origin);
+	}
 }
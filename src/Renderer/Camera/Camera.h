@@ -97,6 +97,9 @@ namespace TS_ENGINE
 		const Matrix4 GetViewMatrix() const { return mViewMatrix; }
 		const Matrix4 GetProjectionViewMatrix() const;		
 
+		// World space ray through a viewport pixel (origin at the top left), for Scene::Raycast
+		void ScreenPointToRay(const Vector2& viewportPosition, const Vector2& viewportSize, Vector3& origin, Vector3& direction) const;
+
 		const Ref<Framebuffer>& GetFramebuffer() const { return mFramebuffer; }
 		virtual Ref<Node> GetNode() = 0;
 	protected:
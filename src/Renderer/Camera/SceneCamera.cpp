@@ -200,8 +200,7 @@ namespace TS_ENGINE {
 			nonHomogeneousFrustrumVertices[i].position = Vector4(pos, 1);
 		}
 
-		mSceneCameraFrustrumNode->GetMeshes()[0]->SetVertices(nonHomogeneousFrustrumVertices);
-		mSceneCameraFrustrumNode->GetMeshes()[0]->Create(DrawMode::LINE);
+		mSceneCameraFrustrumNode->GetMeshes()[0]->UpdateVertices(nonHomogeneousFrustrumVertices);
 	}
 
 #else
@@ -0,0 +1,261 @@
+#include "tspch.h"
+#include "Renderer/DynamicBatcher.h"
+#include "Renderer/StreamBuffer.h"
+#include "Platform/OpenGL/OpenGLDynamicBatcher.h"
+#include "Application.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define TS_DYNAMIC_BATCHER_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace TS_ENGINE {
+
+	Ref<DynamicBatcher> DynamicBatcher::Create()
+	{
+		//ToDo: Add support for multiple APIs
+		return CreateRef<OpenGLDynamicBatcher>();
+	}
+
+#ifdef TS_ENGINE_EDITOR
+	bool DynamicBatcher::Submit(int entityID, const Ref<Mesh>& mesh, const Matrix4& worldMatrix)
+#else
+	bool DynamicBatcher::Submit(const Ref<Mesh>& mesh, const Matrix4& worldMatrix)
+#endif
+	{
+		const Ref<Material>& material = mesh->GetMaterial();
+
+		if (mesh->GetDrawMode() != DrawMode::TRIANGLE || mesh->HasBoneInfluence() || !material
+			|| mesh->GetVertices().empty() || mesh->GetVertices().size() > sMaxMeshVertices || mesh->GetIndices().empty())
+			return false;
+
+		Group* group = nullptr;
+
+		for (size_t i = 0; i < mGroupCount && !group; i++)
+		{
+			if (mGroups[i].material == material || mGroups[i].material->RendersLike(*material, mGroups[i].layered))
+				group = &mGroups[i];
+		}
+
+		if (!group)
+		{
+			if (mGroupCount == mGroups.size())
+				mGroups.emplace_back();
+
+			group = &mGroups[mGroupCount++];
+			group->material = material;
+			group->layered = material->SamplesTextureArrays();
+			group->items.clear();
+		}
+
+		Item item;
+		item.mesh = mesh;
+		item.worldMatrix = worldMatrix;
+#ifdef TS_ENGINE_EDITOR
+		item.entityID = entityID;
+#endif
+		group->items.push_back(item);
+		return true;
+	}
+
+	void DynamicBatcher::Flush(Ref<Shader> shader, bool enableTextures)
+	{
+		for (size_t g = 0; g < mGroupCount; g++)
+		{
+			Group& group = mGroups[g];
+			size_t first = 0;
+
+			shader->SetMat4("u_Model", Matrix4(1));		// Vertices are transformed to world space
+
+			while (first < group.items.size())
+			{
+				// Items up to sMaxDrawVertices, at least one
+				size_t last = first;
+				uint32_t vertexCount = 0;
+				uint32_t indexCount = 0;
+
+				for (; last < group.items.size(); last++)
+				{
+					const Ref<Mesh>& mesh = group.items[last].mesh;
+
+					if (last > first && vertexCount + mesh->GetVertices().size() > sMaxDrawVertices)
+						break;
+
+					vertexCount += (uint32_t)mesh->GetVertices().size();
+					indexCount += (uint32_t)mesh->GetIndices().size();
+				}
+
+				if (!DrawItems(group, first, last, vertexCount, indexCount, enableTextures))
+				{
+					for (size_t i = first; i < last; i++)
+						DrawItem(shader, group.items[i], enableTextures);
+
+					shader->SetMat4("u_Model", Matrix4(1));
+				}
+
+				first = last;
+			}
+
+			// Drop the references, the storage is kept
+			group.material = nullptr;
+			group.items.clear();
+		}
+
+		mGroupCount = 0;
+		mFlushCount++;
+
+		if (mFlushCount % sCacheEvictionFlushes == 0)
+		{
+			for (auto it = mCachedVertices.begin(); it != mCachedVertices.end();)
+			{
+				if (mFlushCount - it->second.lastUsedFlush > sCacheEvictionFlushes || it->second.mesh.expired())
+					it = mCachedVertices.erase(it);
+				else
+					++it;
+			}
+		}
+	}
+
+	void DynamicBatcher::WriteVertices(const Item& item, DynamicVertex* outVertices)
+	{
+		const std::vector<Vertex>& meshVertices = item.mesh->GetVertices();
+		CachedVertices& cached = mCachedVertices[item.mesh.get()];
+		cached.lastUsedFlush = mFlushCount;
+
+		bool unchanged = cached.mesh.lock() == item.mesh && cached.vertexVersion == item.mesh->GetVertexVersion() && cached.worldMatrix == item.worldMatrix;
+
+		if (!unchanged)
+		{
+			// Possibly moving, transformed straight into the draw
+			cached.mesh = item.mesh;
+			cached.worldMatrix = item.worldMatrix;
+			cached.vertexVersion = item.mesh->GetVertexVersion();
+			cached.vertices.clear();
+
+			Matrix3 normalMatrix = glm::transpose(glm::inverse(Matrix3(item.worldMatrix)));
+			TransformVertices(meshVertices.data(), meshVertices.size(), item.worldMatrix, normalMatrix, outVertices);
+			return;
+		}
+
+		// Held still since its last draw, transformed once more into the cache
+		if (cached.vertices.size() != meshVertices.size())
+		{
+			cached.vertices.resize(meshVertices.size());
+			Matrix3 normalMatrix = glm::transpose(glm::inverse(Matrix3(item.worldMatrix)));
+			TransformVertices(meshVertices.data(), meshVertices.size(), item.worldMatrix, normalMatrix, cached.vertices.data());
+		}
+
+		memcpy(outVertices, cached.vertices.data(), cached.vertices.size() * sizeof(DynamicVertex));
+	}
+
+	bool DynamicBatcher::DrawItems(Group& group, size_t first, size_t last, uint32_t vertexCount, uint32_t indexCount, bool enableTextures)
+	{
+		Ref<StreamBuffer> streamBuffer = StreamBuffer::GetInstance();
+		uint32_t vertexOffset = 0;
+		uint32_t indexOffset = 0;
+
+		DynamicVertex* vertices = (DynamicVertex*)streamBuffer->Allocate(vertexCount * (uint32_t)sizeof(DynamicVertex), 16, vertexOffset);
+		uint32_t* indices = vertices ? (uint32_t*)streamBuffer->Allocate(indexCount * (uint32_t)sizeof(uint32_t), sizeof(uint32_t), indexOffset) : nullptr;
+
+		if (!indices)
+			return false;
+
+		uint32_t baseVertex = 0;
+
+		for (size_t i = first; i < last; i++)
+		{
+			const Item& item = group.items[i];
+			const std::vector<Vertex>& meshVertices = item.mesh->GetVertices();
+
+			WriteVertices(item, vertices + baseVertex);
+
+			if (group.layered)
+			{
+				Ref<Texture2D> diffuseMap = item.mesh->GetMaterial()->GetDiffuseMap();
+				float layer = diffuseMap ? (float)diffuseMap->GetArrayLayer().layer : 0.0f;
+
+				for (size_t v = 0; v < meshVertices.size(); v++)
+					vertices[baseVertex + v].normal.w = layer;
+			}
+
+			for (uint32_t index : item.mesh->GetIndices())
+				*indices++ = baseVertex + index;
+
+			baseVertex += (uint32_t)meshVertices.size();
+		}
+
+#ifdef TS_ENGINE_EDITOR
+		group.material->Render(group.items[first].entityID, enableTextures);
+#else
+		group.material->Render(enableTextures);
+#endif
+		if (group.layered)
+			group.material->GetShader()->SetInt("u_DiffuseMapLayer", -1);	// Layer per vertex
+
+		Draw(vertexOffset, indexOffset, indexCount);
+
+		Application::GetInstance().AddDrawCalls(1);
+		Application::GetInstance().AddVertices(vertexCount);
+		Application::GetInstance().AddIndices(indexCount);
+		return true;
+	}
+
+	void DynamicBatcher::DrawItem(Ref<Shader> shader, const Item& item, bool enableTextures)
+	{
+		shader->SetMat4("u_Model", item.worldMatrix);
+#ifdef TS_ENGINE_EDITOR
+		item.mesh->Render(item.entityID, enableTextures);
+#else
+		item.mesh->Render(enableTextures);
+#endif
+	}
+
+	void DynamicBatcher::TransformVertices(const Vertex* vertices, size_t count, const Matrix4& worldMatrix, const Matrix3& normalMatrix, DynamicVertex* outVertices)
+	{
+#if defined(TS_DYNAMIC_BATCHER_SSE)
+		// Columns of the matrices, each vertex is a weighted sum of them
+		__m128 column0 = _mm_loadu_ps(&worldMatrix[0][0]);
+		__m128 column1 = _mm_loadu_ps(&worldMatrix[1][0]);
+		__m128 column2 = _mm_loadu_ps(&worldMatrix[2][0]);
+		__m128 column3 = _mm_loadu_ps(&worldMatrix[3][0]);
+		__m128 normalColumn0 = _mm_setr_ps(normalMatrix[0][0], normalMatrix[0][1], normalMatrix[0][2], 0.0f);
+		__m128 normalColumn1 = _mm_setr_ps(normalMatrix[1][0], normalMatrix[1][1], normalMatrix[1][2], 0.0f);
+		__m128 normalColumn2 = _mm_setr_ps(normalMatrix[2][0], normalMatrix[2][1], normalMatrix[2][2], 0.0f);
+		__m128 minLength = _mm_set1_ps(1e-20f);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			const Vertex& vertex = vertices[i];
+
+			__m128 position = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(column0, _mm_set1_ps(vertex.position.x)), _mm_mul_ps(column1, _mm_set1_ps(vertex.position.y))),
+				_mm_add_ps(_mm_mul_ps(column2, _mm_set1_ps(vertex.position.z)), column3));
+
+			__m128 normal = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(normalColumn0, _mm_set1_ps(vertex.normal.x)), _mm_mul_ps(normalColumn1, _mm_set1_ps(vertex.normal.y))),
+				_mm_mul_ps(normalColumn2, _mm_set1_ps(vertex.normal.z)));
+
+			// Horizontal sum of the squares into every lane, w is 0
+			__m128 squares = _mm_mul_ps(normal, normal);
+			__m128 sum = _mm_add_ps(squares, _mm_shuffle_ps(squares, squares, _MM_SHUFFLE(2, 3, 0, 1)));
+			sum = _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 0, 3, 2)));
+			normal = _mm_div_ps(normal, _mm_max_ps(_mm_sqrt_ps(sum), minLength));
+
+			_mm_storeu_ps(&outVertices[i].position.x, position);
+			_mm_storeu_ps(&outVertices[i].normal.x, normal);
+			outVertices[i].texCoord = vertex.texCoord;
+		}
+#else
+		for (size_t i = 0; i < count; i++)
+		{
+			const Vertex& vertex = vertices[i];
+			Vector3 normal = normalMatrix * vertex.normal;
+			float normalLength = glm::length(normal);
+
+			outVertices[i].position = worldMatrix * Vector4(Vector3(vertex.position), 1.0f);
+			outVertices[i].normal = Vector4(normalLength > 0.0f ? normal / normalLength : normal, 0.0f);
+			outVertices[i].texCoord = vertex.texCoord;
+		}
+#endif
+	}
+}
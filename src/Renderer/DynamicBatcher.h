@@ -0,0 +1,93 @@
+#pragma once
+#include "Primitive/Mesh.h"
+
+namespace TS_ENGINE {
+
+	// World space vertex written by the dynamic batcher. Attribute locations match the mesh vertex formats.
+	struct DynamicVertex
+	{
+		Vector4 position;		// w is 1
+		Vector4 normal;			// w is the diffuse map's texture array layer, for shaders sampling arrays
+		Vector2 texCoord;
+	};
+
+	/// <summary>
+	/// Merges small meshes that share their material state into one draw. The queued meshes are transformed to world space
+	/// on the CPU, so moving meshes with different geometry can share a draw where instancing would need the same mesh.
+	/// Meshes that keep their world matrix between frames are transformed once and copied from a cache afterwards.
+	/// </summary>
+	class DynamicBatcher
+	{
+	public:
+		static constexpr uint32_t sMaxMeshVertices = 512;		// Larger meshes cost less to draw on their own than to transform
+		static constexpr uint32_t sMaxDrawVertices = 1 << 15;	// Splits large groups so a draw fits into the stream buffer
+		static constexpr uint32_t sCacheEvictionFlushes = 120;	// Cached vertices of meshes not drawn for this many flushes are dropped
+
+		virtual ~DynamicBatcher() = default;
+
+		/// <summary>
+		/// Queues a triangle mesh to be drawn at worldMatrix by the next Flush. Returns false for meshes that don't qualify
+		/// (too many vertices, lines, skinned, no material), which the caller draws itself.
+		/// </summary>
+#ifdef TS_ENGINE_EDITOR
+		bool Submit(int entityID, const Ref<Mesh>& mesh, const Matrix4& worldMatrix);
+#else
+		bool Submit(const Ref<Mesh>& mesh, const Matrix4& worldMatrix);
+#endif
+
+		/// <summary>
+		/// Draws the queued meshes, one call per group of meshes whose materials render alike, and clears the queue.
+		/// Materials whose shader samples texture arrays also group across diffuse maps in different layers of one array,
+		/// with u_DiffuseMapLayer set to -1 so the shader reads the layer per vertex.
+		/// Sets u_Model to identity. Meshes that don't fit into the stream buffer are drawn one by one.
+		/// </summary>
+		void Flush(Ref<Shader> shader, bool enableTextures);
+
+		// Transforms positions by worldMatrix and normals by normalMatrix, renormalized. Uses SSE where available.
+		static void TransformVertices(const Vertex* vertices, size_t count, const Matrix4& worldMatrix, const Matrix3& normalMatrix, DynamicVertex* outVertices);
+
+		static Ref<DynamicBatcher> Create();
+	protected:
+		// Draws indexCount 32-bit indices at indexOffset bytes, reading vertices from vertexOffset bytes, both in the stream buffer
+		virtual void Draw(uint32_t vertexOffset, uint32_t indexOffset, uint32_t indexCount) = 0;
+	private:
+		struct Item
+		{
+			Ref<Mesh> mesh;
+			Matrix4 worldMatrix;
+#ifdef TS_ENGINE_EDITOR
+			int entityID;
+#endif
+		};
+
+		struct Group
+		{
+			Ref<Material> material;
+			bool layered = false;			// Items may use any layer of the material's diffuse map array
+			std::vector<Item> items;
+		};
+
+		struct CachedVertices
+		{
+			std::weak_ptr<Mesh> mesh;		// Expired if the mesh was freed and another one reuses its address
+			Matrix4 worldMatrix = Matrix4(1);
+			uint32_t vertexVersion = 0;
+			uint64_t lastUsedFlush = 0;
+			std::vector<DynamicVertex> vertices;	// Empty until the mesh was submitted twice with the same world matrix
+		};
+
+		// Writes the item's world space vertices, from the cache if its mesh and world matrix didn't change
+		void WriteVertices(const Item& item, DynamicVertex* outVertices);
+
+		// Merges items [first, last) of the group into one draw. Returns false if the stream buffer is full.
+		bool DrawItems(Group& group, size_t first, size_t last, uint32_t vertexCount, uint32_t indexCount, bool enableTextures);
+		// Draws an item with its own mesh, when it could not be merged
+		void DrawItem(Ref<Shader> shader, const Item& item, bool enableTextures);
+
+		std::vector<Group> mGroups;			// Groups past mGroupCount keep their storage for later frames
+		size_t mGroupCount = 0;
+
+		std::unordered_map<const Mesh*, CachedVertices> mCachedVertices;
+		uint64_t mFlushCount = 0;
+	};
+}
@@ -3,9 +3,23 @@
 
 namespace TS_ENGINE {
 
+	std::unordered_set<Framebuffer*> Framebuffer::sReadbackFramebuffers;
+
 	Ref<Framebuffer> Framebuffer::Create(const FramebufferSpecification& spec)
 	{
 		//ToDo: Add support for multiple APIs
 		return CreateRef<OpenGLFramebuffer>(spec);
 	}
+
+	void Framebuffer::ProcessAllReadbacks()
+	{
+		// Processing removes framebuffers from the set, and readback callbacks may destroy others
+		std::vector<Framebuffer*> framebuffers(sReadbackFramebuffers.begin(), sReadbackFramebuffers.end());
+
+		for (Framebuffer* framebuffer : framebuffers)
+		{
+			if (sReadbackFramebuffers.find(framebuffer) != sReadbackFramebuffers.end())
+				framebuffer->ProcessReadbacks();
+		}
+	}
 }
@@ -2,6 +2,9 @@
 #include "Core/Base.h"
 #include <initializer_list>
 #include <vector>
+#include <future>
+#include <functional>
+#include <unordered_set>
 
 #include "Renderer/Image.h"
 
@@ -64,13 +67,49 @@ namespace TS_ENGINE {
 		virtual std::vector<GLubyte> SaveFramebufferToFile(const std::string& _filepath) = 0;
 
 		virtual void ClearAttachment(uint32_t attachmentIndex, int value) = 0;
+		virtual void ClearAttachmentRegion(uint32_t attachmentIndex, int value, int x, int y, int width, int height) = 0;
+
+		// Color attachments written by draws, each at the fragment output location of its index. The others are masked.
+		virtual void SetDrawAttachments(const std::vector<uint32_t>& attachmentIndices) = 0;
 
 		virtual uint32_t GetColorAttachmentRendererID(uint32_t index = 0) const = 0;
+		// 0 if the framebuffer has no depth attachment
+		virtual uint32_t GetDepthAttachmentRendererID() const = 0;
 
 		virtual const FramebufferSpecification& GetSpecification() const = 0;
 
 		virtual Ref<Image> GetFrameBufferImage(int startX = 0, int startY = 0) = 0;
 
+#pragma region Asynchronous readback
+		// Readbacks go through a ring of pixel buffer objects guarded by fences, so they don't stall the pipeline.
+		// Results are delivered by ProcessReadbacks once the GPU has finished, usually a frame or two later.
+
+		// If a readback fails, its callback isn't called and its future holds a std::runtime_error. Destroying the framebuffer
+		// waits for the readbacks in flight and delivers them.
+
+		// Callback runs on the main thread inside ProcessReadbacks
+		virtual void ReadPixelAsync(uint32_t attachmentIndex, int x, int y, const std::function<void(int)>& callback) = 0;
+		virtual std::future<int> ReadPixelAsync(uint32_t attachmentIndex, int x, int y) = 0;
+		virtual void ReadPixelColorAsync(uint32_t attachmentIndex, int x, int y, const std::function<void(Vector4)>& callback) = 0;
+
+		// Same rows as GetFrameBufferImage (bottom row first). The callback runs on a worker thread.
+		virtual void GetFrameBufferImageAsync(int startX, int startY, const std::function<void(Ref<Image>)>& callback) = 0;
+		virtual std::future<Ref<Image>> GetFrameBufferImageAsync(int startX = 0, int startY = 0) = 0;
+
+		// Row flipping and PNG encoding run on a worker thread. The future is true if the file was written.
+		virtual std::future<bool> SaveFramebufferToFileAsync(const std::string& _filepath) = 0;
+
+		// Delivers finished readbacks of this framebuffer
+		virtual void ProcessReadbacks() = 0;
+		// Delivers finished readbacks of every framebuffer with readbacks in flight. The application calls it once per frame,
+		// so callers of the asynchronous readbacks don't have to.
+		static void ProcessAllReadbacks();
+#pragma endregion
+
 		static Ref<Framebuffer> Create(const FramebufferSpecification& spec);
+
+	protected:
+		// Added when a readback is issued, removed once none are left in flight
+		static std::unordered_set<Framebuffer*> sReadbackFramebuffers;
 	};
 }
@@ -0,0 +1,169 @@
+#include "tspch.h"
+#include "Frustum.h"
+
+#if defined(__AVX__)
+#define TS_FRUSTUM_AVX
+#include <immintrin.h>
+#elif defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define TS_FRUSTUM_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace TS_ENGINE {
+
+	Frustum::Frustum()
+	{
+		for (int i = 0; i < COUNT; i++)
+			mPlanes[i] = Vector4(0.0f);
+	}
+
+	Frustum::Frustum(const Matrix4& projectionViewMatrix)
+	{
+		SetFromMatrix(projectionViewMatrix);
+	}
+
+	void Frustum::SetFromMatrix(const Matrix4& m)
+	{
+		// Gribb/Hartmann plane extraction. glm is column major, so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+		Vector4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+		Vector4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+		Vector4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+		Vector4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+		mPlanes[LEFT] = row3 + row0;
+		mPlanes[RIGHT] = row3 - row0;
+		mPlanes[BOTTOM] = row3 + row1;
+		mPlanes[TOP] = row3 - row1;
+		mPlanes[ZNEAR] = row3 + row2;
+		mPlanes[ZFAR] = row3 - row2;
+
+		for (int i = 0; i < COUNT; i++)
+		{
+			float length = glm::length(Vector3(mPlanes[i]));
+
+			if (length > 0.0f)
+				mPlanes[i] /= length;
+		}
+	}
+
+	bool Frustum::IsBoxVisible(const AABB& box) const
+	{
+		Vector3 center = box.GetCenter();
+		Vector3 extents = box.GetExtents();
+
+		for (int i = 0; i < COUNT; i++)
+		{
+			const Vector4& plane = mPlanes[i];
+
+			float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+			float radius = fabsf(plane.x) * extents.x + fabsf(plane.y) * extents.y + fabsf(plane.z) * extents.z;
+
+			if (distance + radius < 0.0f)
+				return false;
+		}
+
+		return true;
+	}
+
+	bool Frustum::IsSphereVisible(const BoundingSphere& sphere) const
+	{
+		for (int i = 0; i < COUNT; i++)
+		{
+			const Vector4& plane = mPlanes[i];
+
+			if (glm::dot(Vector3(plane), sphere.center) + plane.w < -sphere.radius)
+				return false;
+		}
+
+		return true;
+	}
+
+	void Frustum::TestBoxes(const AABB* boxes, size_t count, uint8_t* outVisible) const
+	{
+		size_t i = 0;
+
+#if defined(TS_FRUSTUM_AVX)
+		// 8 boxes per iteration, stored as structure of arrays
+		for (; i + 8 <= count; i += 8)
+		{
+			alignas(32) float cx[8], cy[8], cz[8], ex[8], ey[8], ez[8];
+
+			for (int j = 0; j < 8; j++)
+			{
+				Vector3 center = boxes[i + j].GetCenter();
+				Vector3 extents = boxes[i + j].GetExtents();
+				cx[j] = center.x; cy[j] = center.y; cz[j] = center.z;
+				ex[j] = extents.x; ey[j] = extents.y; ez[j] = extents.z;
+			}
+
+			__m256 centerX = _mm256_load_ps(cx), centerY = _mm256_load_ps(cy), centerZ = _mm256_load_ps(cz);
+			__m256 extentX = _mm256_load_ps(ex), extentY = _mm256_load_ps(ey), extentZ = _mm256_load_ps(ez);
+			__m256 outside = _mm256_setzero_ps();
+
+			for (int p = 0; p < COUNT; p++)
+			{
+				const Vector4& plane = mPlanes[p];
+
+				__m256 distance = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(centerX, _mm256_set1_ps(plane.x)), _mm256_mul_ps(centerY, _mm256_set1_ps(plane.y))),
+					_mm256_add_ps(_mm256_mul_ps(centerZ, _mm256_set1_ps(plane.z)), _mm256_set1_ps(plane.w)));
+
+				__m256 radius = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(extentX, _mm256_set1_ps(fabsf(plane.x))), _mm256_mul_ps(extentY, _mm256_set1_ps(fabsf(plane.y)))),
+					_mm256_mul_ps(extentZ, _mm256_set1_ps(fabsf(plane.z))));
+
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_LT_OQ));
+			}
+
+			int mask = _mm256_movemask_ps(outside);
+
+			for (int j = 0; j < 8; j++)
+				outVisible[i + j] = (mask & (1 << j)) ? 0 : 1;
+		}
+#endif
+
+#if defined(TS_FRUSTUM_AVX) || defined(TS_FRUSTUM_SSE)
+		// 4 boxes per iteration, stored as structure of arrays
+		for (; i + 4 <= count; i += 4)
+		{
+			alignas(16) float cx[4], cy[4], cz[4], ex[4], ey[4], ez[4];
+
+			for (int j = 0; j < 4; j++)
+			{
+				Vector3 center = boxes[i + j].GetCenter();
+				Vector3 extents = boxes[i + j].GetExtents();
+				cx[j] = center.x; cy[j] = center.y; cz[j] = center.z;
+				ex[j] = extents.x; ey[j] = extents.y; ez[j] = extents.z;
+			}
+
+			__m128 centerX = _mm_load_ps(cx), centerY = _mm_load_ps(cy), centerZ = _mm_load_ps(cz);
+			__m128 extentX = _mm_load_ps(ex), extentY = _mm_load_ps(ey), extentZ = _mm_load_ps(ez);
+			__m128 outside = _mm_setzero_ps();
+
+			for (int p = 0; p < COUNT; p++)
+			{
+				const Vector4& plane = mPlanes[p];
+
+				__m128 distance = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(plane.x)), _mm_mul_ps(centerY, _mm_set1_ps(plane.y))),
+					_mm_add_ps(_mm_mul_ps(centerZ, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+
+				__m128 radius = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(extentX, _mm_set1_ps(fabsf(plane.x))), _mm_mul_ps(extentY, _mm_set1_ps(fabsf(plane.y)))),
+					_mm_mul_ps(extentZ, _mm_set1_ps(fabsf(plane.z))));
+
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+			}
+
+			int mask = _mm_movemask_ps(outside);
+
+			for (int j = 0; j < 4; j++)
+				outVisible[i + j] = (mask & (1 << j)) ? 0 : 1;
+		}
+#endif
+
+		// Remainder (or everything without SIMD)
+		for (; i < count; i++)
+			outVisible[i] = IsBoxVisible(boxes[i]) ? 1 : 0;
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "Renderer/Bounds.h"
+
+namespace TS_ENGINE {
+
+	/// <summary>
+	/// View frustum planes extracted from a projection * view matrix (OpenGL clip space).
+	/// Planes point inwards and are normalized.
+	/// </summary>
+	class Frustum
+	{
+	public:
+		enum Plane
+		{
+			LEFT,
+			RIGHT,
+			BOTTOM,
+			TOP,
+			ZNEAR,	// NEAR and FAR are macros in Windows.h
+			ZFAR,
+			COUNT
+		};
+
+		Frustum();
+		Frustum(const Matrix4& projectionViewMatrix);
+
+		void SetFromMatrix(const Matrix4& projectionViewMatrix);
+
+		bool IsBoxVisible(const AABB& box) const;
+		bool IsSphereVisible(const BoundingSphere& sphere) const;
+
+		/// <summary>
+		/// Tests many boxes at once. Uses SSE (4 boxes per iteration) or AVX (8 boxes per iteration) when available.
+		/// outVisible[i] is set to 1 if boxes[i] intersects the frustum, 0 otherwise.
+		/// </summary>
+		void TestBoxes(const AABB* boxes, size_t count, uint8_t* outVisible) const;
+
+		const Vector4& GetPlane(Plane plane) const { return mPlanes[plane]; }
+	private:
+		Vector4 mPlanes[COUNT];
+	};
+}
@@ -0,0 +1,18 @@
+#include "tspch.h"
+#include "Renderer/GPUCuller.h"
+#include "Platform/OpenGL/OpenGLGPUCuller.h"
+
+namespace TS_ENGINE {
+
+	bool GPUCuller::IsSupported()
+	{
+		//ToDo: Add support for multiple APIs
+		return OpenGLGPUCuller::IsSupported();
+	}
+
+	Ref<GPUCuller> GPUCuller::Create()
+	{
+		//ToDo: Add support for multiple APIs
+		return CreateRef<OpenGLGPUCuller>();
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include "Renderer/Bounds.h"
+#include "Renderer/Buffer.h"
+
+namespace TS_ENGINE {
+
+	// Matches the layout glMultiDrawElementsIndirect reads
+	struct DrawElementsIndirectCommand
+	{
+		uint32_t count = 0;
+		uint32_t instanceCount = 0;
+		uint32_t firstIndex = 0;
+		int32_t baseVertex = 0;
+		uint32_t baseInstance = 0;
+	};
+
+	// One culled draw, std430 layout of the instance storage buffer
+	struct GPUCullInstance
+	{
+		Vector4 boundsMin = Vector4(0.0f);	// World space
+		Vector4 boundsMax = Vector4(0.0f);
+		uint32_t indexCount = 0;
+		uint32_t firstIndex = 0;
+		int32_t baseVertex = 0;
+		uint32_t drawGroup = 0;			// Draws of a group share a vertex array and are submitted together
+		uint32_t groupSlot = 0;			// Set by SetInstances
+		uint32_t padding[3] = { 0, 0, 0 };
+	};
+
+	// What the vertex shader needs of a culled instance, std430 layout of the draw instance storage buffer. Same order as the GPUCullInstances.
+	struct GPUDrawInstance
+	{
+		Matrix4 modelMatrix = Matrix4(1);
+		uint32_t materialIndex = 0;		// Into the draw materials
+		int32_t entityID = -1;
+		uint32_t padding[2] = { 0, 0 };
+	};
+
+	// Material values that differ between the instances of a draw group, std430 layout of the draw material storage buffer
+	struct GPUDrawMaterial
+	{
+		Vector4 ambientColor = Vector4(0.0f);
+		Vector4 diffuseColor = Vector4(0.0f);
+		Vector4 specularColor = Vector4(0.0f);
+		Vector2 diffuseMapOffset = Vector2(0.0f);
+		Vector2 diffuseMapTiling = Vector2(1.0f);
+		int32_t diffuseMapLayer = 0;		// In the group's texture array
+		uint32_t padding[3] = { 0, 0, 0 };
+	};
+
+	/// <summary>
+	/// GPU driven culling. Instance bounds and draw descriptors live in storage buffers, a compute pass frustum culls them
+	/// and tests them against a depth pyramid built from the previous frame's depth, then writes the indirect draw commands.
+	/// Each draw group is submitted with one multi draw indirect call, using the GPU written draw count when the driver supports it.
+	/// A command's base instance is its instance's index. The vertex shader gets it as a_DrawInstance and reads the model matrix
+	/// and material of the instance from the draw instance and draw material storage buffers, while u_DrawInstanced is set.
+	/// </summary>
+	class GPUCuller
+	{
+	public:
+		static constexpr uint32_t sDrawInstanceBinding = 4;		// Shader storage binding of the GPUDrawInstances
+		static constexpr uint32_t sDrawMaterialBinding = 5;		// Shader storage binding of the GPUDrawMaterials
+		static constexpr uint32_t sDrawInstanceLocation = 5;	// a_DrawInstance, per instance attribute added to the bound vertex array while drawing
+
+		virtual ~GPUCuller() = default;
+
+		/// <summary>
+		/// Uploads instances with their draw data, only needed when they change. Group slots are assigned in order,
+		/// group ids must be below numDrawGroups. drawInstances has one entry per instance.
+		/// </summary>
+		virtual void SetInstances(std::vector<GPUCullInstance>& instances, const std::vector<GPUDrawInstance>& drawInstances,
+			const std::vector<GPUDrawMaterial>& drawMaterials, uint32_t numDrawGroups) = 0;
+
+		/// <summary>
+		/// Builds the depth pyramid from a depth texture holding a frame rendered with depthProjectionViewMatrix.
+		/// Call before the texture is cleared for the new frame. Without a pyramid only frustum culling is done.
+		/// </summary>
+		virtual void BuildDepthPyramid(uint32_t depthTextureID, uint32_t width, uint32_t height, const Matrix4& depthProjectionViewMatrix) = 0;
+		virtual void InvalidateDepthPyramid() = 0;
+
+		// Dispatches the culling pass for the current instances
+		virtual void Cull(const Matrix4& projectionViewMatrix) = 0;
+
+		// Draws the visible instances of a group with the bound shader and vertex array in one call
+		virtual void DrawGroup(uint32_t drawGroup, IndexType indexType) = 0;
+
+		virtual uint32_t GetInstanceCount() const = 0;
+		virtual bool HasDrawCountSupport() const = 0;
+
+		// Compute shaders and indirect draws are available
+		static bool IsSupported();
+		static Ref<GPUCuller> Create();
+	};
+}
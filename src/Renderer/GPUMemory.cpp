@@ -0,0 +1,285 @@
+#include "tspch.h"
+#include "Renderer/GPUMemory.h"
+#include "Renderer/TextureArray.h"
+#include "Platform/OpenGL/OpenGLGPUMemory.h"
+#include "Application.h"
+
+namespace TS_ENGINE {
+
+	GPUMemoryManager* GPUMemoryManager::mInstance = nullptr;
+
+	GPUMemoryManager* GPUMemoryManager::GetInstance()
+	{
+		//ToDo: Add support for multiple APIs
+		if (mInstance == nullptr)
+			mInstance = new OpenGLGPUMemoryManager();
+
+		return mInstance;
+	}
+
+	void GPUMemoryManager::Allocate(GPUMemoryCategory category, uint64_t bytes)
+	{
+		mUsage[(uint32_t)category] += bytes;
+	}
+
+	void GPUMemoryManager::Release(GPUMemoryCategory category, uint64_t bytes)
+	{
+		TS_CORE_ASSERT(mUsage[(uint32_t)category] >= bytes);
+		mUsage[(uint32_t)category] -= std::min(mUsage[(uint32_t)category], bytes);
+	}
+
+	uint64_t GPUMemoryManager::GetTotalUsage() const
+	{
+		uint64_t total = 0;
+
+		for (uint64_t usage : mUsage)
+			total += usage;
+
+		return total;
+	}
+
+	uint64_t GPUMemoryManager::GetBudget()
+	{
+		uint64_t budget = (uint64_t)Application::GetInstance().mGPUMemoryBudget << 20;
+
+		if (budget != 0)
+			return budget;
+
+		if (mDeviceMemory == UINT64_MAX)
+		{
+			mDeviceMemory = QueryDeviceMemory();
+
+			if (mDeviceMemory != 0)
+				TS_CORE_INFO("GPU memory budget of {0} MB from the driver", mDeviceMemory / 4 * 3 >> 20);
+		}
+
+		// The rest is left to the driver, the window and other applications
+		return mDeviceMemory / 4 * 3;
+	}
+
+	void GPUMemoryManager::Register(const Ref<Texture2D>& texture)
+	{
+		mTextures.push_back(texture);
+	}
+
+	void GPUMemoryManager::Update()
+	{
+		mFrame++;
+
+		uint64_t budget = GetBudget();
+
+		if (budget == 0)
+			return;
+
+		uint64_t usage = GetTotalUsage();
+		uint64_t restoreLimit = budget - budget / 100 * sRestoreHeadroom;
+
+		if (usage <= budget && (mTrimmedTextures == 0 || usage >= restoreLimit))
+			return;
+
+		std::vector<ResidencyEntry> entries = GatherEntries();
+
+		if (usage > budget)
+			Trim(entries, usage - budget);
+		else
+			Restore(entries, restoreLimit - usage);
+	}
+
+	std::vector<GPUMemoryManager::ResidencyEntry> GPUMemoryManager::GatherEntries()
+	{
+		std::vector<ResidencyEntry> entries;
+		entries.reserve(mTextures.size());
+		mTrimmedTextures = 0;
+
+		mTextures.erase(std::remove_if(mTextures.begin(), mTextures.end(), [](const std::weak_ptr<Texture2D>& texture) { return texture.expired(); }), mTextures.end());
+
+		for (const auto& weakTexture : mTextures)
+		{
+			Ref<Texture2D> texture = weakTexture.lock();
+
+			if (!texture->CanChangeResidency())
+				continue;
+
+			ResidencyEntry entry;
+			entry.texture = texture;
+			entry.lastUsedFrame = texture->GetLastUsedFrame();
+			entries.push_back(entry);
+		}
+
+		// Layers of arrays can't change their levels on their own, the whole array does
+		TextureArrayManager* arrays = TextureArrayManager::GetInstance().get();
+
+		for (uint32_t array = 0; array < arrays->GetArrayCount(); array++)
+		{
+			if (!arrays->CanChangeResidency(array))
+				continue;
+
+			ResidencyEntry entry;
+			entry.array = array;
+			entry.lastUsedFrame = arrays->GetLastUsedFrame(array);
+			entries.push_back(entry);
+		}
+
+		for (const auto& entry : entries)
+			mTrimmedTextures += GetResidentLevel(entry) > 0 ? 1 : 0;
+
+		return entries;
+	}
+
+	void GPUMemoryManager::Trim(std::vector<ResidencyEntry>& entries, uint64_t excess)
+	{
+		std::sort(entries.begin(), entries.end(), [](const ResidencyEntry& a, const ResidencyEntry& b) { return a.lastUsedFrame < b.lastUsedFrame; });
+
+		// Dropping a level copies the levels that stay
+		uint64_t copyBudget = sResidencyBytesPerFrame;
+
+		// Idle entries first, then all of them, one level per entry and pass
+		for (bool includeUsed : { false, true })
+		{
+			bool trimmed = true;
+
+			while (trimmed)
+			{
+				trimmed = false;
+
+				for (auto& entry : entries)
+				{
+					if (!includeUsed && mFrame - entry.lastUsedFrame < sIdleFrames)
+						break;
+
+					uint32_t level = GetResidentLevel(entry);
+
+					if (level >= GetMaxResidentLevel(entry))
+						continue;
+
+					uint64_t kept = GetLevelBytes(entry, level + 1);
+					uint64_t freed = GetLevelBytes(entry, level) - kept;
+
+					if (kept > copyBudget)
+						return;
+
+					if (!SetResidentLevel(entry, level + 1))
+						continue;
+
+					mTrimmedTextures += level == 0 ? 1 : 0;
+					copyBudget -= kept;
+					excess -= std::min(excess, freed);
+					trimmed = true;
+
+					if (excess == 0)
+						return;
+				}
+			}
+		}
+	}
+
+	void GPUMemoryManager::Restore(std::vector<ResidencyEntry>& entries, uint64_t room)
+	{
+		std::sort(entries.begin(), entries.end(), [](const ResidencyEntry& a, const ResidencyEntry& b) { return a.lastUsedFrame > b.lastUsedFrame; });
+
+		// Restoring a level uploads it and copies the levels below
+		uint64_t uploadBudget = sResidencyBytesPerFrame;
+		bool restored = true;
+
+		while (restored)
+		{
+			restored = false;
+
+			for (auto& entry : entries)
+			{
+				// Idle entries stay blurry until they're used again
+				if (mFrame - entry.lastUsedFrame >= sIdleFrames)
+					break;
+
+				uint32_t level = GetResidentLevel(entry);
+
+				if (level == 0)
+					continue;
+
+				uint64_t cost = GetLevelBytes(entry, level - 1);
+				uint64_t added = cost - GetLevelBytes(entry, level);
+
+				if (added > room || cost > uploadBudget)
+					return;
+
+				if (!SetResidentLevel(entry, level - 1))
+					continue;
+
+				mTrimmedTextures -= level == 1 ? 1 : 0;
+				room -= added;
+				uploadBudget -= cost;
+				restored = true;
+			}
+		}
+	}
+
+	uint32_t GPUMemoryManager::GetResidentLevel(const ResidencyEntry& entry)
+	{
+		return entry.texture ? entry.texture->GetResidentLevel() : TextureArrayManager::GetInstance()->GetResidentLevel(entry.array);
+	}
+
+	uint64_t GPUMemoryManager::GetLevelBytes(const ResidencyEntry& entry, uint32_t level)
+	{
+		return entry.texture ? entry.texture->GetLevelBytes(level) : TextureArrayManager::GetInstance()->GetLevelBytes(entry.array, level);
+	}
+
+	bool GPUMemoryManager::SetResidentLevel(const ResidencyEntry& entry, uint32_t level)
+	{
+		return entry.texture ? entry.texture->SetResidentLevel(level) : TextureArrayManager::GetInstance()->SetResidentLevel(entry.array, level);
+	}
+
+	uint32_t GPUMemoryManager::GetMaxResidentLevel(const ResidencyEntry& entry)
+	{
+		TextureArrayManager* arrays = TextureArrayManager::GetInstance().get();
+		uint32_t levelCount = entry.texture ? entry.texture->GetLevelCount() : arrays->GetLevelCount(entry.array);
+		uint32_t size = entry.texture ? std::max(entry.texture->GetWidth(), entry.texture->GetHeight()) : std::max(arrays->GetWidth(entry.array), arrays->GetHeight(entry.array));
+		uint32_t level = 0;
+
+		while (level + 1 < levelCount && size >> (level + 1) >= sMinResidentSize)
+			level++;
+
+		return level;
+	}
+
+	GPUMemoryReport GPUMemoryManager::GetReport()
+	{
+		GPUMemoryReport report;
+
+		for (uint32_t category = 0; category < (uint32_t)GPUMemoryCategory::Count; category++)
+			report.usage[category] = mUsage[category];
+
+		report.totalUsage = GetTotalUsage();
+		report.budget = GetBudget();
+		report.unevictableBytes = report.totalUsage - report.usage[(uint32_t)GPUMemoryCategory::Texture];
+
+		for (const auto& entry : GatherEntries())
+		{
+			uint32_t level = GetResidentLevel(entry);
+
+			if (level == 0)
+			{
+				report.residentTextures++;
+				continue;
+			}
+
+			report.trimmedTextures++;
+			report.trimmedBytes += GetLevelBytes(entry, 0) - GetLevelBytes(entry, level);
+		}
+
+		return report;
+	}
+
+	void GPUMemoryManager::LogReport()
+	{
+		GPUMemoryReport report = GetReport();
+		const float megabyte = 1024.0f * 1024.0f;
+
+		TS_CORE_INFO("GPU memory: {0:.1f} of {1:.1f} MB, textures {2:.1f} MB, vertex buffers {3:.1f} MB, index buffers {4:.1f} MB, framebuffers {5:.1f} MB",
+			report.totalUsage / megabyte, report.budget / megabyte, report.usage[(uint32_t)GPUMemoryCategory::Texture] / megabyte,
+			report.usage[(uint32_t)GPUMemoryCategory::VertexBuffer] / megabyte, report.usage[(uint32_t)GPUMemoryCategory::IndexBuffer] / megabyte,
+			report.usage[(uint32_t)GPUMemoryCategory::Framebuffer] / megabyte);
+		TS_CORE_INFO("{0} textures and arrays fully resident, {1} with dropped levels saving {2:.1f} MB",
+			report.residentTextures, report.trimmedTextures, report.trimmedBytes / megabyte);
+		TS_CORE_INFO("{0:.1f} MB of geometry and framebuffers are accounted but never evicted", report.unevictableBytes / megabyte);
+	}
+}
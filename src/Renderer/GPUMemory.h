@@ -0,0 +1,99 @@
+#pragma once
+#include "Core/Base.h"
+#include "Renderer/Texture.h"
+
+namespace TS_ENGINE {
+
+	enum class GPUMemoryCategory : uint32_t
+	{
+		Texture = 0,		// 2D textures and texture arrays
+		VertexBuffer,
+		IndexBuffer,
+		Framebuffer,
+		Count
+	};
+
+	// Snapshot of GetReport, bytes per category
+	struct GPUMemoryReport
+	{
+		uint64_t usage[(uint32_t)GPUMemoryCategory::Count] = {};
+		uint64_t totalUsage = 0;
+		uint64_t budget = 0;				// 0 when unbounded
+		uint32_t residentTextures = 0;		// Textures and texture arrays whose levels can be dropped, with all of them in GPU memory
+		uint32_t trimmedTextures = 0;		// Textures and texture arrays with dropped levels
+		uint64_t trimmedBytes = 0;			// Freed by dropping levels
+		uint64_t unevictableBytes = 0;		// Vertex and index buffers and framebuffers, accounted but never evicted
+	};
+
+	/// <summary>
+	/// Accounts the GPU memory of textures, vertex and index buffers and framebuffers, and keeps it under a budget.
+	/// While over budget the least recently used textures drop their largest mip level, one level a pass, so idle textures
+	/// get blurrier before textures in use lose anything. Texture arrays do the same for all their layers at once, used as
+	/// recently as their most recently used layer. Dropped levels come back from the textures' baked containers once there
+	/// is room below the budget again, most recently used textures first. Geometry is accounted but never evicted, meshes in
+	/// the MeshArena share buffers and are drawn from them by batches and the GPU culler, so the report lists it apart.
+	/// </summary>
+	class GPUMemoryManager
+	{
+	public:
+		static constexpr uint32_t sIdleFrames = 300;					// Textures unused this long are restored last
+		static constexpr uint32_t sMinResidentSize = 64;				// Levels up to this size are never dropped
+		static constexpr uint32_t sResidencyBytesPerFrame = 32 << 20;	// Copied or uploaded to change levels each frame
+		static constexpr uint32_t sRestoreHeadroom = 10;				// Percent of the budget kept free before restoring levels
+
+		virtual ~GPUMemoryManager() = default;
+
+		// Main thread only, like the GL calls they account
+		void Allocate(GPUMemoryCategory category, uint64_t bytes);
+		void Release(GPUMemoryCategory category, uint64_t bytes);
+
+		uint64_t GetUsage(GPUMemoryCategory category) const { return mUsage[(uint32_t)category]; }
+		uint64_t GetTotalUsage() const;
+		// Application::mGPUMemoryBudget, or most of the video memory the driver reports. 0 when unbounded.
+		uint64_t GetBudget();
+
+		// Textures whose levels follow the budget, see Texture2D::CanChangeResidency
+		void Register(const Ref<Texture2D>& texture);
+		// Drops or restores texture levels. Called once a frame.
+		void Update();
+
+		uint64_t GetFrame() const { return mFrame; }
+		GPUMemoryReport GetReport();
+		void LogReport();
+
+		static GPUMemoryManager* GetInstance();
+	protected:
+		// Dedicated video memory the driver reports, 0 if it reports none
+		virtual uint64_t QueryDeviceMemory() = 0;
+	private:
+		// Never destroyed, textures in the static registries are released after it
+		static GPUMemoryManager* mInstance;
+
+		// A texture, or a texture array whose layers change their levels together
+		struct ResidencyEntry
+		{
+			Ref<Texture2D> texture;			// nullptr for an array
+			uint32_t array = 0;
+			uint64_t lastUsedFrame = 0;
+		};
+
+		// Live textures and the arrays that can change their levels, dropping expired textures
+		std::vector<ResidencyEntry> GatherEntries();
+		// Drops a level of entries at a time, least recently used first, until excess bytes are freed
+		void Trim(std::vector<ResidencyEntry>& entries, uint64_t excess);
+		// Restores a level of entries at a time, most recently used first, within room bytes
+		void Restore(std::vector<ResidencyEntry>& entries, uint64_t room);
+
+		static uint32_t GetResidentLevel(const ResidencyEntry& entry);
+		static uint64_t GetLevelBytes(const ResidencyEntry& entry, uint32_t level);
+		static bool SetResidentLevel(const ResidencyEntry& entry, uint32_t level);
+		// Lowest level an entry may drop to
+		static uint32_t GetMaxResidentLevel(const ResidencyEntry& entry);
+
+		uint64_t mUsage[(uint32_t)GPUMemoryCategory::Count] = {};
+		std::vector<std::weak_ptr<Texture2D>> mTextures;
+		uint32_t mTrimmedTextures = 0;				// Textures and arrays with dropped levels
+		uint64_t mFrame = 0;
+		uint64_t mDeviceMemory = UINT64_MAX;		// Queried once
+	};
+}
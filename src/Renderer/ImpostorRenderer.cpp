@@ -0,0 +1,61 @@
+#include "tspch.h"
+#include "Renderer/ImpostorRenderer.h"
+#include "Renderer/Frustum.h"
+#include "Primitive/Mesh.h"
+#include "Platform/OpenGL/OpenGLImpostorRenderer.h"
+
+namespace TS_ENGINE {
+
+	bool Impostor::IsStale() const
+	{
+		for (const auto& source : sources)
+		{
+			Ref<Mesh> mesh = source.mesh.lock();
+
+			if (!mesh || mesh->GetVertexVersion() != source.vertexVersion || mesh->GetMaterial().get() != source.material
+				|| (source.material && source.material->GetVersion() != source.materialVersion))
+				return true;
+		}
+
+		return false;
+	}
+
+	bool ImpostorRenderer::Submit(Impostor& impostor, const Matrix4& worldMatrix, int entityID, const Vector3& cameraPosition, float distance, const Frustum* frustum)
+	{
+		BoundingSphere worldBounds = impostor.bounds.Transform(worldMatrix);
+		Vector3 offset = worldBounds.center - cameraPosition;
+
+		if (glm::dot(offset, offset) <= distance * distance)
+			return false;
+
+		if (frustum && !frustum->IsSphereVisible(worldBounds))
+			return true;
+
+		if (impostor.instances.empty())
+			mQueuedImpostors.push_back(&impostor);
+
+		impostor.instances.push_back({ worldMatrix, entityID });
+		return true;
+	}
+
+	void ImpostorRenderer::SetLight(const Vector3& direction, const Vector3& ambient, const Vector3& diffuse)
+	{
+		mLightDirection = glm::normalize(direction);
+		mLightAmbient = ambient;
+		mLightDiffuse = diffuse;
+	}
+
+	Vector3 ImpostorRenderer::GetViewDirection(uint32_t yaw, uint32_t pitch)
+	{
+		float yawAngle = glm::radians(360.0f * yaw / sYawViews);
+		float pitchAngle = glm::radians(sPitchStep * pitch);
+
+		return Vector3(cosf(pitchAngle) * sinf(yawAngle), sinf(pitchAngle), cosf(pitchAngle) * cosf(yawAngle));
+	}
+
+	Ref<ImpostorRenderer> ImpostorRenderer::Create()
+	{
+		//ToDo: Add support for multiple APIs
+		return CreateRef<OpenGLImpostorRenderer>();
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include "Renderer/Bounds.h"
+#include "Renderer/Framebuffer.h"
+#include "Renderer/Shader.h"
+
+namespace TS_ENGINE {
+
+	class Node;
+	class Model;
+	class Frustum;
+
+	class Mesh;
+	class Material;
+
+	// A mesh an impostor was baked from, with the versions it had then
+	struct ImpostorSource
+	{
+		std::weak_ptr<Mesh> mesh;
+		const Material* material = nullptr;
+		uint32_t vertexVersion = 0;
+		uint32_t materialVersion = 0;
+	};
+
+	struct ImpostorInstance
+	{
+		Matrix4 worldMatrix;
+		int entityID = -1;					// Written to the entity ID attachment, for picks
+	};
+
+	/// <summary>
+	/// A model baked from a ring of views into one atlas with two color attachments: the unlit albedo of the materials,
+	/// and normals with depth, so the draw lights the albedo like the meshes would be.
+	/// Bounds are in the space of the model's root node, so every instance of the model can share the impostor.
+	/// </summary>
+	struct Impostor
+	{
+		Ref<Framebuffer> atlas;					// RGBA8 albedo at 0, RGB normal in root space at 1 with depth from the view's near plane in alpha, 0 where empty
+		BoundingSphere bounds;					// Root space
+		std::vector<ImpostorSource> sources;
+		std::vector<ImpostorInstance> instances;	// Queued for the current frame
+
+		// True once a source mesh was destroyed, its vertices or material were edited, or it was given another material
+		bool IsStale() const;
+	};
+
+	/// <summary>
+	/// Bakes impostors and draws the instances queued during a frame, one instanced quad draw per impostor.
+	/// Each quad faces the camera along the nearest baked view and writes the baked depth, so it intersects the scene like the model would.
+	/// </summary>
+	class ImpostorRenderer
+	{
+	public:
+		static constexpr uint32_t sYawViews = 8;			// Around the model, 45 degrees apart
+		static constexpr uint32_t sPitchViews = 3;			// From the horizon up, sPitchStep degrees apart
+		static constexpr float sPitchStep = 30.0f;
+		static constexpr uint32_t sViewResolution = 128;	// Pixels per atlas cell
+
+		virtual ~ImpostorRenderer() = default;
+
+		/// <summary>
+		/// Renders the subtree of rootNode from every view. Skinned meshes are baked in the current pose of the model's bones,
+		/// which are updated through shader. model can be nullptr for models without bones. Binds the default framebuffer when done.
+		/// </summary>
+		virtual Ref<Impostor> Bake(Ref<Node> rootNode, Ref<Model> model, Ref<Shader> shader) = 0;
+
+		/// <summary>
+		/// Queues an instance of the impostor if its bounds are farther than distance from the camera and inside the frustum (nullptr skips the test).
+		/// Returns true if the instance no longer needs its meshes, either queued or outside the frustum.
+		/// </summary>
+		bool Submit(Impostor& impostor, const Matrix4& worldMatrix, int entityID, const Vector3& cameraPosition, float distance, const Frustum* frustum);
+
+		// Draws the queued instances and clears the queues. Fragment outputs are the color at 0 and the entity ID at 1.
+		virtual void Flush(const Matrix4& viewMatrix, const Matrix4& projectionMatrix, bool countStats = true) = 0;
+
+		// Light the baked albedo is shaded with, as a direction towards the light in world space
+		void SetLight(const Vector3& direction, const Vector3& ambient, const Vector3& diffuse);
+
+		// Direction from the model towards the camera of a baked view
+		static Vector3 GetViewDirection(uint32_t yaw, uint32_t pitch);
+
+		static Ref<ImpostorRenderer> Create();
+	protected:
+		std::vector<Impostor*> mQueuedImpostors;
+
+		Vector3 mLightDirection = glm::normalize(Vector3(0.3f, 1.0f, 0.5f));
+		Vector3 mLightAmbient = Vector3(0.3f);
+		Vector3 mLightDiffuse = Vector3(0.7f);
+	};
+}
@@ -3,6 +3,8 @@
 #include "Shader.h"
 #include "Renderer/Renderer.h"
 #include "Renderer/RenderCommand.h"
+#include "Renderer/TextureArray.h"
+#include "Renderer/BindlessTextureTable.h"
 
 #ifdef TS_ENGINE_EDITOR
 #include <imgui.h>
@@ -13,6 +15,8 @@
 
 namespace TS_ENGINE {
 
+	uint32_t Material::sTrackedVersion = 0;
+
 	Material::Material()
 		: mAmbientColor(1.0f),
 		mDiffuseColor(1.0f),
@@ -105,6 +109,7 @@ namespace TS_ENGINE {
 
 		this->mAlphaBlendingEnabled = material->mAlphaBlendingEnabled;
 		this->mDepthTestEnabled = material->mDepthTestEnabled;
+		MarkEdited();
 	}
 
 	const Ref<Shader> Material::GetShader()
@@ -112,6 +117,51 @@ namespace TS_ENGINE {
 		return mShader;
 	}
 
+	bool Material::RendersLike(const Material& other, bool anyArrayLayer) const
+	{
+		// Meshes create their own shader instances, the same program source has the same name
+		bool sameShader = mShader == other.mShader || (mShader && other.mShader && mShader->GetName() == other.mShader->GetName());
+
+		bool sameArray = anyArrayLayer && mDiffuseMap && other.mDiffuseMap
+			&& mDiffuseMap->GetArrayLayer().IsValid() && mDiffuseMap->GetArrayLayer().array == other.mDiffuseMap->GetArrayLayer().array;
+
+		bool sameDiffuseMap = (mDiffuseMap == other.mDiffuseMap || sameArray)
+			&& (!mDiffuseMap || (mDiffuseMapOffset == other.mDiffuseMapOffset && mDiffuseMapTiling == other.mDiffuseMapTiling));
+
+		return sameShader && sameDiffuseMap
+			&& mAmbientColor == other.mAmbientColor
+			&& mDiffuseColor == other.mDiffuseColor
+			&& mSpecularColor == other.mSpecularColor
+			&& mDepthTestEnabled == other.mDepthTestEnabled
+			&& mAlphaBlendingEnabled == other.mAlphaBlendingEnabled;
+	}
+
+	bool Material::DrawsInstancedLike(const Material& other) const
+	{
+		bool sameShader = mShader == other.mShader || (mShader && other.mShader && mShader->GetName() == other.mShader->GetName());
+
+		// Bindless handles are set per draw, so only layers of a texture array can differ
+		bool sameArray = mDiffuseMap && other.mDiffuseMap && SamplesTextureArrays() && other.SamplesTextureArrays()
+			&& mDiffuseMap->GetArrayLayer().IsValid() && mDiffuseMap->GetArrayLayer().array == other.mDiffuseMap->GetArrayLayer().array;
+
+		return sameShader && (mDiffuseMap == other.mDiffuseMap || sameArray)
+			&& mDepthTestEnabled == other.mDepthTestEnabled
+			&& mAlphaBlendingEnabled == other.mAlphaBlendingEnabled;
+	}
+
+	void Material::MarkEdited()
+	{
+		mVersion++;
+
+		if (mTracked)
+			sTrackedVersion++;
+	}
+
+	bool Material::UsesBindlessTextures() const
+	{
+		return mShader && Application::GetInstance().mBindlessTextures && BindlessTextureTable::IsSupported() && mShader->HasUniform("u_DiffuseMapIndex");
+	}
+
 #ifdef  TS_ENGINE_EDITOR
 	void Material::Render(int _entityID, bool _enableTextures)
 #else
@@ -134,8 +184,34 @@ namespace TS_ENGINE {
 
 			if (Ref<Texture2D> diffuseMap = mDiffuseMap)
 			{
-				diffuseMap->Bind();											// Bind Diffuse Map
+				uint32_t handleIndex = UINT32_MAX;
+
+				if (UsesBindlessTextures())
+					handleIndex = BindlessTextureTable::GetInstance()->Acquire(diffuseMap);
+
+				bool useBindless = handleIndex != UINT32_MAX;
+				const TextureArrayLayer& arrayLayer = diffuseMap->GetArrayLayer();
+				bool useArray = !useBindless && arrayLayer.IsValid() && mShader->HasUniform("u_DiffuseMapArray");
+
+				if (useBindless)											// Index Into Handle Table, No Bind
+				{
+					BindlessTextureTable::GetInstance()->Bind();
+					mShader->SetInt("u_DiffuseMapIndex", (int)handleIndex);
+				}
+				else if (useArray)											// Bind Diffuse Map Array, skipped while it's bound
+				{
+					TextureArrayManager::GetInstance()->Bind(arrayLayer.array);
+					diffuseMap->MarkUsed();									// Keeps The Array's Levels, See GPUMemoryManager
+					mShader->SetInt("u_DiffuseMapArray", TextureArrayManager::sArraySlot);
+					mShader->SetInt("u_DiffuseMapLayer", (int)arrayLayer.layer);
+				}
+				else
+				{
+					diffuseMap->Bind();										// Bind Diffuse Map
+				}
 
+				mShader->SetBool("u_HasBindlessDiffuseMap", useBindless);	// HasBindlessDiffuseMap
+				mShader->SetBool("u_HasDiffuseMapArray", useArray);			// HasDiffuseMapArray
 				mShader->SetBool("u_HasDiffuseTexture", _enableTextures);	// HasDiffuseTexture
 
 				mShader->SetVec2("u_DiffuseMapOffset", mDiffuseMapOffset);	// DiffuseMapOffset
@@ -143,6 +219,8 @@ namespace TS_ENGINE {
 			}
 			else
 			{
+				mShader->SetBool("u_HasBindlessDiffuseMap", false);			// HasBindlessDiffuseMap
+				mShader->SetBool("u_HasDiffuseMapArray", false);			// HasDiffuseMapArray
 				mShader->SetBool("u_HasDiffuseTexture", false);				// HasDiffuseTexture
 			}
 		}
@@ -166,6 +244,7 @@ namespace TS_ENGINE {
 					if (ImGui::Button("Delete"))
 					{
 						mDiffuseMap = nullptr;
+						MarkEdited();
 						ImGui::CloseCurrentPopup();
 					}
 					ImGui::EndPopup();
@@ -175,6 +254,7 @@ namespace TS_ENGINE {
 					if (ImGui::Button("Delete"))
 					{
 						mSpecularMap = nullptr;
+						MarkEdited();
 						ImGui::CloseCurrentPopup();
 					}
 					ImGui::EndPopup();
@@ -184,6 +264,7 @@ namespace TS_ENGINE {
 					if (ImGui::Button("Delete"))
 					{
 						mNormalMap = nullptr;
+						MarkEdited();
 						ImGui::CloseCurrentPopup();
 					}
 					ImGui::EndPopup();
@@ -200,6 +281,7 @@ namespace TS_ENGINE {
 				{
 					mMaterialGui.mAmbientColor = Vector4(ambientColor[0], ambientColor[1], ambientColor[2], ambientColor[3]);
 					mAmbientColor = mMaterialGui.mAmbientColor;
+					MarkEdited();
 				}
 
 				ImGui::Spacing();
@@ -214,6 +296,7 @@ namespace TS_ENGINE {
 				{
 					mMaterialGui.mDiffuseColor = Vector4(diffuseColor[0], diffuseColor[1], diffuseColor[2], diffuseColor[3]);
 					mDiffuseColor = mMaterialGui.mDiffuseColor;
+					MarkEdited();
 				}
 
 				ImGui::Spacing();
@@ -236,6 +319,7 @@ namespace TS_ENGINE {
 				if (ImGui::DragFloat2((std::string("##DiffuseMapOffset") + std::to_string(meshIndex)).c_str(), mMaterialGui.mDiffuseMapOffset))
 				{
 					mDiffuseMapOffset = Vector2(mMaterialGui.mDiffuseMapOffset[0], mMaterialGui.mDiffuseMapOffset[1]);
+					MarkEdited();
 				}
 				ImGui::SameLine();
 				ImGui::Text("Offset");
@@ -244,6 +328,7 @@ namespace TS_ENGINE {
 				if (ImGui::DragFloat2((std::string("##DiffuseMapTiling") + std::to_string(meshIndex)).c_str(), mMaterialGui.mDiffuseMapTiling))
 				{
 					mDiffuseMapTiling = Vector2(mMaterialGui.mDiffuseMapTiling[0], mMaterialGui.mDiffuseMapTiling[1]);
+					MarkEdited();
 				}
 				ImGui::SameLine();
 				ImGui::Text("Tiling");
@@ -260,6 +345,7 @@ namespace TS_ENGINE {
 				{
 					mMaterialGui.mSpecularColor = Vector4(specularColor[0], specularColor[1], specularColor[2], specularColor[3]);
 					mSpecularColor = mMaterialGui.mSpecularColor;
+					MarkEdited();
 				}
 
 				ImGui::Spacing();
@@ -283,6 +369,7 @@ namespace TS_ENGINE {
 				if (ImGui::DragFloat2((std::string("##SpecularMapOffset") + std::to_string(meshIndex)).c_str(), mMaterialGui.mSpecularMapOffset))
 				{
 					mSpecularMapOffset = Vector2(mMaterialGui.mSpecularMapOffset[0], mMaterialGui.mSpecularMapOffset[1]);
+					MarkEdited();
 				}
 				ImGui::SameLine();
 				ImGui::Text("Offset");
@@ -291,6 +378,7 @@ namespace TS_ENGINE {
 				if (ImGui::DragFloat2((std::string("##SpecularMapTiling") + std::to_string(meshIndex)).c_str(), mMaterialGui.mSpecularMapTiling))
 				{
 					mSpecularMapTiling = Vector2(mMaterialGui.mSpecularMapTiling[0], mMaterialGui.mSpecularMapTiling[1]);
+					MarkEdited();
 				}
 				ImGui::SameLine();
 				ImGui::Text("Tiling");
@@ -301,6 +389,7 @@ namespace TS_ENGINE {
 				if (ImGui::SliderFloat((std::string("##Shininess") + std::to_string(meshIndex)).c_str(), &mMaterialGui.mShininess, 0, 20.0f))
 				{
 					mShininess = mMaterialGui.mShininess;
+					MarkEdited();
 				}
 
 				ImGui::Spacing();
@@ -328,6 +417,7 @@ namespace TS_ENGINE {
 				if (ImGui::DragFloat2((std::string("##NormalMapOffset") + std::to_string(meshIndex)).c_str(), mMaterialGui.mNormalMapOffset))
 				{
 					mNormalMapOffset = Vector2(mMaterialGui.mNormalMapOffset[0], mMaterialGui.mNormalMapOffset[1]);
+					MarkEdited();
 				}
 				ImGui::SameLine();
 				ImGui::Text("Offset");
@@ -336,6 +426,7 @@ namespace TS_ENGINE {
 				if (ImGui::DragFloat2((std::string("##NormalMapTiling") + std::to_string(meshIndex)).c_str(), mMaterialGui.mNormalMapTiling))
 				{
 					mNormalMapTiling = Vector2(mMaterialGui.mNormalMapTiling[0], mMaterialGui.mNormalMapTiling[1]);
+					MarkEdited();
 				}
 				ImGui::SameLine();
 				ImGui::Text("Tiling");
@@ -346,6 +437,7 @@ namespace TS_ENGINE {
 				if (ImGui::SliderFloat((std::string("##Bump") + std::to_string(meshIndex)).c_str(), &mMaterialGui.mBumpValue, 0, 20.0f))
 				{
 					mBumpValue = mMaterialGui.mBumpValue;
+					MarkEdited();
 				}
 			}
 
@@ -366,22 +458,27 @@ namespace TS_ENGINE {
 				const char* draggedTexturePath = reinterpret_cast<const char*>(payload->Data);
 				TS_CORE_INFO("Dropped {0} on {1}", draggedTexturePath, "DiffuseTextureDropZone");
 
-				Ref<Texture2D> texture = Texture2D::Create(draggedTexturePath);
+				TextureUsage usage = textureType == TextureType::DIFFUSE ? TextureUsage::Color :
+					textureType == TextureType::NORMAL ? TextureUsage::NormalMap : TextureUsage::Data;
+				Ref<Texture2D> texture = Texture2D::Create(draggedTexturePath, usage);
 
 				if (textureType == TextureType::DIFFUSE)
 				{
 					materialGui.mDiffuseMap = texture;
 					mDiffuseMap = texture;
+					MarkEdited();
 				}
 				else if (textureType == TextureType::SPECULAR)
 				{
 					materialGui.mSpecularMap = texture;
 					mSpecularMap = texture;
+					MarkEdited();
 				}
 				else if (textureType == TextureType::NORMAL)
 				{
 					materialGui.mNormalMap = texture;
 					mNormalMap = texture;
+					MarkEdited();
 				}
 			}
 
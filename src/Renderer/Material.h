@@ -50,25 +50,25 @@ namespace TS_ENGINE {
 		void SetName(std::string name) { mName = name; }
 
 		// Ambient
-		void SetAmbientColor(const Vector4& ambientColor) { mAmbientColor = ambientColor; }
+		void SetAmbientColor(const Vector4& ambientColor) { mAmbientColor = ambientColor; MarkEdited(); }
 		Vector4 GetAmbientColor() const { return mAmbientColor; }
 
 		// Diffuse
-		void SetDiffuseColor(const Vector4& diffuseColor) { mDiffuseColor = diffuseColor; }
-		void SetDiffuseMap(const Ref<Texture2D> diffuseMap) { mDiffuseMap = diffuseMap; }
-		void SetDiffuseMapOffset(Vector2 offset) { mDiffuseMapOffset = offset; }
-		void SetDiffuseMapTiling(Vector2 tiling) { mDiffuseMapTiling = tiling; }
+		void SetDiffuseColor(const Vector4& diffuseColor) { mDiffuseColor = diffuseColor; MarkEdited(); }
+		void SetDiffuseMap(const Ref<Texture2D> diffuseMap) { mDiffuseMap = diffuseMap; MarkEdited(); }
+		void SetDiffuseMapOffset(Vector2 offset) { mDiffuseMapOffset = offset; MarkEdited(); }
+		void SetDiffuseMapTiling(Vector2 tiling) { mDiffuseMapTiling = tiling; MarkEdited(); }
 		Vector4 GetDiffuseColor() const { return mDiffuseColor; }
 		Ref<Texture2D> GetDiffuseMap() const { return mDiffuseMap; }
 		Vector2 GetDiffuseMapOffset() const { return mDiffuseMapOffset; }
 		Vector2 GetDiffuseMapTiling() const { return mDiffuseMapTiling; }
 
 		// Specular
-		void SetSpecularColor(const Vector4& specularColor) { mSpecularColor = specularColor; }
-		void SetSpecularMap(const Ref<Texture2D> specularMap) { mSpecularMap = specularMap; }
-		void SetSpecularMapOffset(Vector2 offset) { mSpecularMapOffset = offset; }
-		void SetSpecularMapTiling(Vector2 tiling) { mSpecularMapTiling = tiling; }
-		void SetShininess(float shininess) { mShininess = shininess; }
+		void SetSpecularColor(const Vector4& specularColor) { mSpecularColor = specularColor; MarkEdited(); }
+		void SetSpecularMap(const Ref<Texture2D> specularMap) { mSpecularMap = specularMap; MarkEdited(); }
+		void SetSpecularMapOffset(Vector2 offset) { mSpecularMapOffset = offset; MarkEdited(); }
+		void SetSpecularMapTiling(Vector2 tiling) { mSpecularMapTiling = tiling; MarkEdited(); }
+		void SetShininess(float shininess) { mShininess = shininess; MarkEdited(); }
 		Vector4 GetSpecularColor() const { return mSpecularColor; }
 		Ref<Texture2D> GetSpecularMap() const { return mSpecularMap; }
 		Vector2 GetSpecularMapOffset() const { return mSpecularMapOffset; }
@@ -76,10 +76,10 @@ namespace TS_ENGINE {
 		float GetShininess() const { return mShininess; }
 
 		// Bump
-		void SetNormalMap(const Ref<Texture2D> normalMap) { mNormalMap = normalMap; }
-		void SetNormalMapOffset(Vector2 offset) { mNormalMapOffset = offset; }
-		void SetNormalMapTiling(Vector2 tiling) { mNormalMapTiling = tiling; }
-		void SetBumpValue(const float bumpValue) { mBumpValue = bumpValue; }
+		void SetNormalMap(const Ref<Texture2D> normalMap) { mNormalMap = normalMap; MarkEdited(); }
+		void SetNormalMapOffset(Vector2 offset) { mNormalMapOffset = offset; MarkEdited(); }
+		void SetNormalMapTiling(Vector2 tiling) { mNormalMapTiling = tiling; MarkEdited(); }
+		void SetBumpValue(const float bumpValue) { mBumpValue = bumpValue; MarkEdited(); }
 		Ref<Texture2D> GetNormalMap() const { return mNormalMap; }
 		Vector2 GetNormalMapOffset() const { return mNormalMapOffset; }
 		Vector2 GetNormalMapTiling() const { return mNormalMapTiling; }
@@ -89,10 +89,33 @@ namespace TS_ENGINE {
 		const Ref<Shader> GetShader();
 
 		// Other material properties
-		void EnableDepthTest() { mDepthTestEnabled = true; }
-		void DisableDepthTest() { mDepthTestEnabled = false; }
-		void EnableAlphaBlending() { mAlphaBlendingEnabled = true; }
-		void DisableAlphaBlending() { mAlphaBlendingEnabled = false; }
+		void EnableDepthTest() { mDepthTestEnabled = true; MarkEdited(); }
+		void DisableDepthTest() { mDepthTestEnabled = false; MarkEdited(); }
+		void EnableAlphaBlending() { mAlphaBlendingEnabled = true; MarkEdited(); }
+		void DisableAlphaBlending() { mAlphaBlendingEnabled = false; MarkEdited(); }
+		bool IsDepthTestEnabled() const { return mDepthTestEnabled; }
+		bool IsAlphaBlendingEnabled() const { return mAlphaBlendingEnabled; }
+
+		// Bumped by every edit of the properties, so copies baked or merged from the material can tell they're stale
+		uint32_t GetVersion() const { return mVersion; }
+		// Edits of tracked materials bump GetTrackedVersion, so caches of tracked materials are checked in O(1)
+		void SetTracked(bool tracked) { mTracked = tracked; }
+		static uint32_t GetTrackedVersion() { return sTrackedVersion; }
+
+		/// <summary>
+		/// True if Render sets the same state and values for both, so meshes using either can share a draw. With anyArrayLayer,
+		/// diffuse maps in different layers of one texture array match too, for draws that pass the layer per vertex.
+		/// </summary>
+		bool RendersLike(const Material& other, bool anyArrayLayer = false) const;
+		/// <summary>
+		/// True if meshes using either can share a GPU culled instanced draw, whose instances take their colors, diffuse map offset,
+		/// tiling and array layer from a GPUDrawMaterial. The shader, the diffuse map (or its texture array) and the render state must match.
+		/// </summary>
+		bool DrawsInstancedLike(const Material& other) const;
+		// True if Render samples diffuse maps from texture arrays: the shader declares u_DiffuseMapArray and bindless textures aren't used
+		bool SamplesTextureArrays() const { return mShader && mShader->HasUniform("u_DiffuseMapArray") && !UsesBindlessTextures(); }
+		// True if Render passes the diffuse map as an index into the bindless handle table (the shader declares u_DiffuseMapIndex)
+		bool UsesBindlessTextures() const;
 
 #ifdef  TS_ENGINE_EDITOR
 		// Material Render (Sets Render Commands. Passes properties to fragement shader)
@@ -108,6 +131,9 @@ namespace TS_ENGINE {
 		void DropContentBrowserTexture(TextureType textureType, Material::MaterialGui& materialGui, int meshIndex);
 #endif
 	private:
+		// Bumps the version, and the tracked version for tracked materials
+		void MarkEdited();
+
 #ifdef TS_ENGINE_EDITOR
 		MaterialGui mMaterialGui;
 #endif
@@ -136,6 +162,10 @@ namespace TS_ENGINE {
 		//Other material properties
 		bool mDepthTestEnabled;
 		bool mAlphaBlendingEnabled;
+
+		uint32_t mVersion = 0;
+		bool mTracked = false;
+		static uint32_t sTrackedVersion;
 	};
 }
 
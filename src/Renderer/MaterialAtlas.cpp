@@ -0,0 +1,171 @@
+#include "tspch.h"
+#include "Renderer/MaterialAtlas.h"
+#include "Primitive/Mesh.h"
+#include "Renderer/AtlasPacker.h"
+#include "Renderer/TextureStreamer.h"
+
+namespace TS_ENGINE {
+
+	namespace
+	{
+		uint32_t NextPowerOfTwo(uint32_t value)
+		{
+			uint32_t result = 1;
+
+			while (result < value)
+				result <<= 1;
+
+			return result;
+		}
+	}
+
+	bool MaterialAtlas::FitsAtlas(const Ref<Mesh>& mesh)
+	{
+		Ref<Material> material = mesh->GetMaterial();
+
+		if (!material)
+			return false;
+
+		if (!material->GetDiffuseMap())
+			return true;
+
+		const float epsilon = 1e-3f;
+		Vector2 tiling = material->GetDiffuseMapTiling();
+		Vector2 offset = material->GetDiffuseMapOffset();
+
+		for (const auto& vertex : mesh->GetVertices())
+		{
+			Vector2 uv = vertex.texCoord * tiling + offset;
+
+			if (uv.x < -epsilon || uv.y < -epsilon || uv.x > 1.0f + epsilon || uv.y > 1.0f + epsilon)
+				return false;
+		}
+
+		return true;
+	}
+
+	uint32_t MaterialAtlas::AddMaterial(const Ref<Material>& material)
+	{
+		Ref<Texture2D> texture = material->GetDiffuseMap();
+
+		// Streamed textures are 1x1 until they're uploaded
+		if (texture && texture->IsStreaming())
+			TextureStreamer::GetInstance()->Flush();
+
+		if (texture && (texture->GetWidth() == 0 || texture->GetHeight() == 0))
+			texture = nullptr;
+
+		Vector4 tint = material->GetDiffuseColor();
+		auto key = std::make_tuple(texture.get(), tint.x, tint.y, tint.z, tint.w);
+		auto it = mEntryLookup.find(key);
+
+		if (it != mEntryLookup.end())
+			return it->second;
+
+		Entry entry;
+		entry.texture = texture;
+		entry.tint = tint;
+		entry.width = sSolidEntrySize;
+		entry.height = sSolidEntrySize;
+
+		if (texture)
+		{
+			float scale = std::min(1.0f, (float)sMaxEntrySize / std::max(texture->GetWidth(), texture->GetHeight()));
+			entry.width = std::max(1u, (uint32_t)(texture->GetWidth() * scale));
+			entry.height = std::max(1u, (uint32_t)(texture->GetHeight() * scale));
+		}
+
+		uint32_t entryIndex = (uint32_t)mEntries.size();
+		mEntryLookup[key] = entryIndex;
+		mEntries.push_back(entry);
+		return entryIndex;
+	}
+
+	bool MaterialAtlas::Pack(float textureScale)
+	{
+		std::vector<std::pair<uint32_t, uint32_t>> sizes;
+		sizes.reserve(mEntries.size());
+
+		for (const auto& entry : mEntries)
+		{
+			uint32_t width = entry.texture ? std::max(1u, (uint32_t)(entry.width * textureScale)) : entry.width;
+			uint32_t height = entry.texture ? std::max(1u, (uint32_t)(entry.height * textureScale)) : entry.height;
+			sizes.push_back({ width, height });
+		}
+
+		// The compositor can't turn textures, so entries keep their orientation
+		AtlasPacker packer(sAtlasSize, sAtlasSize, sPadding, 1, false, 1);
+		std::vector<AtlasPackerRect> rects;
+
+		if (!packer.Pack(sizes, rects))
+			return false;
+
+		for (size_t i = 0; i < mEntries.size(); i++)
+		{
+			Entry& entry = mEntries[i];
+			entry.rect.texture = entry.texture;
+			entry.rect.tint = entry.tint;
+			entry.rect.x = rects[i].x;
+			entry.rect.y = rects[i].y;
+			entry.rect.width = rects[i].width;
+			entry.rect.height = rects[i].height;
+			entry.rect.padding = sPadding;
+		}
+
+		mUsedWidth = packer.GetUsedWidth(0);
+		mUsedHeight = packer.GetUsedHeight(0);
+		return true;
+	}
+
+	Ref<Texture2D> MaterialAtlas::Build(TextureCompositor& compositor)
+	{
+		if (mEntries.empty())
+			return nullptr;
+
+		float textureScale = 1.0f;
+
+		while (!Pack(textureScale))
+		{
+			textureScale *= 0.5f;
+
+			if (textureScale * sMaxEntrySize < 1.0f)
+			{
+				TS_CORE_WARN("{0} materials don't fit into the atlas", mEntries.size());
+				return nullptr;
+			}
+		}
+
+		mWidth = NextPowerOfTwo(mUsedWidth);
+		mHeight = NextPowerOfTwo(mUsedHeight);
+
+		std::vector<TextureCompositeRect> rects;
+		rects.reserve(mEntries.size());
+
+		for (const auto& entry : mEntries)
+			rects.push_back(entry.rect);
+
+		return compositor.Composite(mWidth, mHeight, rects);
+	}
+
+	Vector2 MaterialAtlas::GetAtlasUV(uint32_t entry, const Material& material, const Vector2& uv) const
+	{
+		TS_CORE_ASSERT(entry < mEntries.size() && mWidth > 0 && mHeight > 0);
+
+		const TextureCompositeRect& rect = mEntries[entry].rect;
+		Vector2 textureUV = rect.texture
+			? glm::clamp(uv * material.GetDiffuseMapTiling() + material.GetDiffuseMapOffset(), Vector2(0.0f), Vector2(1.0f))
+			: Vector2(0.5f);
+
+		return Vector2((rect.x + textureUV.x * rect.width) / mWidth, (rect.y + textureUV.y * rect.height) / mHeight);
+	}
+
+	Ref<Material> MaterialAtlas::CreateAtlasMaterial(const Ref<Material>& material, Ref<Texture2D> atlas)
+	{
+		Ref<Material> atlasMaterial = CreateRef<Material>(material);
+		atlasMaterial->SetDiffuseMap(atlas);
+		atlasMaterial->SetDiffuseColor(Vector4(1.0f));
+		atlasMaterial->SetDiffuseMapTiling(Vector2(1.0f));
+		atlasMaterial->SetDiffuseMapOffset(Vector2(0.0f));
+		return atlasMaterial;
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "Renderer/Material.h"
+#include "Renderer/TextureCompositor.h"
+#include <map>
+
+namespace TS_ENGINE {
+
+	class Mesh;
+
+	/// <summary>
+	/// Packs the diffuse maps of many materials, each tinted by its diffuse color, into one texture so meshes using them can be
+	/// merged into a single draw. The atlas is composited on the GPU, so it works for textures that keep no pixels on the CPU.
+	/// </summary>
+	class MaterialAtlas
+	{
+	public:
+		static constexpr uint32_t sAtlasSize = 2048;
+		static constexpr uint32_t sMaxEntrySize = 256;		// Longest side of a texture in the atlas
+		static constexpr uint32_t sSolidEntrySize = 4;		// Materials without a diffuse map
+		static constexpr uint32_t sPadding = 2;
+
+		// False if the mesh samples its diffuse map outside of one copy of the texture (repeating tiling or offset)
+		static bool FitsAtlas(const Ref<Mesh>& mesh);
+
+		// Entry of the material's diffuse map tinted by its diffuse color. Materials with the same map and color share an entry.
+		uint32_t AddMaterial(const Ref<Material>& material);
+
+		/// <summary>
+		/// Packs the entries with AtlasPacker, halving the textures until they fit on one page, and composites the atlas.
+		/// Returns nullptr if they don't fit even at the smallest scale.
+		/// </summary>
+		Ref<Texture2D> Build(TextureCompositor& compositor);
+
+		// Atlas UV of a mesh UV, after the entry's material tiling and offset. Only valid after Build.
+		Vector2 GetAtlasUV(uint32_t entry, const Material& material, const Vector2& uv) const;
+
+		// Copy of the material drawing the atlas instead of its diffuse map, with the tint already baked in
+		static Ref<Material> CreateAtlasMaterial(const Ref<Material>& material, Ref<Texture2D> atlas);
+
+		size_t GetEntryCount() const { return mEntries.size(); }
+		uint32_t GetWidth() const { return mWidth; }
+		uint32_t GetHeight() const { return mHeight; }
+	private:
+		struct Entry
+		{
+			Ref<Texture2D> texture;
+			Vector4 tint;
+			uint32_t width;
+			uint32_t height;
+			TextureCompositeRect rect;
+		};
+
+		// Places every entry at textureScale. Returns false if they don't fit.
+		bool Pack(float textureScale);
+
+		std::vector<Entry> mEntries;
+		std::map<std::tuple<const Texture2D*, float, float, float, float>, uint32_t> mEntryLookup;
+		uint32_t mUsedWidth = 0;
+		uint32_t mUsedHeight = 0;
+		uint32_t mWidth = 0;
+		uint32_t mHeight = 0;
+	};
+}
@@ -53,4 +53,9 @@ namespace TS_ENGINE {
 	{
 		return mLitMat;
 	}
+
+	bool MaterialManager::RebuildsNormalZ() const
+	{
+		return mLitShader && mLitShader->HasUniform("u_NormalMapTwoChannel");
+	}
 }
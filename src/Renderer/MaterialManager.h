@@ -16,6 +16,9 @@ namespace TS_ENGINE {
 		Ref<Material> GetUnlitMaterial();
 		Ref<Material> GetSkinnedMeshUnlitMaterial();
 		Ref<Material> GetLitMaterial();
+
+		// True when the shader sampling normal maps rebuilds z from x and y, so they can be stored in two channels
+		bool RebuildsNormalZ() const;
 		
 		const char* mMaterialNameList[2] = {
 			"Unlit",
@@ -0,0 +1,316 @@
+#include "tspch.h"
+#include "Renderer/MeshArena.h"
+#include "Platform/OpenGL/OpenGLMeshArena.h"
+
+namespace TS_ENGINE {
+
+	///***/////////////////////////////ArenaAllocator///////////////////////////***///
+
+	bool ArenaAllocator::Allocate(uint32_t size, uint32_t& offset)
+	{
+		TS_CORE_ASSERT(size > 0);
+
+		for (auto it = mFreeBlocks.begin(); it != mFreeBlocks.end(); ++it)
+		{
+			if (it->second < size)
+				continue;
+
+			offset = it->first;
+			uint32_t remaining = it->second - size;
+			mFreeBlocks.erase(it);
+
+			if (remaining > 0)
+				mFreeBlocks[offset + size] = remaining;
+
+			mUsed += size;
+			return true;
+		}
+
+		return false;
+	}
+
+	void ArenaAllocator::Free(uint32_t offset, uint32_t size)
+	{
+		TS_CORE_ASSERT(size > 0 && offset + size <= mCapacity && size <= mUsed);
+
+		mUsed -= size;
+		auto next = mFreeBlocks.lower_bound(offset);
+
+		// Merge with the following block
+		if (next != mFreeBlocks.end() && next->first == offset + size)
+		{
+			size += next->second;
+			next = mFreeBlocks.erase(next);
+		}
+
+		// Merge with the preceding block
+		if (next != mFreeBlocks.begin())
+		{
+			auto previous = std::prev(next);
+
+			if (previous->first + previous->second == offset)
+			{
+				previous->second += size;
+				return;
+			}
+		}
+
+		mFreeBlocks[offset] = size;
+	}
+
+	void ArenaAllocator::Grow(uint32_t capacity)
+	{
+		if (capacity <= mCapacity)
+			return;
+
+		uint32_t offset = mCapacity;
+		uint32_t size = capacity - mCapacity;
+		mCapacity = capacity;
+
+		// Free() expects the range to be in use
+		mUsed += size;
+		Free(offset, size);
+	}
+
+	uint32_t ArenaAllocator::FindFirstFit(uint32_t size) const
+	{
+		for (const auto& [offset, blockSize] : mFreeBlocks)
+		{
+			if (blockSize >= size)
+				return offset;
+		}
+
+		return UINT32_MAX;
+	}
+
+	bool ArenaAllocator::HasHoles() const
+	{
+		if (mFreeBlocks.empty())
+			return false;
+
+		if (mFreeBlocks.size() > 1)
+			return true;
+
+		const auto& [offset, size] = *mFreeBlocks.begin();
+		return offset + size != mCapacity;
+	}
+
+	///***/////////////////////////////MeshArena///////////////////////////***///
+
+	Ref<MeshArena> MeshArena::mInstance = nullptr;
+
+	Ref<MeshArena> MeshArena::GetInstance()
+	{
+		//ToDo: Add support for multiple APIs
+		if (mInstance == nullptr)
+			mInstance = CreateRef<OpenGLMeshArena>();
+
+		return mInstance;
+	}
+
+	void MeshArena::Shutdown()
+	{
+		mInstance = nullptr;
+	}
+
+	MeshArena::Handle MeshArena::Allocate(VertexFormat vertexFormat, const void* vertexData, uint32_t vertexCount, IndexType indexType, const void* indexData, uint32_t indexCount)
+	{
+		TS_CORE_ASSERT(vertexCount > 0 && indexCount > 0);
+
+		uint32_t baseVertex = 0;
+		uint32_t firstIndex = 0;
+
+		if (!AllocateVertices(vertexFormat, vertexCount, baseVertex))
+			return sInvalidHandle;
+
+		if (!AllocateIndices(indexType, indexCount, firstIndex))
+		{
+			mVertexAllocators[(uint32_t)vertexFormat].Free(baseVertex, vertexCount);
+			return sInvalidHandle;
+		}
+
+		UploadVertices(vertexFormat, baseVertex, vertexData, vertexCount);
+		UploadIndices(indexType, firstIndex, indexData, indexCount);
+
+		Handle handle;
+
+		if (!mFreeHandles.empty())
+		{
+			handle = mFreeHandles.back();
+			mFreeHandles.pop_back();
+		}
+		else
+		{
+			mAllocations.emplace_back();
+			handle = (Handle)mAllocations.size();
+		}
+
+		MeshArenaAllocation& allocation = mAllocations[handle - 1];
+		allocation.vertexFormat = vertexFormat;
+		allocation.indexType = indexType;
+		allocation.baseVertex = baseVertex;
+		allocation.vertexCount = vertexCount;
+		allocation.firstIndex = firstIndex;
+		allocation.indexCount = indexCount;
+
+		mVertexRanges[(uint32_t)vertexFormat][baseVertex] = handle;
+		mIndexRanges[(uint32_t)indexType][firstIndex] = handle;
+
+		return handle;
+	}
+
+	void MeshArena::Free(Handle handle)
+	{
+		TS_CORE_ASSERT(handle != sInvalidHandle && handle <= mAllocations.size());
+
+		MeshArenaAllocation& allocation = mAllocations[handle - 1];
+		mVertexAllocators[(uint32_t)allocation.vertexFormat].Free(allocation.baseVertex, allocation.vertexCount);
+		mIndexAllocators[(uint32_t)allocation.indexType].Free(allocation.firstIndex, allocation.indexCount);
+		mVertexRanges[(uint32_t)allocation.vertexFormat].erase(allocation.baseVertex);
+		mIndexRanges[(uint32_t)allocation.indexType].erase(allocation.firstIndex);
+
+		allocation = MeshArenaAllocation();
+		mFreeHandles.push_back(handle);
+		mLayoutVersion++;
+	}
+
+	const MeshArenaAllocation& MeshArena::GetAllocation(Handle handle) const
+	{
+		TS_CORE_ASSERT(handle != sInvalidHandle && handle <= mAllocations.size());
+		return mAllocations[handle - 1];
+	}
+
+	bool MeshArena::AllocateVertices(VertexFormat vertexFormat, uint32_t count, uint32_t& offset)
+	{
+		ArenaAllocator& allocator = mVertexAllocators[(uint32_t)vertexFormat];
+
+		while (!allocator.Allocate(count, offset))
+		{
+			uint64_t capacity = std::max<uint64_t>((uint64_t)allocator.GetCapacity() * 2, sInitialVertexCapacity);
+			capacity = std::max<uint64_t>(capacity, (uint64_t)allocator.GetUsed() + count);
+
+			if (capacity * VertexFormatUtils::GetStride(vertexFormat) > UINT32_MAX || !ResizeVertexBuffer(vertexFormat, (uint32_t)capacity))
+			{
+				TS_CORE_ERROR("Mesh arena could not grow to {0} vertices", capacity);
+				return false;
+			}
+
+			allocator.Grow((uint32_t)capacity);
+		}
+
+		return true;
+	}
+
+	bool MeshArena::AllocateIndices(IndexType indexType, uint32_t count, uint32_t& offset)
+	{
+		ArenaAllocator& allocator = mIndexAllocators[(uint32_t)indexType];
+
+		while (!allocator.Allocate(count, offset))
+		{
+			uint64_t capacity = std::max<uint64_t>((uint64_t)allocator.GetCapacity() * 2, sInitialIndexCapacity);
+			capacity = std::max<uint64_t>(capacity, (uint64_t)allocator.GetUsed() + count);
+
+			if (capacity * GetIndexSize(indexType) > UINT32_MAX || !ResizeIndexBuffer(indexType, (uint32_t)capacity))
+			{
+				TS_CORE_ERROR("Mesh arena could not grow to {0} indices", capacity);
+				return false;
+			}
+
+			allocator.Grow((uint32_t)capacity);
+		}
+
+		return true;
+	}
+
+	void MeshArena::Defragment(uint32_t maxBytes)
+	{
+		uint32_t copiedBytes = 0;
+
+		for (uint32_t i = 0; i < sNumVertexFormats; i++)
+		{
+			while (copiedBytes < maxBytes && mVertexAllocators[i].HasHoles())
+			{
+				uint32_t bytes = CompactVertices((VertexFormat)i);
+
+				if (bytes == 0)
+					break;
+
+				copiedBytes += bytes;
+			}
+		}
+
+		for (uint32_t i = 0; i < sNumIndexTypes; i++)
+		{
+			while (copiedBytes < maxBytes && mIndexAllocators[i].HasHoles())
+			{
+				uint32_t bytes = CompactIndices((IndexType)i);
+
+				if (bytes == 0)
+					break;
+
+				copiedBytes += bytes;
+			}
+		}
+	}
+
+	uint32_t MeshArena::CompactVertices(VertexFormat vertexFormat)
+	{
+		ArenaAllocator& allocator = mVertexAllocators[(uint32_t)vertexFormat];
+		auto& ranges = mVertexRanges[(uint32_t)vertexFormat];
+
+		for (auto it = ranges.rbegin(); it != ranges.rend(); ++it)
+		{
+			MeshArenaAllocation& allocation = mAllocations[it->second - 1];
+			uint32_t destination = allocator.FindFirstFit(allocation.vertexCount);
+
+			// A block above would only move the fragmentation
+			if (destination == UINT32_MAX || destination > allocation.baseVertex)
+				continue;
+
+			Handle handle = it->second;
+			uint32_t source = allocation.baseVertex;
+			allocator.Allocate(allocation.vertexCount, destination);
+			CopyVertices(vertexFormat, source, destination, allocation.vertexCount);
+			allocator.Free(source, allocation.vertexCount);
+
+			ranges.erase(source);
+			ranges[destination] = handle;
+			allocation.baseVertex = destination;
+			mLayoutVersion++;
+
+			return allocation.vertexCount * VertexFormatUtils::GetStride(vertexFormat);
+		}
+
+		return 0;
+	}
+
+	uint32_t MeshArena::CompactIndices(IndexType indexType)
+	{
+		ArenaAllocator& allocator = mIndexAllocators[(uint32_t)indexType];
+		auto& ranges = mIndexRanges[(uint32_t)indexType];
+
+		for (auto it = ranges.rbegin(); it != ranges.rend(); ++it)
+		{
+			MeshArenaAllocation& allocation = mAllocations[it->second - 1];
+			uint32_t destination = allocator.FindFirstFit(allocation.indexCount);
+
+			if (destination == UINT32_MAX || destination > allocation.firstIndex)
+				continue;
+
+			Handle handle = it->second;
+			uint32_t source = allocation.firstIndex;
+			allocator.Allocate(allocation.indexCount, destination);
+			CopyIndices(indexType, source, destination, allocation.indexCount);
+			allocator.Free(source, allocation.indexCount);
+
+			ranges.erase(source);
+			ranges[destination] = handle;
+			allocation.firstIndex = destination;
+			mLayoutVersion++;
+
+			return allocation.indexCount * GetIndexSize(indexType);
+		}
+
+		return 0;
+	}
+}
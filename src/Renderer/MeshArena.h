@@ -0,0 +1,125 @@
+#pragma once
+#include "Renderer/Buffer.h"
+#include "Renderer/VertexFormat.h"
+#include <map>
+
+namespace TS_ENGINE {
+
+	/// <summary>
+	/// First fit free list over a range of elements. Adjacent free blocks are merged when freed.
+	/// </summary>
+	class ArenaAllocator
+	{
+	public:
+		// Returns false if no free block is large enough
+		bool Allocate(uint32_t size, uint32_t& offset);
+		void Free(uint32_t offset, uint32_t size);
+
+		// Appends the range between the current and the new capacity to the free list
+		void Grow(uint32_t capacity);
+
+		// Offset Allocate would return, UINT32_MAX if nothing fits
+		uint32_t FindFirstFit(uint32_t size) const;
+		// Free space between allocations, the free block at the end doesn't count
+		bool HasHoles() const;
+
+		uint32_t GetCapacity() const { return mCapacity; }
+		uint32_t GetUsed() const { return mUsed; }
+	private:
+		std::map<uint32_t, uint32_t> mFreeBlocks;		// Offset to size
+		uint32_t mCapacity = 0;
+		uint32_t mUsed = 0;
+	};
+
+	// Where a mesh lives in the arena. Offsets are in vertices and indices and change when the arena defragments.
+	struct MeshArenaAllocation
+	{
+		VertexFormat vertexFormat = VertexFormat::STANDARD;
+		IndexType indexType = IndexType::UINT32;
+		uint32_t baseVertex = 0;
+		uint32_t vertexCount = 0;
+		uint32_t firstIndex = 0;
+		uint32_t indexCount = 0;
+	};
+
+	/// <summary>
+	/// Shared GPU storage for mesh geometry. Each vertex format has one large vertex buffer and each index type one large
+	/// index buffer, suballocated with free lists and grown by doubling. Meshes keep indices relative to their first vertex
+	/// and are drawn with a base vertex, so all meshes of a format share one vertex array and their draws can be merged
+	/// into multi draw indirect calls. Freed space is compacted a little every frame by Defragment.
+	/// </summary>
+	class MeshArena
+	{
+	public:
+		typedef uint32_t Handle;
+		static constexpr Handle sInvalidHandle = 0;
+		static constexpr uint32_t sInitialVertexCapacity = 1 << 16;
+		static constexpr uint32_t sInitialIndexCapacity = 1 << 18;
+		static constexpr uint32_t sDefragmentBytesPerFrame = 1 << 20;
+
+		virtual ~MeshArena() = default;
+
+		/// <summary>
+		/// Copies packed vertices and indices into the arena. Indices are relative to the first vertex.
+		/// Returns sInvalidHandle if a buffer can't grow any further.
+		/// </summary>
+		Handle Allocate(VertexFormat vertexFormat, const void* vertexData, uint32_t vertexCount, IndexType indexType, const void* indexData, uint32_t indexCount);
+		void Free(Handle handle);
+		const MeshArenaAllocation& GetAllocation(Handle handle) const;
+
+		// Binds the vertex array shared by the meshes of a format and index type
+		virtual void Bind(VertexFormat vertexFormat, IndexType indexType) = 0;
+		// Draws index ranges of one allocation with the bound shader in one call. Ranges are relative to the allocation's first index.
+		virtual void DrawRanges(Handle handle, const IndexRange* ranges, uint32_t rangeCount) = 0;
+
+		/// <summary>
+		/// Moves allocations into free space below them, starting with the highest ones, until maxBytes were copied.
+		/// Copies stay on the GPU and are ordered after earlier draws, so it can run at any point in the frame.
+		/// </summary>
+		void Defragment(uint32_t maxBytes);
+		// Bumped whenever an allocation is freed or moved, so draws recorded with allocation offsets can tell they're stale
+		uint32_t GetLayoutVersion() const { return mLayoutVersion; }
+
+		static Ref<MeshArena> GetInstance();
+		// Drops the shared arena while the context is alive. Meshes still holding it keep it until they're destroyed.
+		static void Shutdown();
+	protected:
+		static constexpr uint32_t sNumVertexFormats = (uint32_t)VertexFormat::POSITION + 1;
+		static constexpr uint32_t sNumIndexTypes = (uint32_t)IndexType::UINT32 + 1;
+
+		static uint32_t GetIndexSize(IndexType indexType) { return indexType == IndexType::UINT16 ? sizeof(uint16_t) : sizeof(uint32_t); }
+
+		// Grows a buffer to capacity elements keeping its contents. Returns false if it couldn't be allocated.
+		virtual bool ResizeVertexBuffer(VertexFormat vertexFormat, uint32_t capacity) = 0;
+		virtual bool ResizeIndexBuffer(IndexType indexType, uint32_t capacity) = 0;
+
+		virtual void UploadVertices(VertexFormat vertexFormat, uint32_t offset, const void* data, uint32_t count) = 0;
+		virtual void UploadIndices(IndexType indexType, uint32_t offset, const void* data, uint32_t count) = 0;
+
+		// Source and destination ranges never overlap
+		virtual void CopyVertices(VertexFormat vertexFormat, uint32_t source, uint32_t destination, uint32_t count) = 0;
+		virtual void CopyIndices(IndexType indexType, uint32_t source, uint32_t destination, uint32_t count) = 0;
+
+		std::vector<MeshArenaAllocation> mAllocations;	// Indexed by handle - 1
+	private:
+		static Ref<MeshArena> mInstance;
+
+		// Grows the allocator and its buffer until size fits, then allocates
+		bool AllocateVertices(VertexFormat vertexFormat, uint32_t count, uint32_t& offset);
+		bool AllocateIndices(IndexType indexType, uint32_t count, uint32_t& offset);
+
+		// Moves the highest allocation of a pool that fits lower. Returns the bytes copied, 0 if nothing moved.
+		uint32_t CompactVertices(VertexFormat vertexFormat);
+		uint32_t CompactIndices(IndexType indexType);
+
+		ArenaAllocator mVertexAllocators[sNumVertexFormats];
+		ArenaAllocator mIndexAllocators[sNumIndexTypes];
+
+		// Live allocations of each pool ordered by offset, the highest are compacted first
+		std::map<uint32_t, Handle> mVertexRanges[sNumVertexFormats];
+		std::map<uint32_t, Handle> mIndexRanges[sNumIndexTypes];
+
+		std::vector<Handle> mFreeHandles;
+		uint32_t mLayoutVersion = 0;
+	};
+}
@@ -0,0 +1,130 @@
+#include "tspch.h"
+#include "Renderer/MipGenerator.h"
+#include "Core/JobSystem.h"
+
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include <stb_image_resize.h>
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TS_MIP_GENERATOR_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace TS_ENGINE {
+
+	uint32_t MipGenerator::GetLevelCount(uint32_t width, uint32_t height)
+	{
+		uint32_t levels = 1;
+
+		for (uint32_t size = std::max(width, height); size > 1; size >>= 1)
+			levels++;
+
+		return levels;
+	}
+
+	std::vector<std::vector<uint8_t>> MipGenerator::Generate(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels, bool srgb)
+	{
+		TS_CORE_ASSERT(channels >= 1 && channels <= 4);
+
+		std::vector<std::vector<uint8_t>> levels;
+		uint32_t levelCount = GetLevelCount(width, height);
+		levels.reserve(levelCount - 1);
+
+		const uint8_t* source = pixels;
+
+		for (uint32_t level = 1; level < levelCount; level++)
+		{
+			uint32_t sourceWidth = std::max(1u, width >> (level - 1));
+			uint32_t sourceHeight = std::max(1u, height >> (level - 1));
+
+			levels.emplace_back((size_t)std::max(1u, width >> level) * std::max(1u, height >> level) * channels);
+			Downsample(source, sourceWidth, sourceHeight, channels, srgb, levels.back().data());
+			source = levels.back().data();
+		}
+
+		return levels;
+	}
+
+	void MipGenerator::Downsample(const uint8_t* source, uint32_t width, uint32_t height, uint32_t channels, bool srgb, uint8_t* destination)
+	{
+		uint32_t destinationWidth = std::max(1u, width / 2);
+		uint32_t destinationHeight = std::max(1u, height / 2);
+
+		bool oddWidth = width > 1 && (width & 1);
+		bool oddHeight = height > 1 && (height & 1);
+
+		if (srgb || oddWidth || oddHeight)
+		{
+			int alphaChannel = (channels == 2 || channels == 4) ? (int)channels - 1 : STBIR_ALPHA_CHANNEL_NONE;
+
+			// Wraps at the edges like the REPEAT sampling of the textures
+			stbir_resize_uint8_generic(source, (int)width, (int)height, 0, destination, (int)destinationWidth, (int)destinationHeight, 0,
+				(int)channels, alphaChannel, 0, STBIR_EDGE_WRAP, STBIR_FILTER_BOX, srgb ? STBIR_COLORSPACE_SRGB : STBIR_COLORSPACE_LINEAR, nullptr);
+			return;
+		}
+
+		// One band per worker plus one for this thread, all inline when already on a worker
+		uint32_t numBands = JobSystem::IsWorkerThread() ? 1 : std::max(1u, std::min(JobSystem::GetInstance()->GetWorkerCount() + 1, destinationHeight / sMinBandRows));
+		uint32_t rowsPerBand = (destinationHeight + numBands - 1) / numBands;
+		std::vector<std::future<void>> bands;
+
+		for (uint32_t band = 1; band < numBands; band++)
+		{
+			uint32_t firstRow = band * rowsPerBand;
+			uint32_t endRow = std::min(firstRow + rowsPerBand, destinationHeight);
+			bands.push_back(JobSystem::GetInstance()->Async([=]() { DownsampleBand(source, width, height, channels, firstRow, endRow, destination); }));
+		}
+
+		DownsampleBand(source, width, height, channels, 0, std::min(rowsPerBand, destinationHeight), destination);
+
+		for (auto& band : bands)
+			band.wait();
+	}
+
+	void MipGenerator::DownsampleBand(const uint8_t* source, uint32_t width, uint32_t height, uint32_t channels, uint32_t firstRow, uint32_t endRow, uint8_t* destination)
+	{
+		uint32_t destinationWidth = std::max(1u, width / 2);
+		size_t sourceStride = (size_t)width * channels;
+
+		for (uint32_t row = firstRow; row < endRow; row++)
+		{
+			const uint8_t* top = &source[(size_t)(row * 2) * sourceStride];
+			const uint8_t* bottom = &source[(size_t)std::min(row * 2 + 1, height - 1) * sourceStride];
+			uint8_t* output = &destination[(size_t)row * destinationWidth * channels];
+			uint32_t x = 0;
+
+#ifdef TS_MIP_GENERATOR_SSE2
+			if (channels == 4 && width > 1)
+			{
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i rounding = _mm_set1_epi16(2);
+
+				// Four source texels of both rows make two output texels
+				for (; x + 2 <= destinationWidth; x += 2)
+				{
+					__m128i topTexels = _mm_loadu_si128((const __m128i*)(top + x * 8));
+					__m128i bottomTexels = _mm_loadu_si128((const __m128i*)(bottom + x * 8));
+
+					__m128i low = _mm_add_epi16(_mm_unpacklo_epi8(topTexels, zero), _mm_unpacklo_epi8(bottomTexels, zero));
+					__m128i high = _mm_add_epi16(_mm_unpackhi_epi8(topTexels, zero), _mm_unpackhi_epi8(bottomTexels, zero));
+
+					// Adds each texel's neighbour, held in the other 64-bit half
+					low = _mm_add_epi16(low, _mm_shuffle_epi32(low, _MM_SHUFFLE(1, 0, 3, 2)));
+					high = _mm_add_epi16(high, _mm_shuffle_epi32(high, _MM_SHUFFLE(1, 0, 3, 2)));
+
+					__m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(low, high), rounding), 2);
+					_mm_storel_epi64((__m128i*)(output + x * 4), _mm_packus_epi16(sum, zero));
+				}
+			}
+#endif
+			for (; x < destinationWidth; x++)
+			{
+				uint32_t left = x * 2 * channels;
+				uint32_t right = std::min(x * 2 + 1, width - 1) * channels;
+
+				for (uint32_t c = 0; c < channels; c++)
+					output[x * channels + c] = (uint8_t)((top[left + c] + top[right + c] + bottom[left + c] + bottom[right + c] + 2) >> 2);
+			}
+		}
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "Core/tspch.h"
+#include "Core/Base.h"
+
+namespace TS_ENGINE {
+
+	/// <summary>
+	/// Builds mip chains of 8-bit images on the CPU, each level half the size of the one above down to 1x1, following
+	/// GL's level sizes. Even sized linear levels use a 2x2 box filter in parallel row bands, with SSE2 for four channels.
+	/// Odd sized levels, whose texels straddle three source texels, and sRGB colors, which have to be averaged in linear
+	/// space, are filtered by stb_image_resize.
+	/// </summary>
+	class MipGenerator
+	{
+	public:
+		// Levels of a full chain, including the image itself
+		static uint32_t GetLevelCount(uint32_t width, uint32_t height);
+
+		// Levels 1 and below of tightly packed texels
+		static std::vector<std::vector<uint8_t>> Generate(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels, bool srgb);
+	private:
+		static constexpr uint32_t sMinBandRows = 32;
+
+		static void Downsample(const uint8_t* source, uint32_t width, uint32_t height, uint32_t channels, bool srgb, uint8_t* destination);
+		// Box filters destination rows [firstRow, endRow). A source of width or height 1 repeats its only column or row.
+		static void DownsampleBand(const uint8_t* source, uint32_t width, uint32_t height, uint32_t channels, uint32_t firstRow, uint32_t endRow, uint8_t* destination);
+	};
+}
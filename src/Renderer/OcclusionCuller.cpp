@@ -0,0 +1,350 @@
+#include "tspch.h"
+#include "OcclusionCuller.h"
+#include "Core/JobSystem.h"
+#include <chrono>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define TS_OCCLUSION_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace TS_ENGINE {
+
+	static constexpr float sMinClipW = 1e-4f;
+	static constexpr uint32_t sMinBandRows = 8;
+
+	OcclusionCuller::OcclusionCuller() :
+		mProjectionViewMatrix(Matrix4(1))
+	{
+		static_assert(sWidth % 4 == 0, "Depth buffer rows are processed 4 pixels at a time");
+
+		mDepthBuffer.resize(sWidth * sHeight, 1.0f);
+
+		for (uint32_t width = sWidth / 2, height = sHeight / 2; ; width /= 2, height /= 2)
+		{
+			width = std::max(width, 1u);
+			height = std::max(height, 1u);
+			mPyramid.emplace_back(width * height, 1.0f);
+
+			if (width == 1 && height == 1)
+				break;
+		}
+	}
+
+	void OcclusionCuller::BeginFrame(const Matrix4& projectionViewMatrix)
+	{
+		mProjectionViewMatrix = projectionViewMatrix;
+		mTriangles.clear();
+		std::fill(mDepthBuffer.begin(), mDepthBuffer.end(), 1.0f);
+		mStats = Stats();
+	}
+
+	void OcclusionCuller::AddOccluder(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const Matrix4& worldMatrix)
+	{
+		Matrix4 clipMatrix = mProjectionViewMatrix * worldMatrix;
+
+		std::vector<Vector4> clipPositions(vertices.size());
+
+		for (size_t i = 0; i < vertices.size(); i++)
+			clipPositions[i] = clipMatrix * Vector4(Vector3(vertices[i].position), 1.0f);
+
+		auto toScreen = [](const Vector4& clip)
+			{
+				Vector3 ndc = Vector3(clip) / clip.w;
+				return Vector3((ndc.x * 0.5f + 0.5f) * sWidth, (ndc.y * 0.5f + 0.5f) * sHeight, ndc.z * 0.5f + 0.5f);
+			};
+
+		uint32_t numTriangles = 0;
+
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			const Vector4& c0 = clipPositions[indices[i]];
+			const Vector4& c1 = clipPositions[indices[i + 1]];
+			const Vector4& c2 = clipPositions[indices[i + 2]];
+
+			// Dropping triangles that cross the near plane only makes the occluder smaller, which stays conservative
+			if (c0.w < sMinClipW || c1.w < sMinClipW || c2.w < sMinClipW ||
+				c0.z < -c0.w || c1.z < -c1.w || c2.z < -c2.w)
+				continue;
+
+			ScreenTriangle triangle;
+			triangle.v0 = toScreen(c0);
+			triangle.v1 = toScreen(c1);
+			triangle.v2 = toScreen(c2);
+
+			// Off screen
+			float minX = std::min({ triangle.v0.x, triangle.v1.x, triangle.v2.x });
+			float maxX = std::max({ triangle.v0.x, triangle.v1.x, triangle.v2.x });
+			float minY = std::min({ triangle.v0.y, triangle.v1.y, triangle.v2.y });
+			float maxY = std::max({ triangle.v0.y, triangle.v1.y, triangle.v2.y });
+
+			if (maxX < 0.0f || maxY < 0.0f || minX >= (float)sWidth || minY >= (float)sHeight)
+				continue;
+
+			mTriangles.push_back(triangle);
+			numTriangles++;
+		}
+
+		mStats.occluders++;
+		mStats.occluderTriangles += numTriangles;
+	}
+
+	void OcclusionCuller::Rasterize()
+	{
+		auto startTime = std::chrono::high_resolution_clock::now();
+
+		// One band per worker plus one for this thread
+		uint32_t numBands = std::min(JobSystem::GetInstance()->GetWorkerCount() + 1, sHeight / sMinBandRows);
+		uint32_t rowsPerBand = (sHeight + numBands - 1) / numBands;
+
+		if (mTriangles.empty())
+		{
+			numBands = 0;
+		}
+
+		std::vector<std::future<void>> bands;
+
+		for (uint32_t band = 1; band < numBands; band++)
+		{
+			uint32_t firstRow = band * rowsPerBand;
+			uint32_t endRow = std::min(firstRow + rowsPerBand, sHeight);
+			bands.push_back(JobSystem::GetInstance()->Async([this, firstRow, endRow]() { RasterizeBand(firstRow, endRow); }));
+		}
+
+		if (numBands > 0)
+			RasterizeBand(0, std::min(rowsPerBand, sHeight));
+
+		for (auto& band : bands)
+			band.wait();
+
+		BuildPyramid();
+
+		mStats.rasterizeTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+	}
+
+	void OcclusionCuller::RasterizeBand(uint32_t firstRow, uint32_t endRow)
+	{
+		for (const ScreenTriangle& triangle : mTriangles)
+			RasterizeTriangle(triangle, firstRow, endRow);
+	}
+
+	void OcclusionCuller::RasterizeTriangle(const ScreenTriangle& triangle, uint32_t firstRow, uint32_t endRow)
+	{
+		Vector3 v0 = triangle.v0;
+		Vector3 v1 = triangle.v1;
+		Vector3 v2 = triangle.v2;
+
+		float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+
+		if (fabsf(area) < 1e-6f)
+			return;
+
+		// Counter clockwise so the inside is where all edge functions are positive
+		if (area < 0.0f)
+		{
+			std::swap(v1, v2);
+			area = -area;
+		}
+
+		int minY = std::max((int)firstRow, (int)floorf(std::min({ v0.y, v1.y, v2.y })));
+		int maxY = std::min((int)endRow - 1, (int)ceilf(std::max({ v0.y, v1.y, v2.y })));
+
+		if (minY > maxY)
+			return;
+
+		int minX = std::max(0, (int)floorf(std::min({ v0.x, v1.x, v2.x }))) & ~3;
+		int maxX = std::min((int)sWidth - 1, (int)ceilf(std::max({ v0.x, v1.x, v2.x })));
+
+		// Edge function of a -> b is A * x + B * y + C
+		auto edge = [](const Vector3& a, const Vector3& b)
+			{
+				float A = a.y - b.y;
+				float B = b.x - a.x;
+				return Vector3(A, B, -(A * a.x + B * a.y));
+			};
+
+		Vector3 e0 = edge(v1, v2);
+		Vector3 e1 = edge(v2, v0);
+		Vector3 e2 = edge(v0, v1);
+
+		float dzdx = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+		float dzdy = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+		float z0 = v0.z - dzdx * v0.x - dzdy * v0.y;	// Depth at the origin
+
+		for (int y = minY; y <= maxY; y++)
+		{
+			float pixelY = y + 0.5f;
+			float* row = &mDepthBuffer[y * sWidth];
+
+#ifdef TS_OCCLUSION_SSE
+			__m128 rowE0 = _mm_set1_ps(e0.y * pixelY + e0.z);
+			__m128 rowE1 = _mm_set1_ps(e1.y * pixelY + e1.z);
+			__m128 rowE2 = _mm_set1_ps(e2.y * pixelY + e2.z);
+			__m128 rowZ = _mm_set1_ps(z0 + dzdy * pixelY);
+			__m128 zero = _mm_setzero_ps();
+			__m128 one = _mm_set1_ps(1.0f);
+
+			for (int x = minX; x <= maxX; x += 4)
+			{
+				__m128 pixelX = _mm_add_ps(_mm_set1_ps((float)x), _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f));
+
+				__m128 w0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(e0.x), pixelX), rowE0);
+				__m128 w1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(e1.x), pixelX), rowE1);
+				__m128 w2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(e2.x), pixelX), rowE2);
+
+				__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(w0, zero), _mm_cmpge_ps(w1, zero)), _mm_cmpge_ps(w2, zero));
+
+				if (_mm_movemask_ps(inside) == 0)
+					continue;
+
+				__m128 depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(dzdx), pixelX), rowZ);
+				depth = _mm_min_ps(_mm_max_ps(depth, zero), one);
+
+				__m128 previous = _mm_loadu_ps(row + x);
+				__m128 closer = _mm_min_ps(previous, depth);
+				_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, closer), _mm_andnot_ps(inside, previous)));
+			}
+#else
+			for (int x = minX; x <= maxX; x++)
+			{
+				float pixelX = x + 0.5f;
+
+				if (e0.x * pixelX + e0.y * pixelY + e0.z < 0.0f ||
+					e1.x * pixelX + e1.y * pixelY + e1.z < 0.0f ||
+					e2.x * pixelX + e2.y * pixelY + e2.z < 0.0f)
+					continue;
+
+				float depth = glm::clamp(z0 + dzdx * pixelX + dzdy * pixelY, 0.0f, 1.0f);
+				row[x] = std::min(row[x], depth);
+			}
+#endif
+		}
+	}
+
+	void OcclusionCuller::BuildPyramid()
+	{
+		const float* source = mDepthBuffer.data();
+		uint32_t sourceWidth = sWidth;
+		uint32_t sourceHeight = sHeight;
+
+		// Each texel keeps the farthest depth below it, so a box in front of it is in front of everything it covers
+		for (auto& level : mPyramid)
+		{
+			uint32_t width = std::max(sourceWidth / 2, 1u);
+			uint32_t height = std::max(sourceHeight / 2, 1u);
+
+			for (uint32_t y = 0; y < height; y++)
+			{
+				uint32_t y0 = std::min(y * 2, sourceHeight - 1);
+				uint32_t y1 = std::min(y * 2 + 1, sourceHeight - 1);
+
+				for (uint32_t x = 0; x < width; x++)
+				{
+					uint32_t x0 = std::min(x * 2, sourceWidth - 1);
+					uint32_t x1 = std::min(x * 2 + 1, sourceWidth - 1);
+
+					level[y * width + x] = std::max(
+						std::max(source[y0 * sourceWidth + x0], source[y0 * sourceWidth + x1]),
+						std::max(source[y1 * sourceWidth + x0], source[y1 * sourceWidth + x1]));
+				}
+			}
+
+			source = level.data();
+			sourceWidth = width;
+			sourceHeight = height;
+		}
+	}
+
+	bool OcclusionCuller::ProjectBounds(const AABB& worldBounds, const Matrix4& projectionViewMatrix, Vector2& screenMin, Vector2& screenMax, float& minDepth)
+	{
+		screenMin = Vector2(FLT_MAX);
+		screenMax = Vector2(-FLT_MAX);
+		minDepth = FLT_MAX;
+
+		for (int i = 0; i < 8; i++)
+		{
+			Vector3 corner(
+				(i & 1) ? worldBounds.max.x : worldBounds.min.x,
+				(i & 2) ? worldBounds.max.y : worldBounds.min.y,
+				(i & 4) ? worldBounds.max.z : worldBounds.min.z);
+
+			Vector4 clip = projectionViewMatrix * Vector4(corner, 1.0f);
+
+			if (clip.w < sMinClipW || clip.z < -clip.w)
+				return false;
+
+			Vector3 ndc = Vector3(clip) / clip.w;
+			Vector2 screen((ndc.x * 0.5f + 0.5f) * sWidth, (ndc.y * 0.5f + 0.5f) * sHeight);
+
+			screenMin = glm::min(screenMin, screen);
+			screenMax = glm::max(screenMax, screen);
+			minDepth = std::min(minDepth, ndc.z * 0.5f + 0.5f);
+		}
+
+		return true;
+	}
+
+	float OcclusionCuller::GetScreenCoverage(const AABB& worldBounds, const Matrix4& projectionViewMatrix)
+	{
+		Vector2 screenMin, screenMax;
+		float minDepth;
+
+		if (!ProjectBounds(worldBounds, projectionViewMatrix, screenMin, screenMax, minDepth))
+			return 1.0f;
+
+		screenMin = glm::clamp(screenMin, Vector2(0.0f), Vector2((float)sWidth, (float)sHeight));
+		screenMax = glm::clamp(screenMax, Vector2(0.0f), Vector2((float)sWidth, (float)sHeight));
+
+		return (screenMax.x - screenMin.x) * (screenMax.y - screenMin.y) / (float)(sWidth * sHeight);
+	}
+
+	bool OcclusionCuller::IsOccluded(const AABB& worldBounds)
+	{
+		mStats.testedBoxes++;
+
+		if (mStats.occluderTriangles == 0)
+			return false;
+
+		Vector2 screenMin, screenMax;
+		float minDepth;
+
+		// Boxes crossing the near plane are too close to be hidden
+		if (!ProjectBounds(worldBounds, mProjectionViewMatrix, screenMin, screenMax, minDepth))
+			return false;
+
+		int x0 = std::max(0, (int)floorf(screenMin.x));
+		int y0 = std::max(0, (int)floorf(screenMin.y));
+		int x1 = std::min((int)sWidth - 1, (int)floorf(screenMax.x));
+		int y1 = std::min((int)sHeight - 1, (int)floorf(screenMax.y));
+
+		// Off screen, left to frustum culling
+		if (x0 > x1 || y0 > y1)
+			return false;
+
+		// Coarsest level where the box covers at most 2x2 texels
+		uint32_t level = 0;
+
+		while (level < mPyramid.size() && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1))
+			level++;
+
+		const float* depth = level == 0 ? mDepthBuffer.data() : mPyramid[level - 1].data();
+		uint32_t levelWidth = std::max(sWidth >> level, 1u);
+		uint32_t levelHeight = std::max(sHeight >> level, 1u);
+
+		float maxDepth = 0.0f;
+
+		for (int y = y0 >> level; y <= std::min(y1 >> level, (int)levelHeight - 1); y++)
+		{
+			for (int x = x0 >> level; x <= std::min(x1 >> level, (int)levelWidth - 1); x++)
+				maxDepth = std::max(maxDepth, depth[y * levelWidth + x]);
+		}
+
+		if (minDepth > maxDepth)
+		{
+			mStats.occludedBoxes++;
+			return true;
+		}
+
+		return false;
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "Renderer/Bounds.h"
+#include "Primitive/Mesh.h"
+
+namespace TS_ENGINE {
+
+	/// <summary>
+	/// Software occlusion culling. Large occluders are rasterized into a low resolution CPU depth buffer
+	/// (4 pixels per SSE step, horizontal bands split across JobSystem workers), then reduced to a max depth pyramid.
+	/// Bounding boxes are tested against the pyramid level where they cover at most 2x2 texels.
+	/// Does not touch the GPU, so it can run headless.
+	/// </summary>
+	class OcclusionCuller
+	{
+	public:
+		struct Stats
+		{
+			uint32_t occluders = 0;
+			uint32_t occluderTriangles = 0;
+			uint32_t testedBoxes = 0;
+			uint32_t occludedBoxes = 0;
+			float rasterizeTime = 0.0f;		// Milliseconds
+		};
+
+		static constexpr uint32_t sWidth = 256;
+		static constexpr uint32_t sHeight = 128;
+
+		OcclusionCuller();
+
+		// Clears the depth buffer and the stats
+		void BeginFrame(const Matrix4& projectionViewMatrix);
+		// Transforms and sets up the occluder's triangles. Triangles crossing the near plane are dropped.
+		void AddOccluder(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const Matrix4& worldMatrix);
+		// Rasterizes all added occluders and builds the depth pyramid
+		void Rasterize();
+
+		// True if the world space box is completely hidden behind occluders
+		bool IsOccluded(const AABB& worldBounds);
+
+		// Fraction of the screen covered by the projected box, 1 if it crosses the near plane
+		static float GetScreenCoverage(const AABB& worldBounds, const Matrix4& projectionViewMatrix);
+
+		const Stats& GetStats() const { return mStats; }
+		// Depth in [0, 1] per pixel, bottom row first
+		const std::vector<float>& GetDepthBuffer() const { return mDepthBuffer; }
+	private:
+		struct ScreenTriangle
+		{
+			Vector3 v0, v1, v2;		// Pixel x, pixel y, depth
+		};
+
+		// Projects the box, returns false if it crosses the near plane
+		static bool ProjectBounds(const AABB& worldBounds, const Matrix4& projectionViewMatrix, Vector2& screenMin, Vector2& screenMax, float& minDepth);
+
+		void RasterizeBand(uint32_t firstRow, uint32_t endRow);
+		void RasterizeTriangle(const ScreenTriangle& triangle, uint32_t firstRow, uint32_t endRow);
+		void BuildPyramid();
+
+		Matrix4 mProjectionViewMatrix;
+		std::vector<ScreenTriangle> mTriangles;
+		std::vector<float> mDepthBuffer;
+		std::vector<std::vector<float>> mPyramid;	// Level 1 and up, level 0 is the depth buffer
+		Stats mStats;
+	};
+}
@@ -38,6 +38,11 @@ namespace TS_ENGINE {
 			sRendererAPI->DrawIndexed(vertexArray, indexCount);
 		}
 
+		static void DrawIndexedRanges(const Ref<VertexArray>& vertexArray, const std::vector<IndexRange>& ranges)
+		{
+			sRendererAPI->DrawIndexedRanges(vertexArray, ranges);
+		}
+
 		static void DrawLines(const Ref<VertexArray>& vertexArray, uint32_t vertexCount)
 		{
 			sRendererAPI->DrawLines(vertexArray, vertexCount);
@@ -57,5 +62,35 @@ namespace TS_ENGINE {
 		{
 			sRendererAPI->EnableAlphaBlending(enable);
 		}
+
+		static void EnableDepthWrite(bool enable)
+		{
+			sRendererAPI->EnableDepthWrite(enable);
+		}
+
+		static void ClearDepth()
+		{
+			sRendererAPI->ClearDepth();
+		}
+
+		static void EnableScissorTest(bool enable)
+		{
+			sRendererAPI->EnableScissorTest(enable);
+		}
+
+		static void SetScissor(int x, int y, int width, int height)
+		{
+			sRendererAPI->SetScissor(x, y, width, height);
+		}
+
+		static void EnableBackFaceCulling(bool enable)
+		{
+			sRendererAPI->EnableBackFaceCulling(enable);
+		}
+
+		static bool IsBackFaceCullingEnabled()
+		{
+			return sRendererAPI->IsBackFaceCullingEnabled();
+		}
 	};
 }
@@ -21,6 +21,7 @@ namespace TS_ENGINE {
 		virtual void Clear() = 0;
 		
 		virtual void DrawIndexed(const Ref<VertexArray>& vertexArray, uint32_t indexCount = 0) = 0;
+		virtual void DrawIndexedRanges(const Ref<VertexArray>& vertexArray, const std::vector<IndexRange>& ranges) = 0;	// One draw call for all ranges
 		virtual void DrawLines(const Ref<VertexArray>& vertexArray, uint32_t vertexCount) = 0;
 
 		virtual void SetLineWidth(float width) = 0;
@@ -28,6 +29,12 @@ namespace TS_ENGINE {
 		virtual void EnableDepthTest(bool enable) = 0;		// Depth Test
 		virtual void EnableAlphaBlending(bool enable) = 0;	// Alpha Test
 		virtual void EnableWireframe(bool _enabled) = 0;	// Wireframe
+		virtual void EnableDepthWrite(bool enable) = 0;		// Depth Writes
+		virtual void ClearDepth() = 0;						// Depth Only, Limited To The Scissor Box When Enabled
+		virtual void EnableScissorTest(bool enable) = 0;	// Scissor Test
+		virtual void SetScissor(int x, int y, int width, int height) = 0;
+		virtual void EnableBackFaceCulling(bool enable) = 0;	// Back Face Culling, Off By Default
+		virtual bool IsBackFaceCullingEnabled() const = 0;
 
 		static API GetAPI() 
 		{
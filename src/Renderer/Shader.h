@@ -13,6 +13,8 @@ namespace TS_ENGINE {
 		virtual void Unbind() const = 0;
 
 		virtual const std::string& GetName() const = 0;
+		// False for uniforms the program doesn't declare or the compiler removed
+		virtual bool HasUniform(const char* name) const = 0;
 
 		virtual void SetBool(const char* name, bool value) = 0;
 		virtual void SetInt(const char* name, int value) = 0;
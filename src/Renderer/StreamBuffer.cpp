@@ -0,0 +1,22 @@
+#include "tspch.h"
+#include "Renderer/StreamBuffer.h"
+#include "Platform/OpenGL/OpenGLStreamBuffer.h"
+
+namespace TS_ENGINE {
+
+	Ref<StreamBuffer> StreamBuffer::mInstance = nullptr;
+
+	Ref<StreamBuffer> StreamBuffer::GetInstance()
+	{
+		if (mInstance == nullptr)
+			mInstance = Create(sDefaultFrameCapacity);
+
+		return mInstance;
+	}
+
+	Ref<StreamBuffer> StreamBuffer::Create(uint32_t frameCapacity)
+	{
+		//ToDo: Add support for multiple APIs
+		return CreateRef<OpenGLStreamBuffer>(frameCapacity);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+#include "Core/Base.h"
+
+namespace TS_ENGINE {
+
+	/// <summary>
+	/// Persistently mapped ring for data written by the CPU every frame. The buffer is split into sFrameCount regions,
+	/// one per frame in flight. Each region is fenced when its frame ends and only written again once the GPU passed the fence,
+	/// so the CPU never waits on a buffer the GPU still reads unless it runs sFrameCount frames ahead.
+	/// Draws source per-frame geometry straight from their allocations, which are only valid for the frame they were made in.
+	/// </summary>
+	class StreamBuffer
+	{
+	public:
+		static constexpr uint32_t sFrameCount = 3;
+		static constexpr uint32_t sDefaultFrameCapacity = 4 << 20;
+
+		virtual ~StreamBuffer() = default;
+
+		/// <summary>
+		/// Reserves size bytes in the current frame's region. Returns the mapped memory and its offset in the buffer,
+		/// nullptr if the region has no room left (the caller falls back to a regular upload).
+		/// </summary>
+		virtual void* Allocate(uint32_t size, uint32_t alignment, uint32_t& offset) = 0;
+
+		// Fences the current region and moves on to the next one. Called once a frame after the buffers are swapped.
+		virtual void NextFrame() = 0;
+
+		virtual uint32_t GetRendererID() const = 0;
+		// Number of NextFrame calls, an allocation made in an earlier frame may already be overwritten
+		virtual uint64_t GetFrameIndex() const = 0;
+
+		static Ref<StreamBuffer> GetInstance();
+		static Ref<StreamBuffer> Create(uint32_t frameCapacity);
+	private:
+		static Ref<StreamBuffer> mInstance;
+	};
+}
@@ -1,11 +1,19 @@
 #include "tspch.h"
 #include <Renderer/Texture.h>
 #include "Platform/OpenGL/OpenGLTexture.h"
+#include "Renderer/TextureArray.h"
+#include "Renderer/TextureStreamer.h"
+#include "Renderer/TextureCompressor.h"
+#include "Renderer/GPUMemory.h"
+#include "Renderer/MaterialManager.h"
+#include "Application.h"
 
 namespace TS_ENGINE {
 
 	std::map<std::string, uint32_t> Texture2D::mTextureStrAndIdMap;
 	std::map<uint32_t, Ref<TS_ENGINE::Texture2D>> Texture2D::mTextureIdAndTexture2DMap;
+	std::map<uint64_t, uint32_t> Texture2D::mTextureHashAndIdMap;
+	uint32_t Texture2D::sArrayLayerVersion = 0;
 
 	Ref<Texture2D> Texture2D::Create(uint32_t width, uint32_t height)
 	{
@@ -13,7 +21,7 @@ namespace TS_ENGINE {
 		return CreateRef<OpenGLTexture2D>(width, height);
 	}
 
-	Ref<Texture2D> Texture2D::Create(const std::string& path)
+	Ref<Texture2D> Texture2D::Create(const std::string& path, TextureUsage usage)
 	{
 		//TODO: Add support for more APIs
 		if (mTextureStrAndIdMap.find(path) != mTextureStrAndIdMap.end())
@@ -22,29 +30,108 @@ namespace TS_ENGINE {
 			return mTextureIdAndTexture2DMap[mTextureStrAndIdMap[path]];
 		}
 
-		Ref<OpenGLTexture2D> tex2D = CreateRef<OpenGLTexture2D>(path);
+		Ref<Texture2D> tex2D;
+
+		// Streamed textures are registered under their placeholder's ID
+		if (Application::GetInstance().mTextureStreaming)
+			tex2D = TextureStreamer::GetInstance()->Load(path, GetImportSettings(usage));
+		else
+			tex2D = CreateRef<OpenGLTexture2D>(path, GetImportSettings(usage));
+
 		mTextureStrAndIdMap[path] = tex2D->GetRendererID();
 		mTextureIdAndTexture2DMap[tex2D->GetRendererID()] = tex2D;
+
+		// Streamed textures join arrays once they're complete
+		if (Application::GetInstance().mTextureArrays && !tex2D->IsStreaming())
+			TextureArrayManager::GetInstance()->Add(tex2D);
+
+		GPUMemoryManager::GetInstance()->Register(tex2D);
 		return tex2D;
 	}
 
-	Ref<Texture2D> Texture2D::Create(const char* name, const unsigned char* pixelData, uint32_t len)
+	Ref<Texture2D> Texture2D::Create(const char* name, const unsigned char* pixelData, uint32_t len, TextureUsage usage, bool keepPixels)
 	{
 		//TODO: Add support for more APIs
-		/*if (mTextureStrAndIdMap.find(name) != mTextureStrAndIdMap.end())
+		// Embedded names like "*0" repeat across models, so embedded textures are shared by their encoded bytes
+		TextureImportSettings settings = GetImportSettings(usage);
+		uint64_t contentKey = TextureCompressor::GetMemoryCacheKey(pixelData, len, settings, false);
+		auto it = mTextureHashAndIdMap.find(contentKey);
+
+		if (it != mTextureHashAndIdMap.end())
 		{
-			TS_CORE_INFO("Texture from path {0} already loaded", name);
-			return mTextureIdAndTexture2DMap[mTextureStrAndIdMap[name]];
-		}*/
+			Ref<Texture2D> texture = mTextureIdAndTexture2DMap[it->second];
+
+			// A shared texture without pixels can't serve a caller asking for them, which gets a copy of its own
+			if (!keepPixels || !texture->GetPixels().empty())
+			{
+				TS_CORE_INFO("Embedded texture {0} already loaded", name);
+				return texture;
+			}
+		}
+
+		Ref<Texture2D> tex2D;
 
-		Ref<OpenGLTexture2D> tex2D = CreateRef<OpenGLTexture2D>(name, pixelData, len);
-		mTextureStrAndIdMap[name] = tex2D->GetRendererID();
+		if (Application::GetInstance().mTextureStreaming)
+			tex2D = TextureStreamer::GetInstance()->Load(name, pixelData, len, settings, keepPixels);
+		else
+			tex2D = CreateRef<OpenGLTexture2D>(name, pixelData, len, settings, keepPixels);
+
+		mTextureHashAndIdMap[contentKey] = tex2D->GetRendererID();
 		mTextureIdAndTexture2DMap[tex2D->GetRendererID()] = tex2D;
+
+		// Streamed textures join arrays once they're complete
+		if (Application::GetInstance().mTextureArrays && !tex2D->IsStreaming())
+			TextureArrayManager::GetInstance()->Add(tex2D);
+
+		GPUMemoryManager::GetInstance()->Register(tex2D);
 		return tex2D;
 	}
 
+	TextureImportSettings Texture2D::GetImportSettings(TextureUsage usage)
+	{
+		const Application& application = Application::GetInstance();
+
+		TextureImportSettings settings;
+		settings.usage = usage;
+		settings.srgb = application.mSRGBTextures;
+		settings.compress = application.mTextureCompression;
+		settings.preferBC7 = application.mBC7Textures;
+		settings.twoChannelNormals = MaterialManager::GetInstance()->RebuildsNormalZ();
+		settings.mipmaps = application.mMipmaps;
+		settings.anisotropy = application.mTextureAnisotropy;
+		return settings;
+	}
+
+	void Texture2D::MarkUsed() const
+	{
+		mLastUsedFrame = GPUMemoryManager::GetInstance()->GetFrame();
+	}
+
 	const Ref<Texture2D> Texture2D::GetTextureFromID(uint32_t texID)
 	{
 		return mTextureIdAndTexture2DMap[texID];
 	}
+
+	void Texture2D::ReplaceRendererID(uint32_t oldTexID, uint32_t newTexID)
+	{
+		auto it = mTextureIdAndTexture2DMap.find(oldTexID);
+
+		if (it == mTextureIdAndTexture2DMap.end())
+			return;
+
+		mTextureIdAndTexture2DMap[newTexID] = it->second;
+		mTextureIdAndTexture2DMap.erase(oldTexID);
+
+		for (auto& [path, texID] : mTextureStrAndIdMap)
+		{
+			if (texID == oldTexID)
+				texID = newTexID;
+		}
+
+		for (auto& [contentKey, texID] : mTextureHashAndIdMap)
+		{
+			if (texID == oldTexID)
+				texID = newTexID;
+		}
+	}
 }
\ No newline at end of file
@@ -5,6 +5,35 @@
 
 namespace TS_ENGINE {
 
+	// Layer of a texture array holding a texture, see TextureArrayManager
+	struct TextureArrayLayer
+	{
+		uint32_t array = UINT32_MAX;
+		uint32_t layer = 0;
+
+		bool IsValid() const { return array != UINT32_MAX; }
+	};
+
+	// What a texture's texels hold, which decides its storage format
+	enum class TextureUsage
+	{
+		Color,			// Albedo and other colors, sRGB if enabled
+		Data,			// Linear values such as specular or masks
+		NormalMap		// Tangent space normals, compressed to two channels if the shaders rebuild z from x and y
+	};
+
+	// How a texture is stored on import, see Texture2D::Create
+	struct TextureImportSettings
+	{
+		TextureUsage usage = TextureUsage::Color;
+		bool srgb = false;				// Color textures are sampled as linear
+		bool compress = false;			// Block compressed on worker threads and cached on disk
+		bool preferBC7 = false;			// BC7 instead of BC1/BC3 for color
+		bool twoChannelNormals = false;	// BC5 for normal maps, the shaders declare u_NormalMapTwoChannel and rebuild z
+		bool mipmaps = false;			// Full mip chain, sampled trilinearly
+		float anisotropy = 1.0f;		// Maximum anisotropic samples, clamped to what the driver supports
+	};
+
 	class Texture
 	{	
 	public:
@@ -23,10 +52,12 @@ namespace TS_ENGINE {
 		virtual void SetVerticalFlip(bool flip) const = 0;		
 
 		virtual bool IsLoaded() const = 0;
+		// Levels are still being uploaded, see TextureStreamer
+		virtual bool IsStreaming() const = 0;
 
 		virtual bool operator==(const Texture& other) const = 0;
 		virtual unsigned char* GetPixelData() const = 0;
-		virtual std::vector<unsigned char> GetPixels() const = 0;
+		virtual const std::vector<unsigned char>& GetPixels() const = 0;
 
 		virtual void OverrideTextureID(uint32_t texID) = 0;
 	};
@@ -35,10 +66,13 @@ namespace TS_ENGINE {
 	{
 	public:
 		static Ref<Texture2D> Create(uint32_t width, uint32_t height);
-		static Ref<Texture2D> Create(const std::string& path);
-		static Ref<Texture2D> Create(const char* name, const unsigned char* pixelData, uint32_t len); 
+		static Ref<Texture2D> Create(const std::string& path, TextureUsage usage = TextureUsage::Color);
+		// Shared by every caller passing the same encoded bytes. keepPixels holds on to the decoded texels for CPU side atlasing.
+		static Ref<Texture2D> Create(const char* name, const unsigned char* pixelData, uint32_t len, TextureUsage usage = TextureUsage::Color, bool keepPixels = false);
 
 		static const Ref<Texture2D> GetTextureFromID(uint32_t texID);
+		// Keeps the registry pointing at a texture whose renderer ID was overridden
+		static void ReplaceRendererID(uint32_t oldTexID, uint32_t newTexID);
 		static const std::map<uint32_t, Ref<TS_ENGINE::Texture2D>> GetTextureIdAndTexture2DMap()
 		{
 			return mTextureIdAndTexture2DMap;
@@ -49,10 +83,47 @@ namespace TS_ENGINE {
 			return mPath;
 		}
 
+		// Residency, see GPUMemoryManager. Levels above the resident level are dropped from GPU memory.
+		virtual uint32_t GetLevelCount() const = 0;
+		virtual uint32_t GetResidentLevel() const = 0;
+		// Bytes of the levels from level down to the smallest
+		virtual uint64_t GetLevelBytes(uint32_t level) const = 0;
+		// Baked textures that aren't streaming or a layer of an array. Arrays change the levels of all their layers, see TextureArrayManager.
+		virtual bool CanChangeResidency() const = 0;
+		// Drops the levels above level, or reloads them from the baked container. False if the levels can't change.
+		virtual bool SetResidentLevel(uint32_t level) = 0;
+
+		// Keeps the texture's levels from being dropped first, called whenever it's bound for drawing
+		void MarkUsed() const;
+		uint64_t GetLastUsedFrame() const
+		{
+			return mLastUsedFrame;
+		}
+
+		// Set once the texture became a layer of a texture array
+		const TextureArrayLayer& GetArrayLayer() const
+		{
+			return mArrayLayer;
+		}
+		void SetArrayLayer(const TextureArrayLayer& arrayLayer)
+		{
+			mArrayLayer = arrayLayer;
+			sArrayLayerVersion++;
+		}
+		// Bumped whenever any texture gets an array layer
+		static uint32_t GetArrayLayerVersion() { return sArrayLayerVersion; }
+
 	private:
+		// Storage of textures imported with the usage, following the Application's texture flags
+		static TextureImportSettings GetImportSettings(TextureUsage usage);
+
 		static std::map<std::string, uint32_t> mTextureStrAndIdMap;
 		static std::map<uint32_t, Ref<TS_ENGINE::Texture2D>> mTextureIdAndTexture2DMap;
+		static std::map<uint64_t, uint32_t> mTextureHashAndIdMap;		// Embedded textures by their encoded bytes and import settings
+		static uint32_t sArrayLayerVersion;
 	protected:
 		std::string mPath;
+		TextureArrayLayer mArrayLayer;
+		mutable uint64_t mLastUsedFrame = 0;
 	};
 }
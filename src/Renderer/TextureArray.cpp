@@ -0,0 +1,206 @@
+#include "tspch.h"
+#include "Renderer/TextureArray.h"
+#include "Platform/OpenGL/OpenGLTextureArray.h"
+
+namespace TS_ENGINE {
+
+	Ref<TextureArrayManager> TextureArrayManager::mInstance = nullptr;
+
+	Ref<TextureArrayManager> TextureArrayManager::GetInstance()
+	{
+		//ToDo: Add support for multiple APIs
+		if (mInstance == nullptr)
+			mInstance = CreateRef<OpenGLTextureArrayManager>();
+
+		return mInstance;
+	}
+
+	TextureArrayLayer TextureArrayManager::Add(const Ref<Texture2D>& texture)
+	{
+		if (!texture || texture->GetArrayLayer().IsValid())
+			return texture ? texture->GetArrayLayer() : TextureArrayLayer();
+
+		ArrayFormat format;
+
+		if (!GetFormat(*texture, format))
+			return TextureArrayLayer();
+
+		uint32_t arrayIndex = 0;
+		uint32_t layer = UINT32_MAX;
+
+		// Levels an array dropped can only come back for textures with a baked container
+		bool bakedLevels = HasBakedLevels(*texture);
+
+		for (; arrayIndex < mArrays.size() && layer == UINT32_MAX; arrayIndex++)
+		{
+			if (mArrays[arrayIndex].format == format && (mArrays[arrayIndex].residentLevel == 0 || bakedLevels))
+				layer = AllocateLayer(mArrays[arrayIndex]);
+		}
+
+		if (layer != UINT32_MAX)
+		{
+			arrayIndex--;
+		}
+		else
+		{
+			Array array;
+			array.format = format;
+			mArrays.push_back(array);
+			layer = AllocateLayer(mArrays.back());
+
+			if (layer == UINT32_MAX)
+			{
+				mArrays.pop_back();
+				TS_CORE_WARN("Could not allocate a texture array for {0}", texture->GetPath());
+				return TextureArrayLayer();
+			}
+		}
+
+		Array& array = mArrays[arrayIndex];
+		CopyTextureToLayer(texture->GetRendererID(), array.rendererID, format, array.residentLevel, layer);
+		array.layers[layer] = texture;
+		MoveToView(*texture, CreateLayerView(array.rendererID, GetStorageFormat(format, array.residentLevel), layer, texture->GetRendererID()));
+
+		TextureArrayLayer arrayLayer;
+		arrayLayer.array = arrayIndex;
+		arrayLayer.layer = layer;
+		texture->SetArrayLayer(arrayLayer);
+		return arrayLayer;
+	}
+
+	uint32_t TextureArrayManager::AllocateLayer(Array& array)
+	{
+		for (uint32_t i = 0; i < array.layers.size(); i++)
+		{
+			if (array.layers[i].expired())
+				return i;
+		}
+
+		if (array.layers.size() == array.capacity && (array.capacity >= sMaxLayers || !Grow(array)))
+			return UINT32_MAX;
+
+		array.layers.emplace_back();
+		return (uint32_t)array.layers.size() - 1;
+	}
+
+	bool TextureArrayManager::Grow(Array& array)
+	{
+		uint32_t capacity = std::min(std::max(1u, array.capacity * 2), sMaxLayers);
+		ArrayFormat storageFormat = GetStorageFormat(array.format, array.residentLevel);
+		uint32_t rendererID = CreateArray(storageFormat, capacity);
+
+		if (rendererID == 0)
+			return false;
+
+		if (array.rendererID != 0)
+		{
+			CopyLayers(array.rendererID, array.residentLevel, rendererID, array.residentLevel, array.format, (uint32_t)array.layers.size());
+
+			// The old views keep the old storage alive until they are replaced
+			for (uint32_t i = 0; i < array.layers.size(); i++)
+			{
+				if (Ref<Texture2D> texture = array.layers[i].lock())
+					MoveToView(*texture, CreateLayerView(rendererID, storageFormat, i, texture->GetRendererID()));
+			}
+
+			DeleteTexture(array.rendererID);
+		}
+
+		array.rendererID = rendererID;
+		array.capacity = capacity;
+		return true;
+	}
+
+	uint64_t TextureArrayManager::GetLastUsedFrame(uint32_t array) const
+	{
+		uint64_t lastUsedFrame = 0;
+
+		for (const auto& layer : mArrays[array].layers)
+		{
+			if (Ref<Texture2D> texture = layer.lock())
+				lastUsedFrame = std::max(lastUsedFrame, texture->GetLastUsedFrame());
+		}
+
+		return lastUsedFrame;
+	}
+
+	bool TextureArrayManager::CanChangeResidency(uint32_t array) const
+	{
+		const Array& textureArray = mArrays[array];
+
+		if (textureArray.rendererID == 0 || textureArray.format.levels <= 1 || textureArray.residencyFixed)
+			return false;
+
+		for (const auto& layer : textureArray.layers)
+		{
+			Ref<Texture2D> texture = layer.lock();
+
+			if (texture && !HasBakedLevels(*texture))
+				return false;
+		}
+
+		return true;
+	}
+
+	bool TextureArrayManager::SetResidentLevel(uint32_t arrayIndex, uint32_t level)
+	{
+		if (!CanChangeResidency(arrayIndex) || level >= mArrays[arrayIndex].format.levels)
+			return false;
+
+		Array& array = mArrays[arrayIndex];
+
+		if (level == array.residentLevel)
+			return true;
+
+		ArrayFormat storageFormat = GetStorageFormat(array.format, level);
+		uint32_t rendererID = CreateArray(storageFormat, array.capacity);
+
+		if (rendererID == 0)
+			return false;
+
+		// Levels both storages have are copied on the GPU, restored ones are uploaded layer by layer
+		uint32_t layerCount = (uint32_t)array.layers.size();
+		CopyLayers(array.rendererID, array.residentLevel, rendererID, level, array.format, layerCount);
+
+		for (uint32_t i = 0; i < layerCount && level < array.residentLevel; i++)
+		{
+			Ref<Texture2D> texture = array.layers[i].lock();
+
+			if (texture && !UploadBakedLevels(*texture, rendererID, array.format, level, i, level, array.residentLevel))
+			{
+				TS_CORE_WARN("Baked container of texture {0} is gone, the levels of its array stay as they are", texture->GetPath());
+				array.residencyFixed = true;
+				DeleteTexture(rendererID);
+				return false;
+			}
+		}
+
+		for (uint32_t i = 0; i < layerCount; i++)
+		{
+			if (Ref<Texture2D> texture = array.layers[i].lock())
+				MoveToView(*texture, CreateLayerView(rendererID, storageFormat, i, texture->GetRendererID()));
+		}
+
+		DeleteTexture(array.rendererID);
+		array.rendererID = rendererID;
+		array.residentLevel = level;
+		return true;
+	}
+
+	TextureArrayManager::ArrayFormat TextureArrayManager::GetStorageFormat(const ArrayFormat& format, uint32_t residentLevel)
+	{
+		ArrayFormat storageFormat = format;
+		storageFormat.width = std::max(1u, format.width >> residentLevel);
+		storageFormat.height = std::max(1u, format.height >> residentLevel);
+		storageFormat.levels = format.levels - residentLevel;
+		return storageFormat;
+	}
+
+	void TextureArrayManager::MoveToView(Texture2D& texture, uint32_t view)
+	{
+		uint32_t oldTexID = texture.GetRendererID();
+		Texture2D::ReplaceRendererID(oldTexID, view);
+		texture.OverrideTextureID(view);
+		DeleteTexture(oldTexID);
+	}
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include "Renderer/Texture.h"
+
+namespace TS_ENGINE {
+
+	/// <summary>
+	/// Keeps textures of equal size, format and mip levels as layers of shared 2D texture arrays. A texture moved into a layer
+	/// becomes a view of it, so it keeps working as a plain 2D texture under a new renderer ID without using extra memory.
+	/// Shaders that sample the array draw materials with different textures of one array without rebinding, and the
+	/// dynamic batcher merges their meshes. Arrays grow by doubling up to sMaxLayers, then another array is opened.
+	/// </summary>
+	class TextureArrayManager
+	{
+	public:
+		static constexpr uint32_t sMaxLayers = 256;
+		static constexpr uint32_t sArraySlot = 8;		// Texture unit reserved for arrays
+
+		virtual ~TextureArrayManager() = default;
+
+		/// <summary>
+		/// Moves the texture into a layer and records it on the texture. Layers of destroyed textures are reused.
+		/// Returns an invalid layer if the texture can't be a layer or no array could be allocated.
+		/// </summary>
+		TextureArrayLayer Add(const Ref<Texture2D>& texture);
+
+		// Binds an array to sArraySlot, skipped while it's still bound there
+		virtual void Bind(uint32_t array) = 0;
+
+		uint32_t GetArrayCount() const { return (uint32_t)mArrays.size(); }
+		uint32_t GetLayerCount(uint32_t array) const { return (uint32_t)mArrays[array].layers.size(); }
+
+		// Residency, see GPUMemoryManager. The layers of an array share their levels, so the whole array drops or restores a level.
+		uint32_t GetLevelCount(uint32_t array) const { return mArrays[array].format.levels; }
+		uint32_t GetWidth(uint32_t array) const { return mArrays[array].format.width; }
+		uint32_t GetHeight(uint32_t array) const { return mArrays[array].format.height; }
+		uint32_t GetResidentLevel(uint32_t array) const { return mArrays[array].residentLevel; }
+		// Bytes of the levels from level down to the smallest, for all the layers the array has room for
+		virtual uint64_t GetLevelBytes(uint32_t array, uint32_t level) const = 0;
+		// Most recent frame a layer was used in
+		uint64_t GetLastUsedFrame(uint32_t array) const;
+		// Arrays with mip levels whose live layers all have a baked container to restore dropped levels from
+		bool CanChangeResidency(uint32_t array) const;
+		/// <summary>
+		/// Moves the array to storage without the levels above level, or with the dropped ones reloaded from the layers'
+		/// baked containers, and points the layers' textures at views of it. False if the levels can't change.
+		/// </summary>
+		bool SetResidentLevel(uint32_t array, uint32_t level);
+
+		static Ref<TextureArrayManager> GetInstance();
+	protected:
+		struct ArrayFormat
+		{
+			uint32_t width = 0;
+			uint32_t height = 0;
+			uint32_t internalFormat = 0;
+			uint32_t levels = 0;
+
+			bool operator==(const ArrayFormat& other) const
+			{
+				return width == other.width && height == other.height && internalFormat == other.internalFormat && levels == other.levels;
+			}
+		};
+
+		struct Array
+		{
+			ArrayFormat format;								// Of the layers' textures, with all levels
+			uint32_t rendererID = 0;
+			uint32_t capacity = 0;
+			uint32_t residentLevel = 0;						// Level 0 of the storage, the levels above are dropped
+			bool residencyFixed = false;					// Set once a layer's baked container is gone
+			std::vector<std::weak_ptr<Texture2D>> layers;		// Expired for layers free to reuse
+		};
+
+		// Format of storage holding the levels from residentLevel down
+		static ArrayFormat GetStorageFormat(const ArrayFormat& format, uint32_t residentLevel);
+
+		// False if the texture has no immutable storage to copy into a layer
+		virtual bool GetFormat(const Texture2D& texture, ArrayFormat& format) = 0;
+		// Array storage for capacity layers, 0 if it couldn't be allocated
+		virtual uint32_t CreateArray(const ArrayFormat& format, uint32_t capacity) = 0;
+		// Copies the levels of a 2D texture from residentLevel down into a layer of storage holding those levels, on the GPU
+		virtual void CopyTextureToLayer(uint32_t texture, uint32_t array, const ArrayFormat& format, uint32_t residentLevel, uint32_t layer) = 0;
+		// Copies the levels both storages hold of layerCount layers from one array to another, on the GPU. format has all levels.
+		virtual void CopyLayers(uint32_t sourceArray, uint32_t sourceResidentLevel, uint32_t destinationArray, uint32_t destinationResidentLevel,
+			const ArrayFormat& format, uint32_t layerCount) = 0;
+		// True if dropped levels of the texture can be reloaded from its baked container
+		virtual bool HasBakedLevels(const Texture2D& texture) const = 0;
+		// Uploads levels [firstLevel, endLevel) of the texture's baked container into a layer. False if the container is gone.
+		virtual bool UploadBakedLevels(const Texture2D& texture, uint32_t array, const ArrayFormat& format, uint32_t residentLevel, uint32_t layer,
+			uint32_t firstLevel, uint32_t endLevel) = 0;
+		// 2D view of a layer, sampled like parametersSource
+		virtual uint32_t CreateLayerView(uint32_t array, const ArrayFormat& format, uint32_t layer, uint32_t parametersSource) = 0;
+		virtual void DeleteTexture(uint32_t texture) = 0;
+
+		std::vector<Array> mArrays;
+	private:
+		static Ref<TextureArrayManager> mInstance;
+
+		// Doubles the array's capacity and points the live textures at views of the new storage
+		bool Grow(Array& array);
+		// Layer for the next texture, growing the array if needed. UINT32_MAX if the array is full.
+		uint32_t AllocateLayer(Array& array);
+		// Swaps the texture's renderer ID for a view of its layer and deletes the old texture
+		void MoveToView(Texture2D& texture, uint32_t view);
+	};
+}
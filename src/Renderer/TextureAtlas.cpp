@@ -1,53 +1,29 @@
 #include "tspch.h"
 #include "TextureAtlas.h"
-#include "TextureAtlasCreator.h"
+#include "Renderer/TextureCompositor.h"
+#include "Core/JobSystem.h"
+
+#if defined(__AVX__) || defined(__SSSE3__)
+#define TS_TEXTURE_ATLAS_SSSE3
+#include <tmmintrin.h>
+#endif
 
 namespace TS_ENGINE {
-	
+
 	TextureAtlas::TextureAtlas() :
-		mAtlasWidth(0),
-		mAtlasHeight(0),
-		mNumHorizontalSlots(0),
-		mNumVerticalSlots(0),
-		mSmallestTextureWidth(0),
-		mSmallestTextureHeight(0)
+		mWidth(0),
+		mHeight(0),
+		mPadding(0)
 	{
-		
+
 	}
 
-	TextureAtlas::TextureAtlas(float atlasWidth, float atlasHeight, std::vector<TexturePair> texturePairs)
+	TextureAtlas::TextureAtlas(uint32_t width, uint32_t height, uint32_t padding) :
+		mWidth(width),
+		mHeight(height),
+		mPadding(padding)
 	{
-		mAtlasWidth = atlasWidth;
-		mAtlasHeight = atlasHeight;
-		mTexturePairs = texturePairs;
 
-		mSmallestTextureWidth = atlasWidth;//Set smallestTextureWidth equal to textureAtlasWidth. It will be recalculated and reset later
-		mSmallestTextureHeight = atlasHeight;//Set smallestTextureheight equal to textureAtlasHeight. It will be recalculated and reset later
-		
-		GetSmallestTextureSize();
-
-		mNumHorizontalSlots = (int)(mAtlasWidth / mSmallestTextureWidth);
-		mNumVerticalSlots = (int)(mAtlasHeight / mSmallestTextureHeight);
-
-		//Slot creation
-		for (int y = 0; y < mNumVerticalSlots; y++)
-		{
-			for (int x = 0; x < mNumHorizontalSlots; x++)
-			{
-				int id = x + y * mNumHorizontalSlots;
-				Rect rect = Rect(x * mSmallestTextureWidth, y * mSmallestTextureHeight, mSmallestTextureWidth, mSmallestTextureHeight);
-
-				Slot slot = Slot();
-				slot.id = id;
-				slot.x = x;
-				slot.y = y;
-				slot.rect = rect;
-				slot.vacant = true;
-				slot.checkedSlot = false;
-
-				mAvailableSlots.push_back(slot);
-			}
-		}
 	}
 
 	TextureAtlas::~TextureAtlas()
@@ -55,292 +31,185 @@ namespace TS_ENGINE {
 
 	}
 
-	void TextureAtlas::GetSmallestTextureSize()
+	void TextureAtlas::AddTexture(const Ref<Texture2D>& texture, const AtlasPackerRect& rect)
 	{
-		for (auto& texturePair : mTexturePairs)
-		{
-			if (Texture2D::GetTextureFromID(texturePair.texID)->GetWidth() < mSmallestTextureWidth)
-			{
-				mSmallestTextureWidth = (float)(Texture2D::GetTextureFromID(texturePair.texID)->GetWidth());
-			}
-		
-			if (Texture2D::GetTextureFromID(texturePair.texID)->GetHeight() < mSmallestTextureHeight)
-			{
-				mSmallestTextureHeight = (float)(Texture2D::GetTextureFromID(texturePair.texID)->GetWidth());
-			}
-		}
+		TS_CORE_ASSERT(rect.packed && rect.x >= mPadding && rect.y >= mPadding &&
+			rect.x + rect.width + mPadding <= mWidth && rect.y + rect.height + mPadding <= mHeight);
+		TS_CORE_ASSERT(rect.width == (rect.rotated ? texture->GetHeight() : texture->GetWidth()));
+
+		mEntryLookup[texture->GetRendererID()] = mEntries.size();
+		mEntries.push_back({ texture, rect });
 	}
 
 	/// <summary>
-	/// Occupied slots of a particular texture. 
-	/// Eg: If the slot size is 128x128 and texture size is 1024x1024,
-	/// then the number of slots required will be 1024/128 = 8 horizontally
-	///             and							  1024/128 = 8 vertically
+	/// Find the texture in atlas and returns AtlasAndTexturePair for
 	/// </summary>
-	/// <param name="texturePair"></param>
-	void TextureAtlas::OccupySlotsForTexture(TexturePair texturePair)
+	/// <param name="texID"></param>
+	/// <returns></returns>
+	const AtlasSizeAndTextureRectPair TextureAtlas::GetAtlasSizeAndTextureRectPair(uint32_t texID) const
 	{
-		TS_CORE_INFO("Finding slots for texture with path {0}, width {1}, height {2} ", 
-			Texture2D::GetTextureFromID(texturePair.texID)->GetPath(), 
-			Texture2D::GetTextureFromID(texturePair.texID)->GetWidth(), 
-			Texture2D::GetTextureFromID(texturePair.texID)->GetHeight());
-
-		Slot* currentVacantSlotPtr = GetNextVacantSlotIndex();
-		mCurrentSlotBundle.AddCurrentSlot(*currentVacantSlotPtr);
-		
-		if(!currentVacantSlotPtr)
-			TS_CORE_ASSERT("Could not find a vacant slot");
-		
-		currentVacantSlotPtr = nullptr;
-		delete currentVacantSlotPtr;
-
-		mCurrentSlotBundle.GetCurrentSlot().Checked();
-		
-		int requiredHorizontalSlots = Texture2D::GetTextureFromID(texturePair.texID)->GetHeight() / (int)mSmallestTextureWidth;
-		int requiredVerticalSlots = Texture2D::GetTextureFromID(texturePair.texID)->GetHeight() / (int)mSmallestTextureHeight;
-
-		//First check texture can't be placed in Atlas condition
-		if (mCurrentSlotBundle.GetCurrentSlot().rect.x + Texture2D::GetTextureFromID(texturePair.texID)->GetWidth() > mAtlasWidth &&
-			mCurrentSlotBundle.GetCurrentSlot().rect.y + Texture2D::GetTextureFromID(texturePair.texID)->GetHeight() > mAtlasHeight)
+		auto it = mEntryLookup.find(texID);
+
+		if (it != mEntryLookup.end())
 		{
-			TS_CORE_ERROR("Texture with path {0} can't be placed in Atlas!", Texture2D::GetTextureFromID(texturePair.texID)->GetPath());
-			texturePair.checkedPlacement = true;
-			texturePair.placed = false;
+			const AtlasPackerRect& rect = mEntries[it->second].rect;
+			return AtlasSizeAndTextureRectPair(Vector2(mWidth, mHeight), Rect((float)rect.x, (float)rect.y, (float)rect.width, (float)rect.height), rect.rotated);
 		}
 		else
 		{
-			if (mCurrentSlotBundle.GetCurrentSlot().rect.x + Texture2D::GetTextureFromID(texturePair.texID)->GetWidth() <= (float)mAtlasWidth)
-			{
-				for (int y = 0; y < requiredVerticalSlots; y++)
-				{
-					for (int x = 0; x < requiredHorizontalSlots; x++)
-					{
-						Slot* neighbourSlotToOccupyPtr = GetSlot(mCurrentSlotBundle.GetCurrentSlot().x + x, mCurrentSlotBundle.GetCurrentSlot().y + y);
-						Slot neighbourSlotToOccupy = *neighbourSlotToOccupyPtr;						
-	
-						if (neighbourSlotToOccupyPtr != nullptr)
-						{
-							if (neighbourSlotToOccupy.id != mCurrentSlotBundle.GetCurrentSlot().id)
-							{
-								neighbourSlotToOccupy.Checked();								
-								mCurrentSlotBundle.AddNeighbourSlot(neighbourSlotToOccupy);
-								
-								if (!neighbourSlotToOccupy.vacant)
-								{
-									TS_CORE_INFO("NeighbourSlotToOccupy at index {0} is not vacant!", neighbourSlotToOccupy.id);
-									mCurrentSlotBundle.ClearNeighbourSlots();
-									
-									OccupySlotsForTexture(texturePair);
-									break;
-								}								
-							}
-						}
-						else//Out side atlas range
-						{
-							TS_CORE_INFO("NeighbourSlotToOccupy is outside range!");
-							OccupySlotsForTexture(texturePair);
-							break;
-						}
-					}
-
-					if (texturePair.checkedPlacement)
-					{
-						TS_CORE_INFO("Placement checked for texture with path {0}", Texture2D::GetTextureFromID(texturePair.texID)->GetPath());
-						return;
-					}
-				}
-
-				//Very important for keeping the texture and ST rect ready for adding the pixels to atlas later
-				mCurrentSlotBundle.SetTexture(Texture2D::GetTextureFromID(texturePair.texID));
-				
-				mCurrentSlotBundle.CalculateRectForTexture(
-					(float)(Texture2D::GetTextureFromID(texturePair.texID)->GetWidth()),
-					(float)(Texture2D::GetTextureFromID(texturePair.texID)->GetHeight()),
-					mAtlasWidth, 
-					mAtlasHeight);
-
-				mSlotBundles.push_back(mCurrentSlotBundle);
-				mSlotBundleMap[mCurrentSlotBundle.GetTexture()->GetRendererID()] = mCurrentSlotBundle;
-
-				if (!texturePair.checkedPlacement && !texturePair.placed)
-				{
-					//If all the checks are done, occupy slot and the valid neighbouring slots
-					mCurrentSlotBundle.GetCurrentSlot().Occupy();
-					//AddToFilledSlots(mCurrentSlotBundle.GetCurrentSlot());
-					
-					texturePair.rect = Rect(
-						mCurrentSlotBundle.GetCurrentSlot().rect.x, 
-						mCurrentSlotBundle.GetCurrentSlot().rect.y,
-						mCurrentSlotBundle.GetCurrentSlot().rect.w * requiredHorizontalSlots, 
-						mCurrentSlotBundle.GetCurrentSlot().rect.h * requiredVerticalSlots
-					);
-
-					RemoveSlotFromAvailableSlots(mCurrentSlotBundle.GetCurrentSlot().id);
-
-					for(auto& validNeighbouringSlot : mCurrentSlotBundle.GetNeighbourSlots())// validNeighbouringSlots)
-					{
-						validNeighbouringSlot.Occupy();
-						//AddToFilledSlots(validNeighbouringSlot);
-						RemoveSlotFromAvailableSlots(validNeighbouringSlot.id);						
-					}
-
-					TS_CORE_INFO("Found slots for texture with name {0}, width {1}, height {2}",
-						Texture2D::GetTextureFromID(texturePair.texID)->GetPath(),
-						Texture2D::GetTextureFromID(texturePair.texID)->GetWidth(),
-						Texture2D::GetTextureFromID(texturePair.texID)->GetHeight());
-
-					texturePair.checkedPlacement = true;
-					texturePair.placed = true;
-					return;
-				}
-			}
+			TS_CORE_ERROR("Could not find texture ID: {0}", texID);
 		}
-		
-	}
-
-	void TextureAtlas::UncheckAllSlots()
-	{
-		for (auto slot : mAvailableSlots)
-			slot.Uncheck();
-	}
 
-	void TextureAtlas::AddTextureToTextureStPairs(TextureStPair textureStPair)
-	{
-		mTextureStPairs.push_back(textureStPair);
+		return AtlasSizeAndTextureRectPair();
 	}
 
-	Slot* TextureAtlas::GetSlot(uint32_t x, uint32_t y)
+	Vector2 TextureAtlas::GetAtlasUV(uint32_t texID, const Vector2& uv) const
 	{
-		uint32_t index = x + y * mNumHorizontalSlots;
+		auto it = mEntryLookup.find(texID);
+		TS_CORE_ASSERT(it != mEntryLookup.end());
 
-		for (auto& slot : mAvailableSlots)
-		{
-			if (slot.id == index)
-			{
-				return &slot;
-			}
-		}
+		const AtlasPackerRect& rect = mEntries[it->second].rect;
 
-		return nullptr;
+		// Rotated textures have their rows along the atlas' columns, see BlitBand
+		Vector2 rectUV = rect.rotated ? Vector2(1.0f - uv.y, uv.x) : uv;
+		return Vector2((rect.x + rectUV.x * rect.width) / mWidth, (rect.y + rectUV.y * rect.height) / mHeight);
 	}
 
-	Slot* TextureAtlas::GetNextVacantSlotIndex()
+	void TextureAtlas::CreateTextureAtlasTexture()
 	{
-		for (auto& slot : mAvailableSlots)
+		bool hasPixels = std::all_of(mEntries.begin(), mEntries.end(), [](const Entry& entry) { return !entry.texture->GetPixels().empty(); });
+
+		if (!hasPixels)
 		{
-			if (!slot.checkedSlot)
+			std::vector<TextureCompositeRect> rects;
+			rects.reserve(mEntries.size());
+
+			for (const auto& entry : mEntries)
 			{
-				return &slot;
+				TS_CORE_ASSERT(!entry.rect.rotated, "Textures without pixels can't be rotated");
+
+				TextureCompositeRect rect;
+				rect.texture = entry.texture;
+				rect.x = entry.rect.x;
+				rect.y = entry.rect.y;
+				rect.width = entry.rect.width;
+				rect.height = entry.rect.height;
+				rect.padding = mPadding;
+				rects.push_back(rect);
 			}
+
+			mAtlasTexture = TextureCompositor::Create()->Composite(mWidth, mHeight, rects);
+			return;
 		}
 
-		return nullptr;
-	}
+		std::vector<uint8_t> atlasData((size_t)mWidth * mHeight * 4, 0);
 
-	void TextureAtlas::RemoveSlotFromAvailableSlots(uint32_t slotIndex)
-	{
-		for (int i = 0; i < mAvailableSlots.size(); i++)
+		// One band per worker plus one for this thread
+		uint32_t numBands = std::max(1u, std::min(JobSystem::GetInstance()->GetWorkerCount() + 1, mHeight / sMinBandRows));
+		uint32_t rowsPerBand = (mHeight + numBands - 1) / numBands;
+		std::vector<std::future<void>> bands;
+
+		for (uint32_t band = 1; band < numBands; band++)
 		{
-			if (mAvailableSlots[i].id == slotIndex)
-			{
-				mAvailableSlots.erase(mAvailableSlots.begin() + i);
-				TS_CORE_INFO("Removed slot with index {0} from availableSlots", slotIndex);
-			}
+			uint32_t firstRow = band * rowsPerBand;
+			uint32_t endRow = std::min(firstRow + rowsPerBand, mHeight);
+			bands.push_back(JobSystem::GetInstance()->Async([this, firstRow, endRow, &atlasData]() { BlitBand(firstRow, endRow, atlasData); }));
 		}
-	}
 
-	/// <summary>
-	/// Find the texture in atlas and returns AtlasAndTexturePair for 
-	/// </summary>
-	/// <param name="texID"></param>
-	/// <returns></returns>
-	const AtlasSizeAndTextureRectPair TextureAtlas::GetAtlasSizeAndTextureRectPair(uint32_t texID) const
-	{
-		auto it = mSlotBundleMap.find(texID);
+		BlitBand(0, std::min(rowsPerBand, mHeight), atlasData);
 
-		if (it != mSlotBundleMap.end())
-		{
-			SlotBundle slotBundle = it->second;			
-			return AtlasSizeAndTextureRectPair(Vector2(mAtlasWidth, mAtlasHeight), slotBundle.GetRect());
-		}
-		else
-		{
-			TS_CORE_ERROR("Could not find texture ID: {0}", texID);
-		}
+		for (auto& band : bands)
+			band.wait();
 
-		return AtlasSizeAndTextureRectPair();
-	}
-	
-	void TextureAtlas::CreateTextureAtlasTexture()
-	{
-		mAtlasTexture = Texture2D::Create((uint32_t)mAtlasWidth, (uint32_t)mAtlasHeight);
-		GLuint texID = CreateTextureForAtlas(mSlotBundles, (uint32_t)mAtlasWidth, (uint32_t)mAtlasHeight);
-		mAtlasTexture->OverrideTextureID(texID);
+		mAtlasTexture = Texture2D::Create(mWidth, mHeight);
+		mAtlasTexture->SetData(atlasData.data(), (uint32_t)atlasData.size());
 	}
 
-	void TextureAtlas::AddTextureToAtlas(TS_ENGINE::Rect rect, int channels, 
-		std::vector<unsigned char> texData, std::vector<GLubyte>& atlasData)
+	void TextureAtlas::BlitBand(uint32_t firstRow, uint32_t endRow, std::vector<uint8_t>& atlasData) const
 	{
-		if (channels == 3)
+		for (const auto& entry : mEntries)
 		{
-			std::vector<unsigned char> paddedTexData((uint32_t)rect.w * (uint32_t)rect.h * 4);
+			const AtlasPackerRect& rect = entry.rect;
+			uint32_t bandFirstRow = std::max(firstRow, rect.y - mPadding);
+			uint32_t bandEndRow = std::min(endRow, rect.y + rect.height + mPadding);
 
-			for (int row = 0; row < rect.h; row++)
+			if (bandFirstRow >= bandEndRow)
+				continue;
+
+			const std::vector<unsigned char>& pixels = entry.texture->GetPixels();
+			uint32_t channels = entry.texture->GetChannels();
+			uint32_t sourceWidth = entry.texture->GetWidth();
+			uint32_t sourceHeight = entry.texture->GetHeight();
+			TS_CORE_ASSERT(pixels.size() >= (size_t)sourceWidth * sourceHeight * channels);
+
+			for (uint32_t row = bandFirstRow; row < bandEndRow; row++)
 			{
-				for (int col = 0; col < rect.w; col++)
-				{
-					int srcIndex = (int)((row * rect.w + col) * channels);
-					int dstIndex = (int)(((rect.y + row) * mAtlasWidth + (rect.x + col)) * 4);
+				// Gutter rows repeat the nearest edge row
+				uint32_t rectRow = (uint32_t)std::clamp((int64_t)row - rect.y, (int64_t)0, (int64_t)rect.height - 1);
+				uint8_t* destination = &atlasData[((size_t)row * mWidth + rect.x) * 4];
 
-					atlasData[dstIndex + 0] = texData[srcIndex + 0];
-					atlasData[dstIndex + 1] = texData[srcIndex + 1];
-					atlasData[dstIndex + 2] = texData[srcIndex + 2];
-					atlasData[dstIndex + 3] = 255;//Set alpha as 255
+				if (!rect.rotated)
+				{
+					CopyRow(&pixels[(size_t)rectRow * sourceWidth * channels], channels, rect.width, destination);
 				}
-			}
-		}
-		else//4 Channel
-		{
-			for (int row = 0; row < rect.h; row++)
-			{
-				for (int col = 0; col < rect.w; col++)
+				else
 				{
-					int srcIndex = (int)((row * rect.w + col) * channels);
-					int dstIndex = (int)(((rect.y + row) * mAtlasWidth + (rect.x + col)) * channels);
+					// Atlas texel (x, rectRow) comes from source texel (rectRow, sourceHeight - 1 - x)
+					for (uint32_t x = 0; x < rect.width; x++)
+						CopyRow(&pixels[((size_t)(sourceHeight - 1 - x) * sourceWidth + rectRow) * channels], channels, 1, destination + x * 4);
+				}
 
-					atlasData[dstIndex + 0] = texData[srcIndex + 0];
-					atlasData[dstIndex + 1] = texData[srcIndex + 1];
-					atlasData[dstIndex + 2] = texData[srcIndex + 2];
-					atlasData[dstIndex + 3] = texData[srcIndex + 3];
+				for (uint32_t gutter = 1; gutter <= mPadding; gutter++)
+				{
+					std::memcpy(destination - gutter * 4, destination, 4);
+					std::memcpy(destination + (rect.width - 1 + gutter) * 4, destination + (rect.width - 1) * 4, 4);
 				}
 			}
 		}
 	}
 
-	GLuint TextureAtlas::CreateTextureForAtlas(std::vector<SlotBundle> slotBundles, uint32_t atlasWidth, uint32_t atlasHeight)
+	void TextureAtlas::CopyRow(const uint8_t* source, uint32_t channels, uint32_t count, uint8_t* destination)
 	{
-		GLuint atlasTexture;
-		glGenTextures(1, &atlasTexture);
-		glBindTexture(GL_TEXTURE_2D, atlasTexture);
-
-		// Set texture parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		if (channels == 4)
+		{
+			std::memcpy(destination, source, (size_t)count * 4);
+			return;
+		}
 
-		// Define texture data
-		std::vector<GLubyte> atlasData(atlasWidth * atlasHeight * 4);
+		uint32_t i = 0;
 
-		for (uint32_t i = 0; i < slotBundles.size(); i++)
+		if (channels == 3)
 		{
-			std::vector<unsigned char> texData = slotBundles[i].GetTexture()->GetPixels();
-			uint32_t channels = slotBundles[i].GetTexture()->GetChannels();
-			Rect rect = slotBundles[i].GetRect();
+#ifdef TS_TEXTURE_ATLAS_SSSE3
+			const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+			const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
 
-			AddTextureToAtlas(rect, channels, texData, atlasData);
-		}
+			// Loads 16 bytes for 4 texels, so the last texels are left to the scalar loop
+			for (; i + 6 <= count; i += 4)
+			{
+				__m128i texels = _mm_loadu_si128((const __m128i*)(source + i * 3));
+				_mm_storeu_si128((__m128i*)(destination + i * 4), _mm_or_si128(_mm_shuffle_epi8(texels, shuffle), alpha));
+			}
+#endif
+			for (; i < count; i++)
+			{
+				destination[i * 4 + 0] = source[i * 3 + 0];
+				destination[i * 4 + 1] = source[i * 3 + 1];
+				destination[i * 4 + 2] = source[i * 3 + 2];
+				destination[i * 4 + 3] = 255;//Set alpha as 255
+			}
 
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, atlasWidth, atlasHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, atlasData.data());
+			return;
+		}
 
-		return atlasTexture;
+		// Grey and grey with alpha
+		for (; i < count; i++)
+		{
+			uint8_t grey = source[i * channels];
+			destination[i * 4 + 0] = grey;
+			destination[i * 4 + 1] = grey;
+			destination[i * 4 + 2] = grey;
+			destination[i * 4 + 3] = channels == 2 ? source[i * 2 + 1] : 255;
+		}
 	}
 }
@@ -3,69 +3,60 @@
 #include "TS_ENGINE.h"
 #include "Texture.h"
 #include "TextureAtlasHelper.h"
+#include "AtlasPacker.h"
 
 namespace TS_ENGINE {
 
+	/// <summary>
+	/// One page of packed textures. The textures are blitted into an RGBA8 texture with their edge texels repeated into the gutters.
+	/// </summary>
 	class TextureAtlas
 	{
-	private:
-		/// <summary>
-		/// Iterates through all the textures in TextureAtlasCreators's m_TexturePaits 
-		/// and get's the smallest texture size. The slot size will be made accordingly
-		/// </summary>
-		void GetSmallestTextureSize();
-		Ref<Texture2D> mAtlasTexture;
 	public:
 		TextureAtlas();
-		TextureAtlas(float width, float height, std::vector<TexturePair> texturePairs);
+		TextureAtlas(uint32_t width, uint32_t height, uint32_t padding);
 		~TextureAtlas();
 
-		void OccupySlotsForTexture(TexturePair texturePair);
-		void UncheckAllSlots();
-		
-		void AddTextureToTextureStPairs(TextureStPair textureStPair);
+		// Places a texture at a rect packed by AtlasPacker for this page
+		void AddTexture(const Ref<Texture2D>& texture, const AtlasPackerRect& rect);
+
+		/// <summary>
+		/// Blits the textures on the CPU in parallel row bands when all of them kept their pixels,
+		/// otherwise composites them on the GPU, which can't turn rotated textures.
+		/// </summary>
 		void CreateTextureAtlasTexture();
 
 		const Ref<Texture2D> GetTexture() const
 		{
 			return mAtlasTexture;
 		}
+		bool Contains(uint32_t texID) const
+		{
+			return mEntryLookup.find(texID) != mEntryLookup.end();
+		}
 		const AtlasSizeAndTextureRectPair GetAtlasSizeAndTextureRectPair(uint32_t texID) const;
+		// Atlas UV of a UV of the texture, following its rotation
+		Vector2 GetAtlasUV(uint32_t texID, const Vector2& uv) const;
 	private:
-		Slot* GetSlot(uint32_t x, uint32_t y);
-		Slot* GetNextVacantSlotIndex();
-		void RemoveSlotFromAvailableSlots(uint32_t slotIndex);
-		
-		/// <summary>
-		/// Takes texture rect, channel, texel unsigned char vector, and copies the texels to atlasData ie: GLubyte vector
-		/// </summary>
-		/// <param name="rect"></param>
-		/// <param name="channels"></param>
-		/// <param name="texData"></param>
-		/// <param name="atlasWidth"></param>
-		/// <param name="atlasHeight"></param>
-		/// <param name="atlasData"></param>
-		void AddTextureToAtlas(TS_ENGINE::Rect rect, int channels, std::vector<unsigned char> texData, std::vector<GLubyte>& atlasData);		
-		GLuint CreateTextureForAtlas(std::vector<SlotBundle> slotBundles, uint32_t atlasWidth, uint32_t atlasHeight);
-	private:		
-		float mAtlasWidth;
-		float mAtlasHeight;
-		
-		float mSmallestTextureWidth;
-		float mSmallestTextureHeight;
-		
-		int mNumHorizontalSlots;
-		int mNumVerticalSlots;
+		struct Entry
+		{
+			Ref<Texture2D> texture;
+			AtlasPackerRect rect;
+		};
 
-		/// <summary>
-		/// Crucial for placing the texture pixels in Atlas
-		/// </summary>
-		SlotBundle mCurrentSlotBundle;
+		// Writes the rows [firstRow, endRow) of every entry and its gutters. Bands don't share rows, so they run in parallel.
+		void BlitBand(uint32_t firstRow, uint32_t endRow, std::vector<uint8_t>& atlasData) const;
+		// Expands one row of texels to RGBA8
+		static void CopyRow(const uint8_t* source, uint32_t channels, uint32_t count, uint8_t* destination);
+	private:
+		static constexpr uint32_t sMinBandRows = 64;
 
-		std::vector<Slot> mAvailableSlots;
-		std::vector<SlotBundle> mSlotBundles;
-		std::unordered_map<uint32_t, SlotBundle> mSlotBundleMap;
-		std::vector<TexturePair> mTexturePairs;
-		std::vector<TextureStPair> mTextureStPairs;
+		uint32_t mWidth;
+		uint32_t mHeight;
+		uint32_t mPadding;
+
+		std::vector<Entry> mEntries;
+		std::unordered_map<uint32_t, size_t> mEntryLookup;		// Renderer ID to entry
+		Ref<Texture2D> mAtlasTexture;
 	};
-}
\ No newline at end of file
+}
@@ -1,15 +1,15 @@
 #include "tspch.h"
 #include "TextureAtlasCreator.h"
+#include "Renderer/TextureStreamer.h"
+#include <unordered_set>
 
 namespace TS_ENGINE {
 
-	TextureAtlasCreator::TextureAtlasCreator(float atlasWidth, float atlasHeight, std::vector<Ref<Texture2D>> textures)
+	TextureAtlasCreator::TextureAtlasCreator(uint32_t atlasWidth, uint32_t atlasHeight, const std::vector<Ref<Texture2D>>& textures) :
+		mAtlasWidth(atlasWidth),
+		mAtlasHeight(atlasHeight)
 	{
-		mAtlasWidth = atlasWidth;
-		mAtlasHeight = atlasHeight;
-		mTextures = textures;
-
-		StartAtlasCreation();
+		CreateAtlases(textures);
 	}
 
 	TextureAtlasCreator::~TextureAtlasCreator()
@@ -17,56 +17,68 @@ namespace TS_ENGINE {
 
 	}
 
-	void TextureAtlasCreator::StartAtlasCreation()
+	const TextureAtlas* TextureAtlasCreator::GetTextureAtlas(uint32_t texID) const
+	{
+		for (const auto& atlas : mAtlases)
+		{
+			if (atlas.Contains(texID))
+				return &atlas;
+		}
+
+		return nullptr;
+	}
+
+	void TextureAtlasCreator::CreateAtlases(const std::vector<Ref<Texture2D>>& textures)
 	{
-		if (mTextures.size() == 0)
+		if (textures.size() == 0)
 		{
 			TS_CORE_ERROR("No texture assigned for atlasing!");
 			return;
 		}
 
-		for (auto& texture : mTextures)
+		// Sizes, pixels and renderer IDs are final once the textures are uploaded
+		if (std::any_of(textures.begin(), textures.end(), [](const Ref<Texture2D>& texture) { return texture && texture->IsStreaming(); }))
+			TextureStreamer::GetInstance()->Flush();
+
+		std::vector<Ref<Texture2D>> uniqueTextures;
+		std::unordered_set<uint32_t> textureIDs;
+		bool allowRotation = true;
+
+		for (const auto& texture : textures)
 		{
-			TexturePair texturePair = TexturePair();
-			texturePair.texID = texture->GetRendererID();
-			//texturePair.texture = texture;
-			texturePair.placed = false;
-			texturePair.checkedPlacement = false;
+			if (!texture || texture->GetWidth() == 0 || texture->GetHeight() == 0 || !textureIDs.insert(texture->GetRendererID()).second)
+				continue;
 
-			mTexturePairs.push_back(texturePair);
+			uniqueTextures.push_back(texture);
+			allowRotation &= !texture->GetPixels().empty();
 		}
 
-		CreateAtlas();		
-	}
+		std::vector<std::pair<uint32_t, uint32_t>> sizes;
+		sizes.reserve(uniqueTextures.size());
 
-	std::vector<TexturePair> TextureAtlasCreator::GetTexturePairs()
-	{
-		return mTexturePairs;
-	}
+		for (const auto& texture : uniqueTextures)
+			sizes.push_back({ texture->GetWidth(), texture->GetHeight() });
 
-	void TextureAtlasCreator::CreateAtlas()
-	{
-		TextureAtlas atlas = TextureAtlas(mAtlasWidth, mAtlasHeight, mTexturePairs);
+		AtlasPacker packer(mAtlasWidth, mAtlasHeight, sPadding, sAlignment, allowRotation);
+		std::vector<AtlasPackerRect> rects;
+		packer.Pack(sizes, rects);
+		mStats = packer.GetStats();
 
-		std::vector<TexturePair> unplacedTexturePairList = {};
+		TS_CORE_INFO("Packed {0} of {1} textures into {2} atlas pages of {3}x{4}, {5:.1f}% occupancy in {6:.3f} ms",
+			mStats.packedRects, uniqueTextures.size(), mStats.pages, mAtlasWidth, mAtlasHeight, mStats.occupancy * 100.0f, mStats.packingTime);
 
-		for (auto& texturePair : mTexturePairs)
-		{
-			texturePair.checkedPlacement = false;
-			texturePair.placed = false;
-			atlas.OccupySlotsForTexture(texturePair);
-			atlas.UncheckAllSlots();
+		for (uint32_t page = 0; page < packer.GetPageCount(); page++)
+			mAtlases.emplace_back(mAtlasWidth, mAtlasHeight, sPadding);
 
-			if (!texturePair.placed)
-				unplacedTexturePairList.push_back(texturePair);
+		for (size_t i = 0; i < uniqueTextures.size(); i++)
+		{
+			if (rects[i].packed)
+				mAtlases[rects[i].page].AddTexture(uniqueTextures[i], rects[i]);
 			else
-			{
-				TextureStPair textureStPair = TextureStPair(texturePair.texID, texturePair.rect);
-				atlas.AddTextureToTextureStPairs(textureStPair);
-			}
+				TS_CORE_ERROR("Texture with path {0} can't be placed in Atlas!", uniqueTextures[i]->GetPath());
 		}
 
-		atlas.CreateTextureAtlasTexture();
-		mAtlases.push_back(atlas);
+		for (auto& atlas : mAtlases)
+			atlas.CreateTextureAtlasTexture();
 	}
-}
\ No newline at end of file
+}
@@ -8,25 +8,35 @@
 
 namespace TS_ENGINE {
 
+	/// <summary>
+	/// Packs textures into as many atlas pages of the given size as needed.
+	/// Textures are rotated only when all of them kept their pixels, since the GPU fallback can't turn them.
+	/// </summary>
 	class TextureAtlasCreator
 	{
 	public:
-		TextureAtlasCreator(float atlasWidth, float atlasHeight, std::vector<Ref<Texture2D>> textures);
+		static constexpr uint32_t sPadding = 4;		// Gutter texels around each texture
+		static constexpr uint32_t sAlignment = 4;	// Keeps the first two mip levels free of bleeding
+
+		TextureAtlasCreator(uint32_t atlasWidth, uint32_t atlasHeight, const std::vector<Ref<Texture2D>>& textures);
 		~TextureAtlasCreator();
 
-		void StartAtlasCreation();
-		
-		std::vector<TexturePair> GetTexturePairs();
-		const std::vector<TextureAtlas> GetTextureAtlases() const
+		const std::vector<TextureAtlas>& GetTextureAtlases() const
 		{
 			return mAtlases;
 		}
+		// Atlas page holding the texture, nullptr if it didn't fit
+		const TextureAtlas* GetTextureAtlas(uint32_t texID) const;
+		const AtlasPackerStats& GetStats() const
+		{
+			return mStats;
+		}
 	private:
-		float mAtlasWidth;
-		float mAtlasHeight;
-		std::vector<Ref<Texture2D>> mTextures;
-		std::vector<TexturePair> mTexturePairs;
+		void CreateAtlases(const std::vector<Ref<Texture2D>>& textures);
+
+		uint32_t mAtlasWidth;
+		uint32_t mAtlasHeight;
 		std::vector<TextureAtlas> mAtlases;
-		void CreateAtlas();
+		AtlasPackerStats mStats;
 	};
 }
@@ -0,0 +1,12 @@
+#include "tspch.h"
+#include "Renderer/TextureCompositor.h"
+#include "Platform/OpenGL/OpenGLTextureCompositor.h"
+
+namespace TS_ENGINE {
+
+	Ref<TextureCompositor> TextureCompositor::Create()
+	{
+		//ToDo: Add support for multiple APIs
+		return CreateRef<OpenGLTextureCompositor>();
+	}
+}
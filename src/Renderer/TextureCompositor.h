@@ -0,0 +1,31 @@
+#pragma once
+#include "Renderer/Texture.h"
+
+namespace TS_ENGINE {
+
+	struct TextureCompositeRect
+	{
+		Ref<Texture2D> texture = nullptr;		// nullptr fills the rect with the tint
+		Vector4 tint = Vector4(1.0f);
+		uint32_t x = 0;							// Pixels, origin at the bottom left
+		uint32_t y = 0;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t padding = 0;					// Edge texels repeated around the rect so filtering doesn't pick up neighbours
+	};
+
+	/// <summary>
+	/// Draws textures scaled and tinted into rects of a new RGBA8 texture on the GPU.
+	/// Works for any source format and size, and doesn't need the sources' pixels on the CPU.
+	/// </summary>
+	class TextureCompositor
+	{
+	public:
+		virtual ~TextureCompositor() = default;
+
+		// Rects and their padding must lie inside the texture. Restores the bound framebuffer, viewport and program.
+		virtual Ref<Texture2D> Composite(uint32_t width, uint32_t height, const std::vector<TextureCompositeRect>& rects) = 0;
+
+		static Ref<TextureCompositor> Create();
+	};
+}
@@ -0,0 +1,588 @@
+#include "tspch.h"
+#include "Renderer/TextureCompressor.h"
+#include "Core/JobSystem.h"
+#include "Core/Application.h"
+
+namespace TS_ENGINE {
+
+	// Direction of the largest spread of the points through their mean, zero if they're all equal
+	static void GetPrincipalAxis(const float points[16][4], uint32_t dimensions, float mean[4], float axis[4])
+	{
+		for (uint32_t d = 0; d < 4; d++)
+		{
+			mean[d] = 0.0f;
+			axis[d] = 0.0f;
+		}
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			for (uint32_t d = 0; d < dimensions; d++)
+				mean[d] += points[i][d] / 16.0f;
+		}
+
+		float covariance[4][4] = {};
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			for (uint32_t a = 0; a < dimensions; a++)
+			{
+				for (uint32_t b = 0; b < dimensions; b++)
+					covariance[a][b] += (points[i][a] - mean[a]) * (points[i][b] - mean[b]);
+			}
+		}
+
+		// Power iteration from the row of the largest variance, which can't be orthogonal to the principal axis
+		uint32_t largest = 0;
+
+		for (uint32_t d = 1; d < dimensions; d++)
+		{
+			if (covariance[d][d] > covariance[largest][largest])
+				largest = d;
+		}
+
+		if (covariance[largest][largest] <= 0.0f)
+			return;
+
+		for (uint32_t d = 0; d < dimensions; d++)
+			axis[d] = covariance[largest][d];
+
+		for (uint32_t iteration = 0; iteration < 8; iteration++)
+		{
+			float next[4] = {};
+			float maxComponent = 0.0f;
+
+			for (uint32_t a = 0; a < dimensions; a++)
+			{
+				for (uint32_t b = 0; b < dimensions; b++)
+					next[a] += covariance[a][b] * axis[b];
+
+				maxComponent = std::max(maxComponent, std::abs(next[a]));
+			}
+
+			if (maxComponent <= 0.0f)
+				break;
+
+			for (uint32_t d = 0; d < dimensions; d++)
+				axis[d] = next[d] / maxComponent;
+		}
+
+		float length = 0.0f;
+
+		for (uint32_t d = 0; d < dimensions; d++)
+			length += axis[d] * axis[d];
+
+		length = std::sqrt(length);
+
+		for (uint32_t d = 0; d < dimensions; d++)
+			axis[d] = length > 0.0f ? axis[d] / length : 0.0f;
+	}
+
+	// Extremes of the points projected on the axis, in the given dimensions
+	static void GetAxisEndpoints(const float points[16][4], uint32_t dimensions, const float mean[4], const float axis[4], float start[4], float end[4])
+	{
+		float minProjection = 0.0f;
+		float maxProjection = 0.0f;
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			float projection = 0.0f;
+
+			for (uint32_t d = 0; d < dimensions; d++)
+				projection += (points[i][d] - mean[d]) * axis[d];
+
+			minProjection = std::min(minProjection, projection);
+			maxProjection = std::max(maxProjection, projection);
+		}
+
+		for (uint32_t d = 0; d < 4; d++)
+		{
+			start[d] = d < dimensions ? std::clamp(mean[d] + axis[d] * maxProjection, 0.0f, 255.0f) : 255.0f;
+			end[d] = d < dimensions ? std::clamp(mean[d] + axis[d] * minProjection, 0.0f, 255.0f) : 255.0f;
+		}
+	}
+
+	static uint32_t GetSquaredDistance(const uint8_t* a, const uint8_t* b, uint32_t dimensions)
+	{
+		uint32_t distance = 0;
+
+		for (uint32_t d = 0; d < dimensions; d++)
+		{
+			int32_t difference = (int32_t)a[d] - (int32_t)b[d];
+			distance += (uint32_t)(difference * difference);
+		}
+
+		return distance;
+	}
+
+	static uint16_t PackRGB565(const float color[4])
+	{
+		uint32_t r = (uint32_t)(color[0] * 31.0f / 255.0f + 0.5f);
+		uint32_t g = (uint32_t)(color[1] * 63.0f / 255.0f + 0.5f);
+		uint32_t b = (uint32_t)(color[2] * 31.0f / 255.0f + 0.5f);
+		return (uint16_t)((r << 11) | (g << 5) | b);
+	}
+
+	static void UnpackRGB565(uint16_t packed, uint8_t color[4])
+	{
+		uint32_t r = (packed >> 11) & 31;
+		uint32_t g = (packed >> 5) & 63;
+		uint32_t b = packed & 31;
+		color[0] = (uint8_t)((r << 3) | (r >> 2));
+		color[1] = (uint8_t)((g << 2) | (g >> 4));
+		color[2] = (uint8_t)((b << 3) | (b >> 2));
+		color[3] = 255;
+	}
+
+	// Appends fields to a 128-bit block, least significant bit first
+	struct BlockBitWriter
+	{
+		uint8_t* block;
+		uint32_t position = 0;
+
+		void Write(uint32_t value, uint32_t bitCount)
+		{
+			for (uint32_t bit = 0; bit < bitCount; bit++, position++)
+			{
+				if (value & (1u << bit))
+					block[position >> 3] |= (uint8_t)(1u << (position & 7));
+			}
+		}
+	};
+
+	TextureBlockFormat TextureCompressor::ChooseFormat(uint32_t channels, bool hasAlpha, const TextureImportSettings& settings)
+	{
+		if (!settings.compress)
+			return TextureBlockFormat::None;
+
+		switch (settings.usage)
+		{
+		case TextureUsage::NormalMap:
+			// BC5 drops z, so it's only used when the shaders rebuild it
+			if (channels >= 2 && settings.twoChannelNormals)
+				return TextureBlockFormat::BC5;
+			break;
+		case TextureUsage::Data:
+			if (channels == 1)
+				return TextureBlockFormat::BC4;
+			else if (channels == 2)
+				return TextureBlockFormat::BC5;
+			break;
+		default:
+			break;
+		}
+
+		if (settings.preferBC7)
+			return TextureBlockFormat::BC7;
+
+		return hasAlpha ? TextureBlockFormat::BC3 : TextureBlockFormat::BC1;
+	}
+
+	bool TextureCompressor::HasAlpha(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels)
+	{
+		if (channels != 2 && channels != 4)
+			return false;
+
+		size_t texelCount = (size_t)width * height;
+
+		for (size_t i = 0; i < texelCount; i++)
+		{
+			if (pixels[i * channels + channels - 1] != 255)
+				return true;
+		}
+
+		return false;
+	}
+
+	uint32_t TextureCompressor::GetBlockBytes(TextureBlockFormat format)
+	{
+		switch (format)
+		{
+		case TextureBlockFormat::BC1:
+		case TextureBlockFormat::BC4:
+			return 8;
+		case TextureBlockFormat::BC3:
+		case TextureBlockFormat::BC5:
+		case TextureBlockFormat::BC7:
+			return 16;
+		default:
+			return 0;
+		}
+	}
+
+	size_t TextureCompressor::GetCompressedSize(TextureBlockFormat format, uint32_t width, uint32_t height)
+	{
+		return (size_t)((width + 3) / 4) * ((height + 3) / 4) * GetBlockBytes(format);
+	}
+
+	CompressedTexture TextureCompressor::Compress(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels, TextureBlockFormat format)
+	{
+		TS_CORE_ASSERT(channels >= 1 && channels <= 4);
+
+		CompressedTexture texture;
+
+		if (format == TextureBlockFormat::None || width == 0 || height == 0)
+			return texture;
+
+		texture.format = format;
+		texture.width = width;
+		texture.height = height;
+		texture.channels = channels;
+		texture.data.resize(GetCompressedSize(format, width, height));
+
+		uint32_t blockRows = (height + 3) / 4;
+
+		// One band per worker plus one for this thread, all inline when already on a worker
+		uint32_t numBands = JobSystem::IsWorkerThread() ? 1 : std::max(1u, std::min(JobSystem::GetInstance()->GetWorkerCount() + 1, blockRows / sMinBandBlockRows));
+		uint32_t blockRowsPerBand = (blockRows + numBands - 1) / numBands;
+		std::vector<std::future<void>> bands;
+		uint8_t* blocks = texture.data.data();
+
+		for (uint32_t band = 1; band < numBands; band++)
+		{
+			uint32_t firstBlockRow = band * blockRowsPerBand;
+			uint32_t endBlockRow = std::min(firstBlockRow + blockRowsPerBand, blockRows);
+			bands.push_back(JobSystem::GetInstance()->Async([=]() { CompressBand(pixels, width, height, channels, format, firstBlockRow, endBlockRow, blocks); }));
+		}
+
+		CompressBand(pixels, width, height, channels, format, 0, std::min(blockRowsPerBand, blockRows), blocks);
+
+		for (auto& band : bands)
+			band.wait();
+
+		return texture;
+	}
+
+	void TextureCompressor::CompressBand(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels, TextureBlockFormat format,
+		uint32_t firstBlockRow, uint32_t endBlockRow, uint8_t* blocks)
+	{
+		uint32_t blocksX = (width + 3) / 4;
+		uint32_t blockBytes = GetBlockBytes(format);
+
+		uint8_t rgba[16][4];
+		uint8_t red[16];
+		uint8_t green[16];
+
+		for (uint32_t blockY = firstBlockRow; blockY < endBlockRow; blockY++)
+		{
+			for (uint32_t blockX = 0; blockX < blocksX; blockX++)
+			{
+				// Blocks over the edge repeat the last row and column
+				for (uint32_t i = 0; i < 16; i++)
+				{
+					uint32_t x = std::min(blockX * 4 + (i & 3), width - 1);
+					uint32_t y = std::min(blockY * 4 + (i >> 2), height - 1);
+					const uint8_t* texel = &pixels[((size_t)y * width + x) * channels];
+
+					red[i] = texel[0];
+					green[i] = channels > 1 ? texel[1] : texel[0];
+
+					if (channels >= 3)
+					{
+						rgba[i][0] = texel[0];
+						rgba[i][1] = texel[1];
+						rgba[i][2] = texel[2];
+						rgba[i][3] = channels == 4 ? texel[3] : 255;
+					}
+					else
+					{
+						rgba[i][0] = rgba[i][1] = rgba[i][2] = texel[0];
+						rgba[i][3] = channels == 2 ? texel[1] : 255;
+					}
+				}
+
+				uint8_t* block = &blocks[((size_t)blockY * blocksX + blockX) * blockBytes];
+
+				switch (format)
+				{
+				case TextureBlockFormat::BC1:
+					EncodeBC1(rgba, block);
+					break;
+				case TextureBlockFormat::BC3:
+				{
+					uint8_t alpha[16];
+
+					for (uint32_t i = 0; i < 16; i++)
+						alpha[i] = rgba[i][3];
+
+					EncodeBC4(alpha, block);
+					EncodeBC1(rgba, block + 8);
+					break;
+				}
+				case TextureBlockFormat::BC4:
+					EncodeBC4(red, block);
+					break;
+				case TextureBlockFormat::BC5:
+					EncodeBC4(red, block);
+					EncodeBC4(green, block + 8);
+					break;
+				case TextureBlockFormat::BC7:
+					EncodeBC7(rgba, block);
+					break;
+				default:
+					break;
+				}
+			}
+		}
+	}
+
+	void TextureCompressor::EncodeBC1(const uint8_t rgba[16][4], uint8_t* block)
+	{
+		float points[16][4];
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			for (uint32_t d = 0; d < 4; d++)
+				points[i][d] = rgba[i][d];
+		}
+
+		float mean[4], axis[4], start[4], end[4];
+		GetPrincipalAxis(points, 3, mean, axis);
+		GetAxisEndpoints(points, 3, mean, axis, start, end);
+
+		// Inset by a sixteenth of the range, so the outermost texels land between palette entries less often
+		for (uint32_t d = 0; d < 3; d++)
+		{
+			float inset = (start[d] - end[d]) / 16.0f;
+			start[d] -= inset;
+			end[d] += inset;
+		}
+
+		uint16_t color0 = PackRGB565(start);
+		uint16_t color1 = PackRGB565(end);
+
+		// Four color mode needs color0 above color1
+		if (color0 < color1)
+			std::swap(color0, color1);
+
+		uint32_t indices = 0;
+
+		if (color0 != color1)
+		{
+			uint8_t palette[4][4];
+			UnpackRGB565(color0, palette[0]);
+			UnpackRGB565(color1, palette[1]);
+
+			for (uint32_t d = 0; d < 3; d++)
+			{
+				palette[2][d] = (uint8_t)((2 * palette[0][d] + palette[1][d]) / 3);
+				palette[3][d] = (uint8_t)((palette[0][d] + 2 * palette[1][d]) / 3);
+			}
+
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				uint32_t bestIndex = 0;
+				uint32_t bestDistance = UINT32_MAX;
+
+				for (uint32_t index = 0; index < 4; index++)
+				{
+					uint32_t distance = GetSquaredDistance(rgba[i], palette[index], 3);
+
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = index;
+					}
+				}
+
+				indices |= bestIndex << (i * 2);
+			}
+		}
+
+		block[0] = (uint8_t)(color0 & 0xFF);
+		block[1] = (uint8_t)(color0 >> 8);
+		block[2] = (uint8_t)(color1 & 0xFF);
+		block[3] = (uint8_t)(color1 >> 8);
+
+		for (uint32_t i = 0; i < 4; i++)
+			block[4 + i] = (uint8_t)(indices >> (i * 8));
+	}
+
+	void TextureCompressor::EncodeBC4(const uint8_t values[16], uint8_t* block)
+	{
+		uint8_t maxValue = *std::max_element(values, values + 16);
+		uint8_t minValue = *std::min_element(values, values + 16);
+
+		// Eight value mode, codes 0 and 1 are the endpoints and 2 to 7 step from the first to the second
+		block[0] = maxValue;
+		block[1] = minValue;
+		uint64_t indices = 0;
+
+		if (maxValue != minValue)
+		{
+			float scale = 7.0f / (float)(maxValue - minValue);
+
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				uint32_t step = (uint32_t)((float)(maxValue - values[i]) * scale + 0.5f);
+				uint64_t code = step == 0 ? 0 : step == 7 ? 1 : step + 1;
+				indices |= code << (i * 3);
+			}
+		}
+
+		for (uint32_t i = 0; i < 6; i++)
+			block[2 + i] = (uint8_t)(indices >> (i * 8));
+	}
+
+	void TextureCompressor::EncodeBC7(const uint8_t rgba[16][4], uint8_t* block)
+	{
+		static constexpr uint32_t weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		float points[16][4];
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			for (uint32_t d = 0; d < 4; d++)
+				points[i][d] = rgba[i][d];
+		}
+
+		float mean[4], axis[4];
+		float endpoints[2][4];
+		GetPrincipalAxis(points, 4, mean, axis);
+		GetAxisEndpoints(points, 4, mean, axis, endpoints[0], endpoints[1]);
+
+		// Mode 6 endpoints are 7 bits per channel and a p-bit shared by the channels, which becomes their lowest bit
+		uint8_t quantized[2][4];
+		uint32_t pBits[2] = { 0, 0 };
+
+		for (uint32_t e = 0; e < 2; e++)
+		{
+			uint32_t bestError = UINT32_MAX;
+
+			for (uint32_t p = 0; p < 2; p++)
+			{
+				uint8_t candidate[4];
+				uint32_t error = 0;
+
+				for (uint32_t d = 0; d < 4; d++)
+				{
+					int32_t value = std::clamp((int32_t)((endpoints[e][d] - (float)p) / 2.0f + 0.5f), 0, 127);
+					candidate[d] = (uint8_t)value;
+					int32_t difference = ((value << 1) | (int32_t)p) - (int32_t)(endpoints[e][d] + 0.5f);
+					error += (uint32_t)(difference * difference);
+				}
+
+				if (error < bestError)
+				{
+					bestError = error;
+					pBits[e] = p;
+					std::memcpy(quantized[e], candidate, 4);
+				}
+			}
+		}
+
+		uint8_t palette[16][4];
+
+		for (uint32_t d = 0; d < 4; d++)
+		{
+			uint32_t value0 = ((uint32_t)quantized[0][d] << 1) | pBits[0];
+			uint32_t value1 = ((uint32_t)quantized[1][d] << 1) | pBits[1];
+
+			for (uint32_t index = 0; index < 16; index++)
+				palette[index][d] = (uint8_t)(((64 - weights[index]) * value0 + weights[index] * value1 + 32) >> 6);
+		}
+
+		uint32_t indices[16] = {};
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			uint32_t bestDistance = UINT32_MAX;
+
+			for (uint32_t index = 0; index < 16; index++)
+			{
+				uint32_t distance = GetSquaredDistance(rgba[i], palette[index], 4);
+
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					indices[i] = index;
+				}
+			}
+		}
+
+		// The first index is stored without its top bit, so it has to be below 8. Swapping the endpoints mirrors the indices.
+		if (indices[0] >= 8)
+		{
+			std::swap(quantized[0], quantized[1]);
+			std::swap(pBits[0], pBits[1]);
+
+			for (uint32_t i = 0; i < 16; i++)
+				indices[i] = 15 - indices[i];
+		}
+
+		std::memset(block, 0, 16);
+		BlockBitWriter writer{ block };
+		writer.Write(1 << 6, 7);
+
+		for (uint32_t d = 0; d < 4; d++)
+		{
+			writer.Write(quantized[0][d], 7);
+			writer.Write(quantized[1][d], 7);
+		}
+
+		writer.Write(pBits[0], 1);
+		writer.Write(pBits[1], 1);
+
+		for (uint32_t i = 0; i < 16; i++)
+			writer.Write(indices[i], i == 0 ? 3 : 4);
+	}
+
+	uint64_t TextureCompressor::HashBytes(const void* data, size_t size, uint64_t seed)
+	{
+		const uint8_t* bytes = (const uint8_t*)data;
+		uint64_t hash = seed;
+
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+	uint64_t TextureCompressor::GetFileCacheKey(const std::string& path, const TextureImportSettings& settings, bool flip)
+	{
+		std::error_code error;
+		uint64_t size = (uint64_t)std::filesystem::file_size(path, error);
+
+		if (error)
+			return 0;
+
+		int64_t writeTime = (int64_t)std::filesystem::last_write_time(path, error).time_since_epoch().count();
+
+		if (error)
+			return 0;
+
+		uint64_t key = HashBytes(path.data(), path.size());
+		key = HashBytes(&size, sizeof(size), key);
+		key = HashBytes(&writeTime, sizeof(writeTime), key);
+		return GetSettingsKey(key, settings, flip);
+	}
+
+	uint64_t TextureCompressor::GetMemoryCacheKey(const uint8_t* data, size_t size, const TextureImportSettings& settings, bool flip)
+	{
+		return GetSettingsKey(HashBytes(data, size), settings, flip);
+	}
+
+	uint64_t TextureCompressor::GetSettingsKey(uint64_t sourceKey, const TextureImportSettings& settings, bool flip)
+	{
+		// Color mips are filtered in sRGB space when the texture is stored as sRGB. Anisotropy only changes how
+		// the levels are sampled, so it shares a cache file.
+		bool srgb = settings.usage == TextureUsage::Color && settings.srgb;
+		bool twoChannelNormals = settings.usage == TextureUsage::NormalMap && settings.twoChannelNormals;
+		uint32_t values[] = { sCacheVersion, (uint32_t)settings.usage, settings.compress ? 1u : 0u, settings.preferBC7 ? 1u : 0u,
+			settings.mipmaps ? 1u : 0u, flip ? 1u : 0u, srgb ? 1u : 0u, twoChannelNormals ? 1u : 0u };
+		uint64_t key = HashBytes(values, sizeof(values), sourceKey);
+		return key != 0 ? key : 1;
+	}
+
+	std::filesystem::path TextureCompressor::GetCachePath(uint64_t key)
+	{
+		if (key == 0 || Application::s_TextureCacheDir.empty())
+			return std::filesystem::path();
+
+		char fileName[32];
+		snprintf(fileName, sizeof(fileName), "%016llx.tstex", (unsigned long long)key);
+		return Application::s_TextureCacheDir / fileName;
+	}
+}
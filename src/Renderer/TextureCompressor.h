@@ -0,0 +1,74 @@
+#pragma once
+#include "Core/tspch.h"
+#include "Core/Base.h"
+#include "Renderer/Texture.h"
+#include <filesystem>
+
+namespace TS_ENGINE {
+
+	enum class TextureBlockFormat : uint32_t
+	{
+		None = 0,
+		BC1,			// RGB, 8 bytes per 4x4 block
+		BC3,			// RGBA, BC4 alpha and BC1 color, 16 bytes
+		BC4,			// One channel, 8 bytes
+		BC5,			// Two channels, two BC4 blocks, 16 bytes
+		BC7				// RGBA, mode 6 only, 16 bytes
+	};
+
+	// Blocks of a compressed image, rows of blocks from the first row of texels
+	struct CompressedTexture
+	{
+		TextureBlockFormat format = TextureBlockFormat::None;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t channels = 0;			// Of the source image
+		std::vector<uint8_t> data;
+
+		bool IsValid() const { return format != TextureBlockFormat::None && !data.empty(); }
+	};
+
+	/// <summary>
+	/// Encodes 8-bit images to BC block formats on the CPU, one band of block rows per worker, and keys the baked
+	/// containers textures are cached in, so textures are only encoded the first time they're imported. Endpoints come
+	/// from the range of the texels along their principal axis, which is fast and close to what offline encoders reach.
+	/// </summary>
+	class TextureCompressor
+	{
+	public:
+		static constexpr uint32_t sCacheVersion = 2;
+
+		// Block format for an image with the usage, None to keep it uncompressed
+		static TextureBlockFormat ChooseFormat(uint32_t channels, bool hasAlpha, const TextureImportSettings& settings);
+		// Any texel below full opacity, false for images without alpha
+		static bool HasAlpha(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels);
+
+		static uint32_t GetBlockBytes(TextureBlockFormat format);
+		static size_t GetCompressedSize(TextureBlockFormat format, uint32_t width, uint32_t height);
+
+		// Encodes tightly packed 1 to 4 channel texels. BC4 and BC5 take the first channels as they are, the other formats expand grey to RGB.
+		static CompressedTexture Compress(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels, TextureBlockFormat format);
+
+		// FNV-1a, chained through seed
+		static uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+		// Cache key of a source file, changing with its size and modification time. 0 if the file can't be read.
+		static uint64_t GetFileCacheKey(const std::string& path, const TextureImportSettings& settings, bool flip);
+		static uint64_t GetMemoryCacheKey(const uint8_t* data, size_t size, const TextureImportSettings& settings, bool flip);
+
+		// Baked TextureContainer of a key in Application::s_TextureCacheDir, empty if there's no key or cache directory
+		static std::filesystem::path GetCachePath(uint64_t key);
+	private:
+		static constexpr uint32_t sMinBandBlockRows = 16;
+
+		static uint64_t GetSettingsKey(uint64_t sourceKey, const TextureImportSettings& settings, bool flip);
+
+		// Encodes the block rows [firstBlockRow, endBlockRow)
+		static void CompressBand(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channels, TextureBlockFormat format,
+			uint32_t firstBlockRow, uint32_t endBlockRow, uint8_t* blocks);
+
+		// Blocks from 16 texels in rows, RGBA or one value per texel for BC4
+		static void EncodeBC1(const uint8_t rgba[16][4], uint8_t* block);
+		static void EncodeBC4(const uint8_t values[16], uint8_t* block);
+		static void EncodeBC7(const uint8_t rgba[16][4], uint8_t* block);
+	};
+}
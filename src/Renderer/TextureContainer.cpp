@@ -0,0 +1,151 @@
+#include "tspch.h"
+#include "Renderer/TextureContainer.h"
+
+namespace TS_ENGINE {
+
+	bool TextureContainer::Open(const std::filesystem::path& path)
+	{
+		Close();
+
+		if (!mFile.Open(path))
+			return false;
+
+		const uint8_t* data = mFile.GetData();
+		size_t size = mFile.GetSize();
+
+		if (size < sizeof(Header))
+		{
+			mFile.Close();
+			return false;
+		}
+
+		const Header* header = (const Header*)data;
+		TextureBlockFormat format = (TextureBlockFormat)header->format;
+
+		bool valid = std::memcmp(header->identifier, sIdentifier, sizeof(sIdentifier)) == 0 && header->version == sVersion &&
+			header->width > 0 && header->height > 0 && header->levelCount > 0 && header->levelCount <= 32 &&
+			header->channels >= 1 && header->channels <= 4 && (format == TextureBlockFormat::None || TextureCompressor::GetBlockBytes(format) > 0) &&
+			size >= sizeof(Header) + header->levelCount * sizeof(LevelIndex);
+
+		const LevelIndex* levels = (const LevelIndex*)(data + sizeof(Header));
+
+		for (uint32_t level = 0; valid && level < header->levelCount; level++)
+		{
+			valid = levels[level].byteLength == GetLevelSize(format, header->channels, header->width, header->height, level) &&
+				levels[level].byteOffset <= size && levels[level].byteLength <= size - levels[level].byteOffset;
+		}
+
+		if (!valid)
+		{
+			mFile.Close();
+			return false;
+		}
+
+		mHeader = header;
+		mLevels = levels;
+		return true;
+	}
+
+	void TextureContainer::Close()
+	{
+		mFile.Close();
+		mHeader = nullptr;
+		mLevels = nullptr;
+	}
+
+	TextureContainerLevel TextureContainer::GetLevel(uint32_t level) const
+	{
+		TS_CORE_ASSERT(IsOpen() && level < mHeader->levelCount);
+
+		TextureContainerLevel containerLevel;
+		containerLevel.data = mFile.GetData() + mLevels[level].byteOffset;
+		containerLevel.size = (size_t)mLevels[level].byteLength;
+		return containerLevel;
+	}
+
+	size_t TextureContainer::GetLevelSize(TextureBlockFormat format, uint32_t channels, uint32_t width, uint32_t height, uint32_t level)
+	{
+		uint32_t levelWidth = std::max(1u, width >> level);
+		uint32_t levelHeight = std::max(1u, height >> level);
+
+		if (format == TextureBlockFormat::None)
+			return (size_t)levelWidth * levelHeight * channels;
+
+		return TextureCompressor::GetCompressedSize(format, levelWidth, levelHeight);
+	}
+
+	bool TextureContainer::Write(const std::filesystem::path& path, TextureBlockFormat format, uint32_t channels, uint32_t sourceChannels,
+		uint32_t width, uint32_t height, const std::vector<TextureContainerLevel>& levels)
+	{
+		TS_CORE_ASSERT(!levels.empty());
+
+		Header header = {};
+		std::memcpy(header.identifier, sIdentifier, sizeof(sIdentifier));
+		header.version = sVersion;
+		header.format = (uint32_t)format;
+		header.channels = channels;
+		header.sourceChannels = sourceChannels;
+		header.width = width;
+		header.height = height;
+		header.levelCount = (uint32_t)levels.size();
+
+		// Smallest level first, each aligned for the block loads of the upload
+		std::vector<LevelIndex> index(levels.size());
+		uint64_t offset = sizeof(Header) + levels.size() * sizeof(LevelIndex);
+
+		for (size_t level = levels.size(); level-- > 0;)
+		{
+			TS_CORE_ASSERT(levels[level].size == GetLevelSize(format, channels, width, height, (uint32_t)level));
+
+			offset = (offset + sLevelAlignment - 1) / sLevelAlignment * sLevelAlignment;
+			index[level] = { offset, (uint64_t)levels[level].size };
+			offset += levels[level].size;
+		}
+
+		std::error_code error;
+		std::filesystem::create_directories(path.parent_path(), error);
+
+		std::filesystem::path temporaryPath = path;
+		temporaryPath += ".tmp";
+
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+
+			if (!file)
+			{
+				TS_CORE_ERROR("Could not write texture container {0}", temporaryPath.string());
+				return false;
+			}
+
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(index.data()), (std::streamsize)(index.size() * sizeof(LevelIndex)));
+
+			uint64_t position = sizeof(Header) + index.size() * sizeof(LevelIndex);
+			const char padding[sLevelAlignment] = {};
+
+			for (size_t level = levels.size(); level-- > 0;)
+			{
+				file.write(padding, (std::streamsize)(index[level].byteOffset - position));
+				file.write(reinterpret_cast<const char*>(levels[level].data), (std::streamsize)levels[level].size);
+				position = index[level].byteOffset + levels[level].size;
+			}
+
+			if (!file)
+			{
+				file.close();
+				std::filesystem::remove(temporaryPath, error);
+				return false;
+			}
+		}
+
+		std::filesystem::rename(temporaryPath, path, error);
+
+		if (error)
+		{
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+
+		return true;
+	}
+}
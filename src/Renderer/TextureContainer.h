@@ -0,0 +1,75 @@
+#pragma once
+#include "Core/tspch.h"
+#include "Core/Base.h"
+#include "Core/MappedFile.h"
+#include "Renderer/TextureCompressor.h"
+
+namespace TS_ENGINE {
+
+	struct TextureContainerLevel
+	{
+		const uint8_t* data = nullptr;
+		size_t size = 0;
+	};
+
+	/// <summary>
+	/// Baked texture with its whole mip chain, laid out like KTX2: a header, an index of the levels and the level data,
+	/// smallest level first so the start of the file is a complete low resolution texture. Containers are memory mapped
+	/// and uploaded level by level straight from the mapping, without decoding or copying them.
+	/// Levels are BC blocks, or tightly packed 8-bit texels when the format is None.
+	/// </summary>
+	class TextureContainer
+	{
+	public:
+		static constexpr uint32_t sVersion = 1;
+
+		// Maps the file and checks its header and level index against its size. Closes the current file first.
+		bool Open(const std::filesystem::path& path);
+		void Close();
+
+		bool IsOpen() const { return mHeader != nullptr; }
+		TextureBlockFormat GetFormat() const { return (TextureBlockFormat)mHeader->format; }
+		uint32_t GetChannels() const { return mHeader->channels; }
+		uint32_t GetSourceChannels() const { return mHeader->sourceChannels; }
+		uint32_t GetWidth() const { return mHeader->width; }
+		uint32_t GetHeight() const { return mHeader->height; }
+		uint32_t GetLevelCount() const { return mHeader->levelCount; }
+		// Level 0 is the full size image
+		TextureContainerLevel GetLevel(uint32_t level) const;
+
+		// Bytes of a level of an image in the format, with channels per texel when it's uncompressed
+		static size_t GetLevelSize(TextureBlockFormat format, uint32_t channels, uint32_t width, uint32_t height, uint32_t level);
+
+		// Writes levels, largest first, to a file next to path and renames it, so a cut off write never looks like a valid container.
+		// sourceChannels are the channels of the image the texture was imported from.
+		static bool Write(const std::filesystem::path& path, TextureBlockFormat format, uint32_t channels, uint32_t sourceChannels,
+			uint32_t width, uint32_t height, const std::vector<TextureContainerLevel>& levels);
+	private:
+		static constexpr uint32_t sLevelAlignment = 16;
+
+		struct Header
+		{
+			uint8_t identifier[8];
+			uint32_t version;
+			uint32_t format;
+			uint32_t channels;
+			uint32_t sourceChannels;
+			uint32_t width;
+			uint32_t height;
+			uint32_t levelCount;
+			uint32_t reserved;
+		};
+
+		struct LevelIndex
+		{
+			uint64_t byteOffset;
+			uint64_t byteLength;
+		};
+
+		static constexpr uint8_t sIdentifier[8] = { 'T', 'S', 'T', 'E', 'X', '\r', '\n', 0x1A };
+
+		MappedFile mFile;
+		const Header* mHeader = nullptr;
+		const LevelIndex* mLevels = nullptr;
+	};
+}
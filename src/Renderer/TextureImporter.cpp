@@ -0,0 +1,200 @@
+#include "tspch.h"
+#include "Renderer/TextureImporter.h"
+#include "Renderer/MipGenerator.h"
+#include <stb_image.h>
+
+namespace TS_ENGINE {
+
+	uint32_t TextureImage::GetRowCount(uint32_t level) const
+	{
+		uint32_t levelHeight = std::max(1u, height >> level);
+		return format == TextureBlockFormat::None ? levelHeight : (levelHeight + 3) / 4;
+	}
+
+	size_t TextureImage::GetRowBytes(uint32_t level) const
+	{
+		uint32_t levelWidth = std::max(1u, width >> level);
+
+		if (format == TextureBlockFormat::None)
+			return (size_t)levelWidth * channels;
+
+		return (size_t)((levelWidth + 3) / 4) * TextureCompressor::GetBlockBytes(format);
+	}
+
+	Ref<TextureImage> TextureImporter::ImportFile(const std::string& path, const TextureImportSettings& settings)
+	{
+		uint64_t cacheKey = IsBaked(settings) ? TextureCompressor::GetFileCacheKey(path, settings, true) : 0;
+
+		// Baked textures skip decoding the image
+		if (Ref<TextureImage> image = OpenBaked(cacheKey))
+		{
+			TS_CORE_INFO("Texture loaded from baked container: {0}", path);
+			return image;
+		}
+
+		int width, height, channels;
+		stbi_set_flip_vertically_on_load_thread(1);
+		unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 0);
+		TS_CORE_INFO("Texture loaded from path: {0}", path);
+
+		if (!data)
+			return nullptr;
+
+		Ref<TextureImage> image = CreateRef<TextureImage>();
+		image->width = width;
+		image->height = height;
+		image->sourceChannels = channels;
+		Bake(data, settings, cacheKey, *image);
+
+		TS_CORE_INFO("Width: {0}, height : {1}, channel : {2}", width, height, channels);
+
+		stbi_image_free(data);
+		return image;
+	}
+
+	Ref<TextureImage> TextureImporter::ImportMemory(const uint8_t* data, uint32_t size, const TextureImportSettings& settings, bool keepPixels)
+	{
+		uint64_t cacheKey = IsBaked(settings) ? TextureCompressor::GetMemoryCacheKey(data, size, settings, false) : 0;
+
+		// Baked textures skip decoding the image, unless the caller asked for its pixels
+		Ref<TextureImage> baked = OpenBaked(cacheKey);
+
+		if (baked && !keepPixels)
+			return baked;
+
+		int width, height, channels;
+		stbi_set_flip_vertically_on_load_thread(0);
+		unsigned char* pixels = stbi_load_from_memory(data, size, &width, &height, &channels, 0);
+
+		if (!pixels)
+			return baked;
+
+		if (baked)
+		{
+			baked->pixels.assign(pixels, pixels + (size_t)width * height * channels);
+			stbi_image_free(pixels);
+			return baked;
+		}
+
+		Ref<TextureImage> image = CreateRef<TextureImage>();
+		image->width = width;
+		image->height = height;
+		image->sourceChannels = channels;
+
+		//Copy pixels data to mPixels vector
+		if (keepPixels)
+			image->pixels.assign(pixels, pixels + (size_t)width * height * channels);
+
+		Bake(pixels, settings, cacheKey, *image);
+
+		stbi_image_free(pixels);
+		return image;
+	}
+
+	bool TextureImporter::IsBaked(const TextureImportSettings& settings)
+	{
+		return settings.compress || settings.mipmaps;
+	}
+
+	Ref<TextureImage> TextureImporter::OpenBaked(uint64_t cacheKey)
+	{
+		Ref<TextureImage> image = CreateRef<TextureImage>();
+
+		if (!image->container.Open(TextureCompressor::GetCachePath(cacheKey)))
+			return nullptr;
+
+		image->cacheKey = cacheKey;
+
+		const TextureContainer& container = image->container;
+		image->format = container.GetFormat();
+		image->width = container.GetWidth();
+		image->height = container.GetHeight();
+		image->channels = container.GetChannels();
+		image->sourceChannels = container.GetSourceChannels();
+
+		for (uint32_t level = 0; level < container.GetLevelCount(); level++)
+			image->levels.push_back(container.GetLevel(level));
+
+		return image;
+	}
+
+	void TextureImporter::Bake(const uint8_t* pixels, const TextureImportSettings& settings, uint64_t cacheKey, TextureImage& image)
+	{
+		auto startTime = std::chrono::high_resolution_clock::now();
+
+		bool color = settings.usage == TextureUsage::Color;
+		uint32_t width = image.width;
+		uint32_t height = image.height;
+		uint32_t channels = image.sourceChannels;
+
+		// Levels end up in ownedLevels, level 0 included, since the decoded image is freed after baking
+		std::vector<std::vector<uint8_t>>& ownedLevels = image.ownedLevels;
+		ownedLevels.emplace_back();
+
+		// Grey colors are expanded, a red texture would need a swizzle that texture arrays don't share
+		if (color && channels < 3)
+		{
+			size_t texelCount = (size_t)width * height;
+			ownedLevels[0].resize(texelCount * 4);
+
+			for (size_t i = 0; i < texelCount; i++)
+			{
+				uint8_t grey = pixels[i * channels];
+				ownedLevels[0][i * 4 + 0] = grey;
+				ownedLevels[0][i * 4 + 1] = grey;
+				ownedLevels[0][i * 4 + 2] = grey;
+				ownedLevels[0][i * 4 + 3] = channels == 2 ? pixels[i * 2 + 1] : 255;
+			}
+
+			channels = 4;
+		}
+		else
+		{
+			ownedLevels[0].assign(pixels, pixels + (size_t)width * height * channels);
+		}
+
+		if (settings.mipmaps)
+		{
+			std::vector<std::vector<uint8_t>> mips = MipGenerator::Generate(ownedLevels[0].data(), width, height, channels, color && settings.srgb);
+
+			for (auto& mip : mips)
+				ownedLevels.push_back(std::move(mip));
+		}
+
+		bool hasAlpha = settings.compress && TextureCompressor::HasAlpha(ownedLevels[0].data(), width, height, channels);
+		TextureBlockFormat format = TextureCompressor::ChooseFormat(channels, hasAlpha, settings);
+
+		if (format != TextureBlockFormat::None)
+		{
+			for (uint32_t level = 0; level < ownedLevels.size(); level++)
+			{
+				uint32_t levelWidth = std::max(1u, width >> level);
+				uint32_t levelHeight = std::max(1u, height >> level);
+				ownedLevels[level] = std::move(TextureCompressor::Compress(ownedLevels[level].data(), levelWidth, levelHeight, channels, format).data);
+			}
+		}
+
+		image.format = format;
+		image.channels = channels;
+		image.levels.clear();
+
+		for (const auto& level : ownedLevels)
+			image.levels.push_back({ level.data(), level.size() });
+
+		if (!IsBaked(settings))
+			return;
+
+		size_t bakedSize = 0;
+
+		for (const auto& level : image.levels)
+			bakedSize += level.size;
+
+		float bakeTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+		TS_CORE_INFO("Baked {0}x{1} texture with {2} levels to {3} KB in {4} ms", width, height, image.levels.size(), bakedSize / 1024, bakeTime);
+
+		std::filesystem::path cachePath = TextureCompressor::GetCachePath(cacheKey);
+
+		if (!cachePath.empty() && TextureContainer::Write(cachePath, format, channels, image.sourceChannels, width, height, image.levels))
+			image.cacheKey = cacheKey;
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include "Core/tspch.h"
+#include "Core/Base.h"
+#include "Renderer/TextureContainer.h"
+
+namespace TS_ENGINE {
+
+	// Levels of a texture ready to upload, from a baked container or built at import
+	struct TextureImage
+	{
+		TextureBlockFormat format = TextureBlockFormat::None;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t channels = 0;					// Of the stored texels when uncompressed
+		uint32_t sourceChannels = 0;			// Of the imported image
+		uint64_t cacheKey = 0;					// Of the baked container holding the levels, 0 if there is none
+		std::vector<TextureContainerLevel> levels;		// Level 0 first, pointing into container or ownedLevels
+		std::vector<unsigned char> pixels;		// Decoded source texels, only kept when asked for
+
+		TextureContainer container;
+		std::vector<std::vector<uint8_t>> ownedLevels;
+
+		// Rows of a level as uploaded, rows of blocks when compressed
+		uint32_t GetRowCount(uint32_t level) const;
+		size_t GetRowBytes(uint32_t level) const;
+	};
+
+	/// <summary>
+	/// CPU side of loading textures: opens the baked container of a source, or decodes it, expands grey colors,
+	/// builds the mip chain, block compresses it and bakes the result. Never touches GL, so it runs on worker threads.
+	/// </summary>
+	class TextureImporter
+	{
+	public:
+		// nullptr if the image can't be decoded. Files are flipped so their first row is at the bottom.
+		static Ref<TextureImage> ImportFile(const std::string& path, const TextureImportSettings& settings);
+		// Embedded images aren't flipped. keepPixels holds on to the decoded texels, decoding baked images just for them.
+		static Ref<TextureImage> ImportMemory(const uint8_t* data, uint32_t size, const TextureImportSettings& settings, bool keepPixels);
+
+		// Textures with import work worth keeping get a baked container
+		static bool IsBaked(const TextureImportSettings& settings);
+	private:
+		static Ref<TextureImage> OpenBaked(uint64_t cacheKey);
+		// Builds the levels of decoded texels and bakes them under cacheKey
+		static void Bake(const uint8_t* pixels, const TextureImportSettings& settings, uint64_t cacheKey, TextureImage& image);
+	};
+}
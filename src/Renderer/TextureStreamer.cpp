@@ -0,0 +1,154 @@
+#include "tspch.h"
+#include "Renderer/TextureStreamer.h"
+#include "Platform/OpenGL/OpenGLTextureStreamer.h"
+#include "Renderer/TextureArray.h"
+#include "Core/JobSystem.h"
+#include "Application.h"
+
+namespace TS_ENGINE {
+
+	Ref<TextureStreamer> TextureStreamer::mInstance = nullptr;
+
+	Ref<TextureStreamer> TextureStreamer::GetInstance()
+	{
+		//ToDo: Add support for multiple APIs
+		if (mInstance == nullptr)
+			mInstance = CreateRef<OpenGLTextureStreamer>();
+
+		return mInstance;
+	}
+
+	Ref<Texture2D> TextureStreamer::Load(const std::string& path, const TextureImportSettings& settings)
+	{
+		TextureImportSettings importSettings = GetSupportedSettings(settings);
+
+		Request request;
+		request.texture = CreatePlaceholder(path);
+		request.settings = importSettings;
+		request.import = JobSystem::GetInstance()->Async([path, importSettings]() { return TextureImporter::ImportFile(path, importSettings); });
+		mRequests.push_back(std::move(request));
+
+		return mRequests.back().texture;
+	}
+
+	Ref<Texture2D> TextureStreamer::Load(const char* name, const unsigned char* pixelData, uint32_t len, const TextureImportSettings& settings, bool keepPixels)
+	{
+		TextureImportSettings importSettings = GetSupportedSettings(settings);
+		Ref<std::vector<uint8_t>> encoded = CreateRef<std::vector<uint8_t>>(pixelData, pixelData + len);
+
+		Request request;
+		request.texture = CreatePlaceholder(name);
+		request.settings = importSettings;
+		request.import = JobSystem::GetInstance()->Async([encoded, importSettings, keepPixels]()
+			{
+				return TextureImporter::ImportMemory(encoded->data(), (uint32_t)encoded->size(), importSettings, keepPixels);
+			});
+		mRequests.push_back(std::move(request));
+
+		return mRequests.back().texture;
+	}
+
+	void TextureStreamer::Update()
+	{
+		if (mRequests.empty())
+			return;
+
+		Poll(false);
+		Upload(sUploadBudget);
+		NextFrame();
+	}
+
+	void TextureStreamer::Flush()
+	{
+		// Each pass fills one region of the ring, NextFrame waits for the GPU to free the next one
+		while (!mRequests.empty())
+		{
+			Poll(true);
+			Upload(sUploadBudget);
+			NextFrame();
+		}
+	}
+
+	void TextureStreamer::Poll(bool wait)
+	{
+		for (auto& request : mRequests)
+		{
+			if (request.image || request.done)
+				continue;
+
+			if (!wait && request.import.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				continue;
+
+			Ref<TextureImage> image = request.import.get();
+
+			if (!image || image->levels.empty())
+			{
+				// Keeps the placeholder
+				TS_CORE_ERROR("Failed to load texture: {0}", request.texture->GetPath());
+				request.done = true;
+				continue;
+			}
+
+			AllocateStorage(*request.texture, *image, request.settings);
+			request.image = image;
+			request.level = (uint32_t)image->levels.size() - 1;
+		}
+
+		mRequests.erase(std::remove_if(mRequests.begin(), mRequests.end(), [](const Request& request) { return request.done; }), mRequests.end());
+	}
+
+	void TextureStreamer::Upload(size_t budget)
+	{
+		while (budget > 0)
+		{
+			// The request whose next level is smallest, which finishes a visible improvement soonest
+			Request* next = nullptr;
+
+			for (auto& request : mRequests)
+			{
+				if (!request.image || request.done)
+					continue;
+
+				if (!next || request.image->levels[request.level].size < next->image->levels[next->level].size)
+					next = &request;
+			}
+
+			if (!next)
+				break;
+
+			const TextureImage& image = *next->image;
+			uint32_t rowCount = image.GetRowCount(next->level);
+			size_t rowBytes = image.GetRowBytes(next->level);
+			uint32_t rows = (uint32_t)std::min<size_t>(rowCount - next->row, std::max<size_t>(1, budget / rowBytes));
+
+			if (!UploadRows(*next->texture, image, next->level, next->row, rows))
+				break;
+
+			budget -= std::min(budget, rows * rowBytes);
+			next->row += rows;
+
+			if (next->row < rowCount)
+				continue;
+
+			SetStreamedLevel(*next->texture, next->level);
+			next->row = 0;
+
+			if (next->level == 0)
+				Finish(*next);
+			else
+				next->level--;
+		}
+
+		mRequests.erase(std::remove_if(mRequests.begin(), mRequests.end(), [](const Request& request) { return request.done; }), mRequests.end());
+	}
+
+	void TextureStreamer::Finish(Request& request)
+	{
+		// Array layers copy all levels, so textures only join once they're complete
+		if (Application::GetInstance().mTextureArrays)
+			TextureArrayManager::GetInstance()->Add(request.texture);
+
+		request.image = nullptr;
+		request.done = true;
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "Core/Base.h"
+#include "Renderer/Texture.h"
+#include "Renderer/TextureImporter.h"
+#include <future>
+
+namespace TS_ENGINE {
+
+	/// <summary>
+	/// Loads textures without stalling the frame. Load returns a 1x1 placeholder right away and imports the image on the
+	/// JobSystem. Update allocates the storage of finished imports and uploads their levels through a staging ring,
+	/// at most sUploadBudget bytes a frame. The smallest level of any texture goes first, so every texture gets a blurry
+	/// version early and sharpens as its larger levels arrive. Textures join arrays once their last level is uploaded.
+	/// </summary>
+	class TextureStreamer
+	{
+	public:
+		static constexpr uint32_t sUploadBudget = 8 << 20;
+
+		virtual ~TextureStreamer() = default;
+
+		Ref<Texture2D> Load(const std::string& path, const TextureImportSettings& settings);
+		// Copies the encoded image, which embedded textures free once their model is imported
+		Ref<Texture2D> Load(const char* name, const unsigned char* pixelData, uint32_t len, const TextureImportSettings& settings, bool keepPixels);
+
+		// Allocates finished imports and uploads levels within the budget. Called once a frame.
+		void Update();
+		// Waits for every import and uploads all of it, for code reading sizes or pixels of textures it just loaded
+		void Flush();
+
+		uint32_t GetPendingCount() const { return (uint32_t)mRequests.size(); }
+
+		static Ref<TextureStreamer> GetInstance();
+	protected:
+		// 1x1 texture sampled until the smallest level arrived
+		virtual Ref<Texture2D> CreatePlaceholder(const std::string& path) = 0;
+		// Settings the driver can store, asked on this thread before importing
+		virtual TextureImportSettings GetSupportedSettings(const TextureImportSettings& settings) = 0;
+		// Storage for all levels of the image, which hands its pixels to the texture
+		virtual void AllocateStorage(Texture2D& texture, TextureImage& image, const TextureImportSettings& settings) = 0;
+		// Stages rows of a level and copies them into the storage. False if the staging ring is full this frame, rows that
+		// don't fit an empty ring are uploaded directly.
+		virtual bool UploadRows(Texture2D& texture, const TextureImage& image, uint32_t level, uint32_t firstRow, uint32_t rowCount) = 0;
+		// Levels from level down to the smallest are uploaded and sampled from now on
+		virtual void SetStreamedLevel(Texture2D& texture, uint32_t level) = 0;
+		// Moves the staging ring on to its next region
+		virtual void NextFrame() = 0;
+	private:
+		static Ref<TextureStreamer> mInstance;
+
+		struct Request
+		{
+			Ref<Texture2D> texture;
+			std::future<Ref<TextureImage>> import;
+			TextureImportSettings settings;
+			Ref<TextureImage> image;			// Set once the storage is allocated
+			uint32_t level = 0;					// Uploading, the levels below are done
+			uint32_t row = 0;					// Rows of level already uploaded
+			bool done = false;
+		};
+
+		// Allocates the storage of finished imports, waiting for all of them if wait is set
+		void Poll(bool wait);
+		// Uploads rows up to budget bytes, smallest level first, until the staging ring is full
+		void Upload(size_t budget);
+		void Finish(Request& request);
+
+		std::vector<Request> mRequests;
+	};
+}
@@ -18,6 +18,9 @@ namespace TS_ENGINE {
 		virtual const std::vector<Ref<VertexBuffer>>& GetVertexBuffers() const = 0;
 		virtual const Ref<IndexBuffer>& GetIndexBuffer() const = 0;
 
+		// Points the attributes of the first vertex buffer at offset in another buffer, for geometry streamed every frame
+		virtual void SetVertexSource(uint32_t buffer, uint32_t offset) = 0;
+
 		static Ref<VertexArray> Create();
 
 		virtual unsigned int GetRendererID() const = 0;
@@ -0,0 +1,166 @@
+#include "tspch.h"
+#include "VertexFormat.h"
+#include "Primitive/Mesh.h"
+#include <glm/gtc/packing.hpp>
+
+namespace TS_ENGINE {
+
+	static_assert(sizeof(Vertex) == StandardVertexLayout::sStride, "Vertex size changed, update StandardVertexLayout");
+
+	// Largest UV error half floats may add, a quarter texel at 1024. UVs in [0, 1] always fit, tiled ones past 1 only if they are close to a half value.
+	static constexpr float sHalfUVTolerance = 1.0f / 4096.0f;
+
+	namespace VertexFormatUtils
+	{
+		BufferLayout GetBufferLayout(VertexFormat format)
+		{
+			switch (format)
+			{
+			case VertexFormat::STANDARD:
+				return CreateBufferLayout<StandardVertexLayout>();
+			case VertexFormat::STATIC:
+				return CreateBufferLayout<StaticVertexLayout>();
+			case VertexFormat::SKINNED:
+				return CreateBufferLayout<SkinnedVertexLayout>();
+			case VertexFormat::POSITION:
+				return CreateBufferLayout<PositionVertexLayout>();
+			}
+
+			TS_CORE_ASSERT(false, "Unknown VertexFormat!");
+			return BufferLayout();
+		}
+
+		uint32_t GetStride(VertexFormat format)
+		{
+			switch (format)
+			{
+			case VertexFormat::STANDARD:
+				return StandardVertexLayout::sStride;
+			case VertexFormat::STATIC:
+				return StaticVertexLayout::sStride;
+			case VertexFormat::SKINNED:
+				return SkinnedVertexLayout::sStride;
+			case VertexFormat::POSITION:
+				return PositionVertexLayout::sStride;
+			}
+
+			TS_CORE_ASSERT(false, "Unknown VertexFormat!");
+			return 0;
+		}
+
+		static bool UVsFitHalf(const std::vector<Vertex>& vertices)
+		{
+			for (const Vertex& vertex : vertices)
+			{
+				Vector2 roundTrip = glm::unpackHalf2x16(glm::packHalf2x16(vertex.texCoord));
+
+				if (glm::any(glm::greaterThan(glm::abs(roundTrip - vertex.texCoord), Vector2(sHalfUVTolerance))))
+					return false;
+			}
+
+			return true;
+		}
+
+		VertexFormat SelectFormat(const std::vector<Vertex>& vertices, bool hasBoneInfluence, bool positionOnly)
+		{
+			if (positionOnly)
+				return VertexFormat::POSITION;
+
+			// STATIC and SKINNED store UVs as half floats
+			if (!UVsFitHalf(vertices))
+				return VertexFormat::STANDARD;
+
+			if (!hasBoneInfluence)
+				return VertexFormat::STATIC;
+
+			for (const Vertex& vertex : vertices)
+			{
+				bool hasInfluence = false;
+
+				for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+				{
+					if (vertex.mBoneIds[i] > 255)
+						return VertexFormat::STANDARD;
+
+					if (vertex.mBoneIds[i] >= 0 && vertex.mWeights[i] > 0.0f)
+						hasInfluence = true;
+				}
+
+				// Shaders skip -1 ids, which can not be stored in 8 bits
+				if (!hasInfluence)
+					return VertexFormat::STANDARD;
+			}
+
+			return VertexFormat::SKINNED;
+		}
+
+		static uint32_t PackNormal(const Vector3& normal)
+		{
+			return glm::packSnorm3x10_1x2(Vector4(normal, 0.0f));
+		}
+
+		std::vector<uint8_t> Pack(const std::vector<Vertex>& vertices, VertexFormat format)
+		{
+			std::vector<uint8_t> data((size_t)GetStride(format) * vertices.size());
+
+			switch (format)
+			{
+			case VertexFormat::STANDARD:
+			{
+				memcpy(data.data(), vertices.data(), data.size());
+				break;
+			}
+			case VertexFormat::POSITION:
+			{
+				PositionVertex* dst = reinterpret_cast<PositionVertex*>(data.data());
+
+				for (size_t i = 0; i < vertices.size(); i++)
+					dst[i].position = Vector3(vertices[i].position);
+				break;
+			}
+			case VertexFormat::STATIC:
+			{
+				StaticVertex* dst = reinterpret_cast<StaticVertex*>(data.data());
+
+				for (size_t i = 0; i < vertices.size(); i++)
+				{
+					dst[i].position = Vector3(vertices[i].position);
+					dst[i].texCoord = glm::packHalf2x16(vertices[i].texCoord);
+					dst[i].normal = PackNormal(vertices[i].normal);
+				}
+				break;
+			}
+			case VertexFormat::SKINNED:
+			{
+				SkinnedVertex* dst = reinterpret_cast<SkinnedVertex*>(data.data());
+
+				for (size_t i = 0; i < vertices.size(); i++)
+				{
+					const Vertex& src = vertices[i];
+
+					dst[i].position = Vector3(src.position);
+					dst[i].texCoord = glm::packHalf2x16(src.texCoord);
+					dst[i].normal = PackNormal(src.normal);
+
+					Vector4 weights(0.0f);
+
+					for (int j = 0; j < MAX_BONE_INFLUENCE; j++)
+					{
+						bool used = src.mBoneIds[j] >= 0;
+						dst[i].boneIds[j] = used ? (uint8_t)src.mBoneIds[j] : 0;
+						weights[j] = used ? src.mWeights[j] : 0.0f;
+					}
+
+					glm::u16vec4 packedWeights(glm::round(glm::clamp(weights, 0.0f, 1.0f) * 65535.0f));
+
+					for (int j = 0; j < MAX_BONE_INFLUENCE; j++)
+						dst[i].weights[j] = packedWeights[j];
+				}
+				break;
+			}
+			}
+
+			return data;
+		}
+	}
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include "Renderer/Buffer.h"
+
+namespace TS_ENGINE {
+
+	struct Vertex;
+
+	/// <summary>
+	/// GPU side vertex formats. The CPU copy of a mesh always stays in the full Vertex layout,
+	/// the format only decides what gets packed into the vertex buffer.
+	/// Attribute locations are kept stable across formats (0 position, 1 uv, 2 normal, 3 bone ids, 4 weights)
+	/// so the same shaders work with all of them. Attributes missing from a format fall back to the
+	/// generic vertex attribute values set in OpenGLRendererAPI::Init.
+	/// </summary>
+	enum class VertexFormat
+	{
+		STANDARD,	// Full 68 byte Vertex (fallback)
+		STATIC,		// 20 bytes: float3 position, half2 uv, 10-10-10-2 normal
+		SKINNED,	// 32 bytes: STATIC + uint8 bone ids + unorm16 weights
+		POSITION	// 12 bytes: float3 position (lines, gizmos)
+	};
+
+	struct VertexAttributeDesc
+	{
+		ShaderDataType type;
+		const char* name;
+		bool normalized;
+	};
+
+	struct StandardVertexLayout
+	{
+		static constexpr VertexAttributeDesc sAttributes[] = {
+			{ ShaderDataType::FLOAT4, "a_Position", false },	// Position
+			{ ShaderDataType::FLOAT2, "a_TexCoord", false },	// UV
+			{ ShaderDataType::FLOAT3, "a_Normal", false },		// Normal
+			{ ShaderDataType::INT4,   "a_BoneIds", false },		// Bone IDs
+			{ ShaderDataType::FLOAT4, "a_Weights", false }		// Bone Weights
+		};
+		static constexpr uint32_t sStride = 68;
+	};
+
+	struct PositionVertex
+	{
+		Vector3 position;
+	};
+
+	struct PositionVertexLayout
+	{
+		static constexpr VertexAttributeDesc sAttributes[] = {
+			{ ShaderDataType::FLOAT3, "a_Position", false }		// Position
+		};
+		static constexpr uint32_t sStride = sizeof(PositionVertex);
+	};
+
+	struct StaticVertex
+	{
+		Vector3 position;
+		uint32_t texCoord;		// packHalf2x16
+		uint32_t normal;		// packSnorm3x10_1x2
+	};
+
+	struct StaticVertexLayout
+	{
+		static constexpr VertexAttributeDesc sAttributes[] = {
+			{ ShaderDataType::FLOAT3, "a_Position", false },		// Position
+			{ ShaderDataType::HALF2, "a_TexCoord", false },			// UV
+			{ ShaderDataType::PACKED_NORMAL, "a_Normal", true }		// Normal
+		};
+		static constexpr uint32_t sStride = sizeof(StaticVertex);
+	};
+
+	struct SkinnedVertex
+	{
+		Vector3 position;
+		uint32_t texCoord;		// packHalf2x16
+		uint32_t normal;		// packSnorm3x10_1x2
+		uint8_t boneIds[4];		// Unused slots are bone 0 with weight 0
+		uint16_t weights[4];	// unorm16
+	};
+
+	struct SkinnedVertexLayout
+	{
+		static constexpr VertexAttributeDesc sAttributes[] = {
+			{ ShaderDataType::FLOAT3, "a_Position", false },		// Position
+			{ ShaderDataType::HALF2, "a_TexCoord", false },			// UV
+			{ ShaderDataType::PACKED_NORMAL, "a_Normal", true },	// Normal
+			{ ShaderDataType::UBYTE4, "a_BoneIds", false },			// Bone IDs
+			{ ShaderDataType::USHORT4, "a_Weights", true }			// Bone Weights
+		};
+		static constexpr uint32_t sStride = sizeof(SkinnedVertex);
+	};
+
+	template<typename Layout>
+	constexpr uint32_t CalculateLayoutStride()
+	{
+		uint32_t stride = 0;
+
+		for (const auto& attribute : Layout::sAttributes)
+			stride += ShaderDataTypeSize(attribute.type);
+
+		return stride;
+	}
+
+	static_assert(CalculateLayoutStride<StandardVertexLayout>() == StandardVertexLayout::sStride, "Standard vertex layout does not match Vertex");
+	static_assert(CalculateLayoutStride<PositionVertexLayout>() == PositionVertexLayout::sStride, "Position vertex layout does not match PositionVertex");
+	static_assert(CalculateLayoutStride<StaticVertexLayout>() == StaticVertexLayout::sStride, "Static vertex layout does not match StaticVertex");
+	static_assert(CalculateLayoutStride<SkinnedVertexLayout>() == SkinnedVertexLayout::sStride, "Skinned vertex layout does not match SkinnedVertex");
+
+	template<typename Layout>
+	BufferLayout CreateBufferLayout()
+	{
+		std::vector<BufferElement> elements;
+		elements.reserve(std::size(Layout::sAttributes));
+
+		for (const auto& attribute : Layout::sAttributes)
+			elements.push_back(BufferElement(attribute.type, attribute.name, attribute.normalized));
+
+		return BufferLayout(elements);
+	}
+
+	namespace VertexFormatUtils
+	{
+		BufferLayout GetBufferLayout(VertexFormat format);
+		uint32_t GetStride(VertexFormat format);
+
+		/// <summary>
+		/// Picks the smallest format that can represent the vertices. Packed formats keep normals at 10 bits, and are only
+		/// used when every UV survives the half float round trip within a quarter texel at 1024.
+		/// Skinned meshes fall back to STANDARD if a bone id does not fit in 8 bits or a vertex has no influence.
+		/// </summary>
+		VertexFormat SelectFormat(const std::vector<Vertex>& vertices, bool hasBoneInfluence, bool positionOnly);
+
+		/// <summary>
+		/// Packs vertices into the given format. Returns the packed byte buffer.
+		/// </summary>
+		std::vector<uint8_t> Pack(const std::vector<Vertex>& vertices, VertexFormat format);
+	}
+}
@@ -0,0 +1,645 @@
+#include "tspch.h"
+#include "DynamicAABBTree.h"
+#include <chrono>
+#include <random>
+
+namespace TS_ENGINE {
+
+	// Fat AABBs are extended by this multiple of the displacement to predict movement
+	static constexpr float sDisplacementMultiplier = 4.0f;
+
+	DynamicAABBTree::DynamicAABBTree(float fatMargin) :
+		mFatMargin(fatMargin)
+	{
+		mNodes.reserve(16);
+	}
+
+	DynamicAABBTree::~DynamicAABBTree()
+	{
+		mNodes.clear();
+	}
+
+	int DynamicAABBTree::AllocateNode()
+	{
+		// Grow the pool and link the new nodes into the free list
+		if (mFreeList == sNullNode)
+		{
+			int oldCapacity = (int)mNodes.size();
+			int newCapacity = glm::max(16, oldCapacity * 2);
+			mNodes.resize(newCapacity);
+
+			for (int i = oldCapacity; i < newCapacity - 1; i++)
+			{
+				mNodes[i].parentOrNext = i + 1;
+				mNodes[i].height = -1;
+			}
+
+			mNodes[newCapacity - 1].parentOrNext = sNullNode;
+			mNodes[newCapacity - 1].height = -1;
+			mFreeList = oldCapacity;
+		}
+
+		int nodeId = mFreeList;
+		mFreeList = mNodes[nodeId].parentOrNext;
+
+		TreeNode& node = mNodes[nodeId];
+		node.parentOrNext = sNullNode;
+		node.child1 = sNullNode;
+		node.child2 = sNullNode;
+		node.height = 0;
+		node.userData = nullptr;
+
+		return nodeId;
+	}
+
+	void DynamicAABBTree::FreeNode(int nodeId)
+	{
+		TS_CORE_ASSERT(0 <= nodeId && nodeId < (int)mNodes.size());
+
+		mNodes[nodeId].parentOrNext = mFreeList;
+		mNodes[nodeId].height = -1;
+		mNodes[nodeId].userData = nullptr;
+		mFreeList = nodeId;
+	}
+
+	int DynamicAABBTree::CreateProxy(const AABB& aabb, void* userData)
+	{
+		int proxyId = AllocateNode();
+
+		Vector3 margin(mFatMargin);
+		mNodes[proxyId].aabb = AABB(aabb.min - margin, aabb.max + margin);
+		mNodes[proxyId].userData = userData;
+		mNodes[proxyId].height = 0;
+
+		InsertLeaf(proxyId);
+		mProxyCount++;
+
+		return proxyId;
+	}
+
+	void DynamicAABBTree::DestroyProxy(int proxyId)
+	{
+		TS_CORE_ASSERT(0 <= proxyId && proxyId < (int)mNodes.size());
+		TS_CORE_ASSERT(mNodes[proxyId].IsLeaf());
+
+		RemoveLeaf(proxyId);
+		FreeNode(proxyId);
+		mProxyCount--;
+	}
+
+	bool DynamicAABBTree::MoveProxy(int proxyId, const AABB& aabb, const Vector3& displacement)
+	{
+		TS_CORE_ASSERT(0 <= proxyId && proxyId < (int)mNodes.size());
+		TS_CORE_ASSERT(mNodes[proxyId].IsLeaf());
+
+		// Still inside the fat AABB, nothing to do
+		if (mNodes[proxyId].aabb.Contains(aabb))
+			return false;
+
+		RemoveLeaf(proxyId);
+
+		Vector3 margin(mFatMargin);
+		AABB fatAABB(aabb.min - margin, aabb.max + margin);
+
+		// Predict movement
+		Vector3 predicted = displacement * sDisplacementMultiplier;
+		fatAABB.min += glm::min(predicted, Vector3(0.0f));
+		fatAABB.max += glm::max(predicted, Vector3(0.0f));
+
+		mNodes[proxyId].aabb = fatAABB;
+
+		InsertLeaf(proxyId);
+
+		return true;
+	}
+
+	void DynamicAABBTree::Clear()
+	{
+		mNodes.clear();
+		mRoot = sNullNode;
+		mFreeList = sNullNode;
+		mProxyCount = 0;
+	}
+
+	void* DynamicAABBTree::GetUserData(int proxyId) const
+	{
+		TS_CORE_ASSERT(0 <= proxyId && proxyId < (int)mNodes.size());
+		return mNodes[proxyId].userData;
+	}
+
+	const AABB& DynamicAABBTree::GetFatAABB(int proxyId) const
+	{
+		TS_CORE_ASSERT(0 <= proxyId && proxyId < (int)mNodes.size());
+		return mNodes[proxyId].aabb;
+	}
+
+	void DynamicAABBTree::InsertLeaf(int leaf)
+	{
+		if (mRoot == sNullNode)
+		{
+			mRoot = leaf;
+			mNodes[mRoot].parentOrNext = sNullNode;
+			return;
+		}
+
+		// Find the best sibling with the surface area heuristic
+		AABB leafAABB = mNodes[leaf].aabb;
+		int index = mRoot;
+
+		while (!mNodes[index].IsLeaf())
+		{
+			int child1 = mNodes[index].child1;
+			int child2 = mNodes[index].child2;
+
+			float area = mNodes[index].aabb.GetSurfaceArea();
+			float combinedArea = AABB::Union(mNodes[index].aabb, leafAABB).GetSurfaceArea();
+
+			// Cost of creating a new parent for this node and the new leaf
+			float cost = 2.0f * combinedArea;
+
+			// Minimum cost of pushing the leaf further down the tree
+			float inheritanceCost = 2.0f * (combinedArea - area);
+
+			auto descendCost = [&](int child)
+				{
+					float childCombinedArea = AABB::Union(leafAABB, mNodes[child].aabb).GetSurfaceArea();
+
+					if (mNodes[child].IsLeaf())
+						return childCombinedArea + inheritanceCost;
+
+					return (childCombinedArea - mNodes[child].aabb.GetSurfaceArea()) + inheritanceCost;
+				};
+
+			float cost1 = descendCost(child1);
+			float cost2 = descendCost(child2);
+
+			if (cost < cost1 && cost < cost2)
+				break;
+
+			index = cost1 < cost2 ? child1 : child2;
+		}
+
+		int sibling = index;
+
+		// Create a new parent
+		int oldParent = mNodes[sibling].parentOrNext;
+		int newParent = AllocateNode();
+		mNodes[newParent].parentOrNext = oldParent;
+		mNodes[newParent].aabb = AABB::Union(leafAABB, mNodes[sibling].aabb);
+		mNodes[newParent].height = mNodes[sibling].height + 1;
+
+		if (oldParent != sNullNode)
+		{
+			if (mNodes[oldParent].child1 == sibling)
+				mNodes[oldParent].child1 = newParent;
+			else
+				mNodes[oldParent].child2 = newParent;
+		}
+		else
+		{
+			mRoot = newParent;
+		}
+
+		mNodes[newParent].child1 = sibling;
+		mNodes[newParent].child2 = leaf;
+		mNodes[sibling].parentOrNext = newParent;
+		mNodes[leaf].parentOrNext = newParent;
+
+		// Walk back up fixing heights and AABBs
+		index = mNodes[leaf].parentOrNext;
+
+		while (index != sNullNode)
+		{
+			index = Balance(index);
+
+			int child1 = mNodes[index].child1;
+			int child2 = mNodes[index].child2;
+
+			TS_CORE_ASSERT(child1 != sNullNode && child2 != sNullNode);
+
+			mNodes[index].height = 1 + glm::max(mNodes[child1].height, mNodes[child2].height);
+			mNodes[index].aabb = AABB::Union(mNodes[child1].aabb, mNodes[child2].aabb);
+
+			index = mNodes[index].parentOrNext;
+		}
+	}
+
+	void DynamicAABBTree::RemoveLeaf(int leaf)
+	{
+		if (leaf == mRoot)
+		{
+			mRoot = sNullNode;
+			return;
+		}
+
+		int parent = mNodes[leaf].parentOrNext;
+		int grandParent = mNodes[parent].parentOrNext;
+		int sibling = mNodes[parent].child1 == leaf ? mNodes[parent].child2 : mNodes[parent].child1;
+
+		if (grandParent != sNullNode)
+		{
+			// Connect sibling to grand parent and destroy parent
+			if (mNodes[grandParent].child1 == parent)
+				mNodes[grandParent].child1 = sibling;
+			else
+				mNodes[grandParent].child2 = sibling;
+
+			mNodes[sibling].parentOrNext = grandParent;
+			FreeNode(parent);
+
+			int index = grandParent;
+
+			while (index != sNullNode)
+			{
+				index = Balance(index);
+
+				int child1 = mNodes[index].child1;
+				int child2 = mNodes[index].child2;
+
+				mNodes[index].aabb = AABB::Union(mNodes[child1].aabb, mNodes[child2].aabb);
+				mNodes[index].height = 1 + glm::max(mNodes[child1].height, mNodes[child2].height);
+
+				index = mNodes[index].parentOrNext;
+			}
+		}
+		else
+		{
+			mRoot = sibling;
+			mNodes[sibling].parentOrNext = sNullNode;
+			FreeNode(parent);
+		}
+	}
+
+	// Performs a left or right rotation if node A is imbalanced. Returns the new root index of the subtree.
+	int DynamicAABBTree::Balance(int iA)
+	{
+		TS_CORE_ASSERT(iA != sNullNode);
+
+		TreeNode* A = &mNodes[iA];
+
+		if (A->IsLeaf() || A->height < 2)
+			return iA;
+
+		int iB = A->child1;
+		int iC = A->child2;
+		TreeNode* B = &mNodes[iB];
+		TreeNode* C = &mNodes[iC];
+
+		int balance = C->height - B->height;
+
+		// Rotate C up
+		if (balance > 1)
+		{
+			int iF = C->child1;
+			int iG = C->child2;
+			TreeNode* F = &mNodes[iF];
+			TreeNode* G = &mNodes[iG];
+
+			// Swap A and C
+			C->child1 = iA;
+			C->parentOrNext = A->parentOrNext;
+			A->parentOrNext = iC;
+
+			// A's old parent should point to C
+			if (C->parentOrNext != sNullNode)
+			{
+				if (mNodes[C->parentOrNext].child1 == iA)
+					mNodes[C->parentOrNext].child1 = iC;
+				else
+					mNodes[C->parentOrNext].child2 = iC;
+			}
+			else
+			{
+				mRoot = iC;
+			}
+
+			// Rotate
+			if (F->height > G->height)
+			{
+				C->child2 = iF;
+				A->child2 = iG;
+				G->parentOrNext = iA;
+				A->aabb = AABB::Union(B->aabb, G->aabb);
+				C->aabb = AABB::Union(A->aabb, F->aabb);
+
+				A->height = 1 + glm::max(B->height, G->height);
+				C->height = 1 + glm::max(A->height, F->height);
+			}
+			else
+			{
+				C->child2 = iG;
+				A->child2 = iF;
+				F->parentOrNext = iA;
+				A->aabb = AABB::Union(B->aabb, F->aabb);
+				C->aabb = AABB::Union(A->aabb, G->aabb);
+
+				A->height = 1 + glm::max(B->height, F->height);
+				C->height = 1 + glm::max(A->height, G->height);
+			}
+
+			return iC;
+		}
+
+		// Rotate B up
+		if (balance < -1)
+		{
+			int iD = B->child1;
+			int iE = B->child2;
+			TreeNode* D = &mNodes[iD];
+			TreeNode* E = &mNodes[iE];
+
+			// Swap A and B
+			B->child1 = iA;
+			B->parentOrNext = A->parentOrNext;
+			A->parentOrNext = iB;
+
+			// A's old parent should point to B
+			if (B->parentOrNext != sNullNode)
+			{
+				if (mNodes[B->parentOrNext].child1 == iA)
+					mNodes[B->parentOrNext].child1 = iB;
+				else
+					mNodes[B->parentOrNext].child2 = iB;
+			}
+			else
+			{
+				mRoot = iB;
+			}
+
+			// Rotate
+			if (D->height > E->height)
+			{
+				B->child2 = iD;
+				A->child1 = iE;
+				E->parentOrNext = iA;
+				A->aabb = AABB::Union(C->aabb, E->aabb);
+				B->aabb = AABB::Union(A->aabb, D->aabb);
+
+				A->height = 1 + glm::max(C->height, E->height);
+				B->height = 1 + glm::max(A->height, D->height);
+			}
+			else
+			{
+				B->child2 = iE;
+				A->child1 = iD;
+				D->parentOrNext = iA;
+				A->aabb = AABB::Union(C->aabb, D->aabb);
+				B->aabb = AABB::Union(A->aabb, E->aabb);
+
+				A->height = 1 + glm::max(C->height, D->height);
+				B->height = 1 + glm::max(A->height, E->height);
+			}
+
+			return iB;
+		}
+
+		return iA;
+	}
+
+	int DynamicAABBTree::FindNearest(const Vector3& point, float maxDistance) const
+	{
+		if (mRoot == sNullNode)
+			return sNullNode;
+
+		// Best first search ordered by distance to node bounds
+		using Entry = std::pair<float, int>;
+		std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+
+		float bestDistanceSquared = maxDistance == FLT_MAX ? FLT_MAX : maxDistance * maxDistance;
+		int bestProxy = sNullNode;
+
+		queue.push({ mNodes[mRoot].aabb.DistanceSquared(point), mRoot });
+
+		while (!queue.empty())
+		{
+			auto [distanceSquared, nodeId] = queue.top();
+			queue.pop();
+
+			// Everything left is farther away
+			if (distanceSquared > bestDistanceSquared)
+				break;
+
+			const TreeNode& node = mNodes[nodeId];
+
+			if (node.IsLeaf())
+			{
+				bestDistanceSquared = distanceSquared;
+				bestProxy = nodeId;
+				break;
+			}
+
+			queue.push({ mNodes[node.child1].aabb.DistanceSquared(point), node.child1 });
+			queue.push({ mNodes[node.child2].aabb.DistanceSquared(point), node.child2 });
+		}
+
+		return bestProxy;
+	}
+
+	int DynamicAABBTree::GetHeight() const
+	{
+		return mRoot == sNullNode ? 0 : mNodes[mRoot].height;
+	}
+
+	int DynamicAABBTree::GetMaxBalance() const
+	{
+		int maxBalance = 0;
+
+		for (const TreeNode& node : mNodes)
+		{
+			if (node.height <= 1)
+				continue;
+
+			int balance = abs(mNodes[node.child2].height - mNodes[node.child1].height);
+			maxBalance = glm::max(maxBalance, balance);
+		}
+
+		return maxBalance;
+	}
+
+	float DynamicAABBTree::GetAreaRatio() const
+	{
+		if (mRoot == sNullNode)
+			return 0.0f;
+
+		float rootArea = mNodes[mRoot].aabb.GetSurfaceArea();
+		float totalArea = 0.0f;
+
+		for (const TreeNode& node : mNodes)
+		{
+			if (node.height < 0)
+				continue;
+
+			totalArea += node.aabb.GetSurfaceArea();
+		}
+
+		return rootArea > 0.0f ? totalArea / rootArea : 0.0f;
+	}
+
+	int DynamicAABBTree::ComputeHeight(int nodeId) const
+	{
+		const TreeNode& node = mNodes[nodeId];
+
+		if (node.IsLeaf())
+			return 0;
+
+		return 1 + glm::max(ComputeHeight(node.child1), ComputeHeight(node.child2));
+	}
+
+	void DynamicAABBTree::ValidateStructure(int nodeId) const
+	{
+		if (nodeId == sNullNode)
+			return;
+
+		if (nodeId == mRoot)
+			TS_CORE_ASSERT(mNodes[nodeId].parentOrNext == sNullNode);
+
+		const TreeNode& node = mNodes[nodeId];
+
+		if (node.IsLeaf())
+		{
+			TS_CORE_ASSERT(node.child2 == sNullNode);
+			TS_CORE_ASSERT(node.height == 0);
+			return;
+		}
+
+		TS_CORE_ASSERT(mNodes[node.child1].parentOrNext == nodeId);
+		TS_CORE_ASSERT(mNodes[node.child2].parentOrNext == nodeId);
+
+		ValidateStructure(node.child1);
+		ValidateStructure(node.child2);
+	}
+
+	void DynamicAABBTree::ValidateMetrics(int nodeId) const
+	{
+		if (nodeId == sNullNode)
+			return;
+
+		const TreeNode& node = mNodes[nodeId];
+
+		if (node.IsLeaf())
+			return;
+
+		int height = 1 + glm::max(mNodes[node.child1].height, mNodes[node.child2].height);
+		TS_CORE_ASSERT(node.height == height);
+
+		AABB aabb = AABB::Union(mNodes[node.child1].aabb, mNodes[node.child2].aabb);
+		TS_CORE_ASSERT(aabb.min == node.aabb.min && aabb.max == node.aabb.max);
+
+		ValidateMetrics(node.child1);
+		ValidateMetrics(node.child2);
+	}
+
+	void DynamicAABBTree::Validate() const
+	{
+		ValidateStructure(mRoot);
+		ValidateMetrics(mRoot);
+
+		uint32_t freeCount = 0;
+
+		for (int freeIndex = mFreeList; freeIndex != sNullNode; freeIndex = mNodes[freeIndex].parentOrNext)
+			freeCount++;
+
+		TS_CORE_ASSERT(GetHeight() == (mRoot == sNullNode ? 0 : ComputeHeight(mRoot)));
+		TS_CORE_ASSERT((uint32_t)mNodes.size() - freeCount == (mProxyCount == 0 ? 0 : 2 * mProxyCount - 1));
+	}
+
+	void DynamicAABBTree::Benchmark(uint32_t numProxies, uint32_t numFrames, uint32_t numQueries)
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		auto elapsedMs = [](Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+		std::uniform_real_distribution<float> size(0.5f, 5.0f);
+		std::uniform_real_distribution<float> velocity(-2.0f, 2.0f);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+		std::vector<AABB> boxes(numProxies);
+		std::vector<Vector3> velocities(numProxies);
+		std::vector<int> proxies(numProxies);
+
+		for (uint32_t i = 0; i < numProxies; i++)
+		{
+			Vector3 center(position(random), position(random), position(random));
+			Vector3 extents(size(random), size(random), size(random));
+			boxes[i] = AABB(center - extents, center + extents);
+			velocities[i] = Vector3(velocity(random), velocity(random), velocity(random));
+		}
+
+		DynamicAABBTree tree;
+
+		// Build
+		auto start = Clock::now();
+
+		for (uint32_t i = 0; i < numProxies; i++)
+			proxies[i] = tree.CreateProxy(boxes[i], nullptr);
+
+		double buildMs = elapsedMs(start);
+
+		// Refit with every proxy moving each frame
+		uint32_t reinsertions = 0;
+		start = Clock::now();
+
+		for (uint32_t frame = 0; frame < numFrames; frame++)
+		{
+			for (uint32_t i = 0; i < numProxies; i++)
+			{
+				Vector3 displacement = velocities[i] * 0.016f;
+				boxes[i].min += displacement;
+				boxes[i].max += displacement;
+
+				if (tree.MoveProxy(proxies[i], boxes[i], displacement))
+					reinsertions++;
+			}
+		}
+
+		double refitMs = elapsedMs(start);
+
+		// Region queries
+		uint32_t regionHits = 0;
+		start = Clock::now();
+
+		for (uint32_t i = 0; i < numQueries; i++)
+		{
+			Vector3 center(position(random), position(random), position(random));
+			AABB region(center - Vector3(20.0f), center + Vector3(20.0f));
+			tree.QueryRegion(region, [&regionHits](int) { regionHits++; return true; });
+		}
+
+		double regionMs = elapsedMs(start);
+
+		// Closest hit ray casts
+		uint32_t rayHits = 0;
+		start = Clock::now();
+
+		for (uint32_t i = 0; i < numQueries; i++)
+		{
+			Vector3 origin(position(random), position(random), position(random));
+			Vector3 direction = glm::normalize(Vector3(unit(random), unit(random), unit(random)) + Vector3(0.001f));
+			bool hit = false;
+
+			tree.RayCast(origin, direction, 1000.0f, [&hit](int, float distance) { hit = true; return distance; });
+
+			if (hit)
+				rayHits++;
+		}
+
+		double rayMs = elapsedMs(start);
+
+		// Nearest proxy lookups
+		start = Clock::now();
+
+		for (uint32_t i = 0; i < numQueries; i++)
+			tree.FindNearest(Vector3(position(random), position(random), position(random)));
+
+		double nearestMs = elapsedMs(start);
+
+		TS_CORE_INFO("DynamicAABBTree benchmark: {0} proxies, height {1}, max balance {2}, area ratio {3:.2f}",
+			numProxies, tree.GetHeight(), tree.GetMaxBalance(), tree.GetAreaRatio());
+		TS_CORE_INFO("  Build: {0:.3f} ms", buildMs);
+		TS_CORE_INFO("  Refit: {0:.3f} ms per frame ({1} reinsertions over {2} frames)", refitMs / numFrames, reinsertions, numFrames);
+		TS_CORE_INFO("  Region queries: {0:.0f} per second ({1} hits)", numQueries / (regionMs / 1000.0), regionHits);
+		TS_CORE_INFO("  Ray casts: {0:.0f} per second ({1} hits)", numQueries / (rayMs / 1000.0), rayHits);
+		TS_CORE_INFO("  Nearest queries: {0:.0f} per second", numQueries / (nearestMs / 1000.0));
+	}
+}
@@ -0,0 +1,257 @@
+#pragma once
+#include "Renderer/Bounds.h"
+#include "Renderer/Frustum.h"
+
+namespace TS_ENGINE {
+
+	/// <summary>
+	/// Incremental bounding volume hierarchy of fattened AABBs (same scheme as Box2D's b2DynamicTree, extended to 3D).
+	/// Leaves are proxies carrying user data. Proxies that move inside their fat AABB cost nothing,
+	/// otherwise they are reinserted with surface area heuristic and the tree is rebalanced with rotations.
+	/// </summary>
+	class DynamicAABBTree
+	{
+	public:
+		static constexpr int sNullNode = -1;
+
+		DynamicAABBTree(float fatMargin = 0.1f);
+		~DynamicAABBTree();
+
+		// Creates a proxy and returns its id
+		int CreateProxy(const AABB& aabb, void* userData);
+		void DestroyProxy(int proxyId);
+
+		/// <summary>
+		/// Refits a proxy. Returns true if the proxy left its fat AABB and was reinserted.
+		/// The displacement is used to predict movement and enlarge the fat AABB in that direction.
+		/// </summary>
+		bool MoveProxy(int proxyId, const AABB& aabb, const Vector3& displacement = Vector3(0.0f));
+
+		void Clear();
+
+		void* GetUserData(int proxyId) const;
+		const AABB& GetFatAABB(int proxyId) const;
+
+		// Calls callback(proxyId) for each proxy overlapping the box. Return false from the callback to stop.
+		template<typename Callback>
+		void QueryRegion(const AABB& aabb, Callback callback) const;
+
+		// Calls callback(proxyId) for each proxy intersecting the frustum. Return false from the callback to stop.
+		template<typename Callback>
+		void QueryFrustum(const Frustum& frustum, Callback callback) const;
+
+		/// <summary>
+		/// Calls callback(proxyId, entryDistance) for each proxy hit by the ray, nearest subtrees first.
+		/// The callback returns the new max distance: 0 stops, the hit distance clips the ray, maxDistance continues.
+		/// </summary>
+		template<typename Callback>
+		void RayCast(const Vector3& origin, const Vector3& direction, float maxDistance, Callback callback) const;
+
+		// Calls callback(proxyId) for each proxy whose fat AABB is within radius of the point
+		template<typename Callback>
+		void QueryRadius(const Vector3& point, float radius, Callback callback) const;
+
+		// Returns the proxy whose fat AABB is closest to the point, or sNullNode
+		int FindNearest(const Vector3& point, float maxDistance = FLT_MAX) const;
+
+		int GetHeight() const;
+		int GetMaxBalance() const;
+		// Sum of node surface areas divided by root surface area, lower is better
+		float GetAreaRatio() const;
+		uint32_t GetProxyCount() const { return mProxyCount; }
+
+		// Checks structure and heights (debug only)
+		void Validate() const;
+
+		/// <summary>
+		/// Logs build, refit and query timings for numProxies boxes moving for numFrames frames
+		/// </summary>
+		static void Benchmark(uint32_t numProxies = 5000, uint32_t numFrames = 100, uint32_t numQueries = 10000);
+	private:
+		struct TreeNode
+		{
+			AABB aabb;
+			void* userData = nullptr;
+			int parentOrNext = sNullNode;	// Parent in the tree, next free node in the free list
+			int child1 = sNullNode;
+			int child2 = sNullNode;
+			int height = -1;				// Leaf = 0, free node = -1
+
+			bool IsLeaf() const { return child1 == sNullNode; }
+		};
+
+		int AllocateNode();
+		void FreeNode(int nodeId);
+
+		void InsertLeaf(int leaf);
+		void RemoveLeaf(int leaf);
+		int Balance(int nodeId);
+
+		int ComputeHeight(int nodeId) const;
+		void ValidateStructure(int nodeId) const;
+		void ValidateMetrics(int nodeId) const;
+
+		std::vector<TreeNode> mNodes;
+		int mRoot = sNullNode;
+		int mFreeList = sNullNode;
+		uint32_t mProxyCount = 0;
+		float mFatMargin;
+	};
+
+	template<typename Callback>
+	void DynamicAABBTree::QueryRegion(const AABB& aabb, Callback callback) const
+	{
+		std::vector<int> stack;
+		stack.reserve(64);
+		stack.push_back(mRoot);
+
+		while (!stack.empty())
+		{
+			int nodeId = stack.back();
+			stack.pop_back();
+
+			if (nodeId == sNullNode)
+				continue;
+
+			const TreeNode& node = mNodes[nodeId];
+
+			if (!node.aabb.Intersects(aabb))
+				continue;
+
+			if (node.IsLeaf())
+			{
+				if (!callback(nodeId))
+					return;
+			}
+			else
+			{
+				stack.push_back(node.child1);
+				stack.push_back(node.child2);
+			}
+		}
+	}
+
+	template<typename Callback>
+	void DynamicAABBTree::QueryFrustum(const Frustum& frustum, Callback callback) const
+	{
+		std::vector<int> stack;
+		stack.reserve(64);
+		stack.push_back(mRoot);
+
+		while (!stack.empty())
+		{
+			int nodeId = stack.back();
+			stack.pop_back();
+
+			if (nodeId == sNullNode)
+				continue;
+
+			const TreeNode& node = mNodes[nodeId];
+
+			if (!frustum.IsBoxVisible(node.aabb))
+				continue;
+
+			if (node.IsLeaf())
+			{
+				if (!callback(nodeId))
+					return;
+			}
+			else
+			{
+				stack.push_back(node.child1);
+				stack.push_back(node.child2);
+			}
+		}
+	}
+
+	template<typename Callback>
+	void DynamicAABBTree::RayCast(const Vector3& origin, const Vector3& direction, float maxDistance, Callback callback) const
+	{
+		Vector3 inverseDirection = 1.0f / direction;
+
+		std::vector<int> stack;
+		stack.reserve(64);
+		stack.push_back(mRoot);
+
+		while (!stack.empty())
+		{
+			int nodeId = stack.back();
+			stack.pop_back();
+
+			if (nodeId == sNullNode)
+				continue;
+
+			const TreeNode& node = mNodes[nodeId];
+			float tHit;
+
+			if (!node.aabb.IntersectsRay(origin, inverseDirection, maxDistance, tHit))
+				continue;
+
+			if (node.IsLeaf())
+			{
+				float newMaxDistance = callback(nodeId, tHit);
+
+				if (newMaxDistance <= 0.0f)
+					return;
+
+				maxDistance = glm::min(maxDistance, newMaxDistance);
+			}
+			else
+			{
+				// Push the farther child first so the nearer one is visited first
+				float t1, t2;
+				bool hit1 = mNodes[node.child1].aabb.IntersectsRay(origin, inverseDirection, maxDistance, t1);
+				bool hit2 = mNodes[node.child2].aabb.IntersectsRay(origin, inverseDirection, maxDistance, t2);
+
+				if (hit1 && hit2)
+				{
+					stack.push_back(t1 < t2 ? node.child2 : node.child1);
+					stack.push_back(t1 < t2 ? node.child1 : node.child2);
+				}
+				else if (hit1)
+				{
+					stack.push_back(node.child1);
+				}
+				else if (hit2)
+				{
+					stack.push_back(node.child2);
+				}
+			}
+		}
+	}
+
+	template<typename Callback>
+	void DynamicAABBTree::QueryRadius(const Vector3& point, float radius, Callback callback) const
+	{
+		float radiusSquared = radius * radius;
+
+		std::vector<int> stack;
+		stack.reserve(64);
+		stack.push_back(mRoot);
+
+		while (!stack.empty())
+		{
+			int nodeId = stack.back();
+			stack.pop_back();
+
+			if (nodeId == sNullNode)
+				continue;
+
+			const TreeNode& node = mNodes[nodeId];
+
+			if (node.aabb.DistanceSquared(point) > radiusSquared)
+				continue;
+
+			if (node.IsLeaf())
+			{
+				if (!callback(nodeId))
+					return;
+			}
+			else
+			{
+				stack.push_back(node.child1);
+				stack.push_back(node.child2);
+			}
+		}
+	}
+}
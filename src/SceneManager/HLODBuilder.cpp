@@ -0,0 +1,182 @@
+#include "tspch.h"
+#include "SceneManager/HLODBuilder.h"
+#include "Primitive/MeshSimplifier.h"
+#include "Renderer/MaterialManager.h"
+#include "Renderer/MaterialAtlas.h"
+
+namespace TS_ENGINE {
+
+	HLODCell HLODBuilder::GetCell(Node* node, float cellSize)
+	{
+		Vector3 cell = glm::floor(node->GetMeshesWorldBounds().GetCenter() / cellSize);
+		return { (int)cell.x, (int)cell.y, (int)cell.z };
+	}
+
+	AABB HLODBuilder::GetCellBounds(const HLODCell& cell, float cellSize)
+	{
+		Vector3 min = Vector3((float)std::get<0>(cell), (float)std::get<1>(cell), (float)std::get<2>(cell)) * cellSize;
+		return AABB(min, min + Vector3(cellSize));
+	}
+
+	bool HLODBuilder::IsStatic(Node* node)
+	{
+		for (Node* ancestor = node; ancestor; ancestor = ancestor->GetParentNode().get())
+		{
+			if (ancestor->IsStatic())
+				return true;
+		}
+
+		return false;
+	}
+
+	bool HLODBuilder::IsEligible(Node* node)
+	{
+		if (node->GetChildCount() > 0 || !node->HasMeshes() || node->GetBoneInfluence() || !node->IsCullable()
+			|| node->GetSceneCamera() || node->GetImpostor() || node->IsStaticBatched() || !node->GetMeshesWorldBounds().IsValid()
+			|| !IsStatic(node))
+			return false;
+
+#ifdef TS_ENGINE_EDITOR
+		for (Node* ancestor = node; ancestor; ancestor = ancestor->GetParentNode().get())
+		{
+			if (!ancestor->m_Enabled || !ancestor->IsVisibleInEditor())
+				return false;
+		}
+#endif
+
+		for (auto& mesh : node->GetMeshes())
+		{
+			if (mesh->GetDrawMode() != DrawMode::TRIANGLE || mesh->HasBoneInfluence() || mesh->GetNumIndices() == 0 || !MaterialAtlas::FitsAtlas(mesh))
+				return false;
+		}
+
+		return true;
+	}
+
+	bool HLODBuilder::MergeNodes(const std::vector<Ref<Node>>& nodes, TextureCompositor& compositor, HLODProxyGeometry& geometry)
+	{
+		MaterialAtlas atlas;
+		std::vector<std::pair<uint32_t, Ref<Material>>> meshEntries;	// Atlas entry and material of each merged mesh
+		std::vector<uint32_t> vertexMeshes;								// Merged mesh of each vertex
+		geometry.nodeRanges.resize(nodes.size());
+
+		// Merge in world space, each material becomes an atlas entry of its diffuse map tinted by its diffuse color
+		for (uint32_t n = 0; n < (uint32_t)nodes.size(); n++)
+		{
+			const Matrix4& worldMatrix = nodes[n]->GetTransform()->GetWorldTransformationMatrix();
+			Matrix3 normalMatrix = glm::transpose(glm::inverse(Matrix3(worldMatrix)));
+
+			for (auto& mesh : nodes[n]->GetMeshes())
+			{
+				meshEntries.emplace_back(atlas.AddMaterial(mesh->GetMaterial()), mesh->GetMaterial());
+				uint32_t baseVertex = (uint32_t)geometry.vertices.size();
+
+				for (const auto& vertex : mesh->GetVertices())
+				{
+					Vertex merged;
+					merged.position = worldMatrix * Vector4(Vector3(vertex.position), 1.0f);
+					merged.texCoord = vertex.texCoord;
+
+					Vector3 normal = normalMatrix * vertex.normal;
+					float normalLength = glm::length(normal);
+					merged.normal = normalLength > 0.0f ? normal / normalLength : normal;
+
+					geometry.vertices.push_back(merged);
+					geometry.vertexNodes.push_back(n);
+					vertexMeshes.push_back((uint32_t)meshEntries.size() - 1);
+				}
+
+				for (uint32_t index : mesh->GetIndices())
+					geometry.indices.push_back(baseVertex + index);
+			}
+		}
+
+		geometry.atlasTexture = atlas.Build(compositor);
+
+		if (!geometry.atlasTexture)
+		{
+			TS_CORE_WARN("HLOD proxy of {0} nodes skipped", nodes.size());
+			return false;
+		}
+
+		for (size_t i = 0; i < geometry.vertices.size(); i++)
+		{
+			const auto& [entry, material] = meshEntries[vertexMeshes[i]];
+			geometry.vertices[i].texCoord = atlas.GetAtlasUV(entry, *material, geometry.vertices[i].texCoord);
+		}
+
+		geometry.sourceIndexCount = geometry.indices.size();
+		return true;
+	}
+
+	void HLODBuilder::Simplify(HLODProxyGeometry& geometry)
+	{
+		std::vector<Vector3> positions(geometry.vertices.size());
+
+		for (size_t i = 0; i < geometry.vertices.size(); i++)
+			positions[i] = Vector3(geometry.vertices[i].position);
+
+		size_t targetIndexCount = std::max<size_t>(3, (size_t)(geometry.sourceIndexCount * sProxyIndexRatio) / 3 * 3);
+		std::vector<uint32_t> indices = MeshSimplifier::Simplify(positions, geometry.indices, targetIndexCount, sProxyMaxError);
+
+		// Triangles of a node are kept together, a triangle belongs to the node of its first vertex
+		uint32_t nodeCount = (uint32_t)geometry.nodeRanges.size();
+		std::vector<uint32_t> nodeTriangles(nodeCount + 1, 0);
+
+		for (size_t t = 0; t < indices.size(); t += 3)
+			nodeTriangles[geometry.vertexNodes[indices[t]] + 1]++;
+
+		for (uint32_t n = 0; n < nodeCount; n++)
+		{
+			nodeTriangles[n + 1] += nodeTriangles[n];
+			geometry.nodeRanges[n] = { nodeTriangles[n] * 3, (nodeTriangles[n + 1] - nodeTriangles[n]) * 3 };
+		}
+
+		std::vector<uint32_t> sortedIndices(indices.size());
+
+		for (size_t t = 0; t < indices.size(); t += 3)
+		{
+			uint32_t destination = nodeTriangles[geometry.vertexNodes[indices[t]]]++ * 3;
+			sortedIndices[destination] = indices[t];
+			sortedIndices[destination + 1] = indices[t + 1];
+			sortedIndices[destination + 2] = indices[t + 2];
+		}
+
+		// Drop the vertices the simplified triangles no longer use
+		std::vector<uint32_t> remap(geometry.vertices.size(), UINT32_MAX);
+		std::vector<Vertex> proxyVertices;
+
+		for (uint32_t& index : sortedIndices)
+		{
+			if (remap[index] == UINT32_MAX)
+			{
+				remap[index] = (uint32_t)proxyVertices.size();
+				proxyVertices.push_back(geometry.vertices[index]);
+			}
+
+			index = remap[index];
+		}
+
+		geometry.vertices = std::move(proxyVertices);
+		geometry.indices = std::move(sortedIndices);
+		geometry.vertexNodes.clear();
+	}
+
+	Ref<Mesh> HLODBuilder::CreateProxyMesh(HLODProxyGeometry& geometry)
+	{
+		if (geometry.indices.empty())
+			return nullptr;
+
+		Ref<Mesh> proxyMesh = CreateRef<Mesh>();
+		proxyMesh->SetName("HLODProxy");
+		proxyMesh->SetMaterial(MaterialAtlas::CreateAtlasMaterial(MaterialManager::GetInstance()->GetUnlitMaterial(), geometry.atlasTexture));
+		proxyMesh->SetVertices(std::move(geometry.vertices));
+		proxyMesh->SetIndices(std::move(geometry.indices));
+		proxyMesh->Create();
+
+		TS_CORE_INFO("HLOD proxy of {0} nodes: {1} -> {2} triangles, {3}x{4} atlas", geometry.nodeRanges.size(), geometry.sourceIndexCount / 3,
+			proxyMesh->GetNumIndices() / 3, geometry.atlasTexture->GetWidth(), geometry.atlasTexture->GetHeight());
+
+		return proxyMesh;
+	}
+}
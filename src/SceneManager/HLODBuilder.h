@@ -0,0 +1,68 @@
+#pragma once
+#include "SceneManager/Node.h"
+#include "Renderer/TextureCompositor.h"
+
+namespace TS_ENGINE {
+
+	// Grid cell of the nodes merged into one cluster
+	using HLODCell = std::tuple<int, int, int>;
+
+	/// <summary>
+	/// Spatially close static nodes merged into one simplified, atlas textured proxy mesh in world space.
+	/// </summary>
+	struct HLODCluster
+	{
+		HLODCell cell = { 0, 0, 0 };
+		std::vector<Ref<Node>> nodes;
+		std::vector<Matrix4> nodeWorldMatrices;		// At build time, the proxy is stale once a node moves
+		std::vector<IndexRange> nodeRanges;			// Proxy triangles left of each node, drawn with its entity ID by picks
+		Ref<Mesh> proxyMesh;						// nullptr while the cell has no proxy
+		AABB bounds;								// World space
+	};
+
+	// Merged geometry of a cluster, simplified on a worker
+	struct HLODProxyGeometry
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		std::vector<uint32_t> vertexNodes;			// Cluster node each vertex came from
+		std::vector<IndexRange> nodeRanges;			// One per node, filled by Simplify
+		Ref<Texture2D> atlasTexture;
+		size_t sourceIndexCount = 0;
+	};
+
+	class HLODBuilder
+	{
+	public:
+		static constexpr uint32_t sMinClusterNodes = 2;
+		static constexpr float sProxyIndexRatio = 0.25f;		// Proxy triangles as a fraction of the merged triangles
+		static constexpr float sProxyMaxError = 0.02f;			// Simplification error limit, fraction of the cluster extent
+
+		// Cell of the node's meshes bounds center. Needs world bounds (Node::ComputeWorldBounds).
+		static HLODCell GetCell(Node* node, float cellSize);
+		// Cell space bounds, for gathering the nodes of a cell from the spatial tree
+		static AABB GetCellBounds(const HLODCell& cell, float cellSize);
+
+		// The node or one of its ancestors is flagged static
+		static bool IsStatic(Node* node);
+
+		/// <summary>
+		/// Leaves of static subtrees with triangle meshes whose UVs stay inside their texture, so the textures can be packed into one atlas,
+		/// that aren't drawn by a static batch and are drawn at all (enabled with their ancestors in the editor).
+		/// </summary>
+		static bool IsEligible(Node* node);
+
+		/// <summary>
+		/// Merges the nodes' meshes in world space and packs their materials into one atlas, which needs the GL context.
+		/// Returns false if the atlas couldn't be built.
+		/// </summary>
+		static bool MergeNodes(const std::vector<Ref<Node>>& nodes, TextureCompositor& compositor, HLODProxyGeometry& geometry);
+		/// <summary>
+		/// Simplifies merged geometry, drops the vertices it no longer uses and orders the triangles by node.
+		/// CPU only, so it runs on a worker.
+		/// </summary>
+		static void Simplify(HLODProxyGeometry& geometry);
+		// Creates the proxy mesh of simplified geometry. Needs the GL context.
+		static Ref<Mesh> CreateProxyMesh(HLODProxyGeometry& geometry);
+	};
+}
@@ -1,6 +1,11 @@
 #include "tspch.h"
 #include "SceneManager/Node.h"
 #include "Core/Factory.h"
+#include "Renderer/Frustum.h"
+#include "Renderer/OcclusionCuller.h"
+#include "Renderer/ImpostorRenderer.h"
+#include "Renderer/DynamicBatcher.h"
+#include "Renderer/RenderCommand.h"
 
 #ifdef TS_ENGINE_EDITOR
 #include <imgui.h>
@@ -8,6 +13,8 @@
 
 namespace TS_ENGINE
 {
+	uint32_t Node::sHierarchyVersion = 0;
+
 	Node::Node()
 	{
 		mIsInitialized = false;
@@ -33,7 +40,7 @@ namespace TS_ENGINE
 		EntityManager::GetInstance()->Remove(mNodeRef->GetEntity()->GetEntityID());
 
 #ifdef TS_ENGINE_EDITOR
-		m_Enabled = false;
+		SetEnabled(false);
 #endif
 
 		mParentNode->RemoveChild(mNodeRef);
@@ -59,6 +66,8 @@ namespace TS_ENGINE
 		duplicateNode->mNodeRef = duplicateNode;
 		duplicateNode->mNodeRef->CloneMeshes(mNodeRef->mMeshes);
 		duplicateNode->mNodeRef->mModelPath = mNodeRef->mModelPath;
+		duplicateNode->mNodeRef->mImpostor = mNodeRef->mImpostor;
+		duplicateNode->mNodeRef->mIsStatic = mNodeRef->mIsStatic;
 
 		duplicateNode->mNodeRef->mTransform = CreateRef<Transform>();
 		duplicateNode->mNodeRef->mTransform->mLocalPosition = mNodeRef->mTransform->mLocalPosition;
@@ -212,6 +221,7 @@ namespace TS_ENGINE
 	{
 		child->mParentNode = mNodeRef;
 		mChildren.push_back(child);
+		sHierarchyVersion++;
 		//TS_CORE_INFO("{0} is set as child of {1}", child->mEntity->GetName().c_str(), mNodeRef->mEntity->GetName().c_str());
 
 		child->UpdateSiblings();
@@ -221,6 +231,7 @@ namespace TS_ENGINE
 	{
 		mChildren.erase(std::remove(mChildren.begin(), mChildren.end(), child), mChildren.end());
 		child->UpdateSiblings();
+		sHierarchyVersion++;
 	}
 
 	void Node::RemoveAllChildren()
@@ -232,6 +243,7 @@ namespace TS_ENGINE
 		}
 
 		mChildren.clear();
+		sHierarchyVersion++;
 	}
 
 	Ref<Node> Node::GetChildAt(uint32_t childIndex) const
@@ -344,7 +356,8 @@ namespace TS_ENGINE
 	}
 
 	// If there is no parent set parentTransformModelMatrix to identity
-	void Node::Update(Ref<Shader> shader, float deltaTime)
+	void Node::Update(Ref<Shader> shader, float deltaTime, const Frustum* frustum, OcclusionCuller* occlusionCuller, GPUCuller* gpuCuller,
+		const RenderView* view)
 	{
 		TS_CORE_ASSERT(mIsInitialized, "Node is not initialized!");
 
@@ -355,24 +368,180 @@ namespace TS_ENGINE
 		if (m_Enabled)
 #endif
 		{
+			bool countStats = !view || view->countStats;
+
+			// Drawn by static batches
+			size_t meshCount = view && view->staticBatches && mIsStaticBatched ? 0 : mMeshes.size();
+
+			// Test all meshes of this node in one batch
+			bool cullMeshes = frustum && meshCount > 0 && mMeshWorldBounds.size() == mMeshes.size();
+
+			if (cullMeshes)
+			{
+				mVisibilityScratch.resize(mMeshes.size());
+				frustum->TestBoxes(mMeshWorldBounds.data(), mMeshWorldBounds.size(), mVisibilityScratch.data());
+			}
+
+			// Single sided meshes cull back faces in camera passes. Mirroring flips the winding, so mirrored nodes draw both sides.
+			bool cullBackFaces = view && meshCount > 0 && glm::determinant(Matrix3(mTransform->GetWorldTransformationMatrix())) > 0.0f;
+
 			// Draw Meshes
-			for (auto& mesh : mMeshes)
+			for (size_t i = 0; i < meshCount; i++)
 			{
+				auto& mesh = mMeshes[i];
+
+				// Culled on the GPU and drawn with the other instances of its draw group
+				if (gpuCuller && i < mMeshDrawGroups.size() && mMeshDrawGroups[i] >= 0)
+					continue;
+
+				// Meshes without valid bounds (e.g. skinned) are always drawn
+				if (cullMeshes && !mVisibilityScratch[i] && mMeshWorldBounds[i].IsValid())
+				{
+					if (countStats)
+						Application::GetInstance().AddCulledMeshes(1);
+					continue;
+				}
+
+				if (occlusionCuller && i < mMeshWorldBounds.size() && mMeshWorldBounds[i].IsValid() && occlusionCuller->IsOccluded(mMeshWorldBounds[i]))
+				{
+					if (countStats)
+						Application::GetInstance().AddOccludedMeshes(1);
+					continue;
+				}
+
+				uint32_t lod = 0;
+
+				if (view && view->lodCamera && mesh->GetLODCount() > 0)
+				{
+					float screenSize = Mesh::GetScreenSize(mesh->GetBoundingSphere().Transform(mTransform->GetWorldTransformationMatrix()), view->cameraPosition, view->projectionMatrix);
+					lod = mesh->SelectLOD(view->lodCamera, screenSize, view->keepLODs);
+				}
+
+				RenderCommand::EnableBackFaceCulling(cullBackFaces && !mesh->IsDoubleSided() && mesh->GetDrawMode() == DrawMode::TRIANGLE);
+
+				// Meshlets only cover the base LOD
+				if (lod == 0 && view && view->clusterCulling && mesh->HasMeshlets())
+				{
 #ifdef TS_ENGINE_EDITOR
-				mesh->Render(mEntity->GetEntityID(), Application::GetInstance().IsTextureModeEnabled());
+					bool rendered = mesh->RenderClusters(mEntity->GetEntityID(), Application::GetInstance().IsTextureModeEnabled(), frustum, mTransform->GetWorldTransformationMatrix(), *view);
 #else
-				mesh->Render(Application::GetInstance().IsTextureModeEnabled());
+					bool rendered = mesh->RenderClusters(Application::GetInstance().IsTextureModeEnabled(), frustum, mTransform->GetWorldTransformationMatrix(), *view);
 #endif
+					if (countStats)
+					{
+						if (rendered)
+							Application::GetInstance().AddVisibleMeshes(1);
+						else
+							Application::GetInstance().AddCulledMeshes(1);
+					}
+
+					continue;
+				}
+
+				// Small meshes are merged with others of the same material and drawn when the batcher is flushed
+#ifdef TS_ENGINE_EDITOR
+				bool batched = lod == 0 && view && view->dynamicBatcher && view->dynamicBatcher->Submit(mEntity->GetEntityID(), mesh, mTransform->GetWorldTransformationMatrix());
+#else
+				bool batched = lod == 0 && view && view->dynamicBatcher && view->dynamicBatcher->Submit(mesh, mTransform->GetWorldTransformationMatrix());
+#endif
+				if (!batched)
+				{
+#ifdef TS_ENGINE_EDITOR
+					mesh->Render(mEntity->GetEntityID(), Application::GetInstance().IsTextureModeEnabled(), lod);
+#else
+					mesh->Render(Application::GetInstance().IsTextureModeEnabled(), lod);
+#endif
+				}
+
+				if (countStats)
+					Application::GetInstance().AddVisibleMeshes(1);
+			}
+
+			// Hierarchical rejection: a child's subtree is skipped when its combined bounds are outside the frustum
+			if (frustum)
+			{
+				mChildBoundsScratch.resize(mChildren.size());
+
+				for (size_t i = 0; i < mChildren.size(); i++)
+					mChildBoundsScratch[i] = mChildren[i]->mWorldBounds;
+
+				mVisibilityScratch.resize(mChildren.size());
+				frustum->TestBoxes(mChildBoundsScratch.data(), mChildBoundsScratch.size(), mVisibilityScratch.data());
 			}
 
 			// Send children modelMatrix to shader and draw gameobject with attached to child
-			for (auto& child : mChildren)
+			for (size_t i = 0; i < mChildren.size(); i++)
 			{
-				child->Update(shader, deltaTime);
+				auto& child = mChildren[i];
+
+				// Drawn by its cluster's HLOD proxy
+				if (view && view->activeHLODClusters && child->mHLODCluster >= 0 && (*view->activeHLODClusters)[child->mHLODCluster])
+					continue;
+
+				if (frustum && child->mIsCullable && !mVisibilityScratch[i])
+				{
+					if (countStats)
+						Application::GetInstance().AddCulledMeshes(child->mSubtreeMeshCount);
+					continue;
+				}
+
+				// Far enough to be drawn as a billboard, or its impostor is outside the frustum. Static subtrees are batched instead.
+				if (view && view->impostorRenderer && child->mImpostor && !(view->staticBatches && child->mIsStatic)
+					&& view->impostorRenderer->Submit(*child->mImpostor, child->mTransform->GetWorldTransformationMatrix(), child->mEntity->GetEntityID(),
+						view->cameraPosition, view->impostorDistance, frustum))
+					continue;
+
+				if (occlusionCuller && child->mIsCullable && child->mSubtreeMeshCount > 0 && child->mWorldBounds.IsValid() && occlusionCuller->IsOccluded(child->mWorldBounds))
+				{
+					if (countStats)
+						Application::GetInstance().AddOccludedMeshes(child->mSubtreeMeshCount);
+					continue;
+				}
+
+				child->Update(shader, deltaTime, frustum, occlusionCuller, gpuCuller, view);
 			}
 		}
 	}
 
+	void Node::ComputeWorldBounds()
+	{
+		const Matrix4& worldMatrix = mTransform->GetWorldTransformationMatrix();
+
+		mWorldBounds = AABB();
+		mIsCullable = true;
+		mSubtreeMeshCount = (uint32_t)mMeshes.size();
+		mMeshWorldBounds.resize(mMeshes.size());
+
+		for (size_t i = 0; i < mMeshes.size(); i++)
+		{
+			const Ref<Mesh>& mesh = mMeshes[i];
+
+			// Skinned vertices are moved by bones in the shader, their bind pose bounds can't be trusted
+			if (mesh->HasBoneInfluence() || !mesh->GetBoundingBox().IsValid())
+			{
+				mMeshWorldBounds[i] = AABB();
+				mIsCullable = false;
+				continue;
+			}
+
+			mMeshWorldBounds[i] = mesh->GetBoundingBox().Transform(worldMatrix);
+			mWorldBounds.Expand(mMeshWorldBounds[i]);
+		}
+
+		mMeshesWorldBounds = mWorldBounds;
+
+		for (auto& child : mChildren)
+		{
+			child->ComputeWorldBounds();
+
+			mWorldBounds.Expand(child->mWorldBounds);
+			mSubtreeMeshCount += child->mSubtreeMeshCount;
+
+			if (!child->mIsCullable)
+				mIsCullable = false;
+		}
+	}
+
 	Ref<Node> Node::FindNodeByName(std::string _name)
 	{
 		Ref<Node> foundNode = nullptr;
@@ -412,6 +581,8 @@ namespace TS_ENGINE
 	{
 		mMeshes.clear();
 		mMeshes.push_back(mesh);
+		mMeshesVersion++;
+		sHierarchyVersion++;
 	}
 
 	void Node::ChangeMesh(PrimitiveType primitiveType)
@@ -422,16 +593,22 @@ namespace TS_ENGINE
 	void Node::AddMesh(Ref<Mesh> mesh)
 	{
 		mMeshes.push_back(mesh);
+		mMeshesVersion++;
+		sHierarchyVersion++;
 	}
 
 	void Node::AddMeshes(std::vector<Ref<Mesh>> meshes)
 	{
 		mMeshes = meshes;
+		mMeshesVersion++;
+		sHierarchyVersion++;
 	}
 
 	void Node::RemoveAllMeshes()
 	{
 		mMeshes.clear();
+		mMeshesVersion++;
+		sHierarchyVersion++;
 	}
 
 	bool Node::HasMeshes()
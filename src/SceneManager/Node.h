@@ -11,6 +11,10 @@ namespace TS_ENGINE
 {
 	class Transform;
 	class SceneCamera;
+	class Frustum;
+	class OcclusionCuller;
+	class GPUCuller;
+	struct Impostor;
 	class Node
 	{		
 	public:
@@ -64,7 +68,29 @@ namespace TS_ENGINE
 		void ReInitializeTransforms();
 
 		// Sets model matrix in shader. Renders mesh. Then updates children.
-		void Update(Ref<Shader> shader, float deltaTime);
+		// With a frustum, meshes and child subtrees outside of it are skipped (needs ComputeWorldBounds first).
+		// With an occlusion culler, the ones hidden behind its occluders are skipped too.
+		// With a GPU culler, meshes that have a draw group are drawn through its indirect commands instead.
+		// With a render view, meshes with LODs draw the one matching their screen size, and meshes split into meshlets
+		// only draw the meshlets in view and facing the camera. Children with an impostor are queued to its renderer instead
+		// when they are beyond the view's impostor distance. Children in an active HLOD cluster are skipped, its proxy draws them.
+		// With the view's static batches, meshes of batched nodes are skipped too. With its dynamic batcher, small meshes are queued to it.
+		void Update(Ref<Shader> shader, float deltaTime, const Frustum* frustum = nullptr, OcclusionCuller* occlusionCuller = nullptr, GPUCuller* gpuCuller = nullptr,
+			const RenderView* view = nullptr);
+
+		// Computes world space bounds of meshes and of the whole subtree for culling
+		void ComputeWorldBounds();
+		const AABB& GetWorldBounds() const { return mWorldBounds; }
+		// Bounds of this node's own meshes, without children
+		const AABB& GetMeshesWorldBounds() const { return mMeshesWorldBounds; }
+		// False if the subtree has meshes that can not be culled (skinned meshes)
+		bool IsCullable() const { return mIsCullable; }
+		// World bounds of each mesh, invalid for meshes that can not be culled
+		const std::vector<AABB>& GetMeshWorldBounds() const { return mMeshWorldBounds; }
+
+		// GPU culler draw group of each mesh, -1 for meshes drawn directly
+		void SetMeshDrawGroups(const std::vector<int32_t>& drawGroups) { mMeshDrawGroups = drawGroups; }
+		void ClearMeshDrawGroups() { mMeshDrawGroups.clear(); }
 
 		Ref<Node> FindNodeByName(std::string _name);
 
@@ -77,9 +103,29 @@ namespace TS_ENGINE
 		void AddMeshes(std::vector<Ref<Mesh>> meshes);
 		void RemoveAllMeshes();
 		bool HasMeshes();
+		// Bumped whenever meshes are added, replaced or removed
+		uint32_t GetMeshesVersion() const { return mMeshesVersion; }
+		// Bumped whenever any node gains or loses children or meshes, or changes its static flag or enabled state
+		static uint32_t GetHierarchyVersion() { return sHierarchyVersion; }
 
 		void SetModelPath(std::string modelPath);
 
+		// Baked billboard standing in for this node's subtree at a distance, shared by the instances of a model
+		void SetImpostor(Ref<Impostor> impostor) { mImpostor = impostor; }
+		Ref<Impostor> GetImpostor() const { return mImpostor; }
+
+		// Index of the HLOD cluster whose proxy includes this node, -1 if none
+		void SetHLODCluster(int32_t cluster) { mHLODCluster = cluster; }
+		int32_t GetHLODCluster() const { return mHLODCluster; }
+
+		// Meshes of static nodes and of their subtrees are merged into static batches
+		void SetStatic(bool isStatic) { mIsStatic = isStatic; sHierarchyVersion++; }
+		bool IsStatic() const { return mIsStatic; }
+
+		// True while a static batch draws this node's meshes. Cleared when the node is edited, it then draws them itself again.
+		void SetStaticBatched(bool isStaticBatched) { mIsStaticBatched = isStaticBatched; }
+		bool IsStaticBatched() const { return mIsStaticBatched; }
+
 		void PrintChildrenName();//Only for testing
 
 		void CloneMeshes(std::vector<Ref<Mesh>> meshes);
@@ -116,6 +162,8 @@ namespace TS_ENGINE
 
 #ifdef TS_ENGINE_EDITOR
 		bool m_Enabled = true;//For IMGUI
+		// Changes m_Enabled so caches of the hierarchy notice, see GetHierarchyVersion
+		void SetEnabled(bool enabled) { m_Enabled = enabled; sHierarchyVersion++; }
 #endif
 	
 		void SetHasBoneInfluence(bool _hasBoneInfluence);
@@ -130,12 +178,29 @@ namespace TS_ENGINE
 
 		std::vector<Ref<Node>> mSiblings = {};
 		std::vector<Ref<Mesh>> mMeshes;
+		uint32_t mMeshesVersion = 0;
 		std::string mModelPath;		
 		Ref<SceneCamera> mSceneCamera;// Only used incase of scene camera node
 #ifdef TS_ENGINE_EDITOR
 		bool mIsVisibleInEditor = true;
 #endif
 		bool mHasBoneInfluence;
+
+		// Culling
+		AABB mWorldBounds;							// Bounds of meshes and children
+		AABB mMeshesWorldBounds;					// Bounds of own meshes
+		std::vector<AABB> mMeshWorldBounds;			// Bounds of each mesh
+		bool mIsCullable = true;
+		uint32_t mSubtreeMeshCount = 0;
+		std::vector<AABB> mChildBoundsScratch;
+		std::vector<uint8_t> mVisibilityScratch;
+		std::vector<int32_t> mMeshDrawGroups;
+		Ref<Impostor> mImpostor;
+		int32_t mHLODCluster = -1;
+		bool mIsStatic = false;
+		bool mIsStaticBatched = false;
+
+		static uint32_t sHierarchyVersion;
 	};
 }
 
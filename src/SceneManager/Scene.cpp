@@ -12,6 +12,8 @@
 
 #include "Renderer/RenderCommand.h"
 #include "Core/Factory.h"
+#include "Renderer/Frustum.h"
+#include "Core/JobSystem.h"
 
 namespace TS_ENGINE
 {
@@ -21,7 +23,6 @@ namespace TS_ENGINE
 		mSceneNode->SetNodeRef(mSceneNode);
 
 		mCurrentSceneCameraIndex = 0;
-		//m_BatchButton.RegisterClickHandler(std::bind(&ButtonHandler::OnButtonClicked, &mBatchButtonHandler, std::placeholders::_1, std::placeholders::_2));
 
 		mSkybox = CreateRef<Skybox>();	
 
@@ -53,11 +54,32 @@ namespace TS_ENGINE
 			if (mSceneCameras[i] == sceneCamera)
 			{
 				mSceneCameras.erase(mSceneCameras.begin() + i);
+				ReleaseCameraState(sceneCamera.get());
 				return;
 			}
 		}
 	}
 
+	void Scene::ReleaseCameraState(Camera* camera)
+	{
+		mOcclusionCullers.erase(camera);
+		mGPUCullStates.erase(camera);
+
+		std::vector<Ref<Node>> stack = { mSceneNode };
+
+		while (!stack.empty())
+		{
+			Ref<Node> node = stack.back();
+			stack.pop_back();
+
+			for (const auto& mesh : node->GetMeshes())
+				mesh->ReleaseCamera(camera);
+
+			for (const auto& child : node->GetChildren())
+				stack.push_back(child);
+		}
+	}
+
 	void Scene::Flush()
 	{
 #ifdef TS_ENGINE_EDITOR
@@ -69,26 +91,45 @@ namespace TS_ENGINE
 
 		EntityManager::GetInstance()->Flush();
 		Factory::GetInstance()->Flush();
+		mSpatialProxies.clear();
+		mSpatialTree.Clear();
+		mSkinnedNodes.clear();
+		mOcclusionCullers.clear();
+		mGPUCullStates.clear();
+		mImpostors.clear();
+		mImpostorRenderer.reset();
+		mDynamicBatcher.reset();
+		mHLODClusters.clear();
+		mActiveHLODClusters.clear();
+		mHLODCellSlots.clear();
+		mHLODDirtyCells.clear();
+		mPendingHLODBuilds.clear();
+		mHLODDynamicNodes.clear();
+		mHLODCompositor.reset();
+		mHLODCellSize = 0.0f;
+		mHLODStaticNodeCount = 0;
+		mHLODsDirty = true;
+		mStaticBatches.clear();
+		mStaticBatchEditedNodes.clear();
+		mStaticNodeCount = 0;
+		mStaticBatchesNodeCount = 0;
+		mStaticBatchesDirty = true;
+		UntrackGPUCullDraws();
+		mGPUCullGroups.clear();
+		mGPUCullInstances.clear();
+		mGPUDrawInstances.clear();
+		mGPUDrawMaterials.clear();
+		mGPUCullSetNodeCount = 0;
+		mGPUCullSetDirty = true;
 		mSceneNode.reset();
 		//ModelLoader::GetInstance()->Flush();
 	}
 
-	/*void Scene::OnBatched()
-	{
-		mSceneNode->RemoveAllChildren();
-		Ref<Node> batchedNode = Batcher::GetInstance()->GetBatchedNode();
-		mSceneNode->AddChild(mSceneNode, batchedNode);
-		batchedNode->SetParentNode(mSceneNode);
-	}*/
-
-	/*void Scene::OnUnBatched()
-	{
-		mSceneNode->RemoveChild(Batcher::GetInstance()->GetBatchedNode());
-		Batcher::GetInstance()->GetBatchedNode()->GetTransform()->Reset();
-	}*/
-
 	void Scene::Render(Ref<Shader> shader, float deltaTime)
 	{
+		if (Application::GetInstance().mImpostors)
+			UpdateImpostors(shader);			// Bakes New Models And Re-Bakes Edited Ones, Before Any Camera Pass
+
 		// Scene camera pass
 		if (mSceneCameras.size() > 0)
 		{
@@ -115,10 +156,18 @@ namespace TS_ENGINE
 		//	camera->GetFramebuffer()->Resize((uint32_t)mViewportPanelSize.x, (uint32_t)mViewportPanelSize.y);
 		//}
 
+		bool impostors = Application::GetInstance().mImpostors && mImpostorRenderer;
+
 #ifdef TS_ENGINE_EDITOR
 		camera->GetFramebuffer()->Bind();
+		camera->GetFramebuffer()->SetDrawAttachments({ 0 });	// Entity IDs are only written by the pick pass
 #endif
 
+		bool gpuCulling = Application::GetInstance().mGPUCulling && GPUCuller::IsSupported();
+
+		if (gpuCulling)
+			BuildGPUCullDepthPyramid(camera);	// Hi-Z From Last Frame's Depth, Before It Is Cleared
+
 		//if(!mGammaCorrection)
 		RenderCommand::SetClearColor(Vector4(0.2f, 0.3f, 0.3f, 1.0f));
 		//else
@@ -126,11 +175,6 @@ namespace TS_ENGINE
 
 		RenderCommand::Clear();
 
-		// Clear entity ID attachment to -1
-#ifdef TS_ENGINE_EDITOR
-		camera->GetFramebuffer()->ClearAttachment(1, -1);
-#endif
-
 		//mCurrentShader->SetBool("u_Gamma", mGammaCorrection);
 		//mCurrentShader->SetFloat("u_GammaValue", mGammaValue);
 		//mCurrentShader->SetBool("u_Hdr", mHdr);
@@ -148,7 +192,73 @@ namespace TS_ENGINE
 
 		camera->Update(shader, deltaTime);		// Camera's View And Projection Matrix Updates 
 		
-		mSceneNode->Update(shader, deltaTime);	// Updates Shader Parameters And Renders Scene Hierarchy
+		UpdateSpatialTree();					// World Space Bounds For Culling And Queries
+
+		Frustum frustum(camera->GetProjectionViewMatrix());
+		OcclusionCuller* occlusionCuller = nullptr;
+
+		if (Application::GetInstance().mOcclusionCulling)
+			occlusionCuller = PrepareOcclusionCuller(camera, frustum);	// Depth Of Large Occluders On The CPU
+
+		RenderView view;						// Camera Data For Meshlet Culling And LOD Selection
+		view.cameraPosition = Vector3(glm::inverse(camera->GetViewMatrix())[3]);
+		view.viewDirection = -glm::normalize(Vector3(glm::inverse(camera->GetViewMatrix())[2]));
+		view.orthographic = camera->GetProjectionType() == Camera::ProjectionType::ORTHOGRAPHIC;
+		view.projectionMatrix = camera->GetProjectionMatrix();
+		view.clusterCulling = Application::GetInstance().mClusterCulling;
+		view.lodCamera = Application::GetInstance().mLODSelection ? camera.get() : nullptr;
+		view.impostorRenderer = impostors ? mImpostorRenderer.get() : nullptr;
+		view.impostorDistance = Application::GetInstance().mImpostorDistance;
+
+		if (Application::GetInstance().mDynamicBatching)
+		{
+			if (!mDynamicBatcher)
+				mDynamicBatcher = DynamicBatcher::Create();
+
+			view.dynamicBatcher = mDynamicBatcher.get();
+		}
+
+		// Before HLODs, so static subtrees go into batches rather than clusters
+		if (Application::GetInstance().mStaticBatching)
+		{
+			UpdateStaticBatches();				// Unbatches Edited Nodes
+			view.staticBatches = true;
+		}
+
+		if (Application::GetInstance().mHLOD)
+		{
+			UpdateHLODs(view.cameraPosition);	// Clusters Far Enough To Be Drawn By Their Proxy
+			view.activeHLODClusters = &mActiveHLODClusters;
+		}
+
+		// After batches and clusters, which take their nodes out of the GPU culled set
+		GPUCuller* gpuCuller = gpuCulling ? PrepareGPUCuller(camera) : nullptr;	// Static Meshes Culled By A Compute Pass
+
+		if (Application::GetInstance().mFrustumCulling)
+		{
+			mSceneNode->Update(shader, deltaTime, &frustum, occlusionCuller, gpuCuller, &view);	// Updates Shader Parameters And Renders Visible Part Of Scene Hierarchy
+		}
+		else
+		{
+			mSceneNode->Update(shader, deltaTime, nullptr, occlusionCuller, gpuCuller, &view);	// Updates Shader Parameters And Renders Scene Hierarchy
+		}
+
+		RenderCommand::EnableBackFaceCulling(false);	// Merged Draws Below Mix Single And Double Sided Meshes
+
+		if (gpuCuller)
+			RenderGPUCullGroups(shader, *gpuCuller);	// Static Meshes Left By The Culling Pass, One Call Per Group
+
+		if (view.dynamicBatcher)
+			mDynamicBatcher->Flush(shader, Application::GetInstance().IsTextureModeEnabled());	// Small Meshes Merged Per Material
+
+		if (view.staticBatches)
+			RenderStaticBatches(shader, Application::GetInstance().mFrustumCulling ? &frustum : nullptr, occlusionCuller);	// Merged Meshes Of Static Subtrees
+
+		if (view.activeHLODClusters)
+			RenderHLODProxies(shader, Application::GetInstance().mFrustumCulling ? &frustum : nullptr);	// Merged Proxies Of Distant Clusters
+
+		if (view.impostorRenderer)
+			mImpostorRenderer->Flush(camera->GetViewMatrix(), camera->GetProjectionMatrix());	// Instanced Billboards Of Distant Models
 		
 		// Set selected bone Id
 		shader->SetInt("selectedBoneId",		// Pass selected bone to shader
@@ -165,8 +275,1049 @@ namespace TS_ENGINE
 			model->UpdateBone(shader);			// Bone Gui Update
 
 			if (Application::GetInstance().mBoneView)
-				model->RenderBones(shader);			// Bone Gui Render
+				model->RenderBones(shader, view.dynamicBatcher);	// Bone Gui Render
 		}
+
+		if (view.dynamicBatcher && Application::GetInstance().mBoneView)
+		{
+			RenderCommand::EnableWireframe(false);					// Bones Are Never Drawn In Wireframe
+			mDynamicBatcher->Flush(shader, false);					// Bone Gui Of All Models Merged
+
+			if (Application::GetInstance().IsWireframeModeEnabled())
+				RenderCommand::EnableWireframe(true);
+		}
+
+#ifdef TS_ENGINE_EDITOR
+		RenderEntityIDPicks(camera, shader, deltaTime);	// Entity IDs For Pending Picks
+#endif
+	}
+
+#ifdef TS_ENGINE_EDITOR
+	void Scene::RequestEntityIDPick(Ref<Camera> camera, int x, int y, const std::function<void(int)>& callback)
+	{
+		EntityIDPick pick;
+		pick.camera = camera.get();
+		pick.x = x;
+		pick.y = y;
+		pick.callback = callback;
+		mEntityIDPicks.push_back(pick);
+	}
+
+	void Scene::RenderEntityIDPicks(Ref<Camera> camera, Ref<Shader> shader, float deltaTime)
+	{
+		const Ref<Framebuffer>& framebuffer = camera->GetFramebuffer();
+		const FramebufferSpecification& spec = framebuffer->GetSpecification();
+
+		// Only fragment output 1 is written. The picked pixel gets its own depth, since meshes merged by the dynamic batcher
+		// are transformed on the CPU in the color pass and their depths don't match the ones drawn here exactly.
+		framebuffer->SetDrawAttachments({ 1 });
+		RenderCommand::EnableScissorTest(true);
+
+		for (auto it = mEntityIDPicks.begin(); it != mEntityIDPicks.end();)
+		{
+			if (it->camera != camera.get())
+			{
+				++it;
+				continue;
+			}
+
+			if (it->x < 0 || it->y < 0 || it->x >= (int)spec.Width || it->y >= (int)spec.Height)
+			{
+				it->callback(-1);
+				it = mEntityIDPicks.erase(it);
+				continue;
+			}
+
+			RenderCommand::SetScissor(it->x, it->y, 1, 1);
+			framebuffer->ClearAttachmentRegion(1, -1, it->x, it->y, 1, 1);
+			RenderCommand::ClearDepth();
+
+			// Skybox fills the pixels no mesh covers
+			camera->SetIsDistanceIndependent(true);
+			camera->Update(shader, deltaTime);
+			mSkybox->Render();
+			camera->SetIsDistanceIndependent(false);
+			camera->Update(shader, deltaTime);
+
+			// Cull with the frustum of the picked pixel, mapped to the whole clip space
+			float pixelWidth = 2.0f / spec.Width;
+			float pixelHeight = 2.0f / spec.Height;
+			Vector2 pixelCenter(-1.0f + (it->x + 0.5f) * pixelWidth, -1.0f + (it->y + 0.5f) * pixelHeight);
+
+			Matrix4 pickMatrix =
+				glm::scale(Matrix4(1), Vector3(2.0f / pixelWidth, 2.0f / pixelHeight, 1.0f)) *
+				glm::translate(Matrix4(1), Vector3(-pixelCenter, 0.0f));
+
+			Frustum pickFrustum(pickMatrix * camera->GetProjectionViewMatrix());
+
+			// Batched nodes are drawn from their batch's index ranges
+			// Same LODs as the color pass, so the picked surface is the one on screen
+			RenderView pickView;
+			pickView.cameraPosition = Vector3(glm::inverse(camera->GetViewMatrix())[3]);
+			pickView.projectionMatrix = camera->GetProjectionMatrix();
+			pickView.lodCamera = Application::GetInstance().mLODSelection ? camera.get() : nullptr;
+			pickView.keepLODs = false;
+			pickView.countStats = false;
+			pickView.activeHLODClusters = Application::GetInstance().mHLOD ? &mActiveHLODClusters : nullptr;
+			pickView.staticBatches = Application::GetInstance().mStaticBatching;
+			pickView.impostorRenderer = Application::GetInstance().mImpostors ? mImpostorRenderer.get() : nullptr;
+			pickView.impostorDistance = Application::GetInstance().mImpostorDistance;
+			mSceneNode->Update(shader, deltaTime, &pickFrustum, nullptr, nullptr, &pickView);
+			RenderCommand::EnableBackFaceCulling(false);
+
+			if (pickView.staticBatches)
+				RenderStaticBatchEntityIDs(shader, pickFrustum);
+
+			if (pickView.activeHLODClusters)
+				RenderHLODProxyEntityIDs(shader, pickFrustum);
+
+			if (pickView.impostorRenderer)
+				mImpostorRenderer->Flush(camera->GetViewMatrix(), camera->GetProjectionMatrix(), false);	// Billboards Write Their Instance's Entity ID
+
+			if (Application::GetInstance().mBoneView)
+			{
+				for (auto& [modelName, pair] : Factory::GetInstance()->mLoadedModelNodeMap)
+					pair.second->RenderBones(shader);
+			}
+
+			framebuffer->ReadPixelAsync(1, it->x, it->y, it->callback);
+			it = mEntityIDPicks.erase(it);
+		}
+
+		RenderCommand::EnableScissorTest(false);
+		framebuffer->SetDrawAttachments({ 0 });
+	}
+
+	void Scene::RenderHLODProxyEntityIDs(Ref<Shader> shader, const Frustum& frustum)
+	{
+		shader->SetMat4("u_Model", Matrix4(1));		// Proxies are merged in world space
+		std::vector<IndexRange> drawRange(1);
+
+		for (size_t i = 0; i < mHLODClusters.size(); i++)
+		{
+			const HLODCluster& cluster = mHLODClusters[i];
+
+			if (!mActiveHLODClusters[i] || !frustum.IsBoxVisible(cluster.bounds))
+				continue;
+
+			for (size_t n = 0; n < cluster.nodes.size(); n++)
+			{
+				if (cluster.nodeRanges[n].indexCount == 0)
+					continue;
+
+				cluster.proxyMesh->GetMaterial()->Render(cluster.nodes[n]->GetEntity()->GetEntityID(), Application::GetInstance().IsTextureModeEnabled());
+				drawRange[0] = cluster.nodeRanges[n];
+				cluster.proxyMesh->DrawRanges(drawRange);
+			}
+		}
+	}
+
+	void Scene::RenderStaticBatchEntityIDs(Ref<Shader> shader, const Frustum& frustum)
+	{
+		shader->SetMat4("u_Model", Matrix4(1));		// Batches are merged in world space
+		std::vector<IndexRange> drawRange(1);
+
+		for (const auto& batch : mStaticBatches)
+		{
+			if (batch.drawRanges.empty() || !frustum.IsBoxVisible(batch.bounds))
+				continue;
+
+			for (const auto& range : batch.ranges)
+			{
+				if (!range.batched || !frustum.IsBoxVisible(range.node->GetMeshesWorldBounds()))
+					continue;
+
+				batch.mesh->GetMaterial()->Render(range.node->GetEntity()->GetEntityID(), Application::GetInstance().IsTextureModeEnabled());
+				drawRange[0] = { range.firstIndex, range.indexCount };
+				batch.mesh->DrawRanges(drawRange);
+			}
+		}
+	}
+#endif
+
+	void Scene::UpdateSpatialTree()
+	{
+		TS_CORE_ASSERT(mSceneNode);
+
+		mSceneNode->ComputeWorldBounds();
+		mSpatialTreeStamp++;
+
+		mSkinnedNodes.clear();
+		mStaticNodeCount = 0;
+
+		// Insert or refit every node that has meshes with valid bounds. Nodes are paired with whether they are in a static subtree.
+		std::vector<std::pair<Ref<Node>, bool>> stack = { { mSceneNode, false } };
+
+		while (!stack.empty())
+		{
+			auto [node, isStatic] = stack.back();
+			stack.pop_back();
+			isStatic = isStatic || node->IsStatic();
+
+			for (auto& child : node->GetChildren())
+				stack.push_back({ child, isStatic });
+
+			if (isStatic && node->HasMeshes())
+				mStaticNodeCount++;
+
+			if (node->GetBoneInfluence())
+				mSkinnedNodes.push_back(node);
+
+			// Model instances pick up the impostor baked for their model, again after it was re-baked
+			if (!mImpostors.empty() && !node->GetModelPath().empty())
+			{
+				auto it = mImpostors.find(node->GetModelPath());
+
+				if (it != mImpostors.end() && node->GetImpostor() != it->second)
+				{
+					node->SetImpostor(it->second);
+					mGPUCullSetDirty = true;
+				}
+			}
+
+			const AABB& bounds = node->GetMeshesWorldBounds();
+
+			if (!node->HasMeshes() || !bounds.IsValid())
+				continue;
+
+			SpatialProxy& proxy = mSpatialProxies[node.get()];
+			proxy.stamp = mSpatialTreeStamp;
+
+			if (proxy.proxyId == DynamicAABBTree::sNullNode)
+			{
+				proxy.proxyId = mSpatialTree.CreateProxy(bounds, node.get());
+				proxy.node = node;
+
+				if (Application::GetInstance().mHLOD)
+					MarkHLODCellDirty(node.get());
+			}
+			else
+			{
+				mSpatialTree.MoveProxy(proxy.proxyId, bounds, bounds.GetCenter() - proxy.lastCenter);
+			}
+
+			proxy.lastCenter = bounds.GetCenter();
+		}
+
+		// Remove nodes that left the hierarchy or lost their meshes
+		for (auto it = mSpatialProxies.begin(); it != mSpatialProxies.end();)
+		{
+			if (it->second.stamp != mSpatialTreeStamp)
+			{
+				mSpatialTree.DestroyProxy(it->second.proxyId);
+				it = mSpatialProxies.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+	void Scene::QueryNodesInRegion(const AABB& region, std::vector<Ref<Node>>& nodes) const
+	{
+		mSpatialTree.QueryRegion(region, [&](int proxyId)
+			{
+				Node* node = static_cast<Node*>(mSpatialTree.GetUserData(proxyId));
+
+				if (node->GetMeshesWorldBounds().Intersects(region))
+					nodes.push_back(node->GetNode());
+
+				return true;
+			});
+	}
+
+	void Scene::QueryNodesInFrustum(const Frustum& frustum, std::vector<Ref<Node>>& nodes) const
+	{
+		mSpatialTree.QueryFrustum(frustum, [&](int proxyId)
+			{
+				Node* node = static_cast<Node*>(mSpatialTree.GetUserData(proxyId));
+
+				if (frustum.IsBoxVisible(node->GetMeshesWorldBounds()))
+					nodes.push_back(node->GetNode());
+
+				return true;
+			});
+	}
+
+	void Scene::QueryNodesInRadius(const Vector3& point, float radius, std::vector<Ref<Node>>& nodes) const
+	{
+		mSpatialTree.QueryRadius(point, radius, [&](int proxyId)
+			{
+				Node* node = static_cast<Node*>(mSpatialTree.GetUserData(proxyId));
+
+				if (node->GetMeshesWorldBounds().DistanceSquared(point) <= radius * radius)
+					nodes.push_back(node->GetNode());
+
+				return true;
+			});
+	}
+
+	Ref<Node> Scene::FindNearestNode(const Vector3& point, float maxDistance) const
+	{
+		int proxyId = mSpatialTree.FindNearest(point, maxDistance);
+
+		if (proxyId == DynamicAABBTree::sNullNode)
+			return nullptr;
+
+		return static_cast<Node*>(mSpatialTree.GetUserData(proxyId))->GetNode();
+	}
+
+	OcclusionCuller* Scene::PrepareOcclusionCuller(Ref<Camera> camera, const Frustum& frustum)
+	{
+		static const float sMinOccluderCoverage = 0.02f;	// Fraction of the screen
+		static const size_t sMaxOccluders = 16;
+
+		Scope<OcclusionCuller>& occlusionCuller = mOcclusionCullers[camera.get()];
+
+		if (!occlusionCuller)
+			occlusionCuller = CreateScope<OcclusionCuller>();
+
+		Matrix4 projectionViewMatrix = camera->GetProjectionViewMatrix();
+		occlusionCuller->BeginFrame(projectionViewMatrix);
+
+		struct OccluderCandidate
+		{
+			float coverage;
+			Node* node;
+			Ref<Mesh> mesh;
+		};
+
+		std::vector<OccluderCandidate> candidates;
+
+		mSpatialTree.QueryFrustum(frustum, [&](int proxyId)
+			{
+				Node* node = static_cast<Node*>(mSpatialTree.GetUserData(proxyId));
+#ifdef TS_ENGINE_EDITOR
+				if (!node->m_Enabled)
+					return true;
+#endif
+				const Matrix4& worldMatrix = node->GetTransform()->GetWorldTransformationMatrix();
+
+				for (auto& mesh : node->GetMeshes())
+				{
+					Ref<Mesh> occluderMesh = mesh->GetOccluderMesh() ? mesh->GetOccluderMesh() : mesh;
+
+					if (mesh->HasBoneInfluence() || !mesh->GetBoundingBox().IsValid() || occluderMesh->GetIndices().size() / 3 > Mesh::sMaxOccluderTriangles)
+						continue;
+
+					float coverage = OcclusionCuller::GetScreenCoverage(mesh->GetBoundingBox().Transform(worldMatrix), projectionViewMatrix);
+
+					if (coverage >= sMinOccluderCoverage)
+						candidates.push_back({ coverage, node, occluderMesh });
+				}
+
+				return true;
+			});
+
+		// Largest on screen first
+		size_t numOccluders = std::min(candidates.size(), sMaxOccluders);
+		std::partial_sort(candidates.begin(), candidates.begin() + numOccluders, candidates.end(),
+			[](const OccluderCandidate& a, const OccluderCandidate& b) { return a.coverage > b.coverage; });
+
+		for (size_t i = 0; i < numOccluders; i++)
+		{
+			const OccluderCandidate& candidate = candidates[i];
+			occlusionCuller->AddOccluder(candidate.mesh->GetVertices(), candidate.mesh->GetIndices(), candidate.node->GetTransform()->GetWorldTransformationMatrix());
+		}
+
+		occlusionCuller->Rasterize();
+		return occlusionCuller.get();
+	}
+
+	void Scene::BuildGPUCullDepthPyramid(Ref<Camera> camera)
+	{
+		GPUCullState& state = mGPUCullStates[camera.get()];
+
+		if (!state.gpuCuller)
+			state.gpuCuller = GPUCuller::Create();
+
+		Ref<Framebuffer> framebuffer = camera->GetFramebuffer();
+
+		// Multisampled depth can not be sampled by the reduction pass
+		if (!state.hasLastFrame || !framebuffer || framebuffer->GetSpecification().Samples > 1 || framebuffer->GetDepthAttachmentRendererID() == 0)
+		{
+			state.gpuCuller->InvalidateDepthPyramid();
+			return;
+		}
+
+		const FramebufferSpecification& spec = framebuffer->GetSpecification();
+		state.gpuCuller->BuildDepthPyramid(framebuffer->GetDepthAttachmentRendererID(), spec.Width, spec.Height, state.lastProjectionViewMatrix);
+	}
+
+	GPUCuller* Scene::PrepareGPUCuller(Ref<Camera> camera)
+	{
+		GPUCullState& state = mGPUCullStates[camera.get()];
+
+		if (!state.gpuCuller)
+			state.gpuCuller = GPUCuller::Create();
+
+		// Static batches, HLOD clusters and impostors take nodes out of the set
+		uint32_t features = (Application::GetInstance().mStaticBatching ? 1u : 0u) | (Application::GetInstance().mHLOD ? 2u : 0u)
+			| (Application::GetInstance().mImpostors ? 4u : 0u);
+
+		if (mGPUCullSetDirty || mStaticNodeCount != mGPUCullSetNodeCount || features != mGPUCullSetFeatures || IsGPUCullSetEdited())
+			BuildGPUCullSet();
+
+		// Each camera has its own culler, uploaded once per change of the set
+		if (state.setVersion != mGPUCullSetVersion)
+		{
+			state.gpuCuller->SetInstances(mGPUCullInstances, mGPUDrawInstances, mGPUDrawMaterials, (uint32_t)mGPUCullGroups.size());
+			state.setVersion = mGPUCullSetVersion;
+		}
+
+		state.gpuCuller->Cull(camera->GetProjectionViewMatrix());
+
+		// The depth of this frame is culled against next frame
+		state.lastProjectionViewMatrix = camera->GetProjectionViewMatrix();
+		state.hasLastFrame = true;
+
+		return state.gpuCuller.get();
+	}
+
+	void Scene::BuildGPUCullSet()
+	{
+		TS_CORE_ASSERT(mSceneNode);
+
+		bool staticBatching = Application::GetInstance().mStaticBatching;
+		bool hlod = Application::GetInstance().mHLOD;
+		bool impostors = Application::GetInstance().mImpostors;
+
+		UntrackGPUCullDraws();
+		mGPUCullGroups.clear();
+		mGPUCullInstances.clear();
+		mGPUDrawInstances.clear();
+		mGPUDrawMaterials.clear();
+
+		std::unordered_map<const Material*, uint32_t> materialIndices;
+		std::vector<int32_t> drawGroups;
+
+		struct StackEntry
+		{
+			Ref<Node> node;
+			bool isStatic;
+			bool drawable;		// False below nodes that may be drawn by an impostor or proxy, or are disabled
+		};
+
+		std::vector<StackEntry> stack = { { mSceneNode, false, true } };
+
+		while (!stack.empty())
+		{
+			auto [node, isStatic, drawable] = stack.back();
+			stack.pop_back();
+			isStatic = isStatic || node->IsStatic();
+
+			// Whether these are drawn depends on the camera, so their subtrees keep drawing themselves
+			if (node != mSceneNode)
+			{
+				if (hlod && node->GetHLODCluster() >= 0)
+					drawable = false;
+
+				if (impostors && node->GetImpostor() && !(staticBatching && node->IsStatic()))
+					drawable = false;
+			}
+#ifdef TS_ENGINE_EDITOR
+			if (!node->m_Enabled)
+				drawable = false;
+#endif
+			for (auto& child : node->GetChildren())
+				stack.push_back({ child, isStatic, drawable });
+
+			const auto& meshes = node->GetMeshes();
+			const auto& meshWorldBounds = node->GetMeshWorldBounds();
+
+			bool eligible = isStatic && drawable && !meshes.empty() && meshWorldBounds.size() == meshes.size()
+				&& !(staticBatching && node->IsStaticBatched())
+				&& mSpatialProxies.find(node.get()) != mSpatialProxies.end();
+
+			if (!eligible)
+			{
+				node->ClearMeshDrawGroups();
+				continue;
+			}
+
+			drawGroups.assign(meshes.size(), -1);
+
+			for (size_t i = 0; i < meshes.size(); i++)
+			{
+				const Ref<Mesh>& mesh = meshes[i];
+				const MeshArenaAllocation* allocation = mesh->GetArenaAllocation();
+				Ref<Material> material = mesh->GetMaterial();
+
+				// Instances are drawn from the arena buffers by shaders that read their draw data
+				if (!allocation || mesh->GetDrawMode() != DrawMode::TRIANGLE || mesh->HasBoneInfluence() || !meshWorldBounds[i].IsValid()
+					|| !material || !material->GetShader() || !material->GetShader()->HasUniform("u_DrawInstanced"))
+					continue;
+
+				uint32_t group = 0;
+
+				while (group < mGPUCullGroups.size() && !(mGPUCullGroups[group].vertexFormat == allocation->vertexFormat
+					&& mGPUCullGroups[group].indexType == allocation->indexType && mGPUCullGroups[group].material->DrawsInstancedLike(*material)))
+					group++;
+
+				if (group == mGPUCullGroups.size())
+				{
+					GPUCullGroup& cullGroup = mGPUCullGroups.emplace_back();
+					cullGroup.material = material;
+					cullGroup.vertexFormat = allocation->vertexFormat;
+					cullGroup.indexType = allocation->indexType;
+				}
+
+				mGPUCullGroups[group].vertexCount += (uint32_t)mesh->GetVertices().size();
+				mGPUCullGroups[group].indexCount += (uint32_t)mesh->GetIndices().size();
+
+				Ref<Texture2D> diffuseMap = material->GetDiffuseMap();
+				int32_t diffuseMapLayer = diffuseMap && diffuseMap->GetArrayLayer().IsValid() ? (int32_t)diffuseMap->GetArrayLayer().layer : -1;
+
+				auto [materialIt, added] = materialIndices.try_emplace(material.get(), (uint32_t)mGPUDrawMaterials.size());
+
+				if (added)
+				{
+					GPUDrawMaterial& drawMaterial = mGPUDrawMaterials.emplace_back();
+					drawMaterial.ambientColor = material->GetAmbientColor();
+					drawMaterial.diffuseColor = material->GetDiffuseColor();
+					drawMaterial.specularColor = material->GetSpecularColor();
+					drawMaterial.diffuseMapOffset = material->GetDiffuseMapOffset();
+					drawMaterial.diffuseMapTiling = material->GetDiffuseMapTiling();
+					drawMaterial.diffuseMapLayer = std::max(diffuseMapLayer, 0);
+				}
+
+				GPUCullInstance& instance = mGPUCullInstances.emplace_back();
+				instance.boundsMin = Vector4(meshWorldBounds[i].min, 1.0f);
+				instance.boundsMax = Vector4(meshWorldBounds[i].max, 1.0f);
+				instance.indexCount = (uint32_t)mesh->GetIndices().size();
+				instance.firstIndex = allocation->firstIndex;
+				instance.baseVertex = (int32_t)allocation->baseVertex;
+				instance.drawGroup = group;
+
+				GPUDrawInstance& drawInstance = mGPUDrawInstances.emplace_back();
+				drawInstance.modelMatrix = node->GetTransform()->GetWorldTransformationMatrix();
+				drawInstance.materialIndex = materialIt->second;
+				drawInstance.entityID = node->GetEntity()->GetEntityID();
+
+				// Edits to these bump the counters compared by IsGPUCullSetEdited
+				node->GetTransform()->SetTracked(true);
+				mesh->SetTracked(true);
+				material->SetTracked(true);
+
+				GPUCullDraw& draw = mGPUCullDraws.emplace_back();
+				draw.transform = node->GetTransform();
+				draw.mesh = mesh;
+				draw.material = material;
+
+				drawGroups[i] = (int32_t)group;
+			}
+
+			node->SetMeshDrawGroups(drawGroups);
+		}
+
+		mGPUCullSetVersion++;
+		mGPUCullSetNodeCount = mStaticNodeCount;
+		mGPUCullSetFeatures = (staticBatching ? 1u : 0u) | (hlod ? 2u : 0u) | (impostors ? 4u : 0u);
+		mGPUCullSetVersions = GetGPUCullSetVersions();
+		mGPUCullSetDirty = false;
+	}
+
+	void Scene::UntrackGPUCullDraws()
+	{
+		// An object shared with a draw that is still in the set is tracked again when the set is rebuilt
+		for (const GPUCullDraw& draw : mGPUCullDraws)
+		{
+			if (Ref<Transform> transform = draw.transform.lock())
+				transform->SetTracked(false);
+
+			if (Ref<Mesh> mesh = draw.mesh.lock())
+				mesh->SetTracked(false);
+
+			if (Ref<Material> material = draw.material.lock())
+				material->SetTracked(false);
+		}
+
+		mGPUCullDraws.clear();
+	}
+
+	Scene::GPUCullSetVersions Scene::GetGPUCullSetVersions()
+	{
+		GPUCullSetVersions versions;
+		versions.hierarchy = Node::GetHierarchyVersion();
+		versions.transforms = Transform::GetTrackedVersion();
+		versions.meshes = Mesh::GetTrackedVersion();
+		versions.materials = Material::GetTrackedVersion();
+		versions.arenaLayout = MeshArena::GetInstance()->GetLayoutVersion();
+		versions.arrayLayers = Texture2D::GetArrayLayerVersion();
+		return versions;
+	}
+
+	bool Scene::IsGPUCullSetEdited() const
+	{
+		// Enabling, disabling, re-parenting or changing the meshes of any node bumps the hierarchy version. Moves, material and
+		// geometry edits only count for objects of the set, while defragmenting the arena or repacking texture arrays counts always.
+		return GetGPUCullSetVersions() != mGPUCullSetVersions;
+	}
+
+	void Scene::RenderGPUCullGroups(Ref<Shader> shader, GPUCuller& gpuCuller)
+	{
+		if (mGPUCullGroups.empty())
+			return;
+
+		Ref<MeshArena> arena = MeshArena::GetInstance();
+		shader->SetBool("u_DrawInstanced", true);		// Model matrices and materials are read per instance
+
+		for (uint32_t i = 0; i < (uint32_t)mGPUCullGroups.size(); i++)
+		{
+			const GPUCullGroup& group = mGPUCullGroups[i];
+
+#ifdef TS_ENGINE_EDITOR
+			group.material->Render(-1, Application::GetInstance().IsTextureModeEnabled());
+#else
+			group.material->Render(Application::GetInstance().IsTextureModeEnabled());
+#endif
+			arena->Bind(group.vertexFormat, group.indexType);
+			gpuCuller.DrawGroup(i, group.indexType);
+
+			// Visibility is only known on the GPU, so the submitted geometry is counted
+			Application::GetInstance().AddDrawCalls(1);
+			Application::GetInstance().AddVertices(group.vertexCount);
+			Application::GetInstance().AddIndices(group.indexCount);
+		}
+
+		shader->SetBool("u_DrawInstanced", false);
+	}
+
+	void Scene::UpdateImpostors(Ref<Shader> shader)
+	{
+		if (!mImpostorRenderer)
+			mImpostorRenderer = ImpostorRenderer::Create();
+
+		// The first instance of each model is baked, the others are duplicates of it. Models that couldn't be baked stay nullptr.
+		for (auto& [modelPath, pair] : Factory::GetInstance()->mLoadedModelNodeMap)
+		{
+			auto it = mImpostors.find(modelPath);
+
+			if (it == mImpostors.end())
+			{
+				mImpostors[modelPath] = mImpostorRenderer->Bake(pair.first, pair.second, shader);
+			}
+			else if (it->second && it->second->IsStale())
+			{
+				TS_CORE_INFO("Impostor of {0} is stale, re-baking it", modelPath);
+				it->second = mImpostorRenderer->Bake(pair.first, pair.second, shader);
+			}
+		}
+	}
+
+	void Scene::BuildHLODs()
+	{
+		mHLODsDirty = true;
+	}
+
+	void Scene::UpdateHLODs(const Vector3& cameraPosition)
+	{
+		float cellSize = Application::GetInstance().mHLODCellSize;
+
+		// Every cell with eligible nodes, the first time, after the cell size changed or once nodes were flagged static or unflagged
+		if (mHLODsDirty || cellSize != mHLODCellSize || mStaticNodeCount != mHLODStaticNodeCount)
+		{
+			for (int32_t slot = 0; slot < (int32_t)mHLODClusters.size(); slot++)
+				RetireHLODCluster(slot);
+
+			mHLODClusters.clear();
+			mHLODCellSlots.clear();
+			mHLODDirtyCells.clear();
+			mPendingHLODBuilds.clear();
+			mHLODCellSize = cellSize;
+			mHLODStaticNodeCount = mStaticNodeCount;
+			mHLODsDirty = false;
+
+			for (auto& [node, proxy] : mSpatialProxies)
+				MarkHLODCellDirty(node);
+		}
+
+		// A proxy no longer matches its nodes once one moved, lost its static flag, was disabled or left the hierarchy
+		for (const auto& cluster : mHLODClusters)
+		{
+			for (size_t i = 0; i < cluster.nodes.size(); i++)
+			{
+				const Ref<Node>& node = cluster.nodes[i];
+				bool stale = false;
+
+				if (node->GetTransform()->GetWorldTransformationMatrix() != cluster.nodeWorldMatrices[i])
+				{
+					mHLODDynamicNodes[node.get()] = node;
+					stale = true;
+				}
+				else if (mSpatialProxies.find(node.get()) == mSpatialProxies.end() || !HLODBuilder::IsStatic(node.get()))
+				{
+					stale = true;
+				}
+#ifdef TS_ENGINE_EDITOR
+				else if (!node->m_Enabled)
+				{
+					stale = true;
+				}
+#endif
+				if (stale)
+				{
+					mHLODDirtyCells.insert(cluster.cell);
+					break;
+				}
+			}
+		}
+
+		for (const HLODCell& cell : mHLODDirtyCells)
+			StartHLODBuild(cell);
+
+		mHLODDirtyCells.clear();
+
+		// Swap in the proxies simplified since the last frame
+		for (auto it = mPendingHLODBuilds.begin(); it != mPendingHLODBuilds.end();)
+		{
+			PendingHLODBuild& build = it->second;
+
+			if (build.simplified.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			{
+				++it;
+				continue;
+			}
+
+			build.simplified.get();
+			build.cluster.nodeRanges = build.geometry->nodeRanges;
+			build.cluster.proxyMesh = HLODBuilder::CreateProxyMesh(*build.geometry);
+
+			auto [slotIt, added] = mHLODCellSlots.try_emplace(it->first, (int32_t)mHLODClusters.size());
+			int32_t slot = slotIt->second;
+
+			if (added)
+				mHLODClusters.emplace_back();
+
+			RetireHLODCluster(slot);
+
+			if (build.cluster.proxyMesh)
+			{
+				for (auto& node : build.cluster.nodes)
+					node->SetHLODCluster(slot);
+
+				mGPUCullSetDirty = true;
+
+				mHLODClusters[slot] = std::move(build.cluster);
+			}
+
+			it = mPendingHLODBuilds.erase(it);
+		}
+
+		float distance = Application::GetInstance().mHLODDistance;
+		mActiveHLODClusters.resize(mHLODClusters.size());
+
+		for (size_t i = 0; i < mHLODClusters.size(); i++)
+			mActiveHLODClusters[i] = mHLODClusters[i].proxyMesh && mHLODClusters[i].bounds.DistanceSquared(cameraPosition) > distance * distance ? 1 : 0;
+	}
+
+	void Scene::MarkHLODCellDirty(Node* node)
+	{
+		// Queued by the next UpdateHLODs once all cells are rebuilt
+		if (mHLODsDirty || mHLODCellSize <= 0.0f || IsHLODDynamic(node) || !HLODBuilder::IsEligible(node))
+			return;
+
+		mHLODDirtyCells.insert(HLODBuilder::GetCell(node, mHLODCellSize));
+	}
+
+	void Scene::RetireHLODCluster(int32_t slot)
+	{
+		HLODCluster& cluster = mHLODClusters[slot];
+
+		for (auto& node : cluster.nodes)
+		{
+			if (node->GetHLODCluster() == slot)
+				node->SetHLODCluster(-1);
+		}
+
+		mGPUCullSetDirty = true;
+
+		HLODCell cell = cluster.cell;
+		cluster = HLODCluster();
+		cluster.cell = cell;
+	}
+
+	void Scene::StartHLODBuild(const HLODCell& cell)
+	{
+		// The cell's nodes draw themselves until the new proxy is ready
+		auto slotIt = mHLODCellSlots.find(cell);
+
+		if (slotIt != mHLODCellSlots.end())
+			RetireHLODCluster(slotIt->second);
+
+		mPendingHLODBuilds.erase(cell);
+
+		for (auto it = mHLODDynamicNodes.begin(); it != mHLODDynamicNodes.end();)
+		{
+			if (it->second.expired())
+				it = mHLODDynamicNodes.erase(it);
+			else
+				++it;
+		}
+
+		std::vector<Ref<Node>> candidates;
+		QueryNodesInRegion(HLODBuilder::GetCellBounds(cell, mHLODCellSize), candidates);
+
+		std::vector<Ref<Node>> nodes;
+
+		for (auto& node : candidates)
+		{
+			if (HLODBuilder::GetCell(node.get(), mHLODCellSize) == cell && !IsHLODDynamic(node.get()) && HLODBuilder::IsEligible(node.get()))
+				nodes.push_back(node);
+		}
+
+		if (nodes.size() < HLODBuilder::sMinClusterNodes)
+			return;
+
+		// Same order for the same nodes, whatever the spatial tree returned
+		std::sort(nodes.begin(), nodes.end(), [](const Ref<Node>& a, const Ref<Node>& b) { return a->GetEntity()->GetEntityID() < b->GetEntity()->GetEntityID(); });
+
+		if (!mHLODCompositor)
+			mHLODCompositor = TextureCompositor::Create();
+
+		Ref<HLODProxyGeometry> geometry = CreateRef<HLODProxyGeometry>();
+
+		if (!HLODBuilder::MergeNodes(nodes, *mHLODCompositor, *geometry))
+			return;
+
+		PendingHLODBuild& build = mPendingHLODBuilds[cell];
+		build.cluster.cell = cell;
+		build.cluster.nodes = nodes;
+
+		for (auto& node : nodes)
+		{
+			build.cluster.nodeWorldMatrices.push_back(node->GetTransform()->GetWorldTransformationMatrix());
+			build.cluster.bounds.Expand(node->GetMeshesWorldBounds());
+		}
+
+		build.geometry = geometry;
+		build.simplified = JobSystem::GetInstance()->Async([geometry]() { HLODBuilder::Simplify(*geometry); });
+	}
+
+	bool Scene::IsHLODDynamic(const Node* node) const
+	{
+		auto it = mHLODDynamicNodes.find(node);
+		return it != mHLODDynamicNodes.end() && !it->second.expired();
+	}
+
+	void Scene::RenderHLODProxies(Ref<Shader> shader, const Frustum* frustum)
+	{
+		shader->SetMat4("u_Model", Matrix4(1));		// Proxies are merged in world space
+
+		for (size_t i = 0; i < mHLODClusters.size(); i++)
+		{
+			if (!mActiveHLODClusters[i])
+				continue;
+
+			const HLODCluster& cluster = mHLODClusters[i];
+
+			if (frustum && !frustum->IsBoxVisible(cluster.bounds))
+			{
+				Application::GetInstance().AddCulledMeshes(1);
+				continue;
+			}
+
+#ifdef TS_ENGINE_EDITOR
+			cluster.proxyMesh->Render(cluster.nodes[0]->GetEntity()->GetEntityID(), Application::GetInstance().IsTextureModeEnabled());
+#else
+			cluster.proxyMesh->Render(Application::GetInstance().IsTextureModeEnabled());
+#endif
+			Application::GetInstance().AddVisibleMeshes(1);
+			Application::GetInstance().AddHLODProxyNodes((uint32_t)cluster.nodes.size());
+		}
+	}
+
+	void Scene::BuildStaticBatches()
+	{
+		TS_CORE_ASSERT(mSceneNode);
+
+		for (auto& batch : mStaticBatches)
+		{
+			for (auto& range : batch.ranges)
+				range.node->SetStaticBatched(false);
+		}
+
+		// Edited nodes that were destroyed since are forgotten, their addresses may be reused by new nodes
+		std::unordered_set<const Node*> excludedNodes;
+
+		for (auto it = mStaticBatchEditedNodes.begin(); it != mStaticBatchEditedNodes.end();)
+		{
+			if (it->second.expired())
+			{
+				it = mStaticBatchEditedNodes.erase(it);
+				continue;
+			}
+
+			excludedNodes.insert(it->first);
+			++it;
+		}
+
+		mSceneNode->ComputeWorldBounds();
+		mStaticBatches = Batcher::Build(mSceneNode, excludedNodes);
+		mStaticBatchesNodeCount = mStaticNodeCount;
+		mStaticBatchesDirty = false;
+		mGPUCullSetDirty = true;
+	}
+
+	void Scene::UpdateStaticBatches()
+	{
+		if (mStaticBatchesDirty || mStaticNodeCount != mStaticBatchesNodeCount)
+			BuildStaticBatches();
+
+		// A batch no longer matches a node once it moved, changed, was disabled or left the hierarchy
+		bool unbatched = false;
+
+		for (auto& batch : mStaticBatches)
+		{
+			for (auto& range : batch.ranges)
+			{
+				const Ref<Node>& node = range.node;
+
+				if (!range.batched || !node->IsStaticBatched())
+					continue;
+
+				bool edited = node->GetTransform()->GetWorldTransformationMatrix() != range.worldMatrix
+					|| mSpatialProxies.find(node.get()) == mSpatialProxies.end()
+					|| Batcher::IsEdited(range);
+#ifdef TS_ENGINE_EDITOR
+				for (Node* parent = node.get(); parent && !edited; parent = parent->GetParentNode().get())
+					edited = !parent->m_Enabled;
+#endif
+				if (edited)
+				{
+					node->SetStaticBatched(false);
+					mStaticBatchEditedNodes[node.get()] = node;
+					unbatched = true;
+				}
+			}
+		}
+
+		if (!unbatched)
+			return;
+
+		mGPUCullSetDirty = true;
+
+		// Also drops the ranges an unbatched node has in other batches
+		for (auto& batch : mStaticBatches)
+		{
+			bool changed = false;
+
+			for (auto& range : batch.ranges)
+			{
+				if (range.batched && !range.node->IsStaticBatched())
+				{
+					range.batched = false;
+					changed = true;
+				}
+			}
+
+			if (changed)
+				batch.UpdateDrawRanges();
+		}
+	}
+
+	void Scene::RenderStaticBatches(Ref<Shader> shader, const Frustum* frustum, OcclusionCuller* occlusionCuller)
+	{
+		shader->SetMat4("u_Model", Matrix4(1));		// Batches are merged in world space
+
+		for (const auto& batch : mStaticBatches)
+		{
+			if (batch.drawRanges.empty())
+				continue;
+
+			if (frustum && !frustum->IsBoxVisible(batch.bounds))
+			{
+				Application::GetInstance().AddCulledMeshes(1);
+				continue;
+			}
+
+			if (occlusionCuller && occlusionCuller->IsOccluded(batch.bounds))
+			{
+				Application::GetInstance().AddOccludedMeshes(1);
+				continue;
+			}
+
+#ifdef TS_ENGINE_EDITOR
+			batch.mesh->GetMaterial()->Render(batch.ranges[0].node->GetEntity()->GetEntityID(), Application::GetInstance().IsTextureModeEnabled());
+#else
+			batch.mesh->GetMaterial()->Render(Application::GetInstance().IsTextureModeEnabled());
+#endif
+			batch.mesh->DrawRanges(batch.drawRanges);
+
+			uint32_t indexCount = 0;
+
+			for (const auto& range : batch.drawRanges)
+				indexCount += range.indexCount;
+
+			Application::GetInstance().AddDrawCalls(1);
+			Application::GetInstance().AddVertices((uint32_t)batch.mesh->GetVertices().size());
+			Application::GetInstance().AddIndices(indexCount);
+			Application::GetInstance().AddVisibleMeshes(1);
+		}
+	}
+
+	const OcclusionCuller* Scene::GetOcclusionCuller(Ref<Camera> camera) const
+	{
+		auto it = mOcclusionCullers.find(camera.get());
+		return it != mOcclusionCullers.end() ? it->second.get() : nullptr;
+	}
+
+	bool Scene::Raycast(const Vector3& origin, const Vector3& direction, RaycastHit& hit, float maxDistance)
+	{
+		hit = RaycastHit();
+		hit.distance = maxDistance;
+
+		if (glm::dot(direction, direction) <= 0.0f)
+			return false;
+
+		Vector3 rayDirection = glm::normalize(direction);
+		bool found = false;
+
+		auto raycastNode = [&](Node* node)
+			{
+#ifdef TS_ENGINE_EDITOR
+				if (!node->m_Enabled)
+					return;
+#endif
+				// The local direction is not renormalized, so local hit distances stay in world units
+				Matrix4 inverseWorldMatrix = glm::inverse(node->GetTransform()->GetWorldTransformationMatrix());
+				Vector3 localOrigin = Vector3(inverseWorldMatrix * Vector4(origin, 1.0f));
+				Vector3 localDirection = Vector3(inverseWorldMatrix * Vector4(rayDirection, 0.0f));
+
+				for (auto& mesh : node->GetMeshes())
+				{
+					MeshBVH::Hit meshHit;
+
+					if (!mesh->Raycast(localOrigin, localDirection, hit.distance, meshHit))
+						continue;
+
+					found = true;
+					hit.node = node->GetNode();
+					hit.mesh = mesh;
+					hit.triangleIndex = meshHit.triangleIndex;
+					hit.distance = meshHit.distance;
+					hit.barycentric = Vector2(meshHit.u, meshHit.v);
+					hit.normal = glm::normalize(Vector3(glm::transpose(inverseWorldMatrix) * Vector4(meshHit.normal, 0.0f)));
+				}
+			};
+
+		// Broad phase, nearest nodes first so farther ones get clipped by the closest hit
+		mSpatialTree.RayCast(origin, rayDirection, hit.distance, [&](int proxyId, float entryDistance)
+			{
+				if (entryDistance < hit.distance)
+					raycastNode(static_cast<Node*>(mSpatialTree.GetUserData(proxyId)));
+
+				return hit.distance;
+			});
+
+		for (auto& skinnedNode : mSkinnedNodes)
+			raycastNode(skinnedNode.get());
+
+		if (found)
+			hit.point = origin + rayDirection * hit.distance;
+
+		return found;
 	}
 
 #ifdef TS_ENGINE_EDITOR
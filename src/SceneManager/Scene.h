@@ -1,11 +1,19 @@
 #pragma once
 #include "Node.h"
-//#include "Renderer/Batcher.h"
+#include "Renderer/Batcher.h"
 //#include "Renderer/Renderer.h"
 #include "Renderer/Camera/Camera.h"
 #include <Renderer/Camera/EditorCamera.h>
 #include <Renderer/Camera/SceneCamera.h>
 #include "Primitive/Skybox.h"
+#include "SceneManager/DynamicAABBTree.h"
+#include "Renderer/OcclusionCuller.h"
+#include "Renderer/GPUCuller.h"
+#include "Renderer/ImpostorRenderer.h"
+#include "Renderer/DynamicBatcher.h"
+#include "SceneManager/HLODBuilder.h"
+#include <unordered_set>
+#include <future>
 
 #include <imgui.h>
 //#define IMGUI_DEFINE_MATH_OPERATORS // Already set in preprocessors
@@ -15,60 +23,20 @@
 
 namespace TS_ENGINE {
 
-#pragma region Batching classes
+	class Camera;
+	class SceneCamera;
 
-	class BatchButton
+	struct RaycastHit
 	{
-	public:
-		typedef std::function<void(Ref<TS_ENGINE::Shader>& currentShader, std::vector<Ref<TS_ENGINE::Node>> nodes)> ClickHandler;
-
-		void RegisterClickHandler(ClickHandler handler)
-		{
-			mClickHandler = handler;
-		}
-
-		void Click(Ref<TS_ENGINE::Shader>& currentShader, std::vector<Ref<TS_ENGINE::Node>> nodes)
-		{
-			mClickHandler(currentShader, nodes);
-		}
-
-	private:
-		ClickHandler mClickHandler;
+		Ref<Node> node = nullptr;
+		Ref<Mesh> mesh = nullptr;
+		uint32_t triangleIndex = 0;
+		Vector3 point = Vector3(0.0f);			// World space
+		Vector3 normal = Vector3(0.0f);			// World space geometric normal
+		float distance = FLT_MAX;
+		Vector2 barycentric = Vector2(0.0f);	// Weights of the triangle's second and third vertex
 	};
 
-	//class ButtonHandler
-	//{
-	//public:
-	//	void OnButtonClicked(const Ref<TS_ENGINE::Shader>& currentShader, std::vector<Ref<TS_ENGINE::Node>> nodes)
-	//	{
-	//		currentShader->Bind();
-
-	//		if (!Batcher::GetInstance()->IsBatched())
-	//		{
-	//			if (nodes.size() == 0)
-	//			{
-	//				TS_CORE_WARN("No gameObjects to batch!");
-	//				return;
-	//			}
-
-	//			TS_CORE_INFO("***Started batching gameobjects***");
-
-	//			//Reset stats
-	//			Application::Get().ResetStats();
-
-	//			if (nodes.size() > 0)
-	//			{
-	//				Batcher::GetInstance()->CreateAtlases();
-	//				Batcher::GetInstance()->StartBatching(nodes);
-	//			}
-	//		}
-	//	}
-	//};
-
-#pragma endregion
-	class Camera;
-	class SceneCamera;
-
 
 	class Scene
 	{
@@ -81,16 +49,11 @@ namespace TS_ENGINE {
 
 		void Flush();
 
-		//BatchButton m_BatchButton;
-		//bool m_BatchingEnabled;
-		//void OnBatched();
-		//void OnUnBatched();
-
 		// 1. Binds camera's framebuffer
 		// 2. Clears color
-		// 3. Clear entity ID attachment to -1
-		// 4. Renders skybox
-		// 5. Renders scene hierarchy
+		// 3. Renders skybox
+		// 4. Renders scene hierarchy
+		// 5. Renders entity IDs for pending picks
 		// 6. Unbinds camera's framebuffer
 		void Render(Ref<Shader> shader, float deltaTime);
 		
@@ -112,10 +75,118 @@ namespace TS_ENGINE {
 #ifdef TS_ENGINE_EDITOR
 		void ShowSceneCameraGUI(Ref<Shader> shader, float deltaTime);
 		Ref<EditorCamera> GetEditorCamera() { return mEditorCamera; }
+
+		/// <summary>
+		/// Requests the entity ID under a framebuffer pixel of the camera (origin at the bottom left).
+		/// Entity IDs are only rendered for these requests, in a scissored pass after the camera's next frame.
+		/// The callback runs on the main thread once the asynchronous readback completes, -1 if nothing was hit.
+		/// </summary>
+		void RequestEntityIDPick(Ref<Camera> camera, int x, int y, const std::function<void(int)>& callback);
 #endif
 		int mSelectedBoneId;
 
+#pragma region Spatial queries
+		// Refreshes world bounds of the hierarchy and refits the spatial tree. Called by UpdateCameraRT.
+		void UpdateSpatialTree();
+
+		// Nodes with meshes overlapping the region
+		void QueryNodesInRegion(const AABB& region, std::vector<Ref<Node>>& nodes) const;
+		// Nodes with meshes inside the frustum
+		void QueryNodesInFrustum(const Frustum& frustum, std::vector<Ref<Node>>& nodes) const;
+		// Nodes with meshes within radius of the point
+		void QueryNodesInRadius(const Vector3& point, float radius, std::vector<Ref<Node>>& nodes) const;
+		// Node with meshes closest to the point, nullptr if none is closer than maxDistance
+		Ref<Node> FindNearestNode(const Vector3& point, float maxDistance = FLT_MAX) const;
+
+
+		/// <summary>
+		/// Closest mesh triangle hit by the ray. Nodes are gathered from the spatial tree, then each mesh is tested against its triangle BVH.
+		/// Skinned meshes are tested in their current pose. Used for picking instead of reading back the entity ID attachment.
+		/// </summary>
+		bool Raycast(const Vector3& origin, const Vector3& direction, RaycastHit& hit, float maxDistance = FLT_MAX);
+
+		const DynamicAABBTree& GetSpatialTree() const { return mSpatialTree; }
+#pragma endregion
+
+		/// <summary>
+		/// Queues a rebuild of every HLOD cluster from the static subtrees of the hierarchy. Runs automatically while HLODs are enabled
+		/// the first time, when the cell size changes and when the number of nodes with meshes in static subtrees changes. Afterwards
+		/// only the cell of a clustered node that moved, lost its static flag or left the scene, or of a node added to it, is rebuilt. Its nodes draw themselves until the new proxy is simplified on a worker and swapped in.
+		/// Nodes that moved are kept out of later builds.
+		/// </summary>
+		void BuildHLODs();
+		const std::vector<HLODCluster>& GetHLODClusters() const { return mHLODClusters; }
+
+		/// <summary>
+		/// Rebuilds the static batches from the subtrees flagged static. Runs automatically while static batching is enabled,
+		/// the first time and whenever the number of nodes with meshes in static subtrees changes. A batched node that moves,
+		/// changes its meshes or materials, is disabled or leaves the scene is unbatched and draws itself again, and is kept
+		/// out of later builds.
+		/// </summary>
+		void BuildStaticBatches();
+		const std::vector<StaticBatch>& GetStaticBatches() const { return mStaticBatches; }
+
+		// Occlusion culling state and stats of the camera's last frame, nullptr if it was never occlusion culled
+		const OcclusionCuller* GetOcclusionCuller(Ref<Camera> camera) const;
+
 	private:
+		// Drops the culling and LOD state kept for a camera
+		void ReleaseCameraState(Camera* camera);
+		// Rasterizes the largest meshes in view into the camera's occlusion culler
+		OcclusionCuller* PrepareOcclusionCuller(Ref<Camera> camera, const Frustum& frustum);
+
+		// Builds the camera's depth pyramid from the depth of its last frame. Call before the framebuffer is cleared.
+		void BuildGPUCullDepthPyramid(Ref<Camera> camera);
+		// Uploads the static draw set to the camera's culler when it changed since its last upload, then dispatches the culling pass
+		GPUCuller* PrepareGPUCuller(Ref<Camera> camera);
+		// Groups the arena meshes of static subtrees by material and vertex format, and assigns the draw groups of their nodes
+		void BuildGPUCullSet();
+		// True once a mesh of the draw set may have moved, changed its material or geometry, left the arena, was disabled or left
+		// the scene. Compares edit counters, so it costs the same for any number of draws.
+		bool IsGPUCullSetEdited() const;
+		// Draws the instances each group left after culling, one call per group
+		void RenderGPUCullGroups(Ref<Shader> shader, GPUCuller& gpuCuller);
+		// Bakes impostors of loaded models that don't have one yet, and re-bakes the ones whose meshes or materials were edited.
+		// Binds the default framebuffer, so it runs before the camera passes.
+		void UpdateImpostors(Ref<Shader> shader);
+		// Starts rebuilds of dirty cells, swaps in finished ones, then activates the clusters far enough from the camera for their proxy
+		void UpdateHLODs(const Vector3& cameraPosition);
+		// Queues a rebuild of the cell of a node that can be clustered, such as one just added to the scene
+		void MarkHLODCellDirty(Node* node);
+		void RetireHLODCluster(int32_t slot);
+		// Merges the eligible nodes of a dirty cell and queues its simplification, or retires its cluster if too few are left
+		void StartHLODBuild(const HLODCell& cell);
+		bool IsHLODDynamic(const Node* node) const;
+		void RenderHLODProxies(Ref<Shader> shader, const Frustum* frustum);
+		// Rebuilds stale batches, then unbatches the nodes edited since
+		void UpdateStaticBatches();
+		void RenderStaticBatches(Ref<Shader> shader, const Frustum* frustum, OcclusionCuller* occlusionCuller);
+
+#ifdef TS_ENGINE_EDITOR
+		struct EntityIDPick
+		{
+			Camera* camera = nullptr;
+			int x = 0;
+			int y = 0;
+			std::function<void(int)> callback;
+		};
+
+		// Renders entity IDs of the camera's pending picks into attachment 1 and queues their readbacks
+		void RenderEntityIDPicks(Ref<Camera> camera, Ref<Shader> shader, float deltaTime);
+		// Draws the index range of each batched node in the frustum separately, with its node's entity ID
+		void RenderStaticBatchEntityIDs(Ref<Shader> shader, const Frustum& frustum);
+		// Draws the triangles each node left in the active proxies separately, with its node's entity ID
+		void RenderHLODProxyEntityIDs(Ref<Shader> shader, const Frustum& frustum);
+#endif
+
+		struct SpatialProxy
+		{
+			int proxyId = DynamicAABBTree::sNullNode;
+			uint32_t stamp = 0;
+			Vector3 lastCenter = Vector3(0.0f);
+			Ref<Node> node;		// Keeps the node alive until it is removed from the tree
+		};
+
 		// Editor camera
 #ifdef TS_ENGINE_EDITOR
 		Ref<EditorCamera> mEditorCamera = nullptr;
@@ -129,6 +200,103 @@ namespace TS_ENGINE {
 		
 		// Skybox
 		Ref<TS_ENGINE::Skybox> mSkybox;
-		//ButtonHandler mBatchButtonHandler;
+
+		// Spatial tree of nodes with meshes
+		DynamicAABBTree mSpatialTree;
+		std::unordered_map<Node*, SpatialProxy> mSpatialProxies;
+		uint32_t mSpatialTreeStamp = 0;
+		std::vector<Ref<Node>> mSkinnedNodes;		// Not in the spatial tree since their bounds follow the bones
+		std::unordered_map<Camera*, Scope<OcclusionCuller>> mOcclusionCullers;
+
+		struct GPUCullState
+		{
+			Ref<GPUCuller> gpuCuller;
+			Matrix4 lastProjectionViewMatrix = Matrix4(1);
+			bool hasLastFrame = false;
+			uint32_t setVersion = UINT32_MAX;		// mGPUCullSetVersion of the last upload
+		};
+
+		// A mesh of the GPU culled draw set. Its transform, mesh and material are tracked while it's in the set.
+		struct GPUCullDraw
+		{
+			std::weak_ptr<Transform> transform;
+			std::weak_ptr<Mesh> mesh;
+			std::weak_ptr<Material> material;
+		};
+
+		// Edit counters the GPU culled set was built with
+		struct GPUCullSetVersions
+		{
+			uint32_t hierarchy = 0;			// Node::GetHierarchyVersion
+			uint32_t transforms = 0;		// Transform::GetTrackedVersion
+			uint32_t meshes = 0;			// Mesh::GetTrackedVersion
+			uint32_t materials = 0;			// Material::GetTrackedVersion
+			uint32_t arenaLayout = 0;		// MeshArena::GetLayoutVersion
+			uint32_t arrayLayers = 0;		// Texture2D::GetArrayLayerVersion
+
+			bool operator!=(const GPUCullSetVersions& other) const
+			{
+				return hierarchy != other.hierarchy || transforms != other.transforms || meshes != other.meshes
+					|| materials != other.materials || arenaLayout != other.arenaLayout || arrayLayers != other.arrayLayers;
+			}
+		};
+
+		static GPUCullSetVersions GetGPUCullSetVersions();
+		// Stops tracking the transforms, meshes and materials of the draw set and clears it
+		void UntrackGPUCullDraws();
+
+		// Draws of a group share their shader, textures, render state and arena buffers
+		struct GPUCullGroup
+		{
+			Ref<Material> material;					// Renders the state shared by the group
+			VertexFormat vertexFormat = VertexFormat::STATIC;
+			IndexType indexType = IndexType::UINT32;
+			uint32_t vertexCount = 0;
+			uint32_t indexCount = 0;
+		};
+
+		std::unordered_map<Camera*, GPUCullState> mGPUCullStates;
+		std::vector<GPUCullDraw> mGPUCullDraws;
+		std::vector<GPUCullGroup> mGPUCullGroups;
+		std::vector<GPUCullInstance> mGPUCullInstances;
+		std::vector<GPUDrawInstance> mGPUDrawInstances;
+		std::vector<GPUDrawMaterial> mGPUDrawMaterials;
+		uint32_t mGPUCullSetVersion = 0;
+		uint32_t mGPUCullSetNodeCount = 0;						// mStaticNodeCount when the set was built
+		uint32_t mGPUCullSetFeatures = 0;						// Static batching, HLOD and impostor flags when the set was built
+		GPUCullSetVersions mGPUCullSetVersions;
+		bool mGPUCullSetDirty = true;
+
+		Ref<ImpostorRenderer> mImpostorRenderer;
+		Ref<DynamicBatcher> mDynamicBatcher;
+		std::unordered_map<std::string, Ref<Impostor>> mImpostors;	// By model path, nullptr if the model could not be baked
+
+		struct PendingHLODBuild
+		{
+			HLODCluster cluster;							// Swapped into the cell's slot once simplified
+			Ref<HLODProxyGeometry> geometry;
+			std::future<void> simplified;
+		};
+
+		std::vector<HLODCluster> mHLODClusters;					// Indexed by Node::GetHLODCluster, a cell keeps its slot
+		std::vector<uint8_t> mActiveHLODClusters;				// For the camera being rendered
+		std::map<HLODCell, int32_t> mHLODCellSlots;
+		std::set<HLODCell> mHLODDirtyCells;
+		std::map<HLODCell, PendingHLODBuild> mPendingHLODBuilds;
+		std::unordered_map<const Node*, std::weak_ptr<Node>> mHLODDynamicNodes;	// Moved after being clustered, expired ones are pruned
+		Ref<TextureCompositor> mHLODCompositor;
+		float mHLODCellSize = 0.0f;								// Cell size of the current clusters
+		uint32_t mHLODStaticNodeCount = 0;						// mStaticNodeCount when all cells were last rebuilt
+		bool mHLODsDirty = true;
+
+		std::vector<StaticBatch> mStaticBatches;
+		std::unordered_map<const Node*, std::weak_ptr<Node>> mStaticBatchEditedNodes;	// Unbatched after an edit, expired ones are pruned
+		uint32_t mStaticNodeCount = 0;							// Nodes with meshes in static subtrees, counted by UpdateSpatialTree
+		uint32_t mStaticBatchesNodeCount = 0;					// mStaticNodeCount when the batches were built
+		bool mStaticBatchesDirty = true;
+
+#ifdef TS_ENGINE_EDITOR
+		std::vector<EntityIDPick> mEntityIDPicks;
+#endif
 	};
 }
\ No newline at end of file
@@ -241,6 +241,7 @@ namespace TS_ENGINE
 #ifdef TS_ENGINE_EDITOR
 		jsonNode["Enabled"] = node->m_Enabled;
 #endif
+		jsonNode["Static"] = node->IsStatic();
 		
 		jsonNode["EntityType"] = node->GetEntity()->GetEntityType();
 
@@ -567,7 +568,7 @@ namespace TS_ENGINE
 
 				if (it != material["Specular"].end())
 				{
-					specularTexture = Texture2D::Create(material["Specular"]["TexturePath"]);
+					specularTexture = Texture2D::Create(material["Specular"]["TexturePath"], TextureUsage::Data);
 				}
 			}
 
@@ -577,7 +578,7 @@ namespace TS_ENGINE
 
 				if (it != material["Normal"].end())
 				{
-					normalTexture = Texture2D::Create(material["Normal"]["TexturePath"]);
+					normalTexture = Texture2D::Create(material["Normal"]["TexturePath"], TextureUsage::NormalMap);
 				}
 			}
 
@@ -621,7 +622,10 @@ namespace TS_ENGINE
 		// Apply Enabled
 		bool enabled = jsonNode["Enabled"];
 #ifdef TS_ENGINE_EDITOR
-		node->m_Enabled = enabled;
+		node->SetEnabled(enabled);
 #endif
+
+		// Apply Static, scenes saved before it was serialized have none
+		node->SetStatic(jsonNode.value("Static", false));
 	}
 }